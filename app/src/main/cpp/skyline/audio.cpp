@@ -1,10 +1,11 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <kernel/host_affinity.h>
 #include "audio.h"
 
 namespace skyline::audio {
-    Audio::Audio(const DeviceState &state) : oboe::AudioStreamCallback() {
+    Audio::Audio(const DeviceState &state) : oboe::AudioStreamCallback(), state(state) {
         builder.setChannelCount(constant::ChannelCount);
         builder.setSampleRate(constant::SampleRate);
         builder.setFormat(constant::PcmFormat);
@@ -39,6 +40,12 @@ namespace skyline::audio {
     }
 
     oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *audioStream, void *audioData, int32_t numFrames) {
+        static thread_local bool isPinned{}; // The callback thread is owned by Oboe, we can only pin it from inside the callback
+        if (!isPinned) [[unlikely]] {
+            state.hostAffinity->PinHostThread(kernel::HostAffinity::HostThread::Audio);
+            isPinned = true;
+        }
+
         auto destBuffer{static_cast<i16 *>(audioData)};
         auto streamSamples{static_cast<size_t>(numFrames) * audioStream->getChannelCount()};
         size_t writtenSamples{};
@@ -11,6 +11,7 @@ namespace skyline::audio {
      */
     class Audio : public oboe::AudioStreamCallback {
       private:
+        const DeviceState &state;
         oboe::AudioStreamBuilder builder;
         oboe::ManagedStream outputStream;
         std::vector<std::shared_ptr<AudioTrack>> audioTracks;
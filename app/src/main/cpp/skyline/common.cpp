@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <cstring>
 #include <android/log.h>
 #include "common.h"
 #include "nce.h"
@@ -9,51 +10,233 @@
 #include "audio.h"
 #include "input.h"
 #include "kernel/types/KThread.h"
+#include "kernel/host_affinity.h"
+#include "kernel/host_thread_pool.h"
 
 namespace skyline {
-    Logger::Logger(const std::string &path, LogLevel configLevel) : configLevel(configLevel), start(util::GetTimeNs() / constant::NsInMillisecond) {
+    static std::atomic<u64> nextLoggerId{}; //!< A monotonically increasing ID for loggers, this is used to detect thread-local rings belonging to a previous logger
+
+    thread_local static std::array<char, 16> threadName;
+    thread_local Logger::ThreadRingReference Logger::threadRing;
+    std::atomic<Logger *> Logger::activeLogger;
+
+    Logger::ThreadRingReference::~ThreadRingReference() {
+        if (ring)
+            ring->exited.store(true, std::memory_order_release);
+    }
+
+    Logger::Logger(const std::string &path, LogLevel configLevel) : start(util::GetTimeNs() / constant::NsInMillisecond), id(nextLoggerId++), configLevel(configLevel) {
         logFile.open(path, std::ios::trunc);
         UpdateTag();
         Write(LogLevel::Info, "Logging started");
+        writerThread = std::thread(&Logger::WriterThread, this);
+        activeLogger.store(this, std::memory_order_release);
     }
 
     Logger::~Logger() {
-        Write(LogLevel::Info, "Logging ended");
+        auto self{this};
+        activeLogger.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+
+        {
+            std::lock_guard lock(writerMutex);
+            writerRunning = false;
+        }
+        writerCondition.notify_one();
+        if (writerThread.joinable())
+            writerThread.join();
+
+        std::lock_guard lock(drainMutex);
+        Drain();
+        WriteLine(LogLevel::Info, util::GetTimeNs(), threadName.data(), "Logging ended");
         logFile.flush();
     }
 
-    thread_local static std::string logTag, threadName;
-
     void Logger::UpdateTag() {
-        std::array<char, 16> name;
-        if (!pthread_getname_np(pthread_self(), name.data(), name.size()))
-            threadName = name.data();
-        else
-            threadName = "unk";
-        logTag = std::string("emu-cpp-") + threadName;
+        if (pthread_getname_np(pthread_self(), threadName.data(), threadName.size()))
+            std::strncpy(threadName.data(), "unk", threadName.size());
+    }
+
+    Logger::ThreadRing &Logger::GetThreadRing() {
+        if (threadRing.loggerId != id) [[unlikely]] {
+            std::lock_guard lock(ringMutex);
+            auto &ring{rings.emplace_back(std::make_shared<ThreadRing>())};
+            if (threadRing.ring)
+                threadRing.ring->exited.store(true, std::memory_order_release); // The ring belongs to a previous logger, it won't be written to anymore
+            threadRing.loggerId = id;
+            threadRing.ring = ring;
+        }
+        return *threadRing.ring;
+    }
+
+    Logger::Entry *Logger::BeginEntry(LogLevel level) {
+        if (!threadName[0])
+            UpdateTag();
+
+        auto &ring{GetThreadRing()};
+        auto tail{ring.tail.load(std::memory_order_relaxed)};
+        if (tail - ring.head.load(std::memory_order_acquire) >= ThreadRing::Capacity) [[unlikely]] {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto &entry{ring.entries[tail % ThreadRing::Capacity]};
+        entry.level = level;
+        entry.threadName = threadName;
+        entry.timestamp = util::GetTimeNs();
+        return &entry;
+    }
+
+    void Logger::CommitEntry() {
+        auto &ring{*threadRing.ring};
+        ring.tail.store(ring.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        if (writerSleeping.load(std::memory_order_acquire)) {
+            std::lock_guard lock(writerMutex);
+            writerCondition.notify_one();
+        }
     }
 
     void Logger::Write(LogLevel level, const std::string &str) {
+        if (level == LogLevel::Error) [[unlikely]] {
+            // Errors are usually followed by a crash or an abort, they're written out immediately rather than going through the ring so that they're never dropped or lost
+            if (!threadName[0])
+                UpdateTag();
+
+            std::lock_guard lock(drainMutex);
+            Drain();
+            WriteLine(level, util::GetTimeNs(), threadName.data(), str);
+            logFile.flush();
+            return;
+        }
+
+        Enqueue(level, [&](Entry &entry) {
+            entry.formatter = nullptr;
+            entry.format = nullptr;
+            entry.function = nullptr;
+            entry.message = new std::string(str);
+        });
+    }
+
+    void Logger::Flush() {
+        std::lock_guard lock(drainMutex);
+        Drain();
+        logFile.flush();
+    }
+
+    void Logger::FlushActive() {
+        auto logger{activeLogger.load(std::memory_order_acquire)};
+        if (logger && logger->drainMutex.try_lock()) {
+            std::unique_lock ringLock(logger->ringMutex, std::try_to_lock);
+            if (ringLock) {
+                ringLock.unlock(); // Drain locks the ring mutex itself, this only ensures that it isn't held by the calling thread
+                logger->Drain();
+                logger->logFile.flush();
+            }
+            logger->drainMutex.unlock();
+        }
+    }
+
+    void Logger::WriteLine(LogLevel level, u64 timestamp, const char *name, std::string_view message) {
         constexpr std::array<char, 5> levelCharacter{'E', 'W', 'I', 'D', 'V'}; // The LogLevel as written out to a file
         constexpr std::array<int, 5> levelAlog{ANDROID_LOG_ERROR, ANDROID_LOG_WARN, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE}; // This corresponds to LogLevel and provides its equivalent for NDK Logging
 
-        if (logTag.empty())
-            UpdateTag();
+        std::array<char, 32> tag;
+        std::snprintf(tag.data(), tag.size(), "emu-cpp-%s", name);
+        __android_log_write(levelAlog[static_cast<u8>(level)], tag.data(), std::string(message).c_str());
+
+        logFile << '\036' << levelCharacter[static_cast<u8>(level)] << '\035' << std::dec << (timestamp / constant::NsInMillisecond) - start << '\035' << name << '\035' << message << '\n'; // We use RS (\036) and GS (\035) as our delimiters
+    }
+
+    void Logger::Drain() {
+        struct RingRange {
+            ThreadRing *ring;
+            size_t head, tail;
+            bool exited; //!< If the thread owning the ring had exited prior to the tail being read, the ring can be removed after this drain
+        };
+        std::vector<RingRange> ranges;
+
+        {
+            std::lock_guard lock(ringMutex);
+            ranges.reserve(rings.size());
+            for (auto &ring : rings) {
+                if (auto dropped{ring->dropped.exchange(0, std::memory_order_relaxed)}) [[unlikely]]
+                    WriteLine(LogLevel::Warn, util::GetTimeNs(), "logger", fmt::format("Dropped {} logs due to a full log ring", dropped));
+                bool exited{ring->exited.load(std::memory_order_acquire)}; // This must be read prior to the tail, a ring can only be removed if no entries can be committed after the tail was read
+                ranges.push_back({ring.get(), ring->head.load(std::memory_order_relaxed), ring->tail.load(std::memory_order_acquire), exited});
+            }
+        }
+
+        // Entries are sorted across all rings by their timestamp so that the log is in the same order it was written in
+        drainEntries.clear();
+        for (auto &range : ranges)
+            for (auto index{range.head}; index != range.tail; index++)
+                drainEntries.push_back(&range.ring->entries[index % ThreadRing::Capacity]);
+        std::stable_sort(drainEntries.begin(), drainEntries.end(), [](const Entry *a, const Entry *b) {
+            return a->timestamp < b->timestamp;
+        });
+
+        for (auto entry : drainEntries) {
+            if (entry->message) {
+                WriteLine(entry->level, entry->timestamp, entry->threadName.data(), *entry->message);
+                delete entry->message;
+            } else {
+                std::string message;
+                try {
+                    message = entry->formatter(*entry);
+                } catch (const std::exception &e) {
+                    // An exception can't be allowed to propagate out of the logger thread, the log is replaced with a description of the failure instead
+                    message = fmt::format("Failed to format log \"{}\": {}", entry->format, e.what());
+                }
+                if (entry->function)
+                    message = std::string(entry->function) + ": " + message;
+                WriteLine(entry->level, entry->timestamp, entry->threadName.data(), message);
+            }
+        }
+
+        // The entries are only released back to the producers after they've been consumed
+        bool anyExited{};
+        for (auto &range : ranges) {
+            range.ring->head.store(range.tail, std::memory_order_release);
+            anyExited |= range.exited;
+        }
+
+        if (anyExited) [[unlikely]] {
+            // Rings of exited threads have been completely drained at this point, they're removed to avoid accumulating a ring for every thread that has ever logged
+            std::lock_guard lock(ringMutex);
+            std::erase_if(rings, [&](const std::shared_ptr<ThreadRing> &ring) {
+                return std::find_if(ranges.begin(), ranges.end(), [&](const RingRange &range) { return range.exited && range.ring == ring.get(); }) != ranges.end();
+            });
+        }
+    }
+
+    void Logger::WriterThread() {
+        pthread_setname_np(pthread_self(), "Sky-Logger");
 
-        __android_log_write(levelAlog[static_cast<u8>(level)], logTag.c_str(), str.c_str());
+        while (true) {
+            {
+                std::unique_lock lock(writerMutex);
+                writerSleeping.store(true, std::memory_order_release);
+                writerCondition.wait_for(lock, std::chrono::milliseconds(100));
+                writerSleeping.store(false, std::memory_order_relaxed);
+                if (!writerRunning)
+                    return;
+            }
 
-        std::lock_guard guard(mutex);
-        logFile << '\036' << levelCharacter[static_cast<u8>(level)] << '\035' << std::dec << (util::GetTimeNs() / constant::NsInMillisecond) - start << '\035' << threadName << '\035' << str << '\n'; // We use RS (\036) and GS (\035) as our delimiters
+            std::lock_guard lock(drainMutex);
+            Drain();
+        }
     }
 
     DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings, std::shared_ptr<Logger> logger)
         : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)), logger(std::move(logger)) {
         // We assign these later as they use the state in their constructor and we don't want null pointers
+        hostAffinity = std::make_shared<kernel::HostAffinity>(*this);
         soc = std::make_shared<soc::SOC>(*this);
         gpu = std::make_shared<gpu::GPU>(*this);
         audio = std::make_shared<audio::Audio>(*this);
         nce = std::make_shared<nce::NCE>(*this);
         scheduler = std::make_shared<kernel::Scheduler>(*this);
+        threadPool = std::make_shared<kernel::HostThreadPool>(*this);
         input = std::make_shared<input::Input>(*this);
     }
 }
@@ -14,6 +14,8 @@
 #include <shared_mutex>
 #include <functional>
 #include <thread>
+#include <condition_variable>
+#include <atomic>
 #include <string>
 #include <cstdint>
 #include <stdexcept>
@@ -23,6 +25,8 @@
 #include <compare>
 #include <variant>
 #include <random>
+#include <chrono>
+#include <ctime>
 #include <sys/mman.h>
 #include <fmt/format.h>
 #include <frozen/unordered_map.h>
@@ -168,11 +172,18 @@ namespace skyline {
          * @return The current time in nanoseconds
          */
         inline u64 GetTimeNs() {
+            #if defined(__aarch64__)
             u64 frequency;
             asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
             u64 ticks;
             asm("MRS %0, CNTVCT_EL0" : "=r"(ticks));
             return ((ticks / frequency) * constant::NsInSecond) + (((ticks % frequency) * constant::NsInSecond + (frequency / 2)) / frequency);
+            #else
+            // Host builds of tests and tools don't have access to the AArch64 system counter, the monotonic clock is used instead
+            timespec time{};
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return (static_cast<u64>(time.tv_sec) * constant::NsInSecond) + static_cast<u64>(time.tv_nsec);
+            #endif
         }
 
         /**
@@ -180,9 +191,26 @@ namespace skyline {
          * @return The current time in ticks
          */
         inline u64 GetTimeTicks() {
+            #if defined(__aarch64__)
             u64 ticks;
             asm("MRS %0, CNTVCT_EL0" : "=r"(ticks));
             return ticks;
+            #else
+            return GetTimeNs();
+            #endif
+        }
+
+        /**
+         * @return The supplied duration in ticks (as returned by GetTimeTicks) converted to nanoseconds
+         */
+        inline u64 TicksToNs(u64 ticks) {
+            #if defined(__aarch64__)
+            u64 frequency;
+            asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+            return ((ticks / frequency) * constant::NsInSecond) + (((ticks % frequency) * constant::NsInSecond + (frequency / 2)) / frequency);
+            #else
+            return ticks;
+            #endif
         }
 
         /**
@@ -491,15 +519,15 @@ namespace skyline {
     struct VariantVisitor : Ts ... { using Ts::operator()...; };
     template<class... Ts> VariantVisitor(Ts...) -> VariantVisitor<Ts...>;
 
+    #ifndef SKYLINE_LOG_LEVEL
+    #define SKYLINE_LOG_LEVEL 4 //!< The numerical value of the minimum Logger::LogLevel compiled in, all levels are compiled in unless this is set by the build system
+    #endif
+
     /**
      * @brief A wrapper around writing logs into a log file and logcat using Android Log APIs
+     * @note Logs are pushed into a lock-free per-thread ring and written out by a dedicated logger thread, logs with a static format string and only arithmetic arguments are also formatted on the logger thread
      */
     class Logger {
-      private:
-        std::mutex mutex; //!< Synchronizes all output I/O to ensure there are no races
-        std::ofstream logFile; //!< An output stream to the log file
-        u64 start; //!< A timestamp in milliseconds for when the logger was started, this is used as the base for all log timestamps
-
       public:
         enum class LogLevel {
             Error,
@@ -509,6 +537,139 @@ namespace skyline {
             Verbose,
         };
 
+      private:
+        /**
+         * @brief A single log message, it's either formatted by the calling thread or has its arguments captured to be formatted by the logger thread
+         */
+        struct Entry {
+            static constexpr size_t ArgumentsSize{0x40}; //!< The maximum size of arguments which can be captured for deferred formatting
+
+            LogLevel level;
+            std::array<char, 16> threadName; //!< The name of the thread which wrote the log at the time it was written
+            u64 timestamp; //!< A timestamp in nanoseconds of when the log was written
+            std::string (*formatter)(const Entry &); //!< A function which formats the captured arguments, this is null if 'message' has been formatted eagerly
+            const char *format; //!< A static format string for deferred formatting
+            const char *function; //!< The name of the calling function to prefix the message with, this is null if there's no prefix
+            std::string *message; //!< An eagerly formatted message which is owned by the entry
+            alignas(u64) std::array<u8, ArgumentsSize> arguments; //!< A std::tuple of the captured arguments for deferred formatting
+        };
+
+        /**
+         * @brief A single-producer single-consumer ring of log entries, every thread which writes logs has its own ring
+         */
+        struct ThreadRing {
+            static constexpr size_t Capacity{0x200}; //!< The amount of entries in the ring, any logs written while the ring is full are dropped
+
+            std::array<Entry, Capacity> entries;
+            std::atomic<size_t> head{}; //!< The index of the next entry to be read by the logger thread
+            std::atomic<size_t> tail{}; //!< The index of the next entry to be written by the owning thread
+            std::atomic<u64> dropped{}; //!< The amount of logs dropped due to the ring being full since the last drain
+            std::atomic<bool> exited{}; //!< If the owning thread has exited, the ring is removed after all its entries have been drained
+        };
+
+        /**
+         * @brief A thread-local reference to the ring of a thread, it marks the ring as exited when the thread exits
+         */
+        struct ThreadRingReference {
+            u64 loggerId{std::numeric_limits<u64>::max()}; //!< The ID of the logger which the ring belongs to
+            std::shared_ptr<ThreadRing> ring; //!< The ring is shared with the logger so it's kept alive regardless of whether the thread or the logger is destroyed first
+
+            ~ThreadRingReference();
+        };
+
+        static thread_local ThreadRingReference threadRing;
+        static std::atomic<Logger *> activeLogger; //!< The latest logger which hasn't been destroyed, this is used to flush logs on fatal paths without access to the device state
+
+        std::ofstream logFile; //!< An output stream to the log file
+        u64 start; //!< A timestamp in milliseconds for when the logger was started, this is used as the base for all log timestamps
+        u64 id; //!< A unique ID for this logger, thread-local rings are tied to a specific logger with this
+        std::mutex ringMutex; //!< Synchronizes the creation of rings and their traversal
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        std::mutex drainMutex; //!< Synchronizes draining the rings and all output I/O, only one thread may consume from the rings at a time
+        std::vector<Entry *> drainEntries; //!< A reusable vector of entries to write in a single drain
+        std::condition_variable writerCondition; //!< Signalled to wake the logger thread when logs have been written
+        std::mutex writerMutex; //!< A mutex for waiting on 'writerCondition'
+        std::atomic<bool> writerSleeping{}; //!< If the logger thread is sleeping on 'writerCondition', this avoids a syscall for every log
+        std::atomic<bool> writerRunning{true};
+        std::thread writerThread;
+
+        /**
+         * @return The ring of the calling thread for this logger, it's created if it doesn't exist
+         */
+        ThreadRing &GetThreadRing();
+
+        /**
+         * @return The next entry in the ring of the calling thread with the level, thread name and timestamp filled in, this is null if the ring is full and the log should be dropped
+         */
+        Entry *BeginEntry(LogLevel level);
+
+        /**
+         * @brief Publishes the entry returned by the last call to BeginEntry to the logger thread
+         */
+        void CommitEntry();
+
+        /**
+         * @brief Pushes a log into the ring of the calling thread, it's dropped if the ring is full
+         * @param fill A function which fills in the level-agnostic contents of the entry
+         */
+        template<typename Function>
+        void Enqueue(LogLevel level, Function &&fill) {
+            if (auto entry{BeginEntry(level)}) [[likely]] {
+                fill(*entry);
+                CommitEntry();
+            }
+        }
+
+        /**
+         * @brief Writes out all entries in all rings in the order they were written
+         * @note 'drainMutex' **must** be locked by the calling thread prior to calling this
+         */
+        void Drain();
+
+        /**
+         * @brief The entry point of the logger thread
+         */
+        void WriterThread();
+
+        /**
+         * @brief Writes a single line into the log file and logcat
+         */
+        void WriteLine(LogLevel level, u64 timestamp, const char *threadName, std::string_view message);
+
+        template<typename... Args>
+        static constexpr bool IsDeferrable{((std::is_arithmetic_v<Args> || std::is_enum_v<Args>) && ...) && sizeof(std::tuple<Args...>) <= Entry::ArgumentsSize && alignof(std::tuple<Args...>) <= alignof(u64)};
+
+        template<typename... Args>
+        static std::string FormatDeferred(const Entry &entry) {
+            return std::apply([&](const auto &... args) {
+                return fmt::format(entry.format, args...);
+            }, *reinterpret_cast<const std::tuple<Args...> *>(entry.arguments.data()));
+        }
+
+        /**
+         * @brief Writes a log with a format string, the formatting is deferred to the logger thread if all arguments can be captured by value
+         * @note The format string and function name **must** have a static lifetime as they may be accessed after this returns, this is the case for string literals
+         */
+        template<typename... Args>
+        void Log(LogLevel level, const char *function, const char *format, Args... args) {
+            if constexpr (IsDeferrable<Args...>) {
+                if (level != LogLevel::Error) {
+                    Enqueue(level, [&](Entry &entry) {
+                        entry.formatter = &FormatDeferred<Args...>;
+                        entry.format = format;
+                        entry.function = function;
+                        entry.message = nullptr;
+                        new(entry.arguments.data()) std::tuple<Args...>(args...);
+                    });
+                    return;
+                }
+            }
+
+            auto message{fmt::format(format, args...)};
+            Write(level, function ? std::string(function) + ": " + message : message);
+        }
+
+      public:
         LogLevel configLevel; //!< The minimum level of logs to write
 
         /**
@@ -518,7 +679,7 @@ namespace skyline {
         Logger(const std::string &path, LogLevel configLevel);
 
         /**
-         * @brief Writes the termination message to the log file
+         * @brief Writes out all pending logs and the termination message to the log file
          */
         ~Logger();
 
@@ -527,8 +688,40 @@ namespace skyline {
          */
         static void UpdateTag();
 
+        static constexpr LogLevel CompiledLevel{static_cast<LogLevel>(SKYLINE_LOG_LEVEL)}; //!< The minimum level of logs which are compiled in, any logs above this are eliminated at compile-time
+
+        /**
+         * @return If logs of the supplied level are compiled in at all, this is independent of the runtime log level
+         */
+        static constexpr bool IsCompiled(LogLevel level) {
+            return level <= CompiledLevel;
+        }
+
+        /**
+         * @return If logs of the supplied level will be written, this can be used to skip any work done solely to produce arguments for a log
+         * @note This is always false for levels which aren't compiled in, this lets the compiler eliminate the checked code
+         */
+        bool IsEnabled(LogLevel level) const {
+            return IsCompiled(level) && level <= configLevel;
+        }
+
+        /**
+         * @brief Writes a preformatted log, errors bypass the ring of the calling thread and are written out synchronously alongside all pending logs so they can't be dropped or lost on a crash
+         */
         void Write(LogLevel level, const std::string &str);
 
+        /**
+         * @brief Synchronously writes out all pending logs on the calling thread, this should be called on paths which might not return such as crashes
+         */
+        void Flush();
+
+        /**
+         * @brief Writes out all pending logs of the active logger if its locks can be acquired without blocking, this is for fatal paths such as termination handlers
+         * @note This isn't async-signal-safe as draining allocates and formats, it must not be called from a signal handler
+         * @note The logs will be skipped if the calling thread was interrupted while writing them out itself as that would otherwise deadlock
+         */
+        static void FlushActive();
+
         /**
          * @brief A wrapper around a string which captures the calling function using Clang source location builtins
          * @note A function needs to be declared for every argument template specialization as CTAD cannot work with implicit casting
@@ -548,95 +741,129 @@ namespace skyline {
 
         template<typename... Args>
         void Error(FunctionString<const char*> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, fmt::format(*formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Error))
+                Log(LogLevel::Error, formatString.function, formatString.string, util::FmtCast(args)...);
         }
 
         template<typename... Args>
         void Error(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
+            if (IsEnabled(LogLevel::Error))
                 Write(LogLevel::Error, fmt::format(*formatString, util::FmtCast(args)...));
         }
 
         template<typename S, typename... Args>
         void ErrorNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, fmt::format(formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Error)) {
+                if constexpr (std::is_convertible_v<S, const char *>)
+                    Log(LogLevel::Error, nullptr, formatString, util::FmtCast(args)...);
+                else
+                    Write(LogLevel::Error, fmt::format(formatString, util::FmtCast(args)...));
+            }
         }
 
         template<typename... Args>
         void Warn(FunctionString<const char*> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, fmt::format(*formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Warn))
+                Log(LogLevel::Warn, formatString.function, formatString.string, util::FmtCast(args)...);
         }
 
         template<typename... Args>
         void Warn(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
+            if (IsEnabled(LogLevel::Warn))
                 Write(LogLevel::Warn, fmt::format(*formatString, util::FmtCast(args)...));
         }
 
         template<typename S, typename... Args>
         void WarnNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, fmt::format(formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Warn)) {
+                if constexpr (std::is_convertible_v<S, const char *>)
+                    Log(LogLevel::Warn, nullptr, formatString, util::FmtCast(args)...);
+                else
+                    Write(LogLevel::Warn, fmt::format(formatString, util::FmtCast(args)...));
+            }
         }
 
         template<typename... Args>
         void Info(FunctionString<const char*> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, fmt::format(*formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Info))
+                Log(LogLevel::Info, formatString.function, formatString.string, util::FmtCast(args)...);
         }
 
         template<typename... Args>
         void Info(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
+            if (IsEnabled(LogLevel::Info))
                 Write(LogLevel::Info, fmt::format(*formatString, util::FmtCast(args)...));
         }
 
         template<typename S, typename... Args>
         void InfoNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, fmt::format(formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Info)) {
+                if constexpr (std::is_convertible_v<S, const char *>)
+                    Log(LogLevel::Info, nullptr, formatString, util::FmtCast(args)...);
+                else
+                    Write(LogLevel::Info, fmt::format(formatString, util::FmtCast(args)...));
+            }
         }
 
         template<typename... Args>
         void Debug(FunctionString<const char*> formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, fmt::format(*formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Debug))
+                Log(LogLevel::Debug, formatString.function, formatString.string, util::FmtCast(args)...);
         }
 
         template<typename... Args>
         void Debug(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
+            if (IsEnabled(LogLevel::Debug))
                 Write(LogLevel::Debug, fmt::format(*formatString, util::FmtCast(args)...));
         }
 
         template<typename S, typename... Args>
         void DebugNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, fmt::format(formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Debug)) {
+                if constexpr (std::is_convertible_v<S, const char *>)
+                    Log(LogLevel::Debug, nullptr, formatString, util::FmtCast(args)...);
+                else
+                    Write(LogLevel::Debug, fmt::format(formatString, util::FmtCast(args)...));
+            }
         }
 
         template<typename... Args>
         void Verbose(FunctionString<const char*> formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, fmt::format(*formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Verbose))
+                Log(LogLevel::Verbose, formatString.function, formatString.string, util::FmtCast(args)...);
         }
 
         template<typename... Args>
         void Verbose(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
+            if (IsEnabled(LogLevel::Verbose))
                 Write(LogLevel::Verbose, fmt::format(*formatString, util::FmtCast(args)...));
         }
 
         template<typename S, typename... Args>
         void VerboseNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, fmt::format(formatString, util::FmtCast(args)...));
+            if (IsEnabled(LogLevel::Verbose)) {
+                if constexpr (std::is_convertible_v<S, const char *>)
+                    Log(LogLevel::Verbose, nullptr, formatString, util::FmtCast(args)...);
+                else
+                    Write(LogLevel::Verbose, fmt::format(formatString, util::FmtCast(args)...));
+            }
         }
     };
 
+    /**
+     * @brief Writes a log at the supplied level if it's compiled in and enabled at runtime, unlike calling the logger directly this doesn't evaluate any arguments otherwise
+     * @note This should be used over directly calling the logger on hot paths, especially for debug and verbose logs which are compiled out of release builds
+     */
+    #define LOG_LEVEL(logger, level, ...)                                                          \
+        do {                                                                                       \
+            if constexpr (::skyline::Logger::IsCompiled(::skyline::Logger::LogLevel::level))       \
+                if ((logger)->IsEnabled(::skyline::Logger::LogLevel::level)) [[unlikely]]          \
+                    (logger)->level(__VA_ARGS__);                                                  \
+        } while (false)
+
+    #define LOG_DEBUG(logger, ...) LOG_LEVEL(logger, Debug, __VA_ARGS__)
+    #define LOG_VERBOSE(logger, ...) LOG_LEVEL(logger, Verbose, __VA_ARGS__)
+
     class Settings;
     namespace nce {
         class NCE;
@@ -655,6 +882,8 @@ namespace skyline {
             class KThread;
         }
         class Scheduler;
+        class HostAffinity;
+        class HostThreadPool;
         class OS;
     }
     namespace audio {
@@ -677,12 +906,14 @@ namespace skyline {
         std::shared_ptr<JvmManager> jvm;
         std::shared_ptr<Settings> settings;
         std::shared_ptr<Logger> logger;
+        std::shared_ptr<kernel::HostAffinity> hostAffinity;
         std::shared_ptr<loader::Loader> loader;
         std::shared_ptr<soc::SOC> soc;
         std::shared_ptr<gpu::GPU> gpu;
         std::shared_ptr<audio::Audio> audio;
         std::shared_ptr<nce::NCE> nce;
         std::shared_ptr<kernel::Scheduler> scheduler;
+        std::shared_ptr<kernel::HostThreadPool> threadPool; //!< This must be destroyed after the process as its workers may still be running guest threads
         std::shared_ptr<kernel::type::KProcess> process;
         static thread_local inline std::shared_ptr<kernel::type::KThread> thread{}; //!< The KThread of the thread which accesses this object
         static thread_local inline nce::ThreadContext *ctx{}; //!< The context of the guest thread for the corresponding host thread
@@ -4,7 +4,9 @@
 #pragma once
 
 #include <concepts>
+#include <set>
 #include <common.h>
+#include <common/trace.h>
 
 namespace skyline {
     template<typename VaType, size_t AddressSpaceBits>
@@ -52,6 +54,21 @@ namespace skyline {
 
         std::mutex blockMutex;
         std::vector<Block> blocks{Block{}};
+        std::atomic<u64> blockLockAcquisitions{}; //!< The amount of times 'blockMutex' has been locked
+        std::atomic<u64> blockLockContentions{}; //!< The amount of times locking 'blockMutex' had to wait on another thread holding it
+
+        /**
+         * @brief Locks 'blockMutex' while counting the acquisition and if it was contended
+         */
+        std::unique_lock<std::mutex> LockBlocks() {
+            std::unique_lock lock(blockMutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                blockLockContentions.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+            }
+            blockLockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+            return lock;
+        }
 
         /**
          * @brief Maps a PA range into the given AS region
@@ -75,14 +92,28 @@ namespace skyline {
         FlatAddressSpaceMap() = default;
 
         void Map(VaType virt, PaType phys, VaType size, ExtraBlockInfo extraInfo = {}) {
-            std::scoped_lock lock(blockMutex);
+            auto lock{LockBlocks()};
             MapLocked(virt, phys, size, extraInfo);
         }
 
         void Unmap(VaType virt, VaType size) {
-            std::scoped_lock lock(blockMutex);
+            auto lock{LockBlocks()};
             UnmapLocked(virt, size);
         }
+
+        /**
+         * @return The amount of times the block list has been locked over the lifetime of the AS
+         */
+        u64 GetLockAcquisitions() const {
+            return blockLockAcquisitions.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The amount of times locking the block list had to wait on another thread over the lifetime of the AS
+         */
+        u64 GetLockContentions() const {
+            return blockLockContentions.load(std::memory_order_relaxed);
+        }
     };
 
     /**
@@ -94,18 +125,114 @@ namespace skyline {
 
     /**
      * @brief FlatMemoryManager specialises FlatAddressSpaceMap to focus on pointers as PAs, adding read/write functions and sparse mapping support
+     * @note A two-level page table mirrors the block list for pages which are fully mapped, this allows translations to be done without locking 'blockMutex' while the block list is only used for any other pages
      */
     template<typename VaType, VaType UnmappedVa, size_t AddressSpaceBits> requires AddressSpaceValid<VaType, AddressSpaceBits>
     class FlatMemoryManager : public FlatAddressSpaceMap<VaType, UnmappedVa, u8 *, nullptr, true, AddressSpaceBits, MemoryManagerBlockInfo> {
       private:
-        static constexpr u64 SparseMapSize{0x400000000}; //!< 16GiB pool size for sparse mappings returned by TranslateRange, this number is arbritary and should be large enough to fit the largest sparse mapping in the AS
-        u8 *sparseMap; //!< Pointer to a zero filled memory region that is returned by TranslateRange for sparse mappings
+        static constexpr u64 SparseMapSize{0x400000000}; //!< 16GiB pool size for sparse mappings returned by ForEachRange, this number is arbritary and should be large enough to fit the largest sparse mapping in the AS
+        u8 *sparseMap; //!< Pointer to a zero filled memory region that is returned by ForEachRange for sparse mappings
+
+        static constexpr size_t PageBits{12}; //!< The size of a page in the page table, this corresponds to the GPU small page size
+        static constexpr VaType PageSize{1ULL << PageBits};
+        static constexpr size_t LeafBits{14}; //!< The amount of VA bits translated by a single leaf table, each one covers 64MiB with 4KiB pages
+        static constexpr VaType LeafSize{PageSize << LeafBits};
+        static constexpr size_t RootBits{AddressSpaceBits - PageBits - LeafBits}; //!< The amount of VA bits translated by the root table
+        static_assert(AddressSpaceBits > PageBits + LeafBits && RootBits <= 16, "The address space is too large for a two-level page table");
+
+        /**
+         * @brief A table of host pointers for every page in a leaf's region, a page which isn't fully mapped or is sparse is null
+         * @note A leaf's region which is entirely mapped to contiguous host memory is represented by only its linear base, this avoids updating every page of large mappings
+         */
+        struct PageTableLeaf {
+            std::atomic<u8 *> linearBase; //!< The host pointer that the start of the leaf's region is mapped to if the entire region is contiguous, all page entries are null while this is set
+            std::array<std::atomic<u8 *>, 1ULL << LeafBits> pages;
+            size_t mappedPages; //!< The amount of page entries which aren't null, this is only accessed with 'blockMutex' locked
+        };
+
+        std::array<std::atomic<PageTableLeaf *>, 1ULL << RootBits> pageTable{}; //!< The root of the page table, leaves are allocated on the first map inside their region and only freed on destruction so lock-free readers can never observe a freed leaf
+
+        /**
+         * @return The host pointer to the start of the page containing the supplied address, this is null if the page isn't in the page table
+         * @note This doesn't require 'blockMutex' to be locked
+         */
+        u8 *LookupPage(VaType virt) {
+            if (virt >> AddressSpaceBits) [[unlikely]]
+                return nullptr;
+
+            auto leaf{pageTable[virt >> (PageBits + LeafBits)].load(std::memory_order_acquire)};
+            if (!leaf) [[unlikely]]
+                return nullptr;
+
+            if (auto linearBase{leaf->linearBase.load(std::memory_order_acquire)})
+                return linearBase + util::AlignDown(virt & (LeafSize - 1), PageSize);
+
+            return leaf->pages[(virt >> PageBits) & ((1ULL << LeafBits) - 1)].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Updates the page table entries for all pages overlapping the supplied region, only pages which are fully inside the region are mapped while all others are removed
+         * @note The region is updated in runs which cover as much of a leaf as possible, runs covering an entire leaf only update its linear base
+         * @param phys The host pointer the region is mapped to, this is null if the region is being unmapped or sparse mapped
+         * @note 'blockMutex' **must** be locked when calling this
+         */
+        void UpdatePageTable(VaType virt, VaType size, u8 *phys);
+
+        /**
+         * @return If the supplied host pointer is inside the zero-filled region that backs sparse mappings
+         */
+        bool IsSparse(u8 *phys) {
+            return phys >= sparseMap && phys < sparseMap + SparseMapSize;
+        }
+
+        /**
+         * @brief Calls the supplied function with all host ranges backing the given virtual range by walking the block list, this is used for any regions which aren't in the page table
+         * @note 'blockMutex' is locked while the function is called
+         */
+        template<typename Function>
+        void ForEachRangeSlow(VaType virt, VaType size, Function &&function) {
+            TRACE_EVENT("containers", "FlatMemoryManager::ForEachRangeSlow");
+
+            auto lock{this->LockBlocks()};
+
+            auto successor{std::upper_bound(this->blocks.begin(), this->blocks.end(), virt, [] (auto virt, const auto &block) {
+                return virt < block.virt;
+            })};
+            auto predecessor{std::prev(successor)};
+            VaType blockOffset{virt - predecessor->virt};
+
+            while (size) {
+                VaType blockSize{successor != this->blocks.end() ? std::min(successor->virt - predecessor->virt - blockOffset, size) : size};
+
+                u8 *blockPhys{};
+                if (predecessor->extraInfo.sparseMapped) {
+                    // Return a zeroed out map to emulate sparse mappings
+                    if (blockSize > SparseMapSize)
+                        throw exception("Size of the sparse map is too small to fit block of size: 0x{:X}", blockSize);
+                    blockPhys = sparseMap;
+                } else if (predecessor->Mapped()) {
+                    blockPhys = predecessor->phys + blockOffset;
+                }
+
+                function(span<u8>(blockPhys, blockSize));
+
+                size -= blockSize;
+                if (size) {
+                    predecessor = successor++;
+                    blockOffset = 0;
+                }
+            }
+        }
 
       public:
         FlatMemoryManager();
 
         ~FlatMemoryManager();
 
+        void Map(VaType virt, u8 *phys, VaType size, MemoryManagerBlockInfo extraInfo = {});
+
+        void Unmap(VaType virt, VaType size);
+
         /**
          * @return A placeholder address for sparse mapped regions, this means nothing
          */
@@ -114,9 +241,47 @@ namespace skyline {
         }
 
         /**
-         * @brief Returns a vector of all physical ranges inside of the given virtual range
+         * @brief Calls the supplied function with all host ranges backing the given virtual range in order without any allocations, ranges which are contiguous in host memory are merged
+         * @note Sparse ranges are backed by a zero-filled region which must not be written to and unmapped ranges have a null data pointer
+         * @note The function must not map or unmap memory in this address space as 'blockMutex' may be locked while it's called
          */
-        std::vector<span<u8>> TranslateRange(VaType virt, VaType size);
+        template<typename Function>
+        void ForEachRange(VaType virt, VaType size, Function &&function) {
+            span<u8> run{}; // Adjacent ranges are accumulated into a single run which is only passed to the function once it's no longer contiguous
+            auto append{[&](span<u8> range) {
+                if (run.data() && run.data() + run.size() == range.data()) {
+                    run = span<u8>(run.data(), run.size() + range.size());
+                } else {
+                    if (!run.empty())
+                        function(run);
+                    run = range;
+                }
+            }};
+
+            while (size) {
+                u8 *pagePhys{LookupPage(virt)};
+                if (!pagePhys) [[unlikely]] {
+                    ForEachRangeSlow(virt, size, append);
+                    break;
+                }
+
+                VaType pageOffset{virt & (PageSize - 1)};
+                VaType chunkSize{std::min(PageSize - pageOffset, size)};
+                append(span<u8>(pagePhys + pageOffset, chunkSize));
+
+                virt += chunkSize;
+                size -= chunkSize;
+            }
+
+            if (!run.empty())
+                function(run);
+        }
+
+        /**
+         * @return A span of the host memory backing the given virtual range if it's physically contiguous and fully mapped, otherwise an empty span
+         * @note This allows accessing the memory in-place, callers should fall back to Read/Write or ForEachRange for an empty span
+         */
+        span<u8> TranslateContiguous(VaType virt, VaType size);
 
         void Read(u8 *destination, VaType virt, VaType size);
 
@@ -147,14 +312,29 @@ namespace skyline {
 
 
     /**
-     * @brief FlatMemoryManager specialises FlatAddressSpaceMap to work as an allocator, with an initial, fast linear pass and a subsequent slower pass that iterates until it finds a free block
+     * @brief FlatAllocator specialises FlatAddressSpaceMap to work as an allocator, with an initial, fast linear pass and a best-fit search over a size-ordered index of free regions once that fails
+     * @note The free regions are tracked independently of the block list so allocations and frees are O(log n) in the amount of free regions regardless of fragmentation
      */
     template<typename VaType, VaType UnmappedVa, size_t AddressSpaceBits> requires AddressSpaceValid<VaType, AddressSpaceBits>
     class FlatAllocator : public FlatAddressSpaceMap<VaType, UnmappedVa, bool, false, false, AddressSpaceBits> {
       private:
         using Base = FlatAddressSpaceMap<VaType, UnmappedVa, bool, false, false, AddressSpaceBits>;
 
-        VaType currentLinearAllocEnd; //!< The end address for the initial linear allocation pass, once this reaches the AS limit the slower allocation path will be used
+        VaType currentLinearAllocEnd; //!< The end address of the last linear allocation, allocations are made linearly from here while the free region after it is large enough as this avoids reusing recently freed regions
+        std::map<VaType, VaType> freeRegions; //!< A map from the start to the end of every free region, adjacent free regions are always merged
+        std::set<std::pair<VaType, VaType>> freeRegionSizes; //!< A set of the size and start of every free region for best-fit allocation
+
+        /**
+         * @brief Marks the given region as free, merging it with any overlapping or adjacent free regions
+         * @note blockMutex MUST be locked when calling this
+         */
+        void InsertFreeRegion(VaType start, VaType end);
+
+        /**
+         * @brief Marks the given region as allocated, splitting any free regions which partially overlap it
+         * @note blockMutex MUST be locked when calling this
+         */
+        void EraseFreeRegion(VaType start, VaType end);
 
       public:
         VaType vaStart; //!< The base VA of the allocator, no allocations will be below this
@@ -163,6 +343,7 @@ namespace skyline {
 
         /**
          * @brief Allocates a region in the AS of the given size and returns its address
+         * @note The size must be non-zero
          */
         VaType Allocate(VaType size);
 
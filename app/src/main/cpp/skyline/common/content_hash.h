@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::util {
+    namespace detail {
+        constexpr u64 ContentHashPrime32_1{0x9E3779B1};
+        constexpr u64 ContentHashPrime64_1{0x9E3779B185EBCA87};
+        constexpr u64 ContentHashPrime64_2{0xC2B2AE3D27D4EB4F};
+        constexpr u64 ContentHashPrime64_3{0x165667B19E3779F9};
+        constexpr u64 ContentHashPrime64_4{0x85EBCA77C2B2AE63};
+        constexpr u64 ContentHashPrime64_5{0x27D4EB2F165667C5};
+
+        constexpr size_t ContentHashLanes{8}; //!< The amount of 64-bit accumulators, each of them is fed by one 64-bit word of a stripe
+        constexpr size_t ContentHashStripeSize{ContentHashLanes * sizeof(u64)}; //!< The amount of bytes consumed per iteration of the inner loop
+        constexpr size_t ContentHashBlockStripes{16}; //!< The amount of stripes after which the accumulators are scrambled
+
+        /**
+         * @brief The keys which are mixed into every stripe, the key of a lane is offset by the index of the stripe within a block
+         */
+        constexpr auto ContentHashSecret{[]() {
+            std::array<u64, ContentHashLanes + ContentHashBlockStripes> secret{};
+            u64 state{ContentHashPrime64_5};
+            for (auto &key : secret) {
+                // SplitMix64
+                u64 value{state += 0x9E3779B97F4A7C15};
+                value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+                value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+                key = value ^ (value >> 31);
+            }
+            return secret;
+        }()};
+
+        inline void ContentHashAccumulate(std::array<u64, ContentHashLanes> &accumulators, const u8 *stripe, size_t stripeIndex) {
+            for (size_t lane{}; lane < ContentHashLanes; lane++) {
+                u64 data;
+                std::memcpy(&data, stripe + (lane * sizeof(u64)), sizeof(u64));
+                u64 key{data ^ ContentHashSecret[lane + stripeIndex]};
+                accumulators[lane ^ 1] += data;
+                accumulators[lane] += (key & 0xFFFFFFFF) * (key >> 32);
+            }
+        }
+    }
+
+    /**
+     * @brief A fast non-cryptographic 64-bit hash for detecting if the contents of a large buffer have changed, it follows the structure of the XXH3 long-input loop
+     * @note The inner loop is written to be auto-vectorized into 32x32->64-bit multiply-accumulates on NEON or SSE2, it's not suitable for anything which requires resistance to collisions being deliberately created
+     */
+    inline u64 HashContent(span<const u8> buffer) {
+        using namespace detail;
+
+        std::array<u64, ContentHashLanes> accumulators{ContentHashPrime32_1, ContentHashPrime64_1, ContentHashPrime64_2, ContentHashPrime64_3, ContentHashPrime64_4, ContentHashPrime32_1 ^ ContentHashPrime64_2, ContentHashPrime64_5, ContentHashPrime32_1 * ContentHashPrime64_3};
+
+        const u8 *pointer{buffer.data()};
+        size_t stripeCount{buffer.size() / ContentHashStripeSize};
+        for (size_t stripe{}; stripe < stripeCount; stripe++, pointer += ContentHashStripeSize) {
+            ContentHashAccumulate(accumulators, pointer, stripe % ContentHashBlockStripes);
+
+            if ((stripe % ContentHashBlockStripes) == (ContentHashBlockStripes - 1)) {
+                // The accumulators are scrambled after every block to avoid the high bits of the products being lost to overflow
+                for (size_t lane{}; lane < ContentHashLanes; lane++) {
+                    auto &accumulator{accumulators[lane]};
+                    accumulator ^= accumulator >> 47;
+                    accumulator ^= ContentHashSecret[lane];
+                    accumulator *= ContentHashPrime32_1;
+                }
+            }
+        }
+
+        if (size_t remaining{buffer.size() % ContentHashStripeSize}) {
+            std::array<u8, ContentHashStripeSize> lastStripe{};
+            std::memcpy(lastStripe.data(), pointer, remaining);
+            ContentHashAccumulate(accumulators, lastStripe.data(), stripeCount % ContentHashBlockStripes);
+        }
+
+        u64 hash{buffer.size() * ContentHashPrime64_1};
+        for (size_t lane{}; lane < ContentHashLanes; lane += 2) {
+            auto product{static_cast<unsigned __int128>(accumulators[lane] ^ ContentHashSecret[lane + 1]) * (accumulators[lane + 1] ^ ContentHashSecret[lane + 2])};
+            hash += static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+        }
+
+        // XXH3 avalanche
+        hash ^= hash >> 37;
+        hash *= 0x165667919E3779F9;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A vector with a fixed capacity which stores all of its elements inline, it never allocates and is suited to containers with a known upper bound on their size
+     * @note Elements are default-initialized in the backing array, as such the type must be cheap to default construct
+     */
+    template<typename Type, size_t Capacity>
+    class InlineVector {
+      private:
+        std::array<Type, Capacity> array; //!< The backing storage, this is intentionally not value-initialized as only elements below 'count' are ever read
+        size_t count{};
+
+      public:
+        using value_type = Type;
+        using iterator = Type *;
+        using const_iterator = const Type *;
+
+        template<typename... Args>
+        Type &emplace_back(Args &&... args) {
+            if (count == Capacity) [[unlikely]]
+                throw exception("InlineVector capacity of {} has been exceeded", Capacity);
+            return array[count++] = Type(std::forward<Args>(args)...);
+        }
+
+        void push_back(const Type &value) {
+            emplace_back(value);
+        }
+
+        Type &operator[](size_t index) {
+            return array[index];
+        }
+
+        const Type &operator[](size_t index) const {
+            return array[index];
+        }
+
+        Type &at(size_t index) {
+            if (index >= count) [[unlikely]]
+                throw exception("InlineVector index {} is out of range for size {}", index, count);
+            return array[index];
+        }
+
+        const Type &at(size_t index) const {
+            if (index >= count) [[unlikely]]
+                throw exception("InlineVector index {} is out of range for size {}", index, count);
+            return array[index];
+        }
+
+        void clear() {
+            count = 0;
+        }
+
+        constexpr size_t size() const {
+            return count;
+        }
+
+        constexpr bool empty() const {
+            return count == 0;
+        }
+
+        constexpr static size_t capacity() {
+            return Capacity;
+        }
+
+        Type *data() {
+            return array.data();
+        }
+
+        iterator begin() {
+            return array.data();
+        }
+
+        iterator end() {
+            return array.data() + count;
+        }
+
+        const_iterator begin() const {
+            return array.data();
+        }
+
+        const_iterator end() const {
+            return array.data() + count;
+        }
+    };
+}
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <bit>
+#include <common/trace.h>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A bounded lock-free multi-producer single-consumer ring buffer, producers block when it's full and the consumer sleeps on a futex only when it's empty
+     * @note Producers reserve a contiguous run of slots with a single atomic operation and publish each slot individually, the consumer is woken at most once per batch
+     */
+    template<typename Type>
+    class MpscRing {
+      private:
+        struct Slot {
+            std::atomic<size_t> sequence; //!< The position of the item in this slot plus one, this is set after the item has been written to publish it
+            Type item;
+        };
+
+        static constexpr size_t CacheLineSize{64}; //!< The size of a cache line on all supported host CPUs, the producer and consumer positions are kept on separate lines to avoid false sharing
+
+        size_t capacity; //!< The amount of slots in the ring, this is always a power of two
+        std::unique_ptr<Slot[]> slots;
+
+        alignas(CacheLineSize) std::atomic<size_t> tail{}; //!< The position after the last reserved slot, producers atomically advance this to reserve slots
+        alignas(CacheLineSize) std::atomic<size_t> head{}; //!< The position of the next item to be consumed, all slots prior to it can be reused by producers
+        std::atomic<u32> consumerSleeping{}; //!< A futex word which is set while the consumer is (about to be) sleeping on it
+        std::atomic<u32> headSignal{}; //!< A futex word which is incremented after the consumer frees up a slot for producers waiting on it
+        std::atomic<u32> producersWaiting{}; //!< The amount of producers waiting for a free slot
+
+        std::atomic<size_t> maxDepth{}; //!< The maximum amount of items which have been queued at once
+        std::atomic<u64> produced{}; //!< The total amount of items which have been queued
+        std::atomic<u64> stalls{}; //!< The amount of times a producer had to wait for the consumer as the ring was full
+        std::atomic<u64> stallTime{}; //!< The total time in nanoseconds producers have spent waiting for the consumer
+
+        static void FutexWait(std::atomic<u32> &word, u32 expected) {
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        }
+
+        static void FutexWake(std::atomic<u32> &word, int count) {
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+        }
+
+        /**
+         * @brief Blocks the calling producer until the consumer has freed up at least a single slot
+         */
+        void WaitForSpace() {
+            TRACE_EVENT("containers", "MpscRing::WaitForSpace");
+            auto startTime{util::GetTimeNs()};
+
+            producersWaiting.fetch_add(1);
+            while (true) {
+                u32 signal{headSignal.load()};
+                if (tail.load() - head.load() < capacity)
+                    break;
+                FutexWait(headSignal, signal);
+            }
+            producersWaiting.fetch_sub(1);
+
+            stalls.fetch_add(1, std::memory_order_relaxed);
+            stallTime.fetch_add(util::GetTimeNs() - startTime, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Reserves up to the supplied amount of contiguous slots, this'll block if the ring is full
+         * @param position The position of the first reserved slot
+         * @return The amount of slots that were reserved, this'll always be at least one
+         */
+        size_t Reserve(size_t count, size_t &position) {
+            while (true) {
+                // The head is loaded prior to the tail which ensures it's never ahead of it, a stale head only underestimates the free space
+                size_t currentHead{head.load(std::memory_order_acquire)};
+                size_t current{tail.load(std::memory_order_relaxed)};
+                size_t used{current - currentHead};
+                if (used > capacity) [[unlikely]]
+                    continue; // Other producers have advanced the tail more than a full ring past our stale head, the free space would underflow so the head needs to be reloaded
+
+                size_t free{capacity - used};
+                if (!free) [[unlikely]] {
+                    WaitForSpace();
+                    continue;
+                }
+
+                size_t reserved{std::min(count, free)};
+                if (tail.compare_exchange_weak(current, current + reserved, std::memory_order_relaxed)) {
+                    position = current;
+                    return reserved;
+                }
+            }
+        }
+
+        /**
+         * @brief Queues a sequence of items in as few reservations as possible, the consumer is woken after each batch has been published
+         */
+        template<typename Iterator, typename Transformation>
+        void Produce(Iterator begin, Iterator end, Transformation transformation) {
+            while (begin != end) {
+                size_t position;
+                size_t count{Reserve(static_cast<size_t>(std::distance(begin, end)), position)};
+
+                for (size_t index{}; index < count; index++, begin++) {
+                    auto &slot{slots[(position + index) & (capacity - 1)]};
+                    slot.item = transformation(*begin);
+                    slot.sequence.store(position + index + 1, std::memory_order_release);
+                }
+
+                produced.fetch_add(count, std::memory_order_relaxed);
+                size_t currentHead{head.load(std::memory_order_relaxed)}, produceEnd{position + count};
+                size_t depth{produceEnd > currentHead ? produceEnd - currentHead : 0}; // The consumer may have already gone past our items
+                size_t previousMaxDepth{maxDepth.load(std::memory_order_relaxed)};
+                while (depth > previousMaxDepth && !maxDepth.compare_exchange_weak(previousMaxDepth, depth, std::memory_order_relaxed));
+
+                // This fence pairs with the consumer setting 'consumerSleeping' prior to checking for items, either it sees our items or we see it sleeping
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (consumerSleeping.load(std::memory_order_relaxed) && consumerSleeping.exchange(0))
+                    FutexWake(consumerSleeping, 1);
+            }
+        }
+
+      public:
+        /**
+         * @brief A snapshot of the state and statistics of the ring
+         */
+        struct Statistics {
+            size_t depth; //!< The amount of items which are currently queued
+            size_t maxDepth; //!< The maximum amount of items which have been queued at once
+            u64 produced; //!< The total amount of items which have been queued
+            u64 stalls; //!< The amount of times a producer had to wait for the consumer as the ring was full
+            u64 stallTime; //!< The total time in nanoseconds producers have spent waiting for the consumer
+        };
+
+        /**
+         * @note The capacity is rounded up to the next power of two
+         */
+        MpscRing(size_t size) : capacity(std::bit_ceil(std::max<size_t>(size, 1))), slots(std::make_unique<Slot[]>(capacity)) {}
+
+        MpscRing(const MpscRing &) = delete;
+
+        MpscRing &operator=(const MpscRing &) = delete;
+
+        /**
+         * @brief A blocking for-each that runs on every item and waits till new items to run on them as well
+         * @param function A function that is called for each item (with the only parameter as a reference to that item)
+         * @note Only a single thread may consume items from the ring
+         */
+        template<typename F>
+        [[noreturn]] void Process(F function) {
+            TRACE_EVENT_BEGIN("containers", "MpscRing::Process");
+
+            size_t position{head.load(std::memory_order_relaxed)};
+            while (true) {
+                auto &slot{slots[position & (capacity - 1)]};
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                    // We announce that we're going to sleep prior to rechecking the slot, a producer publishing after the recheck will see this and wake us
+                    consumerSleeping.store(1);
+                    if (slot.sequence.load() != position + 1) {
+                        TRACE_EVENT_END("containers");
+                        FutexWait(consumerSleeping, 1);
+                        TRACE_EVENT_BEGIN("containers", "MpscRing::Process");
+                    }
+                    consumerSleeping.store(0, std::memory_order_relaxed);
+                    continue;
+                }
+
+                function(slot.item);
+
+                head.store(++position);
+                if (producersWaiting.load()) [[unlikely]] {
+                    headSignal.fetch_add(1);
+                    FutexWake(headSignal, INT_MAX);
+                }
+            }
+        }
+
+        void Push(const Type &item) {
+            Produce(&item, &item + 1, [](const Type &item) -> const Type & { return item; });
+        }
+
+        void Append(span<Type> buffer) {
+            Produce(buffer.begin(), buffer.end(), [](const Type &item) -> const Type & { return item; });
+        }
+
+        /**
+         * @brief Appends a buffer with an alternative input type while supplied transformation function
+         * @param transformation A function that takes in an item of TransformedType as input and returns an item of Type
+         */
+        template<typename TransformedType, typename Transformation>
+        void AppendTransform(span<TransformedType> buffer, Transformation transformation) {
+            Produce(buffer.begin(), buffer.end(), transformation);
+        }
+
+        Statistics GetStatistics() const {
+            size_t currentHead{head.load(std::memory_order_relaxed)};
+            return Statistics{
+                .depth = tail.load(std::memory_order_relaxed) - currentHead,
+                .maxDepth = maxDepth.load(std::memory_order_relaxed),
+                .produced = produced.load(std::memory_order_relaxed),
+                .stalls = stalls.load(std::memory_order_relaxed),
+                .stallTime = stallTime.load(std::memory_order_relaxed),
+            };
+        }
+    };
+}
@@ -21,6 +21,12 @@ namespace skyline {
             PREF_ELEM("operation_mode", operationMode, element.attribute("value").as_bool()),
             PREF_ELEM("force_triple_buffering", forceTripleBuffering, element.attribute("value").as_bool()),
             PREF_ELEM("disable_frame_throttling", disableFrameThrottling, element.attribute("value").as_bool()),
+            PREF_ELEM("thread_pinning", threadPinningMode, static_cast<u8>(element.text().as_uint())),
+            PREF_ELEM("thread_pinning_map", threadPinningMap, element.text().as_string()),
+            PREF_ELEM("thread_priority_mapping", threadPriorityMapping, element.attribute("value").as_bool()),
+            PREF_ELEM("macro_jit", macroJit, element.attribute("value").as_bool()),
+            PREF_ELEM("ipc_profiling", ipcProfiling, element.attribute("value").as_bool()),
+            PREF_ELEM("ipc_capture", ipcCapture, element.attribute("value").as_bool()),
         };
 
         #undef PREF_ELEM
@@ -16,6 +16,12 @@ namespace skyline {
         bool operationMode; //!< If the emulated Switch should be handheld or docked
         bool forceTripleBuffering; //!< If the presentation engine should always triple buffer even if the swapchain supports double buffering
         bool disableFrameThrottling; //!< Allow the guest to submit frames without any blocking calls
+        u8 threadPinningMode; //!< The policy for pinning guest cores and dedicated host threads to host CPUs, it corresponds to kernel::HostAffinity::Mode
+        std::string threadPinningMap; //!< A map of host CPU sets for guest cores and dedicated host threads, this is only used in the custom pinning mode
+        bool threadPriorityMapping; //!< If guest thread priorities should be mapped onto host scheduling policies
+        bool macroJit; //!< If GPU macros should be compiled to host code rather than being interpreted
+        bool ipcProfiling; //!< If the IPC profiler should record HLE service commands from startup
+        bool ipcCapture; //!< If all HLE service requests and responses should be captured to a file for offline replay
 
         /**
          * @param fd An FD to the preference XML file
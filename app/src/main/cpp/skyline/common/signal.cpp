@@ -15,16 +15,25 @@ namespace skyline::signal {
 
     std::terminate_handler terminateHandler{};
 
+    /**
+     * @brief Calls the original termination handler after writing out any pending logs as this is the last point at which they can be
+     */
+    [[noreturn]] void Terminate() {
+        Logger::FlushActive();
+        terminateHandler();
+        __builtin_unreachable();
+    }
+
     inline StackFrame *SafeFrameRecurse(size_t depth, StackFrame *frame) {
         if (frame) {
             for (size_t it{}; it < depth; it++) {
                 if (frame->lr && frame->next)
                     frame = frame->next;
                 else
-                    terminateHandler();
+                    Terminate();
             }
         } else {
-            terminateHandler();
+            Terminate();
         }
         return frame;
     }
@@ -55,14 +64,14 @@ namespace skyline::signal {
                         frame = SafeFrameRecurse(2, lookupFrame);
                         hasAdvanced = true;
                     } else {
-                        terminateHandler(); // We presumably have no exception handlers left on the stack to consume the exception, it's time to quit
+                        Terminate(); // We presumably have no exception handlers left on the stack to consume the exception, it's time to quit
                     }
                 }
                 lookupFrame = lookupFrame->next;
             }
 
             if (!frame->next)
-                terminateHandler(); // We don't know the frame's stack boundaries, the only option is to quit
+                Terminate(); // We don't know the frame's stack boundaries, the only option is to quit
 
             asm("MOV SP, %x0\n\t" // Stack frame is the first item on a function's stack, it's used to calculate calling function's stack pointer
                 "MOV LR, %x1\n\t"
@@ -72,11 +81,12 @@ namespace skyline::signal {
 
             __builtin_unreachable();
         } else {
-            terminateHandler();
+            Terminate();
         }
     }
 
     void ExceptionalSignalHandler(int signal, siginfo *info, ucontext *context) {
+        // Pending logs aren't flushed here as draining them allocates and formats which isn't async-signal-safe, the catch sites write them out alongside the error and Terminate does so otherwise
         SignalException signalException;
         signalException.signal = signal;
         signalException.pc = reinterpret_cast<void *>(context->uc_mcontext.pc);
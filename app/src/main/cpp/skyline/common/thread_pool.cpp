@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "trace.h"
+#include "thread_pool.h"
+
+namespace skyline {
+    ThreadPool::ThreadPool(size_t threadCount, std::function<void()> threadInitializer) : threadInitializer(std::move(threadInitializer)) {
+        threads.reserve(threadCount);
+        for (size_t index{}; index < threadCount; index++)
+            threads.emplace_back(&ThreadPool::WorkerMain, this);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            exiting = true;
+        }
+        jobCondition.notify_all();
+
+        for (auto &thread : threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    void ThreadPool::RunChunks(Job &pJob) {
+        size_t index;
+        while ((index = pJob.next.fetch_add(1, std::memory_order_relaxed)) < pJob.count) {
+            pJob.function(index);
+            if (pJob.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(mutex); // The caller may be between checking the predicate and waiting on the condition, locking here ensures the notification can't be lost
+                completionCondition.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::WorkerMain() {
+        pthread_setname_np(pthread_self(), "ThreadPool");
+        if (threadInitializer)
+            threadInitializer();
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            std::shared_ptr<Job> currentJob;
+            jobCondition.wait(lock, [&]() {
+                currentJob = job;
+                return exiting || (currentJob && currentJob->next.load(std::memory_order_relaxed) < currentJob->count);
+            });
+            if (exiting)
+                return;
+
+            lock.unlock();
+            {
+                TRACE_EVENT("containers", "ThreadPool::RunChunks");
+                RunChunks(*currentJob);
+            }
+            lock.lock();
+        }
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &function) {
+        if (!count)
+            return;
+
+        if (threads.empty() || count == 1) {
+            for (size_t index{}; index < count; index++)
+                function(index);
+            return;
+        }
+
+        std::lock_guard jobLock(jobMutex);
+        auto currentJob{std::make_shared<Job>(function, count)};
+        {
+            std::lock_guard lock(mutex);
+            job = currentJob;
+        }
+        jobCondition.notify_all();
+
+        RunChunks(*currentJob);
+
+        std::unique_lock lock(mutex);
+        completionCondition.wait(lock, [&]() { return currentJob->remaining.load(std::memory_order_acquire) == 0; });
+        job = nullptr;
+    }
+}
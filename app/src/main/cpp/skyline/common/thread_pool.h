@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A pool of host threads for splitting up CPU-bound work such as texture conversion into independent chunks which are run in parallel
+     * @note Only a single job is run by the pool at a time, concurrent callers are serialized and the calling thread participates in running its own job
+     */
+    class ThreadPool {
+      private:
+        /**
+         * @brief A single call to ParallelFor, this is shared with the workers as they may still hold a reference to it after it's completed
+         */
+        struct Job {
+            const std::function<void(size_t)> &function;
+            size_t count; //!< The amount of chunks in the job
+            std::atomic<size_t> next{}; //!< The index of the next chunk which hasn't been started
+            std::atomic<size_t> remaining; //!< The amount of chunks which haven't been completed
+
+            Job(const std::function<void(size_t)> &function, size_t count) : function(function), count(count), remaining(count) {}
+        };
+
+        std::vector<std::thread> threads;
+        std::function<void()> threadInitializer; //!< A function which is called on every worker prior to it running any chunks
+        std::mutex jobMutex; //!< Serializes callers of ParallelFor as there's only a single job at a time
+        std::mutex mutex; //!< Synchronizes the job state between the caller and the workers
+        std::condition_variable jobCondition; //!< Signalled when a new job is available or the pool is being destroyed
+        std::condition_variable completionCondition; //!< Signalled when the last chunk of a job has been completed
+        std::shared_ptr<Job> job; //!< The current job, this is null when there's none
+        bool exiting{}; //!< If the pool is being destroyed and the workers should exit
+
+        /**
+         * @brief Runs chunks of the supplied job till there are none left
+         */
+        void RunChunks(Job &job);
+
+        void WorkerMain();
+
+      public:
+        /**
+         * @param threadCount The amount of workers in the pool, the calling thread of ParallelFor is an additional worker
+         * @param threadInitializer A function which is called on every worker when it starts, this can be used to apply host scheduling policies to the workers
+         */
+        ThreadPool(size_t threadCount, std::function<void()> threadInitializer = {});
+
+        ~ThreadPool();
+
+        /**
+         * @return The amount of threads that a job may be split across including the calling thread
+         */
+        size_t GetConcurrency() const {
+            return threads.size() + 1;
+        }
+
+        /**
+         * @brief Calls the supplied function for every index in the range [0, count) across all threads in the pool and waits for all of them to complete
+         * @note The function must not throw as there's no way to propagate exceptions from the workers
+         */
+        void ParallelFor(size_t count, const std::function<void(size_t)> &function);
+    };
+}
@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include <common/thread_pool.h>
 #include "gpu/memory_manager.h"
 #include "gpu/command_scheduler.h"
+#include "gpu/texture_manager.h"
 #include "gpu/presentation_engine.h"
+#include "gpu/texture_uploader.h"
 
 namespace skyline::gpu {
     /**
@@ -35,9 +38,12 @@ namespace skyline::gpu {
         std::mutex queueMutex; //!< Synchronizes access to the queue as it is externally synchronized
         vk::raii::Queue vkQueue; //!< A Vulkan Queue supporting graphics and compute operations
 
+        ThreadPool threadPool; //!< A pool of host threads which CPU-bound texture work such as deswizzling is split across
         memory::MemoryManager memory;
         CommandScheduler scheduler;
+        TextureManager texture;
         PresentationEngine presentation;
+        TextureUploader uploader; //!< The uploader must be destroyed prior to all other members as its thread uses them
 
         GPU(const DeviceState &state);
     };
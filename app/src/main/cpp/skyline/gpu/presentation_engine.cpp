@@ -9,6 +9,9 @@
 #include <gpu.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
+#include <kernel/host_affinity.h>
+#include <kernel/svc_statistics.h>
+#include <soc.h>
 #include "presentation_engine.h"
 #include "native_window.h"
 #include "texture/format.h"
@@ -27,6 +30,14 @@ namespace skyline::gpu {
     }
 
     PresentationEngine::~PresentationEngine() {
+        if (frametimeSampleCount > 1) {
+            // The frametime variance over the entire session is reported alongside the host affinity configuration to allow comparing runs with and without thread pinning
+            auto variance{frametimeSquaredDeviationNs / static_cast<double>(frametimeSampleCount - 1)};
+            state.logger->Info("Frametime over {} frames: {:.3f}ms mean, {:.3f}ms standard deviation (Thread Pinning: {})", frametimeSampleCount, frametimeMeanNs / constant::NsInMillisecond, std::sqrt(variance) / constant::NsInMillisecond, kernel::ToString(state.hostAffinity->GetMode()));
+            state.logger->Info("SVCs per frame: {} mean, {} max", frameSvcCount / frametimeSampleCount, maxSvcsPerFrame);
+            state.logger->Info("Contended GMMU locks per frame: {:.2f} mean, {} max", static_cast<double>(frameGmmuLockContentions) / static_cast<double>(frametimeSampleCount), maxGmmuLockContentionsPerFrame);
+        }
+
         auto env{state.jvm->GetEnv()};
         if (!env->IsSameObject(jSurface, nullptr))
             env->DeleteGlobalRef(jSurface);
@@ -58,6 +69,7 @@ namespace skyline::gpu {
 
     void PresentationEngine::ChoreographerThread() {
         pthread_setname_np(pthread_self(), "Skyline-Choreographer");
+        state.hostAffinity->PinHostThread(kernel::HostAffinity::HostThread::Choreographer);
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
             choreographerLooper = ALooper_prepare(0);
@@ -235,7 +247,11 @@ namespace skyline::gpu {
         }
 
         std::ignore = gpu.vkDevice.waitForFences(*acquireFence, true, std::numeric_limits<u64>::max());
-        images.at(nextImage.second)->CopyFrom(texture);
+        {
+            // The texture is only locked for the copy as the rest of presentation can block on the swapchain
+            std::scoped_lock textureLock(*texture);
+            images.at(nextImage.second)->CopyFrom(texture);
+        }
 
         if (timestamp) {
             // If the timestamp is specified, we need to convert it from the util::GetTimeNs base to the CLOCK_MONOTONIC one
@@ -295,14 +311,49 @@ namespace skyline::gpu {
 
             Fps = std::round(static_cast<float>(constant::NsInSecond) / averageFrametimeNs);
 
-            TRACE_EVENT_INSTANT("gpu", "Present", presentationTrack, "FrameTimeNs", now - frameTimestamp, "Fps", Fps);
+            frametimeSampleCount++;
+            auto meanDelta{static_cast<double>(currentFrametime) - frametimeMeanNs};
+            frametimeMeanNs += meanDelta / static_cast<double>(frametimeSampleCount);
+            frametimeSquaredDeviationNs += meanDelta * (static_cast<double>(currentFrametime) - frametimeMeanNs);
+
+            auto svcCount{kernel::svc::SvcStatistics::GetTotalCalls()};
+            auto svcsPerFrame{svcCount - lastSvcCount};
+            lastSvcCount = svcCount;
+            frameSvcCount += svcsPerFrame;
+            maxSvcsPerFrame = std::max(maxSvcsPerFrame, svcsPerFrame);
+
+            auto gpuCounters{SampleGpuCounters()};
+            auto gmmuLockContentionsPerFrame{gpuCounters.gmmuLockContentions - lastGpuCounters.gmmuLockContentions};
+            frameGmmuLockContentions += gmmuLockContentionsPerFrame;
+            maxGmmuLockContentionsPerFrame = std::max(maxGmmuLockContentionsPerFrame, gmmuLockContentionsPerFrame);
+
+            TRACE_EVENT_INSTANT("gpu", "Present", presentationTrack, "FrameTimeNs", now - frameTimestamp, "FrameTimeDeviationNs", currentFrametimeDeviation, "Fps", Fps, "SvcsPerFrame", svcsPerFrame,
+                                "DirectPushBuffersPerFrame", gpuCounters.directPushBuffers - lastGpuCounters.directPushBuffers,
+                                "CopiedPushBuffersPerFrame", gpuCounters.copiedPushBuffers - lastGpuCounters.copiedPushBuffers,
+                                "CopiedPushBufferBytesPerFrame", gpuCounters.copiedPushBufferBytes - lastGpuCounters.copiedPushBufferBytes,
+                                "GmmuLocksPerFrame", gpuCounters.gmmuLockAcquisitions - lastGpuCounters.gmmuLockAcquisitions,
+                                "GmmuLockContentionsPerFrame", gmmuLockContentionsPerFrame);
+            lastGpuCounters = gpuCounters;
 
             frameTimestamp = now;
         } else {
             frameTimestamp = util::GetTimeNs();
+            lastSvcCount = kernel::svc::SvcStatistics::GetTotalCalls();
+            lastGpuCounters = SampleGpuCounters();
         }
     }
 
+    PresentationEngine::GpuCounters PresentationEngine::SampleGpuCounters() {
+        auto &gm20b{state.soc->gm20b};
+        return GpuCounters{
+            .directPushBuffers = gm20b.pushBufferCounters.direct.load(std::memory_order_relaxed),
+            .copiedPushBuffers = gm20b.pushBufferCounters.copied.load(std::memory_order_relaxed),
+            .copiedPushBufferBytes = gm20b.pushBufferCounters.copiedBytes.load(std::memory_order_relaxed),
+            .gmmuLockAcquisitions = gm20b.gmmu.GetLockAcquisitions(),
+            .gmmuLockContentions = gm20b.gmmu.GetLockContentions(),
+        };
+    }
+
     NativeWindowTransform PresentationEngine::GetTransformHint() {
         std::unique_lock lock(mutex);
         surfaceCondition.wait(lock, [this]() { return vkSurface.has_value(); });
@@ -43,6 +43,26 @@ namespace skyline::gpu {
         i64 frameTimestamp{}; //!< The timestamp of the last frame being shown in nanoseconds
         i64 averageFrametimeNs{}; //!< The average time between frames in nanoseconds
         i64 averageFrametimeDeviationNs{}; //!< The average deviation of frametimes in nanoseconds
+        u64 frametimeSampleCount{}; //!< The amount of frametimes sampled over the lifetime of the presentation engine
+        double frametimeMeanNs{}; //!< The mean of all sampled frametimes in nanoseconds
+        double frametimeSquaredDeviationNs{}; //!< The sum of squared deviations from the mean of all sampled frametimes, the variance is derived from this with Welford's algorithm
+        u64 lastSvcCount{}; //!< The total amount of SVCs called by the guest as of the last frame
+        u64 frameSvcCount{}; //!< The total amount of SVCs called by the guest within all sampled frames
+        u64 maxSvcsPerFrame{}; //!< The highest amount of SVCs called by the guest within a single frame
+
+        /**
+         * @brief A sample of the lifetime totals of GPU counters, per-frame counts are derived from the difference between samples
+         */
+        struct GpuCounters {
+            u64 directPushBuffers;
+            u64 copiedPushBuffers;
+            u64 copiedPushBufferBytes;
+            u64 gmmuLockAcquisitions;
+            u64 gmmuLockContentions;
+        };
+        GpuCounters lastGpuCounters{}; //!< The GPU counters as of the last frame
+        u64 frameGmmuLockContentions{}; //!< The total amount of contended GMMU block list locks within all sampled frames
+        u64 maxGmmuLockContentionsPerFrame{}; //!< The highest amount of contended GMMU block list locks within a single frame
         perfetto::Track presentationTrack; //!< Perfetto track used for presentation events
 
         std::thread choreographerThread; //!< A thread for signalling the V-Sync event and measure the refresh cycle duration using AChoreographer
@@ -65,6 +85,11 @@ namespace skyline::gpu {
          */
         void UpdateSwapchain(texture::Format format, texture::Dimensions extent);
 
+        /**
+         * @return The current lifetime totals of the GPU counters
+         */
+        GpuCounters SampleGpuCounters();
+
       public:
         std::shared_ptr<kernel::type::KEvent> vsyncEvent; //!< Signalled every time a frame is drawn
 
@@ -85,7 +110,7 @@ namespace skyline::gpu {
          * @param scalingMode The mode by which the image must be scaled up to the surface
          * @param transform A transformation that should be performed on the image
          * @param frameId The ID of this frame for correlating it with presentation timing readouts
-         * @note The texture **must** be locked prior to calling this
+         * @note The texture **must not** be locked by the calling thread, it's only locked while it's being copied into the swapchain image
          */
         void Present(const std::shared_ptr<Texture> &texture, u64 timestamp, u64 swapInterval, service::hosbinder::AndroidRect crop, service::hosbinder::NativeWindowScalingMode scalingMode, service::hosbinder::NativeWindowTransform transform, u64 &frameId);
 
@@ -0,0 +1,808 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "decoder.h"
+
+// Reference on ASTC: https://registry.khronos.org/DataFormat/specs/1.3/dataformat.1.3.html#ASTC
+namespace skyline::gpu::texture::decoder {
+    namespace {
+        constexpr std::array<u8, 4> AstcErrorColor{0xFF, 0x00, 0xFF, 0xFF}; //!< The color which all texels of malformed or unsupported blocks decode to
+        constexpr size_t AstcMaxWeights{64}; //!< The maximum amount of weights in a single block
+        constexpr size_t AstcMaxColorValues{18}; //!< The maximum amount of color endpoint values in a single block
+
+        /**
+         * @brief A 128-bit ASTC block which bits can be extracted from at arbitrary positions
+         */
+        struct AstcBits {
+            u64 low, high;
+
+            static AstcBits Load(const u8 *block) {
+                AstcBits bits;
+                std::memcpy(&bits.low, block, sizeof(u64));
+                std::memcpy(&bits.high, block + sizeof(u64), sizeof(u64));
+                return bits;
+            }
+
+            /**
+             * @return A copy of the block with the order of all bits reversed, the weights are stored from the most significant bit downwards
+             */
+            AstcBits Reverse() const {
+                auto reverse64{[](u64 value) {
+                    value = ((value >> 1) & 0x5555555555555555) | ((value & 0x5555555555555555) << 1);
+                    value = ((value >> 2) & 0x3333333333333333) | ((value & 0x3333333333333333) << 2);
+                    value = ((value >> 4) & 0x0F0F0F0F0F0F0F0F) | ((value & 0x0F0F0F0F0F0F0F0F) << 4);
+                    return __builtin_bswap64(value);
+                }};
+                return AstcBits{reverse64(high), reverse64(low)};
+            }
+
+            /**
+             * @return The value of 'count' bits starting at 'start', any bits past the end of the block are zero
+             */
+            u32 Get(u32 start, u32 count) const {
+                if (!count || start >= 128)
+                    return 0;
+
+                u64 value;
+                if (start >= 64)
+                    value = high >> (start - 64);
+                else if (start == 0)
+                    value = low;
+                else
+                    value = (low >> start) | (high << (64 - start));
+                return static_cast<u32>(value & ((1ULL << count) - 1));
+            }
+        };
+
+        /**
+         * @brief A range of integers encoded with Integer Sequence Encoding, the amount of values in the range is '(trit ? 3 : quint ? 5 : 1) << bits'
+         */
+        struct IseRange {
+            u8 bits;
+            bool trit;
+            bool quint;
+
+            constexpr u32 GetBitCount(u32 count) const {
+                u32 bitCount{count * bits};
+                if (trit)
+                    bitCount += ((count * 8) + 4) / 5;
+                else if (quint)
+                    bitCount += ((count * 7) + 2) / 3;
+                return bitCount;
+            }
+        };
+
+        /**
+         * @brief A value decoded from an integer sequence, it consists of the trit/quint digit and the bits below it
+         */
+        struct IseValue {
+            u8 bits;
+            u8 digit; //!< The trit or quint, this is zero for ranges without either
+        };
+
+        /**
+         * @brief All ranges that color endpoints can be quantized to, ordered by increasing precision
+         */
+        constexpr std::array<IseRange, 21> ColorRanges{{
+            {1, false, false}, {0, true, false}, {2, false, false}, {0, false, true}, {1, true, false}, {3, false, false}, {1, false, true},
+            {2, true, false}, {4, false, false}, {2, false, true}, {3, true, false}, {5, false, false}, {3, false, true}, {4, true, false},
+            {6, false, false}, {4, false, true}, {5, true, false}, {7, false, false}, {5, false, true}, {6, true, false}, {8, false, false},
+        }};
+        constexpr size_t MinimumColorRange{4}; //!< The index of the least precise color range which is valid (0..5)
+
+        /**
+         * @brief All ranges that weights can be quantized to, indexed by the range bits of the block mode with the high-precision bit as the most significant bit
+         */
+        constexpr std::array<IseRange, 12> WeightRanges{{
+            {1, false, false}, {0, true, false}, {2, false, false}, {0, false, true}, {1, true, false}, {3, false, false},
+            {1, false, true}, {2, true, false}, {4, false, false}, {2, false, true}, {3, true, false}, {5, false, false},
+        }};
+
+        /**
+         * @brief Tables for decoding the packed trits of a block of five values and the packed quints of a block of three values
+         */
+        constexpr auto TritTable{[]() {
+            std::array<std::array<u8, 5>, 256> table{};
+            for (u32 packed{}; packed < table.size(); packed++) {
+                auto bit{[&](u32 index) { return (packed >> index) & 1; }};
+                u32 c, trit3, trit4;
+                if (((packed >> 2) & 0b111) == 0b111) {
+                    c = (((packed >> 5) & 0b111) << 2) | (packed & 0b11);
+                    trit4 = 2;
+                    trit3 = 2;
+                } else {
+                    c = packed & 0x1F;
+                    if (((packed >> 5) & 0b11) == 0b11) {
+                        trit4 = 2;
+                        trit3 = bit(7);
+                    } else {
+                        trit4 = bit(7);
+                        trit3 = (packed >> 5) & 0b11;
+                    }
+                }
+
+                u32 trit0, trit1, trit2;
+                auto cBit{[&](u32 index) { return (c >> index) & 1; }};
+                if ((c & 0b11) == 0b11) {
+                    trit2 = 2;
+                    trit1 = cBit(4);
+                    trit0 = (cBit(3) << 1) | (cBit(2) & ~cBit(3) & 1);
+                } else if (((c >> 2) & 0b11) == 0b11) {
+                    trit2 = 2;
+                    trit1 = 2;
+                    trit0 = c & 0b11;
+                } else {
+                    trit2 = cBit(4);
+                    trit1 = (c >> 2) & 0b11;
+                    trit0 = (cBit(1) << 1) | (cBit(0) & ~cBit(1) & 1);
+                }
+                table[packed] = {static_cast<u8>(trit0), static_cast<u8>(trit1), static_cast<u8>(trit2), static_cast<u8>(trit3), static_cast<u8>(trit4)};
+            }
+            return table;
+        }()};
+
+        constexpr auto QuintTable{[]() {
+            std::array<std::array<u8, 3>, 128> table{};
+            for (u32 packed{}; packed < table.size(); packed++) {
+                auto bit{[&](u32 index) { return (packed >> index) & 1; }};
+                u32 quint0, quint1, quint2;
+                if (((packed >> 1) & 0b11) == 0b11 && ((packed >> 5) & 0b11) == 0) {
+                    quint2 = (bit(0) << 2) | ((bit(4) & ~bit(0) & 1) << 1) | (bit(3) & ~bit(0) & 1);
+                    quint1 = 4;
+                    quint0 = 4;
+                } else {
+                    u32 c;
+                    if (((packed >> 1) & 0b11) == 0b11) {
+                        quint2 = 4;
+                        c = (((packed >> 3) & 0b11) << 3) | ((~(packed >> 5) & 0b11) << 1) | bit(0);
+                    } else {
+                        quint2 = (packed >> 5) & 0b11;
+                        c = packed & 0x1F;
+                    }
+
+                    if ((c & 0b111) == 0b101) {
+                        quint1 = 4;
+                        quint0 = (c >> 3) & 0b11;
+                    } else {
+                        quint1 = (c >> 3) & 0b11;
+                        quint0 = c & 0b111;
+                    }
+                }
+                table[packed] = {static_cast<u8>(quint0), static_cast<u8>(quint1), static_cast<u8>(quint2)};
+            }
+            return table;
+        }()};
+
+        /**
+         * @brief Decodes a sequence of integers from the supplied bits, any bits past 'start + range.GetBitCount(count)' are treated as zero
+         */
+        void DecodeIse(const AstcBits &data, u32 start, u32 count, IseRange range, IseValue *values) {
+            u32 end{start + range.GetBitCount(count)}, position{start};
+            auto read{[&](u32 bits) {
+                u32 available{position < end ? std::min(bits, end - position) : 0};
+                u32 value{data.Get(position, available)};
+                position += bits;
+                return value;
+            }};
+
+            if (range.trit) {
+                for (u32 index{}; index < count; index += 5) {
+                    std::array<u32, 5> bits{};
+                    u32 packed{};
+                    bits[0] = read(range.bits);
+                    packed |= read(2);
+                    bits[1] = read(range.bits);
+                    packed |= read(2) << 2;
+                    bits[2] = read(range.bits);
+                    packed |= read(1) << 4;
+                    bits[3] = read(range.bits);
+                    packed |= read(2) << 5;
+                    bits[4] = read(range.bits);
+                    packed |= read(1) << 7;
+
+                    for (u32 offset{}; offset < 5 && (index + offset) < count; offset++)
+                        values[index + offset] = {static_cast<u8>(bits[offset]), TritTable[packed][offset]};
+                }
+            } else if (range.quint) {
+                for (u32 index{}; index < count; index += 3) {
+                    std::array<u32, 3> bits{};
+                    u32 packed{};
+                    bits[0] = read(range.bits);
+                    packed |= read(3);
+                    bits[1] = read(range.bits);
+                    packed |= read(2) << 3;
+                    bits[2] = read(range.bits);
+                    packed |= read(2) << 5;
+
+                    for (u32 offset{}; offset < 3 && (index + offset) < count; offset++)
+                        values[index + offset] = {static_cast<u8>(bits[offset]), QuintTable[packed][offset]};
+                }
+            } else {
+                for (u32 index{}; index < count; index++)
+                    values[index] = {static_cast<u8>(read(range.bits)), 0};
+            }
+        }
+
+        /**
+         * @return The value with its bits replicated till it's 'targetBits' wide
+         */
+        constexpr u32 ReplicateBits(u32 value, u32 bits, u32 targetBits) {
+            if (!bits)
+                return 0;
+            u32 result{value}, resultBits{bits};
+            while (resultBits < targetBits) {
+                result = (result << bits) | value;
+                resultBits += bits;
+            }
+            return result >> (resultBits - targetBits);
+        }
+
+        /**
+         * @return A color endpoint value unquantized to the range 0..255
+         */
+        u8 UnquantizeColor(IseValue value, IseRange range) {
+            if (!range.trit && !range.quint)
+                return static_cast<u8>(ReplicateBits(value.bits, range.bits, 8));
+
+            u32 bits{value.bits};
+            u32 a{(bits & 1) ? 0x1FFU : 0U}, b{}, c{};
+            if (range.trit) {
+                switch (range.bits) {
+                    case 1:
+                        c = 204;
+                        break;
+                    case 2: {
+                        u32 bBit{(bits >> 1) & 1};
+                        b = (bBit << 8) | (bBit << 4) | (bBit << 2) | (bBit << 1);
+                        c = 93;
+                        break;
+                    }
+                    case 3: {
+                        u32 cb{(bits >> 1) & 0b11};
+                        b = (cb << 7) | (cb << 2) | cb;
+                        c = 44;
+                        break;
+                    }
+                    case 4: {
+                        u32 dcb{(bits >> 1) & 0b111};
+                        b = (dcb << 6) | dcb;
+                        c = 22;
+                        break;
+                    }
+                    case 5: {
+                        u32 edcb{(bits >> 1) & 0b1111};
+                        b = (edcb << 5) | (edcb >> 2);
+                        c = 11;
+                        break;
+                    }
+                    case 6: {
+                        u32 fedcb{(bits >> 1) & 0b11111};
+                        b = (fedcb << 4) | (fedcb >> 4);
+                        c = 5;
+                        break;
+                    }
+                }
+            } else {
+                switch (range.bits) {
+                    case 1:
+                        c = 113;
+                        break;
+                    case 2: {
+                        u32 bBit{(bits >> 1) & 1};
+                        b = (bBit << 8) | (bBit << 3) | (bBit << 2);
+                        c = 54;
+                        break;
+                    }
+                    case 3: {
+                        u32 cb{(bits >> 1) & 0b11};
+                        b = (cb << 7) | (cb << 1) | (cb >> 1);
+                        c = 26;
+                        break;
+                    }
+                    case 4: {
+                        u32 dcb{(bits >> 1) & 0b111};
+                        b = (dcb << 6) | (dcb >> 1);
+                        c = 13;
+                        break;
+                    }
+                    case 5: {
+                        u32 edcb{(bits >> 1) & 0b1111};
+                        b = (edcb << 5) | (edcb >> 3);
+                        c = 6;
+                        break;
+                    }
+                }
+            }
+
+            u32 t{(value.digit * c) + b};
+            t ^= a;
+            return static_cast<u8>((a & 0x80) | (t >> 2));
+        }
+
+        /**
+         * @return A weight unquantized to the range 0..64
+         */
+        u8 UnquantizeWeight(IseValue value, IseRange range) {
+            u32 result;
+            if (!range.trit && !range.quint) {
+                result = ReplicateBits(value.bits, range.bits, 6);
+            } else if (!range.bits) {
+                result = range.trit ? value.digit * 32U : value.digit * 16U;
+                return static_cast<u8>(result);
+            } else {
+                u32 bits{value.bits};
+                u32 a{(bits & 1) ? 0x7FU : 0U}, b{}, c{};
+                if (range.trit) {
+                    switch (range.bits) {
+                        case 1:
+                            c = 50;
+                            break;
+                        case 2: {
+                            u32 bBit{(bits >> 1) & 1};
+                            b = (bBit << 6) | (bBit << 2) | bBit;
+                            c = 23;
+                            break;
+                        }
+                        case 3: {
+                            u32 cb{(bits >> 1) & 0b11};
+                            b = (cb << 5) | cb;
+                            c = 11;
+                            break;
+                        }
+                    }
+                } else {
+                    switch (range.bits) {
+                        case 1:
+                            c = 28;
+                            break;
+                        case 2: {
+                            u32 bBit{(bits >> 1) & 1};
+                            b = (bBit << 6) | (bBit << 1);
+                            c = 13;
+                            break;
+                        }
+                    }
+                }
+
+                u32 t{(value.digit * c) + b};
+                t ^= a;
+                result = (a & 0x20) | (t >> 2);
+            }
+
+            return static_cast<u8>(result > 32 ? result + 1 : result);
+        }
+
+        /**
+         * @return The partition of a texel within a block, this is computed by hashing the partition index with the texel coordinates
+         */
+        u32 SelectPartition(u32 seed, u32 x, u32 y, u32 partitionCount, bool smallBlock) {
+            if (smallBlock) {
+                x <<= 1;
+                y <<= 1;
+            }
+
+            seed += (partitionCount - 1) * 1024;
+
+            u32 random{seed};
+            random ^= random >> 15;
+            random -= random << 17;
+            random += random << 7;
+            random += random << 4;
+            random ^= random >> 5;
+            random += random << 16;
+            random ^= random >> 7;
+            random ^= random >> 3;
+            random ^= random << 6;
+            random ^= random >> 17;
+
+            std::array<u32, 8> seeds{};
+            for (u32 index{}; index < seeds.size(); index++) {
+                u32 value{(random >> (index * 4)) & 0xF};
+                seeds[index] = value * value;
+            }
+
+            u32 shift1, shift2;
+            if (seed & 1) {
+                shift1 = (seed & 2) ? 4 : 5;
+                shift2 = (partitionCount == 3) ? 6 : 5;
+            } else {
+                shift1 = (partitionCount == 3) ? 6 : 5;
+                shift2 = (seed & 2) ? 4 : 5;
+            }
+
+            for (u32 index{}; index < seeds.size(); index++)
+                seeds[index] >>= (index & 1) ? shift2 : shift1;
+
+            // Only 2D blocks are supported, the Z-axis terms of the hash are always zero
+            u32 a{((seeds[0] * x) + (seeds[1] * y) + (random >> 14)) & 0x3F};
+            u32 b{((seeds[2] * x) + (seeds[3] * y) + (random >> 10)) & 0x3F};
+            u32 c{((seeds[4] * x) + (seeds[5] * y) + (random >> 6)) & 0x3F};
+            u32 d{((seeds[6] * x) + (seeds[7] * y) + (random >> 2)) & 0x3F};
+
+            if (partitionCount < 4)
+                d = 0;
+            if (partitionCount < 3)
+                c = 0;
+
+            if (a >= b && a >= c && a >= d)
+                return 0;
+            else if (b >= c && b >= d)
+                return 1;
+            else if (c >= d)
+                return 2;
+            else
+                return 3;
+        }
+
+        using Endpoint = std::array<i32, 4>;
+
+        void BitTransferSigned(i32 &a, i32 &b) {
+            b >>= 1;
+            b |= a & 0x80;
+            a >>= 1;
+            a &= 0x3F;
+            if (a & 0x20)
+                a -= 0x40;
+        }
+
+        Endpoint BlueContract(i32 red, i32 green, i32 blue, i32 alpha) {
+            return {(red + blue) >> 1, (green + blue) >> 1, blue, alpha};
+        }
+
+        Endpoint Clamp(Endpoint endpoint) {
+            for (auto &channel : endpoint)
+                channel = std::clamp(channel, 0, 0xFF);
+            return endpoint;
+        }
+
+        /**
+         * @brief Decodes the endpoints of a partition from its color values
+         * @return If the endpoint mode is supported, HDR endpoint modes aren't supported in the LDR profile
+         */
+        bool DecodeEndpoints(u32 mode, const u8 *values, Endpoint &endpoint0, Endpoint &endpoint1) {
+            std::array<i32, 8> v{};
+            for (u32 index{}; index < ((mode >> 2) + 1) * 2; index++)
+                v[index] = values[index];
+
+            switch (mode) {
+                case 0: // LDR Luminance, direct
+                    endpoint0 = {v[0], v[0], v[0], 0xFF};
+                    endpoint1 = {v[1], v[1], v[1], 0xFF};
+                    return true;
+
+                case 1: { // LDR Luminance, base + offset
+                    i32 luminance0{(v[0] >> 2) | (v[1] & 0xC0)};
+                    i32 luminance1{std::min(luminance0 + (v[1] & 0x3F), 0xFF)};
+                    endpoint0 = {luminance0, luminance0, luminance0, 0xFF};
+                    endpoint1 = {luminance1, luminance1, luminance1, 0xFF};
+                    return true;
+                }
+
+                case 4: // LDR Luminance + Alpha, direct
+                    endpoint0 = {v[0], v[0], v[0], v[2]};
+                    endpoint1 = {v[1], v[1], v[1], v[3]};
+                    return true;
+
+                case 5: // LDR Luminance + Alpha, base + offset
+                    BitTransferSigned(v[1], v[0]);
+                    BitTransferSigned(v[3], v[2]);
+                    endpoint0 = {v[0], v[0], v[0], v[2]};
+                    endpoint1 = Clamp({v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]});
+                    return true;
+
+                case 6: // LDR RGB, base + scale
+                    endpoint0 = {(v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, 0xFF};
+                    endpoint1 = {v[0], v[1], v[2], 0xFF};
+                    return true;
+
+                case 8: // LDR RGB, direct
+                    if ((v[1] + v[3] + v[5]) >= (v[0] + v[2] + v[4])) {
+                        endpoint0 = {v[0], v[2], v[4], 0xFF};
+                        endpoint1 = {v[1], v[3], v[5], 0xFF};
+                    } else {
+                        endpoint0 = BlueContract(v[1], v[3], v[5], 0xFF);
+                        endpoint1 = BlueContract(v[0], v[2], v[4], 0xFF);
+                    }
+                    return true;
+
+                case 9: // LDR RGB, base + offset
+                    BitTransferSigned(v[1], v[0]);
+                    BitTransferSigned(v[3], v[2]);
+                    BitTransferSigned(v[5], v[4]);
+                    if ((v[1] + v[3] + v[5]) >= 0) {
+                        endpoint0 = {v[0], v[2], v[4], 0xFF};
+                        endpoint1 = Clamp({v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF});
+                    } else {
+                        endpoint0 = Clamp(BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF));
+                        endpoint1 = BlueContract(v[0], v[2], v[4], 0xFF);
+                    }
+                    return true;
+
+                case 10: // LDR RGB, base + scale plus two A
+                    endpoint0 = {(v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, v[4]};
+                    endpoint1 = {v[0], v[1], v[2], v[5]};
+                    return true;
+
+                case 12: // LDR RGBA, direct
+                    if ((v[1] + v[3] + v[5]) >= (v[0] + v[2] + v[4])) {
+                        endpoint0 = {v[0], v[2], v[4], v[6]};
+                        endpoint1 = {v[1], v[3], v[5], v[7]};
+                    } else {
+                        endpoint0 = BlueContract(v[1], v[3], v[5], v[7]);
+                        endpoint1 = BlueContract(v[0], v[2], v[4], v[6]);
+                    }
+                    return true;
+
+                case 13: // LDR RGBA, base + offset
+                    BitTransferSigned(v[1], v[0]);
+                    BitTransferSigned(v[3], v[2]);
+                    BitTransferSigned(v[5], v[4]);
+                    BitTransferSigned(v[7], v[6]);
+                    if ((v[1] + v[3] + v[5]) >= 0) {
+                        endpoint0 = {v[0], v[2], v[4], v[6]};
+                        endpoint1 = Clamp({v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]});
+                    } else {
+                        endpoint0 = Clamp(BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]));
+                        endpoint1 = BlueContract(v[0], v[2], v[4], v[6]);
+                    }
+                    return true;
+
+                default: // HDR endpoint modes
+                    return false;
+            }
+        }
+
+        void FillErrorColor(u8 *output, u32 texelCount) {
+            for (u32 texel{}; texel < texelCount; texel++)
+                std::memcpy(output + (texel * 4), AstcErrorColor.data(), 4);
+        }
+
+        /**
+         * @brief Decodes a void-extent block which has a single constant color
+         */
+        void DecodeVoidExtent(const AstcBits &data, u8 *output, u32 texelCount) {
+            // HDR void-extent blocks aren't supported in the LDR profile and bits 10-11 must be set for 2D blocks
+            if (data.Get(9, 1) || data.Get(10, 2) != 0b11) {
+                FillErrorColor(output, texelCount);
+                return;
+            }
+
+            // The color is stored as 16-bit UNORM channels, the top 8 bits are the decoded value regardless of the decode mode
+            std::array<u8, 4> color{};
+            for (u32 channel{}; channel < 4; channel++)
+                color[channel] = static_cast<u8>(data.Get(64 + (channel * 16) + 8, 8));
+
+            for (u32 texel{}; texel < texelCount; texel++)
+                std::memcpy(output + (texel * 4), color.data(), 4);
+        }
+
+        /**
+         * @brief The parameters of a block as encoded in its block mode
+         */
+        struct BlockMode {
+            u32 gridWidth;
+            u32 gridHeight;
+            bool dualPlane;
+            IseRange weightRange;
+        };
+
+        /**
+         * @return If the block mode is valid (not reserved)
+         */
+        bool DecodeBlockMode(u32 bits, BlockMode &mode) {
+            u32 range, width, height;
+            bool highPrecision{((bits >> 9) & 1) != 0}, dualPlane{((bits >> 10) & 1) != 0};
+            u32 a{(bits >> 5) & 0b11};
+
+            if (bits & 0b11) {
+                range = ((bits >> 4) & 1) | ((bits & 0b11) << 1);
+                u32 b{(bits >> 7) & 0b11};
+                switch ((bits >> 2) & 0b11) {
+                    case 0:
+                        width = b + 4;
+                        height = a + 2;
+                        break;
+                    case 1:
+                        width = b + 8;
+                        height = a + 2;
+                        break;
+                    case 2:
+                        width = a + 2;
+                        height = b + 8;
+                        break;
+                    default:
+                        if (bits & 0x100) {
+                            width = (b & 1) + 2;
+                            height = a + 2;
+                        } else {
+                            width = a + 2;
+                            height = (b & 1) + 6;
+                        }
+                        break;
+                }
+            } else {
+                if ((bits & 0xF) == 0)
+                    return false;
+
+                range = ((bits >> 4) & 1) | (((bits >> 2) & 0b11) << 1);
+                switch ((bits >> 7) & 0b11) {
+                    case 0:
+                        width = 12;
+                        height = a + 2;
+                        break;
+                    case 1:
+                        width = a + 2;
+                        height = 12;
+                        break;
+                    case 2:
+                        width = a + 6;
+                        height = ((bits >> 9) & 0b11) + 6;
+                        highPrecision = false;
+                        dualPlane = false;
+                        break;
+                    default:
+                        if (a == 0) {
+                            width = 6;
+                            height = 10;
+                        } else if (a == 1) {
+                            width = 10;
+                            height = 6;
+                        } else {
+                            return false;
+                        }
+                        break;
+                }
+            }
+
+            if (range < 2)
+                return false;
+
+            mode = BlockMode{
+                .gridWidth = width,
+                .gridHeight = height,
+                .dualPlane = dualPlane,
+                .weightRange = WeightRanges[(highPrecision ? 6 : 0) + range - 2],
+            };
+            return true;
+        }
+    }
+
+    void DecodeAstcBlock(const u8 *block, u8 *output, const Format &format) {
+        u32 blockWidth{format.blockWidth}, blockHeight{format.blockHeight}, texelCount{blockWidth * blockHeight};
+        // sRGB and UNORM variants of every ASTC block size alternate in the VkFormat enumeration
+        bool srgb{((static_cast<u32>(format.vkFormat) - static_cast<u32>(vk::Format::eAstc4x4UnormBlock)) & 1) != 0};
+
+        auto data{AstcBits::Load(block)};
+        u32 blockModeBits{data.Get(0, 11)};
+        if ((blockModeBits & 0x1FF) == 0x1FC) {
+            DecodeVoidExtent(data, output, texelCount);
+            return;
+        }
+
+        BlockMode mode;
+        if (!DecodeBlockMode(blockModeBits, mode) || mode.gridWidth > blockWidth || mode.gridHeight > blockHeight) {
+            FillErrorColor(output, texelCount);
+            return;
+        }
+
+        u32 planeCount{mode.dualPlane ? 2U : 1U};
+        u32 weightCount{mode.gridWidth * mode.gridHeight * planeCount};
+        u32 weightBits{mode.weightRange.GetBitCount(weightCount)};
+        u32 partitionCount{data.Get(11, 2) + 1};
+        if (weightCount > AstcMaxWeights || weightBits < 24 || weightBits > 96 || (mode.dualPlane && partitionCount == 4)) {
+            FillErrorColor(output, texelCount);
+            return;
+        }
+
+        // Color endpoint modes
+        std::array<u32, 4> endpointModes{};
+        u32 partitionIndex{}, colorStart, extraModeBits{};
+        if (partitionCount == 1) {
+            endpointModes[0] = data.Get(13, 4);
+            colorStart = 17;
+        } else {
+            partitionIndex = data.Get(13, 10);
+            u32 modeBits{data.Get(23, 6)};
+            u32 selector{modeBits & 0b11};
+            if (selector == 0) {
+                for (u32 partition{}; partition < partitionCount; partition++)
+                    endpointModes[partition] = modeBits >> 2;
+            } else {
+                // The endpoint mode of each partition is encoded as a class offset from the base class and a mode within the class, the bits which don't fit are stored below the weights
+                extraModeBits = (3 * partitionCount) - 4;
+                u32 combined{(modeBits >> 2) | (data.Get(128 - weightBits - extraModeBits, extraModeBits) << 4)};
+                u32 baseClass{selector - 1};
+                for (u32 partition{}; partition < partitionCount; partition++) {
+                    u32 classOffset{(combined >> partition) & 1};
+                    u32 classMode{(combined >> (partitionCount + (partition * 2))) & 0b11};
+                    endpointModes[partition] = ((baseClass + classOffset) << 2) | classMode;
+                }
+            }
+            colorStart = 29;
+        }
+
+        u32 planeSelectorStart{128 - weightBits - extraModeBits - 2};
+        u32 colorPlaneComponent{mode.dualPlane ? data.Get(planeSelectorStart, 2) : 0};
+        i32 colorBits{static_cast<i32>(128 - weightBits - extraModeBits - (mode.dualPlane ? 2 : 0)) - static_cast<i32>(colorStart)};
+
+        u32 colorValueCount{};
+        for (u32 partition{}; partition < partitionCount; partition++)
+            colorValueCount += ((endpointModes[partition] >> 2) + 1) * 2;
+        if (colorValueCount > AstcMaxColorValues || colorBits <= 0) {
+            FillErrorColor(output, texelCount);
+            return;
+        }
+
+        // The color endpoints use the most precise range which fits into the remaining bits
+        size_t colorRange{ColorRanges.size()};
+        while (colorRange > 0 && ColorRanges[colorRange - 1].GetBitCount(colorValueCount) > static_cast<u32>(colorBits))
+            colorRange--;
+        if (colorRange == 0 || (colorRange - 1) < MinimumColorRange) {
+            FillErrorColor(output, texelCount);
+            return;
+        }
+        auto colorIseRange{ColorRanges[colorRange - 1]};
+
+        std::array<IseValue, AstcMaxColorValues> colorIse{};
+        DecodeIse(data, colorStart, colorValueCount, colorIseRange, colorIse.data());
+        std::array<u8, AstcMaxColorValues> colorValues{};
+        for (u32 index{}; index < colorValueCount; index++)
+            colorValues[index] = UnquantizeColor(colorIse[index], colorIseRange);
+
+        std::array<Endpoint, 4> endpoints0{}, endpoints1{};
+        for (u32 partition{}, offset{}; partition < partitionCount; partition++) {
+            if (!DecodeEndpoints(endpointModes[partition], colorValues.data() + offset, endpoints0[partition], endpoints1[partition])) {
+                FillErrorColor(output, texelCount);
+                return;
+            }
+            offset += ((endpointModes[partition] >> 2) + 1) * 2;
+        }
+
+        // Weights are stored in reverse bit order starting at the most significant bit of the block
+        std::array<IseValue, AstcMaxWeights> weightIse{};
+        DecodeIse(data.Reverse(), 0, weightCount, mode.weightRange, weightIse.data());
+        std::array<u8, (AstcMaxWeights + 16) * 2> gridWeights{}; // The padding allows the infill to read past the last row without any checks, those weights have a zero contribution
+        for (u32 index{}; index < weightCount; index++)
+            gridWeights[index] = UnquantizeWeight(weightIse[index], mode.weightRange);
+
+        // The weight grid is bilinearly infilled to the block dimensions
+        std::array<std::array<u8, BlockTexelLimit>, 2> texelWeights{};
+        u32 scaleX{(1024 + (blockWidth / 2)) / (blockWidth - 1)}, scaleY{(1024 + (blockHeight / 2)) / (blockHeight - 1)};
+        for (u32 y{}; y < blockHeight; y++) {
+            for (u32 x{}; x < blockWidth; x++) {
+                u32 gridX{(((scaleX * x) * (mode.gridWidth - 1)) + 32) >> 6}, gridY{(((scaleY * y) * (mode.gridHeight - 1)) + 32) >> 6};
+                u32 fractionX{gridX & 0xF}, fractionY{gridY & 0xF};
+                u32 weight11{((fractionX * fractionY) + 8) >> 4};
+                u32 weight10{fractionY - weight11}, weight01{fractionX - weight11}, weight00{16 - fractionX - fractionY + weight11};
+                u32 base{(gridX >> 4) + ((gridY >> 4) * mode.gridWidth)};
+
+                for (u32 plane{}; plane < planeCount; plane++) {
+                    auto weight{[&](u32 index) -> u32 { return gridWeights[(index * planeCount) + plane]; }};
+                    texelWeights[plane][(y * blockWidth) + x] = static_cast<u8>(((weight(base) * weight00) + (weight(base + 1) * weight01) + (weight(base + mode.gridWidth) * weight10) + (weight(base + mode.gridWidth + 1) * weight11) + 8) >> 4);
+                }
+            }
+        }
+
+        bool smallBlock{texelCount < 31};
+        for (u32 y{}; y < blockHeight; y++) {
+            for (u32 x{}; x < blockWidth; x++) {
+                u32 texel{(y * blockWidth) + x};
+                u32 partition{partitionCount > 1 ? SelectPartition(partitionIndex, x, y, partitionCount, smallBlock) : 0};
+                const auto &endpoint0{endpoints0[partition]}, &endpoint1{endpoints1[partition]};
+
+                for (u32 channel{}; channel < 4; channel++) {
+                    u32 weight{texelWeights[(mode.dualPlane && channel == colorPlaneComponent) ? 1 : 0][texel]};
+                    u32 value0{static_cast<u32>(endpoint0[channel]) << 8}, value1{static_cast<u32>(endpoint1[channel]) << 8};
+                    if (srgb) {
+                        value0 |= 0x80;
+                        value1 |= 0x80;
+                    } else {
+                        value0 |= static_cast<u32>(endpoint0[channel]);
+                        value1 |= static_cast<u32>(endpoint1[channel]);
+                    }
+                    output[(texel * 4) + channel] = static_cast<u8>((((value0 * (64 - weight)) + (value1 * weight) + 32) >> 6) >> 8);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "decoder.h"
+
+namespace skyline::gpu::texture::decoder {
+    namespace {
+        constexpr size_t BcBlockTexels{16}; //!< The amount of texels in a single 4x4 BCn block
+
+        u64 LoadU64(const u8 *pointer) {
+            u64 value;
+            std::memcpy(&value, pointer, sizeof(u64));
+            return value;
+        }
+
+        /**
+         * @brief Decodes the color part of a BC1/BC2/BC3 block into the RGB channels of the output texels
+         * @param allowPunchThrough If the 3-color mode with a transparent black texel can be used (BC1), BC2 and BC3 always use the 4-color mode
+         */
+        void DecodeColorBlock(const u8 *block, u8 *output, bool allowPunchThrough) {
+            u16 color0{static_cast<u16>(block[0] | (block[1] << 8))}, color1{static_cast<u16>(block[2] | (block[3] << 8))};
+            u32 indices{static_cast<u32>(block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24))};
+
+            auto expand{[](u32 color) -> std::array<u32, 3> {
+                u32 red{(color >> 11) & 0x1F}, green{(color >> 5) & 0x3F}, blue{color & 0x1F};
+                return {(red << 3) | (red >> 2), (green << 2) | (green >> 4), (blue << 3) | (blue >> 2)};
+            }};
+
+            std::array<std::array<u8, 4>, 4> palette{};
+            auto endpoint0{expand(color0)}, endpoint1{expand(color1)};
+            bool fourColor{!allowPunchThrough || color0 > color1};
+            for (size_t channel{}; channel < 3; channel++) {
+                u32 value0{endpoint0[channel]}, value1{endpoint1[channel]};
+                palette[0][channel] = static_cast<u8>(value0);
+                palette[1][channel] = static_cast<u8>(value1);
+                if (fourColor) {
+                    palette[2][channel] = static_cast<u8>((2 * value0 + value1) / 3);
+                    palette[3][channel] = static_cast<u8>((value0 + 2 * value1) / 3);
+                } else {
+                    palette[2][channel] = static_cast<u8>((value0 + value1) / 2);
+                    palette[3][channel] = 0;
+                }
+            }
+            palette[0][3] = palette[1][3] = palette[2][3] = 0xFF;
+            palette[3][3] = fourColor ? 0xFF : 0;
+
+            for (size_t texel{}; texel < BcBlockTexels; texel++, indices >>= 2)
+                std::memcpy(output + (texel * 4), palette[indices & 0b11].data(), 4);
+        }
+
+        /**
+         * @brief Decodes a BC4 block (also used for the alpha of BC3 and both channels of BC5) into a single channel of the output texels
+         */
+        void DecodeChannelBlock(const u8 *block, u8 *output, size_t channel) {
+            u32 value0{block[0]}, value1{block[1]};
+            u64 indices{LoadU64(block) >> 16};
+
+            std::array<u8, 8> palette{static_cast<u8>(value0), static_cast<u8>(value1)};
+            if (value0 > value1) {
+                for (u32 index{1}; index < 7; index++)
+                    palette[index + 1] = static_cast<u8>(((7 - index) * value0 + index * value1) / 7);
+            } else {
+                for (u32 index{1}; index < 5; index++)
+                    palette[index + 1] = static_cast<u8>(((5 - index) * value0 + index * value1) / 5);
+                palette[6] = 0;
+                palette[7] = 0xFF;
+            }
+
+            for (size_t texel{}; texel < BcBlockTexels; texel++, indices >>= 3)
+                output[(texel * 4) + channel] = palette[indices & 0b111];
+        }
+    }
+
+    void DecodeBc1Block(const u8 *block, u8 *output, const Format &) {
+        DecodeColorBlock(block, output, true);
+    }
+
+    void DecodeBc2Block(const u8 *block, u8 *output, const Format &) {
+        DecodeColorBlock(block + 8, output, false);
+        u64 alpha{LoadU64(block)};
+        for (size_t texel{}; texel < BcBlockTexels; texel++, alpha >>= 4)
+            output[(texel * 4) + 3] = static_cast<u8>((alpha & 0xF) * 0x11);
+    }
+
+    void DecodeBc3Block(const u8 *block, u8 *output, const Format &) {
+        DecodeColorBlock(block + 8, output, false);
+        DecodeChannelBlock(block, output, 3);
+    }
+
+    void DecodeBc4Block(const u8 *block, u8 *output, const Format &) {
+        for (size_t texel{}; texel < BcBlockTexels; texel++)
+            std::memcpy(output + (texel * 4), std::array<u8, 4>{0, 0, 0, 0xFF}.data(), 4);
+        DecodeChannelBlock(block, output, 0);
+    }
+
+    void DecodeBc5Block(const u8 *block, u8 *output, const Format &) {
+        for (size_t texel{}; texel < BcBlockTexels; texel++)
+            std::memcpy(output + (texel * 4), std::array<u8, 4>{0, 0, 0, 0xFF}.data(), 4);
+        DecodeChannelBlock(block, output, 0);
+        DecodeChannelBlock(block + 8, output, 1);
+    }
+
+    namespace {
+        /**
+         * @brief The properties of a BC7 mode, as covered in the BC7 format specification
+         */
+        struct Bc7Mode {
+            u8 subsetCount;
+            u8 partitionBits;
+            u8 rotationBits;
+            u8 indexSelectionBits;
+            u8 colorBits; //!< The precision of the color channels of the endpoints excluding the P-bit
+            u8 alphaBits; //!< The precision of the alpha channel of the endpoints excluding the P-bit, this is 0 for modes without alpha
+            u8 endpointPBits; //!< If each endpoint has a unique P-bit
+            u8 sharedPBits; //!< If each subset has a P-bit shared between its endpoints
+            u8 indexBits;
+            u8 secondaryIndexBits; //!< The precision of the secondary set of indices, this is 0 for modes which only have a single set
+        };
+
+        constexpr std::array<Bc7Mode, 8> Bc7Modes{{
+            {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+            {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+            {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+            {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+            {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+            {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+            {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+            {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+        }};
+
+        /**
+         * @brief The subset of every texel for each of the 64 two-subset partitions, bit N is the subset of texel N
+         */
+        constexpr std::array<u16, 64> Bc7Partitions2{
+            0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+            0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+            0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+            0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+            0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+            0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+            0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+            0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+        };
+
+        /**
+         * @brief The subset of every texel for each of the 64 three-subset partitions, bits 2N and 2N + 1 are the subset of texel N
+         */
+        constexpr std::array<u32, 64> Bc7Partitions3{
+            0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+            0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+            0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+            0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+            0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+            0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+            0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+            0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+        };
+
+        /**
+         * @brief The anchor texel of the second subset for each two-subset partition, the anchor of the first subset is always texel 0
+         */
+        constexpr std::array<u8, 64> Bc7Anchors2{
+            15, 15, 15, 15, 15, 15, 15, 15,
+            15, 15, 15, 15, 15, 15, 15, 15,
+            15, 2, 8, 2, 2, 8, 8, 15,
+            2, 8, 2, 2, 8, 8, 2, 2,
+            15, 15, 6, 8, 2, 8, 15, 15,
+            2, 8, 2, 2, 2, 15, 15, 6,
+            6, 2, 6, 8, 15, 15, 2, 2,
+            15, 15, 15, 15, 15, 2, 2, 15,
+        };
+
+        /**
+         * @brief The anchor texel of the second subset for each three-subset partition
+         */
+        constexpr std::array<u8, 64> Bc7Anchors3Second{
+            3, 3, 15, 15, 8, 3, 15, 15,
+            8, 8, 6, 6, 6, 5, 3, 3,
+            3, 3, 8, 15, 3, 3, 6, 10,
+            5, 8, 8, 6, 8, 5, 15, 15,
+            8, 15, 3, 5, 6, 10, 8, 15,
+            15, 3, 15, 5, 15, 15, 15, 15,
+            3, 15, 5, 5, 5, 8, 5, 10,
+            5, 10, 8, 13, 15, 12, 3, 3,
+        };
+
+        /**
+         * @brief The anchor texel of the third subset for each three-subset partition
+         */
+        constexpr std::array<u8, 64> Bc7Anchors3Third{
+            15, 8, 8, 3, 15, 15, 3, 8,
+            15, 15, 15, 15, 15, 15, 15, 8,
+            15, 8, 15, 3, 15, 8, 15, 8,
+            3, 15, 6, 10, 15, 15, 10, 8,
+            15, 3, 15, 10, 10, 8, 9, 10,
+            6, 15, 8, 15, 3, 6, 6, 8,
+            15, 3, 15, 15, 15, 15, 15, 15,
+            15, 15, 15, 15, 3, 15, 15, 8,
+        };
+
+        constexpr std::array<u8, 4> Bc7Weights2{0, 21, 43, 64};
+        constexpr std::array<u8, 8> Bc7Weights3{0, 9, 18, 27, 37, 46, 55, 64};
+        constexpr std::array<u8, 16> Bc7Weights4{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        constexpr const u8 *GetBc7Weights(u8 indexBits) {
+            switch (indexBits) {
+                case 2:
+                    return Bc7Weights2.data();
+                case 3:
+                    return Bc7Weights3.data();
+                default:
+                    return Bc7Weights4.data();
+            }
+        }
+
+        /**
+         * @brief A reader for consuming a 128-bit block as a little-endian bitstream
+         */
+        class BitReader {
+          private:
+            u64 low, high;
+
+          public:
+            BitReader(const u8 *block) : low(LoadU64(block)), high(LoadU64(block + 8)) {}
+
+            u32 Read(u32 count) {
+                u32 value{static_cast<u32>(low & ((1ULL << count) - 1))};
+                low = (low >> count) | (count ? (high << (64 - count)) : 0);
+                high >>= count;
+                return value;
+            }
+        };
+    }
+
+    void DecodeBc7Block(const u8 *block, u8 *output, const Format &) {
+        BitReader reader{block};
+
+        u32 modeIndex{};
+        while (modeIndex < Bc7Modes.size() && !reader.Read(1))
+            modeIndex++;
+        if (modeIndex == Bc7Modes.size()) {
+            // Reserved modes decode to transparent black
+            std::memset(output, 0, BcBlockTexels * 4);
+            return;
+        }
+
+        const auto &mode{Bc7Modes[modeIndex]};
+        u32 partition{reader.Read(mode.partitionBits)};
+        u32 rotation{reader.Read(mode.rotationBits)};
+        u32 indexSelection{reader.Read(mode.indexSelectionBits)};
+
+        constexpr size_t MaxEndpoints{6};
+        std::array<std::array<u32, 4>, MaxEndpoints> endpoints{};
+        size_t endpointCount{static_cast<size_t>(mode.subsetCount) * 2};
+        for (size_t channel{}; channel < 3; channel++)
+            for (size_t endpoint{}; endpoint < endpointCount; endpoint++)
+                endpoints[endpoint][channel] = reader.Read(mode.colorBits);
+        for (size_t endpoint{}; endpoint < endpointCount; endpoint++)
+            endpoints[endpoint][3] = mode.alphaBits ? reader.Read(mode.alphaBits) : 0xFF;
+
+        u8 colorBits{mode.colorBits}, alphaBits{mode.alphaBits};
+        if (mode.endpointPBits || mode.sharedPBits) {
+            std::array<u32, MaxEndpoints> pBits{};
+            if (mode.endpointPBits) {
+                for (size_t endpoint{}; endpoint < endpointCount; endpoint++)
+                    pBits[endpoint] = reader.Read(1);
+            } else {
+                for (size_t subset{}; subset < mode.subsetCount; subset++)
+                    pBits[subset * 2] = pBits[(subset * 2) + 1] = reader.Read(1);
+            }
+
+            for (size_t endpoint{}; endpoint < endpointCount; endpoint++)
+                for (size_t channel{}; channel < (alphaBits ? 4 : 3); channel++)
+                    endpoints[endpoint][channel] = (endpoints[endpoint][channel] << 1) | pBits[endpoint];
+            colorBits++;
+            if (alphaBits)
+                alphaBits++;
+        }
+
+        // Endpoints are expanded to 8 bits by replicating their most significant bits into the low bits
+        for (size_t endpoint{}; endpoint < endpointCount; endpoint++) {
+            for (size_t channel{}; channel < 4; channel++) {
+                u8 bits{channel == 3 ? alphaBits : colorBits};
+                if (!bits)
+                    continue;
+                auto &value{endpoints[endpoint][channel]};
+                value = (value << (8 - bits)) | (value >> ((2 * bits) - 8));
+            }
+        }
+
+        std::array<u8, BcBlockTexels> subsets{};
+        if (mode.subsetCount == 2) {
+            for (size_t texel{}; texel < BcBlockTexels; texel++)
+                subsets[texel] = (Bc7Partitions2[partition] >> texel) & 0b1;
+        } else if (mode.subsetCount == 3) {
+            for (size_t texel{}; texel < BcBlockTexels; texel++)
+                subsets[texel] = (Bc7Partitions3[partition] >> (texel * 2)) & 0b11;
+        }
+
+        auto isAnchor{[&](size_t texel) {
+            if (texel == 0)
+                return true;
+            if (mode.subsetCount == 2)
+                return texel == Bc7Anchors2[partition];
+            if (mode.subsetCount == 3)
+                return texel == Bc7Anchors3Second[partition] || texel == Bc7Anchors3Third[partition];
+            return false;
+        }};
+
+        // Anchor texels have their most significant index bit omitted as it's implicitly zero
+        std::array<u8, BcBlockTexels> indices{}, secondaryIndices{};
+        for (size_t texel{}; texel < BcBlockTexels; texel++)
+            indices[texel] = static_cast<u8>(reader.Read(mode.indexBits - (isAnchor(texel) ? 1 : 0)));
+        if (mode.secondaryIndexBits)
+            for (size_t texel{}; texel < BcBlockTexels; texel++)
+                secondaryIndices[texel] = static_cast<u8>(reader.Read(mode.secondaryIndexBits - (texel == 0 ? 1 : 0)));
+
+        const u8 *colorWeights{GetBc7Weights(mode.indexBits)}, *alphaWeights{colorWeights};
+        const u8 *colorIndices{indices.data()}, *alphaIndices{indices.data()};
+        if (mode.secondaryIndexBits) {
+            alphaWeights = GetBc7Weights(mode.secondaryIndexBits);
+            alphaIndices = secondaryIndices.data();
+            if (indexSelection) {
+                std::swap(colorWeights, alphaWeights);
+                std::swap(colorIndices, alphaIndices);
+            }
+        }
+
+        for (size_t texel{}; texel < BcBlockTexels; texel++) {
+            const auto &endpoint0{endpoints[subsets[texel] * 2]}, &endpoint1{endpoints[(subsets[texel] * 2) + 1]};
+            u32 colorWeight{colorWeights[colorIndices[texel]]}, alphaWeight{alphaWeights[alphaIndices[texel]]};
+
+            std::array<u8, 4> color;
+            for (size_t channel{}; channel < 4; channel++) {
+                u32 weight{channel == 3 ? alphaWeight : colorWeight};
+                color[channel] = static_cast<u8>((((64 - weight) * endpoint0[channel]) + (weight * endpoint1[channel]) + 32) >> 6);
+            }
+
+            // The rotation swaps the alpha channel with one of the color channels after interpolation
+            if (rotation)
+                std::swap(color[3], color[rotation - 1]);
+
+            std::memcpy(output + (texel * 4), color.data(), 4);
+        }
+    }
+}
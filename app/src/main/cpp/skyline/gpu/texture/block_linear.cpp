@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <common/trace.h>
+#include "block_linear.h"
+
+namespace skyline::gpu::texture {
+    namespace {
+        constexpr u32 SectorWidth{16}; //!< The width of a sector in bytes, all sectors are a single line tall
+        constexpr u32 GobSectorCount{BlockLinear::GobSize / SectorWidth}; //!< The amount of sectors in a GOB
+
+        constexpr u32 DivideCeil(u32 value, u32 divisor) {
+            return (value + divisor - 1) / divisor;
+        }
+
+        /**
+         * @return The X-axis offset in bytes of a sector within a GOB
+         */
+        constexpr u32 SectorX(u32 index) {
+            return ((index << 3) & 0b10000) | ((index << 1) & 0b100000);
+        }
+
+        /**
+         * @return The Y-axis offset in lines of a sector within a GOB
+         */
+        constexpr u32 SectorY(u32 index) {
+            return ((index >> 1) & 0b110) | (index & 0b1);
+        }
+
+        /**
+         * @brief Moves an entire GOB between block-linear and linear memory with 128-bit vector loads and stores
+         * @note A GOB is made up of eight 64-byte chunks, each covering a 32x2 byte region with the sectors ordered as (0, 0), (0, 1), (16, 0), (16, 1) within it
+         */
+        template<bool ToBlockLinear>
+        void CopyGob(u8 *gob, u8 *linear, size_t pitch) {
+            for (u32 chunk{}; chunk < GobSectorCount / 4; chunk++) {
+                u8 *chunkGob{gob + (chunk * 4 * SectorWidth)};
+                u8 *line{linear + (SectorY(chunk * 4) * pitch) + SectorX(chunk * 4)};
+
+                #if defined(__ARM_NEON)
+                if constexpr (ToBlockLinear) {
+                    vst1q_u8_x4(chunkGob, uint8x16x4_t{vld1q_u8(line), vld1q_u8(line + pitch), vld1q_u8(line + SectorWidth), vld1q_u8(line + pitch + SectorWidth)});
+                } else {
+                    auto sectors{vld1q_u8_x4(chunkGob)};
+                    vst1q_u8(line, sectors.val[0]);
+                    vst1q_u8(line + pitch, sectors.val[1]);
+                    vst1q_u8(line + SectorWidth, sectors.val[2]);
+                    vst1q_u8(line + pitch + SectorWidth, sectors.val[3]);
+                }
+                #elif defined(__SSE2__)
+                auto chunkVectors{reinterpret_cast<__m128i *>(chunkGob)};
+                std::array<u8 *, 4> lineSectors{line, line + pitch, line + SectorWidth, line + pitch + SectorWidth};
+                for (size_t sector{}; sector < lineSectors.size(); sector++) {
+                    auto lineVector{reinterpret_cast<__m128i *>(lineSectors[sector])};
+                    if constexpr (ToBlockLinear)
+                        _mm_storeu_si128(chunkVectors + sector, _mm_loadu_si128(lineVector));
+                    else
+                        _mm_storeu_si128(lineVector, _mm_loadu_si128(chunkVectors + sector));
+                }
+                #else
+                std::array<u8 *, 4> lineSectors{line, line + pitch, line + SectorWidth, line + pitch + SectorWidth};
+                for (size_t sector{}; sector < lineSectors.size(); sector++) {
+                    if constexpr (ToBlockLinear)
+                        std::memcpy(chunkGob + (sector * SectorWidth), lineSectors[sector], SectorWidth);
+                    else
+                        std::memcpy(lineSectors[sector], chunkGob + (sector * SectorWidth), SectorWidth);
+                }
+                #endif
+            }
+        }
+
+        /**
+         * @brief Moves the part of a GOB which lies within the bounds of the surface between block-linear and linear memory, this is used for GOBs on the right and bottom edges of the surface
+         * @param width The width of the region within the GOB in bytes
+         * @param height The height of the region within the GOB in lines
+         */
+        template<bool ToBlockLinear>
+        void CopyPartialGob(u8 *gob, u8 *linear, size_t pitch, u32 width, u32 height) {
+            for (u32 index{}; index < GobSectorCount; index++) {
+                u32 x{SectorX(index)}, y{SectorY(index)};
+                if (x >= width || y >= height)
+                    continue;
+
+                u8 *sector{gob + (index * SectorWidth)};
+                u8 *line{linear + (y * pitch) + x};
+                if constexpr (ToBlockLinear)
+                    std::memcpy(sector, line, std::min(SectorWidth, width - x));
+                else
+                    std::memcpy(line, sector, std::min(SectorWidth, width - x));
+            }
+        }
+    }
+
+    BlockLinear::BlockLinear(Dimensions dimensions, const Format &format, u32 blockHeight, u32 blockDepth, u32 levelCount, u32 layerCount) : layerCount(layerCount) {
+        if (!blockHeight || !blockDepth)
+            throw exception("Block-linear surfaces with a block of {}x{} GOBs are invalid", blockHeight, blockDepth);
+
+        size_t blockLinearOffset{}, linearOffset{};
+        levels.reserve(levelCount);
+        for (u32 levelIndex{}; levelIndex < levelCount; levelIndex++) {
+            Dimensions levelDimensions{std::max(dimensions.width >> levelIndex, 1U), std::max(dimensions.height >> levelIndex, 1U), std::max(dimensions.depth >> levelIndex, 1U)};
+            u32 widthBytes{DivideCeil(levelDimensions.width, format.blockWidth) * format.bpb};
+            u32 height{DivideCeil(levelDimensions.height, format.blockHeight)};
+
+            // The GPU reduces the size of blocks for levels which are at most half as tall (or deep) as a block, this is done to avoid excessive padding for small levels
+            u32 levelBlockHeight{blockHeight}, levelBlockDepth{blockDepth};
+            while (levelBlockHeight > 1 && DivideCeil(height, GobHeight) <= (levelBlockHeight >> 1))
+                levelBlockHeight >>= 1;
+            while (levelBlockDepth > 1 && levelDimensions.depth <= (levelBlockDepth >> 1))
+                levelBlockDepth >>= 1;
+
+            auto &level{levels.emplace_back(Level{
+                .dimensions = levelDimensions,
+                .widthBytes = widthBytes,
+                .height = height,
+                .depth = levelDimensions.depth,
+                .blockHeight = levelBlockHeight,
+                .blockDepth = levelBlockDepth,
+                .robWidth = DivideCeil(widthBytes, GobWidth),
+                .robCount = DivideCeil(height, GobHeight * levelBlockHeight),
+                .sliceCount = DivideCeil(levelDimensions.depth, levelBlockDepth),
+                .blockLinearOffset = blockLinearOffset,
+                .linearOffset = linearOffset,
+                .linearLayerSize = static_cast<size_t>(widthBytes) * height * levelDimensions.depth,
+            })};
+
+            blockLinearOffset += level.GetRobCount() * level.robWidth * level.GetBlockSize();
+            linearOffset += level.linearLayerSize * layerCount;
+        }
+
+        blockLinearLayerSize = util::AlignUp(blockLinearOffset, levels.front().GetBlockSize());
+        linearSize = linearOffset;
+
+        layerRobCount = 0;
+        for (const auto &level : levels)
+            layerRobCount += level.GetRobCount();
+
+        // The last accessed sector is in the final slice of the last block of the last ROB of the last level in the last layer, within its bottom-most GOB
+        const auto &level{levels.back()};
+        u32 lastRob{level.robCount - 1};
+        u32 lastGobY{((level.height - 1) / GobHeight) - (lastRob * level.blockHeight)};
+        u32 gobWidth{level.widthBytes - ((level.robWidth - 1) * GobWidth)}, gobLines{level.height - ((lastRob * level.blockHeight + lastGobY) * GobHeight)};
+
+        size_t gobOffset{((layerCount - 1) * blockLinearLayerSize) + level.blockLinearOffset + ((level.GetRobCount() * level.robWidth - 1) * level.GetBlockSize()) + ((((level.depth - 1) % level.blockDepth) * level.blockHeight + lastGobY) * GobSize)};
+        blockLinearAccessSize = gobOffset;
+        for (u32 index{}; index < GobSectorCount; index++)
+            if (SectorX(index) < gobWidth && SectorY(index) < gobLines)
+                blockLinearAccessSize = gobOffset + (index * SectorWidth) + std::min(SectorWidth, gobWidth - SectorX(index));
+    }
+
+    template<bool ToBlockLinear>
+    void BlockLinear::CopyRob(const Level &level, u8 *blockLinear, u8 *linear, size_t index) {
+        size_t blockSize{level.GetBlockSize()};
+        u32 slice{static_cast<u32>(index / level.robCount)}, rob{static_cast<u32>(index % level.robCount)};
+        u8 *robBlocks{blockLinear + (index * level.robWidth * blockSize)};
+        size_t linearSliceSize{static_cast<size_t>(level.widthBytes) * level.height};
+
+        u32 zEnd{std::min((slice + 1) * level.blockDepth, level.depth)};
+        for (u32 z{slice * level.blockDepth}; z < zEnd; z++) {
+            u8 *blockSlice{robBlocks + ((z % level.blockDepth) * level.blockHeight * GobSize)};
+            u8 *linearSlice{linear + (z * linearSliceSize)};
+
+            for (u32 gobY{}; gobY < level.blockHeight; gobY++) {
+                u32 y{(rob * level.blockHeight + gobY) * GobHeight};
+                if (y >= level.height)
+                    break;
+                u32 gobLines{std::min(GobHeight, level.height - y)};
+
+                u8 *gob{blockSlice + (gobY * GobSize)};
+                u8 *line{linearSlice + (static_cast<size_t>(y) * level.widthBytes)};
+                for (u32 x{}; x < level.widthBytes; x += GobWidth, gob += blockSize, line += GobWidth) {
+                    u32 gobWidth{std::min(GobWidth, level.widthBytes - x)};
+                    if (gobWidth == GobWidth && gobLines == GobHeight) [[likely]]
+                        CopyGob<ToBlockLinear>(gob, line, level.widthBytes);
+                    else
+                        CopyPartialGob<ToBlockLinear>(gob, line, level.widthBytes, gobWidth, gobLines);
+                }
+            }
+        }
+    }
+
+    template<bool ToBlockLinear>
+    void BlockLinear::Copy(u8 *blockLinear, u8 *linear, ThreadPool *pool) const {
+        auto copyRob{[&](size_t index) {
+            u32 layer{static_cast<u32>(index / layerRobCount)};
+            index %= layerRobCount;
+
+            for (const auto &level : levels) {
+                if (index < level.GetRobCount()) {
+                    CopyRob<ToBlockLinear>(level, blockLinear + (layer * blockLinearLayerSize) + level.blockLinearOffset, linear + level.linearOffset + (layer * level.linearLayerSize), index);
+                    return;
+                }
+                index -= level.GetRobCount();
+            }
+        }};
+
+        size_t robCount{layerRobCount * layerCount};
+        if (pool && linearSize >= ParallelThreshold) {
+            pool->ParallelFor(robCount, copyRob);
+        } else {
+            for (size_t index{}; index < robCount; index++)
+                copyRob(index);
+        }
+    }
+
+    void BlockLinear::Deswizzle(const u8 *blockLinear, u8 *linear, ThreadPool *pool) const {
+        TRACE_EVENT("gpu", "BlockLinear::Deswizzle", "size", linearSize);
+        Copy<false>(const_cast<u8 *>(blockLinear), linear, pool);
+    }
+
+    void BlockLinear::Swizzle(const u8 *linear, u8 *blockLinear, ThreadPool *pool) const {
+        TRACE_EVENT("gpu", "BlockLinear::Swizzle", "size", linearSize);
+        Copy<true>(blockLinear, const_cast<u8 *>(linear), pool);
+    }
+}
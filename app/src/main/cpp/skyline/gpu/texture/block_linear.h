@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/thread_pool.h>
+#include "texture.h"
+
+namespace skyline::gpu::texture {
+    /**
+     * @brief The BlockLinear class converts surfaces between the block-linear layout used by the Maxwell GPU and a tightly packed linear layout
+     * @note Reference on Block-linear tiling: https://gist.github.com/PixelyIon/d9c35050af0ef5690566ca9f0965bc32
+     * @note A GOB (Group of Bytes) is a 64x8 byte tile, a block is 'blockHeight' GOBs tall and 'blockDepth' GOBs deep and a ROB (Row of Blocks) is a single row of blocks spanning the width of a surface
+     * @note The linear layout stores all layers of a mip level contiguously with levels following each other, this matches a single VkBufferImageCopy per level
+     */
+    class BlockLinear {
+      public:
+        static constexpr u32 GobWidth{64}; //!< The width of a GOB in bytes
+        static constexpr u32 GobHeight{8}; //!< The height of a GOB in lines
+        static constexpr u32 GobSize{GobWidth * GobHeight};
+
+        /**
+         * @brief The layout of a single mip level in both block-linear and linear memory
+         */
+        struct Level {
+            Dimensions dimensions; //!< The dimensions of the level in pixels
+            u32 widthBytes; //!< The size of a single line of format blocks in bytes
+            u32 height; //!< The height of the level in lines of format blocks
+            u32 depth; //!< The depth of the level in slices
+            u32 blockHeight; //!< The height of a block in GOBs, this is reduced from that of the surface for small levels
+            u32 blockDepth; //!< The depth of a block in GOBs, this is reduced from that of the surface for small levels
+            u32 robWidth; //!< The width of a ROB in blocks
+            u32 robCount; //!< The amount of ROBs in a single slice of blocks
+            u32 sliceCount; //!< The amount of slices of blocks along the Z-axis
+            size_t blockLinearOffset; //!< The offset of the level from the start of a layer in block-linear memory
+            size_t linearOffset; //!< The offset of the level from the start of the surface in linear memory
+            size_t linearLayerSize; //!< The size of a single layer of the level in linear memory
+
+            /**
+             * @return The size of a single block in bytes
+             */
+            constexpr size_t GetBlockSize() const {
+                return static_cast<size_t>(GobSize) * blockHeight * blockDepth;
+            }
+
+            /**
+             * @return The amount of independent units of work in a single layer of the level
+             */
+            constexpr size_t GetRobCount() const {
+                return static_cast<size_t>(robCount) * sliceCount;
+            }
+        };
+
+      private:
+        std::vector<Level> levels;
+        u32 layerCount;
+        size_t blockLinearLayerSize; //!< The size of a single layer in block-linear memory, this is aligned to the size of a block of the first level
+        size_t blockLinearAccessSize; //!< The size of the range of block-linear memory which is accessed during a conversion
+        size_t linearSize;
+        size_t layerRobCount; //!< The total amount of ROBs across all levels of a single layer
+
+        static constexpr size_t ParallelThreshold{0x40000}; //!< The size in bytes of a surface below which it's converted on the calling thread as the cost of waking workers would outweigh any gains
+
+        /**
+         * @brief Converts a single ROB of a level between block-linear and linear memory
+         * @param ToBlockLinear If the ROB is swizzled from linear to block-linear memory rather than deswizzled
+         * @param blockLinear A pointer to the start of the level in block-linear memory
+         * @param linear A pointer to the start of the level in linear memory
+         * @param index The index of the ROB across all slices of blocks in the level
+         */
+        template<bool ToBlockLinear>
+        static void CopyRob(const Level &level, u8 *blockLinear, u8 *linear, size_t index);
+
+        template<bool ToBlockLinear>
+        void Copy(u8 *blockLinear, u8 *linear, ThreadPool *pool) const;
+
+      public:
+        /**
+         * @param dimensions The dimensions of the first level in pixels
+         * @param blockHeight The height of the blocks of the first level in GOBs
+         * @param blockDepth The depth of the blocks of the first level in GOBs
+         */
+        BlockLinear(Dimensions dimensions, const Format &format, u32 blockHeight, u32 blockDepth = 1, u32 levelCount = 1, u32 layerCount = 1);
+
+        const std::vector<Level> &GetLevels() const {
+            return levels;
+        }
+
+        /**
+         * @return The size of the entire surface in block-linear memory
+         */
+        size_t GetBlockLinearSize() const {
+            return blockLinearLayerSize * layerCount;
+        }
+
+        /**
+         * @return The size of the range of block-linear memory which is read by Deswizzle and written by Swizzle, unlike GetBlockLinearSize this excludes any padding after the last accessed sector
+         */
+        size_t GetBlockLinearAccessSize() const {
+            return blockLinearAccessSize;
+        }
+
+        /**
+         * @return The size of the entire surface in linear memory
+         */
+        size_t GetLinearSize() const {
+            return linearSize;
+        }
+
+        /**
+         * @brief Deswizzles the entire surface from block-linear memory into linear memory
+         * @param pool A thread pool which ROBs are split across for large surfaces, the conversion is done on the calling thread if this is null
+         */
+        void Deswizzle(const u8 *blockLinear, u8 *linear, ThreadPool *pool = nullptr) const;
+
+        /**
+         * @brief Swizzles the entire surface from linear memory into block-linear memory, this is the inverse of Deswizzle
+         * @param pool A thread pool which ROBs are split across for large surfaces, the conversion is done on the calling thread if this is null
+         * @note Padding in block-linear memory which doesn't correspond to any pixels is left untouched
+         */
+        void Swizzle(const u8 *linear, u8 *blockLinear, ThreadPool *pool = nullptr) const;
+    };
+}
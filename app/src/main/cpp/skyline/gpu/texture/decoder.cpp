@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "decoder.h"
+#include "format.h"
+
+namespace skyline::gpu::texture {
+    namespace {
+        constexpr size_t ParallelThreshold{0x10000}; //!< The size in bytes of a compressed surface below which it's decoded on the calling thread, decoding is far more expensive per byte than (de)swizzling
+
+        constexpr bool IsAstc(vk::Format format) {
+            return format >= vk::Format::eAstc4x4UnormBlock && format <= vk::Format::eAstc12x12SrgbBlock;
+        }
+
+        decoder::BlockDecoder GetBlockDecoder(const Format &format) {
+            switch (format.vkFormat) {
+                case vk::Format::eBc1RgbaUnormBlock:
+                case vk::Format::eBc1RgbaSrgbBlock:
+                    return decoder::DecodeBc1Block;
+                case vk::Format::eBc2UnormBlock:
+                case vk::Format::eBc2SrgbBlock:
+                    return decoder::DecodeBc2Block;
+                case vk::Format::eBc3UnormBlock:
+                case vk::Format::eBc3SrgbBlock:
+                    return decoder::DecodeBc3Block;
+                case vk::Format::eBc4UnormBlock:
+                    return decoder::DecodeBc4Block;
+                case vk::Format::eBc5UnormBlock:
+                    return decoder::DecodeBc5Block;
+                case vk::Format::eBc7UnormBlock:
+                case vk::Format::eBc7SrgbBlock:
+                    return decoder::DecodeBc7Block;
+                default:
+                    return IsAstc(format.vkFormat) ? decoder::DecodeAstcBlock : nullptr;
+            }
+        }
+    }
+
+    bool IsDecodable(const Format &format) {
+        return GetBlockDecoder(format) != nullptr;
+    }
+
+    const Format &GetDecodedFormat(const Format &format) {
+        switch (format.vkFormat) {
+            case vk::Format::eBc1RgbaSrgbBlock:
+            case vk::Format::eBc2SrgbBlock:
+            case vk::Format::eBc3SrgbBlock:
+            case vk::Format::eBc7SrgbBlock:
+                return format::RGBA8888Srgb;
+            default:
+                // sRGB and UNORM variants of every ASTC block size alternate in the VkFormat enumeration
+                if (IsAstc(format.vkFormat) && ((static_cast<u32>(format.vkFormat) - static_cast<u32>(vk::Format::eAstc4x4UnormBlock)) & 1))
+                    return format::RGBA8888Srgb;
+                return format::RGBA8888Unorm;
+        }
+    }
+
+    void Decode(const Format &format, Dimensions dimensions, const u8 *input, u8 *output, ThreadPool *pool) {
+        auto blockDecoder{GetBlockDecoder(format)};
+        if (!blockDecoder)
+            throw exception("Cannot decode textures in format: {}", vk::to_string(format.vkFormat));
+
+        size_t inputSize{format.GetSize(dimensions)};
+        TRACE_EVENT("gpu", "texture::Decode", "size", inputSize);
+
+        u32 blockWidth{format.blockWidth}, blockHeight{format.blockHeight};
+        u32 blocksX{(dimensions.width + blockWidth - 1) / blockWidth}, blocksY{(dimensions.height + blockHeight - 1) / blockHeight};
+        size_t inputRowSize{blocksX * format.bpb};
+        constexpr size_t OutputTexelSize{sizeof(u8) * 4};
+        size_t outputPitch{dimensions.width * OutputTexelSize}, outputSliceSize{outputPitch * dimensions.height};
+
+        // Every row of blocks is independent, they're decoded into a block-sized scratch buffer and then written out while clipping any texels outside the surface
+        auto decodeRow{[&](size_t row) {
+            u32 slice{static_cast<u32>(row / blocksY)}, blockY{static_cast<u32>(row % blocksY)};
+            u32 y{blockY * blockHeight}, rowCount{std::min(blockHeight, dimensions.height - y)};
+            const u8 *block{input + (row * inputRowSize)};
+            u8 *outputRow{output + (slice * outputSliceSize) + (y * outputPitch)};
+
+            std::array<u8, decoder::BlockTexelLimit * OutputTexelSize> texels;
+            for (u32 blockX{}; blockX < blocksX; blockX++, block += format.bpb) {
+                blockDecoder(block, texels.data(), format);
+
+                u32 x{blockX * blockWidth}, columnCount{std::min(blockWidth, dimensions.width - x)};
+                for (u32 line{}; line < rowCount; line++)
+                    std::memcpy(outputRow + (line * outputPitch) + (x * OutputTexelSize), texels.data() + (line * blockWidth * OutputTexelSize), columnCount * OutputTexelSize);
+            }
+        }};
+
+        size_t rowCount{static_cast<size_t>(blocksY) * dimensions.depth};
+        if (pool && inputSize >= ParallelThreshold) {
+            pool->ParallelFor(rowCount, decodeRow);
+        } else {
+            for (size_t row{}; row < rowCount; row++)
+                decodeRow(row);
+        }
+    }
+}
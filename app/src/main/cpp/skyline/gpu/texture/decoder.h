@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/thread_pool.h>
+#include "texture.h"
+
+namespace skyline::gpu::texture {
+    namespace decoder {
+        constexpr size_t BlockTexelLimit{12 * 12}; //!< The maximum amount of texels in a single block of any supported format
+
+        /**
+         * @brief Decodes a single block into RGBA8 texels
+         * @param output A row-major array of 'blockWidth * blockHeight' RGBA8 texels
+         */
+        using BlockDecoder = void (*)(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc1Block(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc2Block(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc3Block(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc4Block(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc5Block(const u8 *block, u8 *output, const Format &format);
+
+        void DecodeBc7Block(const u8 *block, u8 *output, const Format &format);
+
+        /**
+         * @note Only 2D blocks in the LDR profile are supported, HDR endpoints and malformed blocks decode to the ASTC error color (magenta)
+         */
+        void DecodeAstcBlock(const u8 *block, u8 *output, const Format &format);
+    }
+
+    /**
+     * @return If textures in the supplied format can be decoded on the CPU
+     */
+    bool IsDecodable(const Format &format);
+
+    /**
+     * @return The uncompressed format that textures in the supplied format are decoded into
+     */
+    const Format &GetDecodedFormat(const Format &format);
+
+    /**
+     * @brief Decodes a linear surface in a compressed format into its decoded format, this is used when the host GPU doesn't support sampling from the compressed format
+     * @param input A tightly packed linear surface in the compressed format
+     * @param output A tightly packed linear surface in the decoded format
+     * @param pool A thread pool which rows of blocks are split across for large surfaces, the surface is decoded on the calling thread if this is null
+     * @note This is only reached through GuestTexture::CreateTexture for a compressed guest format which the host can't sample, no guest texture is created in a compressed format yet as presentation only uses RGBA8888 and RGB565 surfaces
+     */
+    void Decode(const Format &format, Dimensions dimensions, const u8 *input, u8 *output, ThreadPool *pool = nullptr);
+}
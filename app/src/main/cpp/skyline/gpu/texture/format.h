@@ -9,8 +9,49 @@ namespace skyline::gpu::format {
     using Format = gpu::texture::Format;
 
     constexpr Format RGBA8888Unorm{sizeof(u8) * 4, 1, 1, vk::Format::eR8G8B8A8Unorm}; //!< 8-bits per channel 4-channel pixels
+    constexpr Format RGBA8888Srgb{sizeof(u8) * 4, 1, 1, vk::Format::eR8G8B8A8Srgb}; //!< 8-bits per channel 4-channel pixels with sRGB color channels
     constexpr Format RGB565Unorm{sizeof(u8) * 2, 1, 1, vk::Format::eR5G6B5UnormPack16}; //!< Red channel: 5-bit, Green channel: 6-bit, Blue channel: 5-bit
 
+    constexpr Format BC1Unorm{8, 4, 4, vk::Format::eBc1RgbaUnormBlock}; //!< BC1 (DXT1) with 5:6:5 color endpoints and 1-bit alpha
+    constexpr Format BC1Srgb{8, 4, 4, vk::Format::eBc1RgbaSrgbBlock}; //!< BC1 (DXT1) with 5:6:5 color endpoints and 1-bit alpha in sRGB
+    constexpr Format BC2Unorm{16, 4, 4, vk::Format::eBc2UnormBlock}; //!< BC2 (DXT3) with explicit 4-bit alpha
+    constexpr Format BC2Srgb{16, 4, 4, vk::Format::eBc2SrgbBlock}; //!< BC2 (DXT3) with explicit 4-bit alpha in sRGB
+    constexpr Format BC3Unorm{16, 4, 4, vk::Format::eBc3UnormBlock}; //!< BC3 (DXT5) with interpolated alpha
+    constexpr Format BC3Srgb{16, 4, 4, vk::Format::eBc3SrgbBlock}; //!< BC3 (DXT5) with interpolated alpha in sRGB
+    constexpr Format BC4Unorm{8, 4, 4, vk::Format::eBc4UnormBlock}; //!< BC4 (RGTC1) with a single interpolated channel
+    constexpr Format BC5Unorm{16, 4, 4, vk::Format::eBc5UnormBlock}; //!< BC5 (RGTC2) with two interpolated channels
+    constexpr Format BC7Unorm{16, 4, 4, vk::Format::eBc7UnormBlock}; //!< BC7 (BPTC) with up to three partitions
+    constexpr Format BC7Srgb{16, 4, 4, vk::Format::eBc7SrgbBlock}; //!< BC7 (BPTC) with up to three partitions in sRGB
+
+    constexpr Format ASTC4x4Unorm{16, 4, 4, vk::Format::eAstc4x4UnormBlock}; //!< ASTC with 4x4 texel blocks
+    constexpr Format ASTC4x4Srgb{16, 4, 4, vk::Format::eAstc4x4SrgbBlock}; //!< ASTC with 4x4 texel blocks in sRGB
+    constexpr Format ASTC5x4Unorm{16, 4, 5, vk::Format::eAstc5x4UnormBlock}; //!< ASTC with 5x4 texel blocks
+    constexpr Format ASTC5x4Srgb{16, 4, 5, vk::Format::eAstc5x4SrgbBlock}; //!< ASTC with 5x4 texel blocks in sRGB
+    constexpr Format ASTC5x5Unorm{16, 5, 5, vk::Format::eAstc5x5UnormBlock}; //!< ASTC with 5x5 texel blocks
+    constexpr Format ASTC5x5Srgb{16, 5, 5, vk::Format::eAstc5x5SrgbBlock}; //!< ASTC with 5x5 texel blocks in sRGB
+    constexpr Format ASTC6x5Unorm{16, 5, 6, vk::Format::eAstc6x5UnormBlock}; //!< ASTC with 6x5 texel blocks
+    constexpr Format ASTC6x5Srgb{16, 5, 6, vk::Format::eAstc6x5SrgbBlock}; //!< ASTC with 6x5 texel blocks in sRGB
+    constexpr Format ASTC6x6Unorm{16, 6, 6, vk::Format::eAstc6x6UnormBlock}; //!< ASTC with 6x6 texel blocks
+    constexpr Format ASTC6x6Srgb{16, 6, 6, vk::Format::eAstc6x6SrgbBlock}; //!< ASTC with 6x6 texel blocks in sRGB
+    constexpr Format ASTC8x5Unorm{16, 5, 8, vk::Format::eAstc8x5UnormBlock}; //!< ASTC with 8x5 texel blocks
+    constexpr Format ASTC8x5Srgb{16, 5, 8, vk::Format::eAstc8x5SrgbBlock}; //!< ASTC with 8x5 texel blocks in sRGB
+    constexpr Format ASTC8x6Unorm{16, 6, 8, vk::Format::eAstc8x6UnormBlock}; //!< ASTC with 8x6 texel blocks
+    constexpr Format ASTC8x6Srgb{16, 6, 8, vk::Format::eAstc8x6SrgbBlock}; //!< ASTC with 8x6 texel blocks in sRGB
+    constexpr Format ASTC8x8Unorm{16, 8, 8, vk::Format::eAstc8x8UnormBlock}; //!< ASTC with 8x8 texel blocks
+    constexpr Format ASTC8x8Srgb{16, 8, 8, vk::Format::eAstc8x8SrgbBlock}; //!< ASTC with 8x8 texel blocks in sRGB
+    constexpr Format ASTC10x5Unorm{16, 5, 10, vk::Format::eAstc10x5UnormBlock}; //!< ASTC with 10x5 texel blocks
+    constexpr Format ASTC10x5Srgb{16, 5, 10, vk::Format::eAstc10x5SrgbBlock}; //!< ASTC with 10x5 texel blocks in sRGB
+    constexpr Format ASTC10x6Unorm{16, 6, 10, vk::Format::eAstc10x6UnormBlock}; //!< ASTC with 10x6 texel blocks
+    constexpr Format ASTC10x6Srgb{16, 6, 10, vk::Format::eAstc10x6SrgbBlock}; //!< ASTC with 10x6 texel blocks in sRGB
+    constexpr Format ASTC10x8Unorm{16, 8, 10, vk::Format::eAstc10x8UnormBlock}; //!< ASTC with 10x8 texel blocks
+    constexpr Format ASTC10x8Srgb{16, 8, 10, vk::Format::eAstc10x8SrgbBlock}; //!< ASTC with 10x8 texel blocks in sRGB
+    constexpr Format ASTC10x10Unorm{16, 10, 10, vk::Format::eAstc10x10UnormBlock}; //!< ASTC with 10x10 texel blocks
+    constexpr Format ASTC10x10Srgb{16, 10, 10, vk::Format::eAstc10x10SrgbBlock}; //!< ASTC with 10x10 texel blocks in sRGB
+    constexpr Format ASTC12x10Unorm{16, 10, 12, vk::Format::eAstc12x10UnormBlock}; //!< ASTC with 12x10 texel blocks
+    constexpr Format ASTC12x10Srgb{16, 10, 12, vk::Format::eAstc12x10SrgbBlock}; //!< ASTC with 12x10 texel blocks in sRGB
+    constexpr Format ASTC12x12Unorm{16, 12, 12, vk::Format::eAstc12x12UnormBlock}; //!< ASTC with 12x12 texel blocks
+    constexpr Format ASTC12x12Srgb{16, 12, 12, vk::Format::eAstc12x12SrgbBlock}; //!< ASTC with 12x12 texel blocks in sRGB
+
     /**
      * @brief Converts a Vulkan format to a Skyline format
      */
@@ -18,8 +59,86 @@ namespace skyline::gpu::format {
         switch (format) {
             case vk::Format::eR8G8B8A8Unorm:
                 return RGBA8888Unorm;
+            case vk::Format::eR8G8B8A8Srgb:
+                return RGBA8888Srgb;
             case vk::Format::eR5G6B5UnormPack16:
                 return RGB565Unorm;
+            case vk::Format::eBc1RgbaUnormBlock:
+                return BC1Unorm;
+            case vk::Format::eBc1RgbaSrgbBlock:
+                return BC1Srgb;
+            case vk::Format::eBc2UnormBlock:
+                return BC2Unorm;
+            case vk::Format::eBc2SrgbBlock:
+                return BC2Srgb;
+            case vk::Format::eBc3UnormBlock:
+                return BC3Unorm;
+            case vk::Format::eBc3SrgbBlock:
+                return BC3Srgb;
+            case vk::Format::eBc4UnormBlock:
+                return BC4Unorm;
+            case vk::Format::eBc5UnormBlock:
+                return BC5Unorm;
+            case vk::Format::eBc7UnormBlock:
+                return BC7Unorm;
+            case vk::Format::eBc7SrgbBlock:
+                return BC7Srgb;
+            case vk::Format::eAstc4x4UnormBlock:
+                return ASTC4x4Unorm;
+            case vk::Format::eAstc4x4SrgbBlock:
+                return ASTC4x4Srgb;
+            case vk::Format::eAstc5x4UnormBlock:
+                return ASTC5x4Unorm;
+            case vk::Format::eAstc5x4SrgbBlock:
+                return ASTC5x4Srgb;
+            case vk::Format::eAstc5x5UnormBlock:
+                return ASTC5x5Unorm;
+            case vk::Format::eAstc5x5SrgbBlock:
+                return ASTC5x5Srgb;
+            case vk::Format::eAstc6x5UnormBlock:
+                return ASTC6x5Unorm;
+            case vk::Format::eAstc6x5SrgbBlock:
+                return ASTC6x5Srgb;
+            case vk::Format::eAstc6x6UnormBlock:
+                return ASTC6x6Unorm;
+            case vk::Format::eAstc6x6SrgbBlock:
+                return ASTC6x6Srgb;
+            case vk::Format::eAstc8x5UnormBlock:
+                return ASTC8x5Unorm;
+            case vk::Format::eAstc8x5SrgbBlock:
+                return ASTC8x5Srgb;
+            case vk::Format::eAstc8x6UnormBlock:
+                return ASTC8x6Unorm;
+            case vk::Format::eAstc8x6SrgbBlock:
+                return ASTC8x6Srgb;
+            case vk::Format::eAstc8x8UnormBlock:
+                return ASTC8x8Unorm;
+            case vk::Format::eAstc8x8SrgbBlock:
+                return ASTC8x8Srgb;
+            case vk::Format::eAstc10x5UnormBlock:
+                return ASTC10x5Unorm;
+            case vk::Format::eAstc10x5SrgbBlock:
+                return ASTC10x5Srgb;
+            case vk::Format::eAstc10x6UnormBlock:
+                return ASTC10x6Unorm;
+            case vk::Format::eAstc10x6SrgbBlock:
+                return ASTC10x6Srgb;
+            case vk::Format::eAstc10x8UnormBlock:
+                return ASTC10x8Unorm;
+            case vk::Format::eAstc10x8SrgbBlock:
+                return ASTC10x8Srgb;
+            case vk::Format::eAstc10x10UnormBlock:
+                return ASTC10x10Unorm;
+            case vk::Format::eAstc10x10SrgbBlock:
+                return ASTC10x10Srgb;
+            case vk::Format::eAstc12x10UnormBlock:
+                return ASTC12x10Unorm;
+            case vk::Format::eAstc12x10SrgbBlock:
+                return ASTC12x10Srgb;
+            case vk::Format::eAstc12x12UnormBlock:
+                return ASTC12x12Unorm;
+            case vk::Format::eAstc12x12SrgbBlock:
+                return ASTC12x12Srgb;
             default:
                 throw exception("Vulkan format not supported: '{}'", vk::to_string(format));
         }
@@ -3,11 +3,13 @@
 
 #include <gpu.h>
 #include <common/trace.h>
+#include <common/content_hash.h>
 #include <kernel/types/KProcess.h>
-#include "texture.h"
+#include "block_linear.h"
+#include "decoder.h"
 
 namespace skyline::gpu {
-    GuestTexture::GuestTexture(const DeviceState &state, u8 *pointer, texture::Dimensions dimensions, const texture::Format &format, texture::TileMode tiling, texture::TileConfig layout) : state(state), pointer(pointer), dimensions(dimensions), format(format), tileMode(tiling), tileConfig(layout) {}
+    GuestTexture::GuestTexture(const DeviceState &state, u8 *pointer, size_t mappingSize, texture::Dimensions dimensions, const texture::Format &format, texture::TileMode tiling, texture::TileConfig layout) : state(state), pointer(pointer), mappingSize(mappingSize), dimensions(dimensions), format(format), tileMode(tiling), tileConfig(layout) {}
 
     std::shared_ptr<Texture> GuestTexture::InitializeTexture(vk::Image backing, texture::Dimensions pDimensions, const texture::Format &pFormat, std::optional<vk::ImageTiling> tiling, vk::ImageLayout layout, texture::Swizzle swizzle) {
         if (!host.expired())
@@ -30,8 +32,15 @@ namespace skyline::gpu {
             throw exception("Trying to create multiple Texture objects from a single GuestTexture");
 
         pDimensions = pDimensions ? pDimensions : dimensions;
-        const auto &lFormat{pFormat ? pFormat : format};
+        texture::Format lFormat{pFormat ? pFormat : format};
         auto tiling{pTiling ? *pTiling : (tileMode == texture::TileMode::Block) ? vk::ImageTiling::eOptimal : vk::ImageTiling::eLinear};
+        if (lFormat.IsCompressed() && texture::IsDecodable(lFormat)) {
+            // Compressed formats which the host GPU can't sample from are decoded on the CPU during synchronization, a lot of mobile GPUs lack BCn support and some lack ASTC support
+            auto properties{state.gpu->vkPhysicalDevice.getFormatProperties(lFormat)};
+            auto features{tiling == vk::ImageTiling::eLinear ? properties.linearTilingFeatures : properties.optimalTilingFeatures};
+            if (!(features & vk::FormatFeatureFlagBits::eSampledImage))
+                lFormat = texture::GetDecodedFormat(lFormat);
+        }
         vk::ImageCreateInfo imageCreateInfo{
             .imageType = pDimensions.GetType(),
             .format = lFormat,
@@ -52,10 +61,7 @@ namespace skyline::gpu {
         return sharedHost;
     }
 
-    Texture::Texture(GPU &gpu, BackingType &&backing, std::shared_ptr<GuestTexture> guest, texture::Dimensions dimensions, const texture::Format &format, vk::ImageLayout layout, vk::ImageTiling tiling, vk::ComponentMapping mapping) : gpu(gpu), backing(std::move(backing)), layout(layout), guest(std::move(guest)), dimensions(dimensions), format(format), tiling(tiling), mapping(mapping) {
-        if (GetBacking())
-            SynchronizeHost();
-    }
+    Texture::Texture(GPU &gpu, BackingType &&backing, std::shared_ptr<GuestTexture> guest, texture::Dimensions dimensions, const texture::Format &format, vk::ImageLayout layout, vk::ImageTiling tiling, vk::ComponentMapping mapping) : gpu(gpu), backing(std::move(backing)), layout(layout), guest(std::move(guest)), dimensions(dimensions), format(format), tiling(tiling), mapping(mapping) {}
 
     Texture::Texture(GPU &gpu, BackingType &&backing, texture::Dimensions dimensions, const texture::Format &format, vk::ImageLayout layout, vk::ImageTiling tiling, vk::ComponentMapping mapping) : gpu(gpu), backing(std::move(backing)), guest(nullptr), dimensions(dimensions), format(format), layout(layout), tiling(tiling), mapping(mapping) {}
 
@@ -100,6 +106,7 @@ namespace skyline::gpu {
 
         backing = std::move(pBacking);
         layout = pLayout;
+        contentHash.reset();
         if (GetBacking())
             backingCondition.notify_all();
     }
@@ -137,11 +144,36 @@ namespace skyline::gpu {
         auto pointer{guest->pointer};
         auto size{format.GetSize(dimensions)};
 
+        std::optional<texture::BlockLinear> blockLinear;
+        u32 lineCount{(dimensions.height + guest->format.blockHeight - 1) / guest->format.blockHeight}; // The amount of lines of pixels or blocks in the texture
+        size_t guestSize;
+        if (guest->tileMode == texture::TileMode::Block) {
+            // The ROB width is derived from the texture's dimensions, a surface with a wider layout than its contents would need a row length for the copy to the host
+            if (guest->tileConfig.surfaceWidth != dimensions.width)
+                throw exception("Block-linear surface width ({}) differs from the texture width ({})", guest->tileConfig.surfaceWidth, dimensions.width);
+            blockLinear.emplace(dimensions, guest->format, guest->tileConfig.blockHeight, guest->tileConfig.blockDepth);
+            guestSize = blockLinear->GetBlockLinearAccessSize();
+        } else if (guest->tileMode == texture::TileMode::Pitch) {
+            guestSize = (guest->format.GetSize(guest->tileConfig.pitch, 1) * (lineCount - 1)) + guest->format.GetSize(dimensions.width, 1);
+        } else {
+            guestSize = guest->format.GetSize(dimensions);
+        }
+
+        // Guest textures such as static menus or duplicated frames are frequently synchronized without any changes to their contents, we avoid redundantly uploading them
+        // Only the bytes which are read are hashed as any padding may be reused by the guest, they're clamped to the guest mapping to avoid reading past the end of it
+        size_t hashSize{std::min(guestSize, guest->mappingSize)};
+        auto hash{util::HashContent(span<const u8>{pointer, hashSize})};
+        bool unchanged{contentHash == hash};
+        gpu.texture.RecordSynchronization(unchanged, hashSize);
+        if (unchanged)
+            return;
+        contentHash = hash;
+
         u8 *bufferData;
         auto stagingBuffer{[&]() -> std::shared_ptr<memory::StagingBuffer> {
             if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
                 // We need a staging buffer for all optimal copies (since we aren't aware of the host optimal layout) and linear textures which we cannot map on the CPU since we do not have access to their backing VkDeviceMemory
-                auto stagingBuffer{gpu.memory.AllocateStagingBuffer(size)};
+                auto stagingBuffer{gpu.uploader.AcquireStagingBuffer(size)};
                 bufferData = stagingBuffer->data();
                 return stagingBuffer;
             } else if (tiling == vk::ImageTiling::eLinear) {
@@ -154,63 +186,35 @@ namespace skyline::gpu {
             }
         }()};
 
-        if (guest->tileMode == texture::TileMode::Block) {
-            // Reference on Block-linear tiling: https://gist.github.com/PixelyIon/d9c35050af0ef5690566ca9f0965bc32
-            constexpr u8 SectorWidth{16}; // The width of a sector in bytes
-            constexpr u8 SectorHeight{2}; // The height of a sector in lines
-            constexpr u8 GobWidth{64}; // The width of a GOB in bytes
-            constexpr u8 GobHeight{8}; // The height of a GOB in lines
-
-            auto blockHeight{guest->tileConfig.blockHeight}; // The height of the blocks in GOBs
-            auto robHeight{GobHeight * blockHeight}; // The height of a single ROB (Row of Blocks) in lines
-            auto surfaceHeight{dimensions.height / guest->format.blockHeight}; // The height of the surface in lines
-            auto surfaceHeightRobs{util::AlignUp(surfaceHeight, robHeight) / robHeight}; // The height of the surface in ROBs (Row Of Blocks)
-            auto robWidthBytes{util::AlignUp((guest->tileConfig.surfaceWidth / guest->format.blockWidth) * guest->format.bpb, GobWidth)}; // The width of a ROB in bytes
-            auto robWidthBlocks{robWidthBytes / GobWidth}; // The width of a ROB in blocks (and GOBs because block width == 1 on the Tegra X1)
-            auto robBytes{robWidthBytes * robHeight}; // The size of a ROB in bytes
-            auto gobYOffset{robWidthBytes * GobHeight}; // The offset of the next Y-axis GOB from the current one in linear space
-
-            auto inputSector{pointer}; // The address of the input sector
-            auto outputRob{bufferData}; // The address of the output block
-
-            for (u32 rob{}, y{}, paddingY{}; rob < surfaceHeightRobs; rob++) { // Every Surface contains `surfaceHeightRobs` ROBs
-                auto outputBlock{outputRob}; // We iterate through a block independently of the ROB
-                for (u32 block{}; block < robWidthBlocks; block++) { // Every ROB contains `surfaceWidthBlocks` Blocks
-                    auto outputGob{outputBlock}; // We iterate through a GOB independently of the block
-                    for (u32 gobY{}; gobY < blockHeight; gobY++) { // Every Block contains `blockHeight` Y-axis GOBs
-                        for (u32 index{}; index < SectorWidth * SectorHeight; index++) { // Every Y-axis GOB contains `sectorWidth * sectorHeight` sectors
-                            u32 xT{((index << 3) & 0b10000) | ((index << 1) & 0b100000)}; // Morton-Swizzle on the X-axis
-                            u32 yT{((index >> 1) & 0b110) | (index & 0b1)}; // Morton-Swizzle on the Y-axis
-                            std::memcpy(outputGob + (yT * robWidthBytes) + xT, inputSector, SectorWidth);
-                            inputSector += SectorWidth; // `sectorWidth` bytes are of sequential image data
-                        }
-                        outputGob += gobYOffset; // Increment the output GOB to the next Y-axis GOB
-                    }
-                    inputSector += paddingY; // Increment the input sector to the next sector
-                    outputBlock += GobWidth; // Increment the output block to the next block (As Block Width = 1 GOB Width)
-                }
-                outputRob += robBytes; // Increment the output block to the next ROB
+        // If the host texture is in the decoded format of a compressed guest texture then the guest texture is untiled into an intermediate buffer which is decoded into the staging buffer
+        std::vector<u8> decodeBuffer;
+        u8 *linearData{bufferData};
+        if (guest->format.IsCompressed() && !format.IsCompressed()) {
+            decodeBuffer.resize(guest->format.GetSize(dimensions));
+            linearData = decodeBuffer.data();
+        }
 
-                y += robHeight; // Increment the Y position to the next ROB
-                blockHeight = static_cast<u8>(std::min(static_cast<u32>(blockHeight), (surfaceHeight - y) / GobHeight)); // Calculate the amount of Y GOBs which aren't padding
-                paddingY = (guest->tileConfig.blockHeight - blockHeight) * (SectorWidth * SectorWidth * SectorHeight); // Calculate the amount of padding between contiguous sectors
-            }
+        if (guest->tileMode == texture::TileMode::Block) {
+            blockLinear->Deswizzle(pointer, linearData, &gpu.threadPool);
         } else if (guest->tileMode == texture::TileMode::Pitch) {
             auto sizeLine{guest->format.GetSize(dimensions.width, 1)}; // The size of a single line of pixel data
             auto sizeStride{guest->format.GetSize(guest->tileConfig.pitch, 1)}; // The size of a single stride of pixel data
 
             auto inputLine{pointer}; // The address of the input line
-            auto outputLine{bufferData}; // The address of the output line
+            auto outputLine{linearData}; // The address of the output line
 
-            for (u32 line{}; line < dimensions.height; line++) {
+            for (u32 line{}; line < lineCount; line++) {
                 std::memcpy(outputLine, inputLine, sizeLine);
                 inputLine += sizeStride;
                 outputLine += sizeLine;
             }
         } else if (guest->tileMode == texture::TileMode::Linear) {
-            std::memcpy(bufferData, pointer, size);
+            std::memcpy(linearData, pointer, guestSize);
         }
 
+        if (!decodeBuffer.empty())
+            texture::Decode(guest->format, dimensions, linearData, bufferData, &gpu.threadPool);
+
         if (stagingBuffer) {
             if (WaitOnBacking() && size != format.GetSize(dimensions))
                 throw exception("Backing properties changing during sync is not supported");
@@ -263,6 +267,7 @@ namespace skyline::gpu {
                     });
             });
             cycle->AttachObjects(stagingBuffer, shared_from_this());
+            gpu.uploader.RecycleStagingBuffer(stagingBuffer, cycle);
         }
     }
 
@@ -291,6 +296,8 @@ namespace skyline::gpu {
         else if (source->format != format)
             throw exception("Cannot copy from image with different format");
 
+        contentHash.reset(); // The contents no longer correspond to those of the guest texture
+
         cycle = gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
             auto sourceBacking{source->GetBacking()};
             if (source->layout != vk::ImageLayout::eTransferSrcOptimal) {
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <gpu/fence_cycle.h>
+#include <gpu/memory_manager.h>
 
 namespace skyline::gpu {
     namespace texture {
@@ -78,7 +78,7 @@ namespace skyline::gpu {
              * @return The size of the texture in bytes
              */
             constexpr size_t GetSize(u32 width, u32 height, u32 depth = 1) const {
-                return (((width / blockWidth) * (height / blockHeight)) * bpb) * depth;
+                return ((((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight)) * bpb) * depth;
             }
 
             constexpr size_t GetSize(Dimensions dimensions) const {
@@ -182,13 +182,14 @@ namespace skyline::gpu {
 
       public:
         u8 *pointer; //!< The address of the texture in guest memory
+        size_t mappingSize; //!< The size of the guest memory backing the texture starting at the pointer, the contents are never hashed beyond it
         std::weak_ptr<Texture> host; //!< A host texture (if any) that was created from this guest texture
         texture::Dimensions dimensions;
         texture::Format format;
         texture::TileMode tileMode;
         texture::TileConfig tileConfig;
 
-        GuestTexture(const DeviceState &state, u8 *pointer, texture::Dimensions dimensions, const texture::Format &format, texture::TileMode tileMode = texture::TileMode::Linear, texture::TileConfig tileConfig = {});
+        GuestTexture(const DeviceState &state, u8 *pointer, size_t mappingSize, texture::Dimensions dimensions, const texture::Format &format, texture::TileMode tileMode = texture::TileMode::Linear, texture::TileConfig tileConfig = {});
 
         constexpr size_t Size() {
             return format.GetSize(dimensions);
@@ -204,6 +205,7 @@ namespace skyline::gpu {
          * @param swizzle The channel swizzle of the host texture (Defaults to no channel swizzling)
          * @return A shared pointer to the host texture object
          * @note There can only be one host texture for a corresponding guest texture
+         * @note The host texture isn't synchronized with the guest texture on creation, SynchronizeHost (or TextureUploader::Enqueue) must be used before its contents are read
          * @note If any of the supplied parameters do not match up with the backing then it's undefined behavior
          */
         std::shared_ptr<Texture> InitializeTexture(vk::Image backing, texture::Dimensions dimensions = {}, const texture::Format &format = {}, std::optional<vk::ImageTiling> tiling = std::nullopt, vk::ImageLayout layout = vk::ImageLayout::eUndefined, texture::Swizzle swizzle = {});
@@ -233,6 +235,7 @@ namespace skyline::gpu {
         BackingType backing; //!< The Vulkan image that backs this texture, it is nullable
         std::shared_ptr<FenceCycle> cycle; //!< A fence cycle for when any host operation mutating the texture has completed, it must be waited on prior to any mutations to the backing
         vk::ImageLayout layout;
+        std::optional<u64> contentHash; //!< A hash of the guest texture contents as of the last guest -> host synchronization, this is used to skip synchronizations when the contents haven't changed
 
         /**
          * @note The handle returned is nullable and the appropriate precautions should be taken
@@ -334,7 +337,7 @@ namespace skyline::gpu {
         void SetSwizzle(texture::Swizzle swizzle);
 
         /**
-         * @brief Synchronizes the host texture with the guest after it has been modified
+         * @brief Synchronizes the host texture with the guest after it has been modified, this is skipped if the contents of the guest texture are unchanged since the last synchronization
          * @note The texture **must** be locked prior to calling this
          * @note The guest texture should not be null prior to calling this
          */
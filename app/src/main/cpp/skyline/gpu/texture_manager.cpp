@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <bit>
+#include <common/trace.h>
+#include "texture_manager.h"
+
+namespace skyline::gpu {
+    TextureManager::TextureKey::TextureKey(const GuestTexture &guest) : pointer(guest.pointer), format(guest.format.vkFormat), dimensions(guest.dimensions), tileMode(guest.tileMode), tileConfig(std::bit_cast<u32>(guest.tileConfig)) {}
+
+    size_t TextureManager::TextureKeyHash::operator()(const TextureKey &key) const {
+        size_t hash{std::hash<u8 *>{}(key.pointer)};
+        auto combine{[&](u64 value) {
+            hash ^= std::hash<u64>{}(value) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        }};
+        combine(static_cast<u64>(key.format));
+        combine((static_cast<u64>(key.dimensions.width) << 32) | key.dimensions.height);
+        combine((static_cast<u64>(key.dimensions.depth) << 32) | static_cast<u64>(key.tileMode));
+        combine(key.tileConfig);
+        return hash;
+    }
+
+    TextureManager::TextureManager(const DeviceState &state) : state(state) {}
+
+    TextureManager::~TextureManager() {
+        auto stats{GetStatistics()};
+        if (stats.cacheHits || stats.cacheMisses)
+            state.logger->Info("Texture cache: {} hits, {} misses, {} synchronizations skipped out of {} ({} bytes saved)", stats.cacheHits, stats.cacheMisses, stats.syncSkips, stats.syncSkips + stats.syncUploads, stats.bytesSaved);
+    }
+
+    std::shared_ptr<Texture> TextureManager::FindOrCreate(const std::shared_ptr<GuestTexture> &guest, vk::ImageUsageFlags usage, std::optional<vk::ImageTiling> tiling) {
+        TRACE_EVENT("gpu", "TextureManager::FindOrCreate");
+        std::lock_guard lock(mutex);
+
+        TextureKey key{*guest};
+        auto it{textures.find(key)};
+        if (it != textures.end()) {
+            if (auto texture{it->second.lock()}) {
+                cacheHits.fetch_add(1, std::memory_order_relaxed);
+                return texture;
+            }
+        }
+
+        // Entries of textures which have been destroyed are pruned here as there's no other point where they'd be cleaned up
+        std::erase_if(textures, [](const auto &entry) { return entry.second.expired(); });
+
+        cacheMisses.fetch_add(1, std::memory_order_relaxed);
+        auto texture{guest->CreateTexture(usage, tiling)};
+        textures.insert_or_assign(key, texture);
+        return texture;
+    }
+
+    void TextureManager::RecordSynchronization(bool skipped, size_t size) {
+        if (skipped) {
+            syncSkips.fetch_add(1, std::memory_order_relaxed);
+            bytesSaved.fetch_add(size, std::memory_order_relaxed);
+        } else {
+            syncUploads.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        TRACE_EVENT_INSTANT("gpu", "TextureSynchronization", "Skipped", skipped, "Size", size, "TotalSkips", syncSkips.load(std::memory_order_relaxed), "TotalUploads", syncUploads.load(std::memory_order_relaxed), "TotalBytesSaved", bytesSaved.load(std::memory_order_relaxed));
+    }
+
+    TextureManager::Statistics TextureManager::GetStatistics() const {
+        return Statistics{
+            .cacheHits = cacheHits.load(std::memory_order_relaxed),
+            .cacheMisses = cacheMisses.load(std::memory_order_relaxed),
+            .syncSkips = syncSkips.load(std::memory_order_relaxed),
+            .syncUploads = syncUploads.load(std::memory_order_relaxed),
+            .bytesSaved = bytesSaved.load(std::memory_order_relaxed),
+        };
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "texture/texture.h"
+
+namespace skyline::gpu {
+    /**
+     * @brief The TextureManager class caches host textures by the guest surface they're created from, this allows a texture and its last synchronized contents to be reused whenever the same guest surface is used again
+     * @note Textures are only weakly referenced by the cache, their lifetime is controlled by the users of them
+     */
+    class TextureManager {
+      private:
+        /**
+         * @brief All properties of a guest texture which affect its host counterpart
+         */
+        struct TextureKey {
+            u8 *pointer;
+            vk::Format format;
+            texture::Dimensions dimensions;
+            texture::TileMode tileMode;
+            u32 tileConfig; //!< The raw value of the texture::TileConfig union
+
+            TextureKey(const GuestTexture &guest);
+
+            bool operator==(const TextureKey &) const = default;
+        };
+
+        struct TextureKeyHash {
+            size_t operator()(const TextureKey &key) const;
+        };
+
+        const DeviceState &state;
+        std::mutex mutex; //!< Synchronizes access to the texture cache
+        std::unordered_map<TextureKey, std::weak_ptr<Texture>, TextureKeyHash> textures;
+
+        std::atomic<u64> cacheHits{}; //!< The amount of lookups which found an existing texture
+        std::atomic<u64> cacheMisses{}; //!< The amount of lookups which created a new texture
+        std::atomic<u64> syncSkips{}; //!< The amount of guest -> host synchronizations skipped as the contents were unchanged
+        std::atomic<u64> syncUploads{}; //!< The amount of guest -> host synchronizations which had to upload the contents
+        std::atomic<u64> bytesSaved{}; //!< The total size of all skipped synchronizations in bytes
+
+      public:
+        /**
+         * @brief A snapshot of the statistics of the texture cache and content hashing
+         */
+        struct Statistics {
+            u64 cacheHits;
+            u64 cacheMisses;
+            u64 syncSkips;
+            u64 syncUploads;
+            u64 bytesSaved;
+        };
+
+        TextureManager(const DeviceState &state);
+
+        ~TextureManager();
+
+        /**
+         * @brief Looks up a host texture for the supplied guest texture, if there's no such texture then one is created with the supplied parameters
+         * @return A host texture backed by the same guest surface with the same format, dimensions and tiling, its guest texture may not be the supplied one
+         * @note The parameters are only used for creating a texture, they're ignored when an existing texture is found
+         */
+        std::shared_ptr<Texture> FindOrCreate(const std::shared_ptr<GuestTexture> &guest, vk::ImageUsageFlags usage = {}, std::optional<vk::ImageTiling> tiling = std::nullopt);
+
+        /**
+         * @brief Records the outcome of a guest -> host synchronization of a texture
+         * @param skipped If the synchronization was skipped as the contents of the guest texture were unchanged
+         * @param size The size of the guest texture in bytes
+         */
+        void RecordSynchronization(bool skipped, size_t size);
+
+        Statistics GetStatistics() const;
+    };
+}
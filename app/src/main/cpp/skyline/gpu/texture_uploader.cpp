@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/signal.h>
+#include <common/trace.h>
+#include <loader/loader.h>
+#include <kernel/types/KProcess.h>
+#include <gpu.h>
+#include "texture_uploader.h"
+
+namespace skyline::gpu {
+    TextureUploader::TextureUploader(const DeviceState &state) : state(state), uploadThread(&TextureUploader::Run, this, "TextureUploader", &TextureUploader::ProcessUploads), callbackThread(&TextureUploader::Run, this, "TextureCallback", &TextureUploader::ProcessCallbacks) {}
+
+    TextureUploader::~TextureUploader() {
+        // Both threads are interrupted prior to joining either, a callback may be blocked on presentation which would otherwise never return
+        std::array threads{&uploadThread, &callbackThread};
+        for (auto thread : threads)
+            if (thread->joinable())
+                pthread_kill(thread->native_handle(), SIGINT);
+        for (auto thread : threads)
+            if (thread->joinable())
+                thread->join();
+    }
+
+    void TextureUploader::ProcessUploads() {
+        while (true) {
+            UploadRequest request;
+            {
+                std::unique_lock lock(mutex);
+                requestCondition.wait(lock, [this]() { return !requests.empty() || exiting; });
+                if (exiting)
+                    return;
+                request = std::move(requests.front());
+                requests.pop();
+            }
+
+            {
+                TRACE_EVENT("gpu", "TextureUploader::Upload", "id", request.id);
+                std::scoped_lock textureLock(*request.texture);
+                request.texture->SynchronizeHost();
+            }
+
+            TRACE_EVENT_INSTANT("gpu", "TextureUploadComplete", "id", request.id, "LatencyNs", util::GetTimeNs() - request.enqueueTime);
+            bool hasCallback{static_cast<bool>(request.callback)};
+            {
+                std::scoped_lock lock(mutex);
+                completedRequestId = request.id;
+            }
+            completionCondition.notify_all();
+
+            if (hasCallback) {
+                {
+                    std::unique_lock lock(mutex);
+                    if (callbacks.size() >= MaxPendingCallbacks) {
+                        // We don't wake up on the callback thread exiting as the destructor interrupts this thread prior to joining it
+                        TRACE_EVENT("gpu", "TextureUploader::WaitForCallback");
+                        completionCondition.wait(lock, [this]() { return callbacks.size() < MaxPendingCallbacks; });
+                    }
+                    callbacks.push(std::move(request));
+                }
+                callbackCondition.notify_one();
+            }
+        }
+    }
+
+    void TextureUploader::ProcessCallbacks() {
+        while (true) {
+            UploadRequest request;
+            {
+                std::unique_lock lock(mutex);
+                callbackCondition.wait(lock, [this]() { return !callbacks.empty() || exiting; });
+                if (exiting)
+                    return;
+                request = std::move(callbacks.front());
+            }
+
+            {
+                TRACE_EVENT("gpu", "TextureUploader::Callback", "id", request.id);
+                request.callback(request.texture);
+            }
+
+            {
+                // The request is only popped after the callback has returned so that it counts towards the pending callbacks till then
+                std::scoped_lock lock(mutex);
+                callbacks.pop();
+                completedCallbackId = request.id;
+            }
+            completionCondition.notify_all();
+        }
+    }
+
+    void TextureUploader::Run(const char *name, void (TextureUploader::*loop)()) {
+        pthread_setname_np(pthread_self(), name);
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+            (this->*loop)();
+        } catch (const signal::SignalException &e) {
+            if (e.signal != SIGINT) {
+                state.logger->Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+                signal::BlockSignal({SIGINT});
+                state.process->Kill(false);
+            }
+        } catch (const std::exception &e) {
+            state.logger->Error(e.what());
+            signal::BlockSignal({SIGINT});
+            state.process->Kill(false);
+        }
+
+        // Any threads waiting on requests need to be woken up as they'll never be completed now
+        {
+            std::scoped_lock lock(mutex);
+            exiting = true;
+        }
+        completionCondition.notify_all();
+    }
+
+    u64 TextureUploader::Enqueue(std::shared_ptr<Texture> texture, Callback callback) {
+        u64 id;
+        {
+            std::scoped_lock lock(mutex);
+            id = ++lastRequestId;
+            requests.push(UploadRequest{
+                .texture = std::move(texture),
+                .callback = std::move(callback),
+                .id = id,
+                .enqueueTime = util::GetTimeNs(),
+            });
+        }
+        requestCondition.notify_one();
+        return id;
+    }
+
+    bool TextureUploader::IsComplete(u64 id) {
+        std::scoped_lock lock(mutex);
+        return completedRequestId >= id;
+    }
+
+    bool TextureUploader::Wait(u64 id) {
+        std::unique_lock lock(mutex);
+        if (completedRequestId >= id)
+            return true;
+
+        TRACE_EVENT("gpu", "TextureUploader::Wait", "id", id);
+        completionCondition.wait(lock, [&]() { return completedRequestId >= id || exiting; });
+        return completedRequestId >= id;
+    }
+
+    bool TextureUploader::IsCallbackComplete(u64 id) {
+        std::scoped_lock lock(mutex);
+        return completedCallbackId >= id;
+    }
+
+    bool TextureUploader::WaitCallback(u64 id) {
+        std::unique_lock lock(mutex);
+        if (completedCallbackId >= id)
+            return true;
+
+        TRACE_EVENT("gpu", "TextureUploader::WaitCallback", "id", id);
+        completionCondition.wait(lock, [&]() { return completedCallbackId >= id || exiting; });
+        return completedCallbackId >= id;
+    }
+
+    std::shared_ptr<memory::StagingBuffer> TextureUploader::AcquireStagingBuffer(vk::DeviceSize size) {
+        std::scoped_lock lock(stagingMutex);
+
+        StagingBufferSlot *bestSlot{}, *smallSlot{};
+        for (auto &slot : stagingBuffers) {
+            if (slot.cycle && slot.cycle->Poll())
+                slot.cycle.reset();
+            if (slot.cycle || slot.buffer.use_count() != 1)
+                continue; // The buffer is still in use by the GPU or a prior upload
+
+            if (slot.buffer->size() >= size) {
+                if (!bestSlot || slot.buffer->size() < bestSlot->buffer->size())
+                    bestSlot = &slot;
+            } else {
+                smallSlot = &slot;
+            }
+        }
+
+        if (bestSlot)
+            return bestSlot->buffer;
+
+        auto buffer{state.gpu->memory.AllocateStagingBuffer(size)};
+        if (smallSlot)
+            smallSlot->buffer = buffer; // We replace a free buffer that's too small rather than retaining both
+        else if (stagingBuffers.size() < MaxStagingBufferCount)
+            stagingBuffers.push_back(StagingBufferSlot{buffer});
+        return buffer;
+    }
+
+    void TextureUploader::RecycleStagingBuffer(const std::shared_ptr<memory::StagingBuffer> &buffer, const std::shared_ptr<FenceCycle> &cycle) {
+        std::scoped_lock lock(stagingMutex);
+        auto it{std::find_if(stagingBuffers.begin(), stagingBuffers.end(), [&](const StagingBufferSlot &slot) { return slot.buffer == buffer; })};
+        if (it != stagingBuffers.end())
+            it->cycle = cycle;
+    }
+}
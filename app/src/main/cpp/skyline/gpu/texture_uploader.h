@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <queue>
+#include "texture/texture.h"
+
+namespace skyline::gpu {
+    /**
+     * @brief The TextureUploader class performs guest -> host synchronization of textures on a dedicated thread, this allows the guest to continue execution while the contents of a texture are converted and uploaded
+     * @note Callbacks are invoked on a separate thread in the order of their requests, a callback which blocks (such as presentation waiting on the swapchain) doesn't delay any further uploads unless MaxPendingCallbacks callbacks are already pending
+     * @note The staging buffers used for uploads are owned by the uploader, they're reused once the fence cycle of the upload that last used them has been signalled
+     */
+    class TextureUploader {
+      public:
+        using Callback = std::function<void(const std::shared_ptr<Texture> &)>; //!< A function called on the callback thread after a texture has been synchronized, the texture isn't locked during the call
+
+      private:
+        struct UploadRequest {
+            std::shared_ptr<Texture> texture;
+            Callback callback;
+            u64 id;
+            u64 enqueueTime; //!< The time at which the request was enqueued in nanoseconds
+        };
+
+        /**
+         * @brief A staging buffer which is owned by the uploader
+         */
+        struct StagingBufferSlot {
+            std::shared_ptr<memory::StagingBuffer> buffer;
+            std::shared_ptr<FenceCycle> cycle; //!< The fence cycle of the latest copy from the buffer, the buffer can't be reused till it has been signalled
+        };
+
+        const DeviceState &state;
+
+        std::mutex mutex; //!< Synchronizes access to the request queue and request IDs
+        std::condition_variable requestCondition; //!< Signalled when a request has been enqueued
+        std::condition_variable callbackCondition; //!< Signalled when a request with a callback has been completed
+        std::condition_variable completionCondition; //!< Signalled when a request or a callback has been completed or a thread has exited
+        std::queue<UploadRequest> requests;
+        std::queue<UploadRequest> callbacks; //!< Completed requests which have a callback that's yet to be invoked
+        u64 lastRequestId{}; //!< The ID of the latest enqueued request
+        u64 completedRequestId{}; //!< The ID of the latest completed request, requests are always completed in the order they were enqueued
+        u64 completedCallbackId{}; //!< The ID of the latest request with a callback which has returned, callbacks are always invoked in the order of their requests
+        bool exiting{}; //!< If either thread has exited, no further requests will be completed or callbacks invoked after this is set
+
+        static constexpr size_t MaxPendingCallbacks{2}; //!< The maximum amount of callbacks that can be pending at once, the upload thread blocks on any further callbacks till one has returned
+        static constexpr size_t MaxStagingBufferCount{4}; //!< The maximum amount of staging buffers retained by the uploader, any further buffers are freed after their copy has completed
+        std::mutex stagingMutex; //!< Synchronizes access to the staging buffers
+        std::vector<StagingBufferSlot> stagingBuffers;
+
+        std::thread uploadThread; //!< The thread which all upload requests are processed on
+        std::thread callbackThread; //!< The thread which the callbacks of completed requests are invoked on
+
+        /**
+         * @brief The entry point for both threads, it handles any exceptions thrown by the supplied loop
+         * @param name The name of the thread
+         * @param loop The loop which is run on the thread, it only returns if the uploader is exiting
+         */
+        void Run(const char *name, void (TextureUploader::*loop)());
+
+        /**
+         * @brief Synchronizes textures from the request queue and passes on any callbacks to the callback thread
+         */
+        void ProcessUploads();
+
+        /**
+         * @brief Invokes the callbacks of completed requests
+         */
+        void ProcessCallbacks();
+
+      public:
+        TextureUploader(const DeviceState &state);
+
+        ~TextureUploader();
+
+        /**
+         * @brief Enqueues a guest -> host synchronization of the supplied texture to be performed on the upload thread
+         * @param callback A function which is called on the callback thread after the synchronization, it can be used to consume the texture without blocking the caller or any further uploads
+         * @return The ID of the request, it can be used to wait on the guest texture being read
+         * @note The texture must not be locked by the calling thread and it shouldn't be used by any other thread till the request has been completed
+         */
+        u64 Enqueue(std::shared_ptr<Texture> texture, Callback callback = {});
+
+        /**
+         * @return If the request with the supplied ID has been completed, the guest texture won't be read by it anymore after this
+         * @note The upload itself may still be executing on the GPU, Texture::WaitOnFence must be used to wait on it
+         */
+        bool IsComplete(u64 id);
+
+        /**
+         * @brief Blocks till the request with the supplied ID has been completed, this returns immediately for an ID of 0
+         * @return If the request was completed, this is false if the uploader has exited prior to completing it
+         */
+        bool Wait(u64 id);
+
+        /**
+         * @return If the callback of the request with the supplied ID has returned, the request must have been enqueued with a callback
+         * @note This implies the request itself has been completed
+         */
+        bool IsCallbackComplete(u64 id);
+
+        /**
+         * @brief Blocks till the callback of the request with the supplied ID has returned, this returns immediately for an ID of 0
+         * @return If the callback has returned, this is false if the uploader has exited prior to invoking it
+         * @note The request must have been enqueued with a callback and this must not be called from the callback thread
+         */
+        bool WaitCallback(u64 id);
+
+        /**
+         * @return A staging buffer of at least the supplied size, it's either reused from a prior upload or newly allocated
+         */
+        std::shared_ptr<memory::StagingBuffer> AcquireStagingBuffer(vk::DeviceSize size);
+
+        /**
+         * @brief Attaches a staging buffer acquired from AcquireStagingBuffer to the fence cycle of the copy from it, the buffer is reused after the cycle has been signalled
+         */
+        void RecycleStagingBuffer(const std::shared_ptr<memory::StagingBuffer> &buffer, const std::shared_ptr<FenceCycle> &cycle);
+    };
+}
@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <common/settings.h>
+#include "host_affinity.h"
+
+namespace skyline::kernel {
+    /**
+     * @brief A band of guest priorities and the host scheduling parameters it maps to
+     */
+    struct PriorityBand {
+        u8 maxPriority; //!< The numerically highest guest priority inside this band (inclusive)
+        int policy; //!< The host scheduling policy (SCHED_FIFO/SCHED_RR/SCHED_OTHER)
+        int realtimePriority; //!< The realtime priority for SCHED_FIFO/SCHED_RR, this is ignored for SCHED_OTHER
+        int nice; //!< The niceness for SCHED_OTHER, this is also used as the fallback when realtime policies are denied
+    };
+
+    /**
+     * @note HOS priorities are numerically inverted, the bands are sorted from the highest scheduler priority to the lowest
+     * @note Realtime priorities are kept at the bottom of the range as a guest thread spinning on a core shouldn't be able to starve host system threads
+     */
+    constexpr std::array<PriorityBand, 4> PriorityBands{{
+        {15, SCHED_FIFO, 2, -10}, // Realtime guest threads (Audio, Vsync)
+        {31, SCHED_RR, 1, -8}, // Frame-critical guest threads (Rendering)
+        {43, SCHED_OTHER, 0, -4}, // Above-normal guest threads
+        {58, SCHED_OTHER, 0, 0}, // Normal guest threads, the main thread is usually at 44
+    }};
+    constexpr PriorityBand LowestPriorityBand{63, SCHED_OTHER, 0, 5}; //!< Background guest threads, this includes the preemptive priority on cores 0-2
+
+    /**
+     * @brief Parses a Linux kernel format CPU list (Eg: 0-3,6) into a CPU set
+     */
+    static std::optional<cpu_set_t> ParseCpuList(std::string_view list) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        auto parseCpu{[](std::string_view string) -> std::optional<size_t> {
+            if (string.empty())
+                return std::nullopt;
+            size_t cpu{};
+            for (char digit : string) {
+                if (digit < '0' || digit > '9')
+                    return std::nullopt;
+                cpu = (cpu * 10) + (digit - '0');
+            }
+            return cpu < CPU_SETSIZE ? std::optional(cpu) : std::nullopt;
+        }};
+
+        while (!list.empty()) {
+            auto separator{list.find(',')};
+            auto range{list.substr(0, separator)};
+            list = separator == std::string_view::npos ? std::string_view{} : list.substr(separator + 1);
+
+            auto dash{range.find('-')};
+            auto first{parseCpu(range.substr(0, dash))};
+            auto last{dash == std::string_view::npos ? first : parseCpu(range.substr(dash + 1))};
+            if (!first || !last || *first > *last)
+                return std::nullopt;
+
+            for (size_t cpu{*first}; cpu <= *last; cpu++)
+                CPU_SET(cpu, &set);
+        }
+
+        if (!CPU_COUNT(&set))
+            return std::nullopt;
+        return set;
+    }
+
+    HostAffinity::HostAffinity(const DeviceState &state) : state(state), mode(static_cast<Mode>(state.settings->threadPinningMode)), mapPriority(state.settings->threadPriorityMapping) {
+        switch (mode) {
+            case Mode::Disabled:
+                break;
+            case Mode::Automatic:
+                ConfigureAutomatic();
+                break;
+            case Mode::Custom:
+                ConfigureCustom(state.settings->threadPinningMap);
+                break;
+            default:
+                state.logger->Warn("Unknown thread pinning mode: {}", static_cast<u8>(mode));
+                mode = Mode::Disabled;
+                break;
+        }
+
+        state.logger->Info("Thread Pinning: {}, Priority Mapping: {}", ToString(mode), mapPriority);
+    }
+
+    void HostAffinity::ConfigureAutomatic() {
+        auto cpuCount{static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF))};
+        std::vector<u64> maxFrequencies(cpuCount);
+        for (size_t cpu{}; cpu < cpuCount; cpu++) {
+            std::ifstream stream(fmt::format("/sys/devices/system/cpu/cpu{}/cpufreq/cpuinfo_max_freq", cpu));
+            stream >> maxFrequencies[cpu]; // A CPU without a readable frequency is treated as a part of the slowest cluster
+        }
+
+        auto topFrequency{*std::max_element(maxFrequencies.begin(), maxFrequencies.end())};
+        cpu_set_t performanceSet, efficiencySet;
+        CPU_ZERO(&performanceSet);
+        CPU_ZERO(&efficiencySet);
+        size_t primeCpu{};
+        for (size_t cpu{}; cpu < cpuCount; cpu++) {
+            if (topFrequency && maxFrequencies[cpu] == topFrequency) {
+                CPU_SET(cpu, &performanceSet);
+                primeCpu = cpu;
+            } else {
+                CPU_SET(cpu, &efficiencySet);
+            }
+        }
+
+        if (!CPU_COUNT(&performanceSet) || !CPU_COUNT(&efficiencySet)) {
+            // A homogeneous (or unreadable) topology can't be split into clusters, we only dedicate a single CPU to the GPFIFO thread in this case
+            state.logger->Info("Host CPU topology is homogeneous, only the GPFIFO thread will be pinned");
+            if (cpuCount > 2) {
+                cpu_set_t gpfifoSet;
+                CPU_ZERO(&gpfifoSet);
+                CPU_SET(cpuCount - 1, &gpfifoSet);
+                hostThreadSets[static_cast<u8>(HostThread::Gpfifo)] = gpfifoSet;
+            }
+            return;
+        }
+
+        // The GPFIFO thread gets the fastest CPU to itself when the performance cluster can spare one for it
+        cpu_set_t guestSet{performanceSet};
+        if (CPU_COUNT(&performanceSet) > 1) {
+            cpu_set_t gpfifoSet;
+            CPU_ZERO(&gpfifoSet);
+            CPU_SET(primeCpu, &gpfifoSet);
+            hostThreadSets[static_cast<u8>(HostThread::Gpfifo)] = gpfifoSet;
+            CPU_CLR(primeCpu, &guestSet);
+        } else {
+            hostThreadSets[static_cast<u8>(HostThread::Gpfifo)] = performanceSet;
+        }
+
+        // Application cores (0-2) are placed on the performance cluster while the system core (3) and lightweight host threads are placed on the efficiency cluster
+        for (u8 core{}; core < constant::CoreCount - 1; core++)
+            guestCoreSets[core] = guestSet;
+        guestCoreSets[constant::CoreCount - 1] = efficiencySet;
+        hostThreadSets[static_cast<u8>(HostThread::Audio)] = efficiencySet;
+        hostThreadSets[static_cast<u8>(HostThread::Choreographer)] = efficiencySet;
+        hostThreadSets[static_cast<u8>(HostThread::TextureWorker)] = efficiencySet; // Texture work is split across all workers, it shouldn't compete with guest cores for the performance cluster
+
+        state.logger->Info("Host CPU topology: {} performance CPUs @ {} KHz, {} efficiency CPUs, GPFIFO on CPU {}", CPU_COUNT(&performanceSet), topFrequency, CPU_COUNT(&efficiencySet), primeCpu);
+    }
+
+    void HostAffinity::ConfigureCustom(std::string_view map) {
+        constexpr std::array<std::string_view, HostThreadCount> HostThreadNames{"gpfifo", "audio", "choreographer", "texture"};
+
+        while (!map.empty()) {
+            auto separator{map.find(';')};
+            auto entry{map.substr(0, separator)};
+            map = separator == std::string_view::npos ? std::string_view{} : map.substr(separator + 1);
+            if (entry.empty())
+                continue;
+
+            auto equals{entry.find('=')};
+            if (equals == std::string_view::npos) {
+                state.logger->Warn("Invalid thread pinning entry: '{}'", entry);
+                continue;
+            }
+
+            auto target{entry.substr(0, equals)};
+            auto set{ParseCpuList(entry.substr(equals + 1))};
+            if (!set) {
+                state.logger->Warn("Invalid CPU list in thread pinning entry: '{}'", entry);
+                continue;
+            }
+
+            if (target.size() == 1 && target[0] >= '0' && target[0] < '0' + constant::CoreCount) {
+                guestCoreSets[static_cast<u8>(target[0] - '0')] = set;
+            } else {
+                auto name{std::find(HostThreadNames.begin(), HostThreadNames.end(), target)};
+                if (name != HostThreadNames.end())
+                    hostThreadSets[static_cast<size_t>(std::distance(HostThreadNames.begin(), name))] = set;
+                else
+                    state.logger->Warn("Invalid target in thread pinning entry: '{}'", entry);
+            }
+        }
+    }
+
+    void HostAffinity::SetAffinity(const std::optional<cpu_set_t> &set) {
+        if (set && sched_setaffinity(0, sizeof(cpu_set_t), &*set)) [[unlikely]]
+            state.logger->Warn("Failed to set the host CPU affinity: {}", strerror(errno));
+    }
+
+    void HostAffinity::PinToGuestCore(u8 coreId) {
+        if (coreId < constant::CoreCount)
+            SetAffinity(guestCoreSets[coreId]);
+    }
+
+    void HostAffinity::PinHostThread(HostThread thread) {
+        SetAffinity(hostThreadSets[static_cast<u8>(thread)]);
+    }
+
+    void HostAffinity::ApplyPriority(pid_t tid, u8 priority) {
+        if (!mapPriority || !tid)
+            return;
+
+        const auto &band{[priority]() -> const PriorityBand & {
+            for (const auto &band : PriorityBands)
+                if (priority <= band.maxPriority)
+                    return band;
+            return LowestPriorityBand;
+        }()};
+
+        if (band.policy != SCHED_OTHER && !realtimeDenied.load(std::memory_order_relaxed)) {
+            sched_param param{.sched_priority = band.realtimePriority};
+            if (!sched_setscheduler(tid, band.policy, &param))
+                return;
+
+            if (errno == EPERM) {
+                if (!realtimeDenied.exchange(true))
+                    state.logger->Warn("Realtime host scheduling policies are not permitted, falling back to niceness");
+            } else {
+                state.logger->Warn("Failed to set the host scheduling policy of TID {}: {}", tid, strerror(errno));
+            }
+        }
+
+        sched_param param{.sched_priority = 0};
+        sched_setscheduler(tid, SCHED_OTHER, &param); // A thread may be moving out of a realtime band, it needs to be reverted to SCHED_OTHER for the niceness to have any effect
+
+        int nice{band.nice};
+        if (nice < 0 && niceDenied.load(std::memory_order_relaxed))
+            nice = 0;
+
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) && nice < 0) {
+            if ((errno == EACCES || errno == EPERM) && !niceDenied.exchange(true))
+                state.logger->Warn("Negative host niceness is not permitted, guest priorities above normal will not be boosted");
+            setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 0);
+        }
+    }
+
+    void HostAffinity::ResetThread() {
+        if (mode != Mode::Disabled) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (size_t cpu{}, cpuCount{static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF))}; cpu < cpuCount; cpu++)
+                CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(cpu_set_t), &set);
+        }
+
+        if (mapPriority) {
+            sched_param param{.sched_priority = 0};
+            sched_setscheduler(0, SCHED_OTHER, &param);
+            setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), 0);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <sched.h>
+#include <common/macros.h>
+#include "scheduler.h"
+
+namespace skyline::kernel {
+    /**
+     * @brief HostAffinity maps guest scheduling state onto host scheduling state, it pins guest virtual cores and dedicated emulator threads to host CPU sets and maps guest priorities onto host scheduling policies
+     * @note All policies are opt-in, by default neither the host affinity nor the host scheduling policy of any thread is modified
+     */
+    class HostAffinity {
+      public:
+        enum class Mode : u8 {
+            Disabled = 0, //!< No host threads are pinned
+            Automatic = 1, //!< Host CPU sets are derived from the host CPU topology, guest cores are placed onto the highest performance cluster
+            Custom = 2, //!< Host CPU sets are supplied by the user in 'Settings::threadPinningMap'
+        };
+
+        /**
+         * @brief Host threads which aren't backing any guest thread but can be pinned to a dedicated CPU set
+         */
+        enum class HostThread : u8 {
+            Gpfifo,
+            Audio,
+            Choreographer,
+            TextureWorker, //!< The workers of the GPU thread pool which CPU-bound texture work is split across
+        };
+
+        static constexpr size_t HostThreadCount{4};
+
+      private:
+        const DeviceState &state;
+        Mode mode;
+        bool mapPriority; //!< If guest priorities should be mapped onto host scheduling policies
+        std::array<std::optional<cpu_set_t>, constant::CoreCount> guestCoreSets; //!< The host CPU set for every guest core, an empty optional denotes an unpinned core
+        std::array<std::optional<cpu_set_t>, HostThreadCount> hostThreadSets; //!< The host CPU set for every dedicated host thread
+        std::atomic<bool> realtimeDenied{}; //!< Set after the first failure to use a realtime scheduling policy due to a lack of permissions
+        std::atomic<bool> niceDenied{}; //!< Set after the first failure to use a negative nice value due to a lack of permissions
+
+        /**
+         * @brief Derives the CPU sets from the host's CPU topology, CPUs are grouped into clusters by their maximum frequency
+         */
+        void ConfigureAutomatic();
+
+        /**
+         * @brief Parses the CPU sets from a map in the format of 'target=cpulist;...' where the target is a guest core (0-3) or the name of a host thread (gpfifo, audio, choreographer, texture) and the cpulist is in the format of the Linux kernel (Eg: 0-3,6)
+         */
+        void ConfigureCustom(std::string_view map);
+
+        /**
+         * @brief Sets the affinity of the calling thread to the supplied CPU set if one is present
+         */
+        void SetAffinity(const std::optional<cpu_set_t> &set);
+
+      public:
+        HostAffinity(const DeviceState &state);
+
+        /**
+         * @brief Pins the calling thread to the host CPU set of the supplied guest core
+         */
+        void PinToGuestCore(u8 coreId);
+
+        /**
+         * @brief Pins the calling thread to the host CPU set dedicated to the supplied host thread
+         */
+        void PinHostThread(HostThread thread);
+
+        /**
+         * @brief Maps the supplied guest priority onto the host scheduling policy and niceness of the host thread with the supplied TID
+         * @note If the process lacks the permissions for a realtime policy or a negative niceness, it'll fall back to the closest available setting
+         * @note The caller must guarantee that the TID can't be reused during the call, see KThread::UpdateHostPriority
+         */
+        void ApplyPriority(pid_t tid, u8 priority);
+
+        /**
+         * @brief Restores the host affinity and scheduling policy of the calling thread to the defaults, this is used for host threads which stop backing a guest thread
+         */
+        void ResetThread();
+
+        Mode GetMode() const {
+            return mode;
+        }
+
+        /**
+         * @return If guest threads need to be notified about core or priority changes at all
+         */
+        bool Enabled() const {
+            return mode != Mode::Disabled || mapPriority;
+        }
+    };
+
+    ENUM_STRING(HostAffinity::Mode, {
+        ENUM_CASE(Disabled);
+        ENUM_CASE(Automatic);
+        ENUM_CASE(Custom);
+    })
+}
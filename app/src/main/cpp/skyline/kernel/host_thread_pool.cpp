@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unistd.h>
+#include <common/signal.h>
+#include <common/trace.h>
+#include <nce.h>
+#include "types/KThread.h"
+#include "host_thread_pool.h"
+
+namespace skyline::kernel {
+    HostThreadPool::HostThreadPool(const DeviceState &state) : state(state) {
+        std::lock_guard lock(mutex);
+        for (size_t index{}; index < InitialWorkerCount; index++)
+            idleWorkers.push_back(&CreateWorker(nullptr));
+    }
+
+    HostThreadPool::~HostThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            exiting = true;
+            for (auto &worker : workers)
+                worker.condition.notify_one();
+        }
+
+        for (auto &worker : workers)
+            if (worker.thread.joinable())
+                worker.thread.join();
+    }
+
+    HostThreadPool::Worker &HostThreadPool::CreateWorker(std::shared_ptr<type::KThread> guestThread) {
+        auto &worker{workers.emplace_back()};
+        worker.guestThread = std::move(guestThread);
+        worker.thread = std::thread(&HostThreadPool::WorkerMain, this, &worker);
+        return worker;
+    }
+
+    void HostThreadPool::WorkerMain(Worker *worker) {
+        pthread_setname_np(pthread_self(), "HostThreadPool");
+        state.logger->UpdateTag();
+
+        struct sigevent event{
+            .sigev_signo = Scheduler::PreemptionSignal,
+            .sigev_notify = SIGEV_THREAD_ID,
+            .sigev_notify_thread_id = gettid(),
+        };
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &worker->preemptionTimer))
+            throw exception("timer_create has failed with '{}'", strerror(errno));
+
+        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
+        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false);
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            worker->condition.wait(lock, [&]() { return worker->guestThread || exiting; });
+            if (!worker->guestThread)
+                break;
+
+            auto thread{std::move(worker->guestThread)};
+            lock.unlock();
+
+            {
+                std::lock_guard statusLock(thread->statusMutex);
+                thread->pthread = pthread_self();
+                thread->preemptionTimer = worker->preemptionTimer;
+            }
+
+            thread->StartThread();
+
+            {
+                // The timer is only lent to the guest thread, it needs to be detached prior to the guest thread potentially being destroyed or restarted on another worker
+                std::lock_guard statusLock(thread->statusMutex);
+                if (thread->preemptionTimer == worker->preemptionTimer)
+                    thread->preemptionTimer = {};
+            }
+
+            // Any per-thread state from the guest thread shouldn't leak into the next guest thread that's run on this worker
+            struct itimerspec spec{};
+            timer_settime(worker->preemptionTimer, 0, &spec, nullptr);
+            Scheduler::YieldPending = false;
+            state.thread = nullptr;
+            state.ctx = nullptr;
+            thread.reset(); // This may destroy the KThread, it's done without holding the pool lock
+
+            lock.lock();
+            idleWorkers.push_back(worker);
+        }
+
+        timer_delete(worker->preemptionTimer);
+    }
+
+    void HostThreadPool::Run(const std::shared_ptr<type::KThread> &thread) {
+        TRACE_EVENT("kernel", "HostThreadPool::Run");
+        std::lock_guard lock(mutex);
+        if (idleWorkers.empty()) {
+            CreateWorker(thread);
+            return;
+        }
+
+        auto worker{idleWorkers.back()};
+        idleWorkers.pop_back();
+        worker->guestThread = thread;
+        worker->condition.notify_one();
+    }
+}
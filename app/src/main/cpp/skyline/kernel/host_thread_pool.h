@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+#include <condition_variable>
+
+namespace skyline::kernel {
+    /**
+     * @brief A pool of host threads which guest threads are run on, a host thread is created with its preemption timer and signal handlers set up once and is reused for every guest thread it runs
+     * @note Creating a host thread along with its per-thread kernel state is significantly more expensive than handing a guest thread off to an idle host thread, which matters for titles that create short-lived worker threads
+     */
+    class HostThreadPool {
+      private:
+        /**
+         * @brief A single host thread in the pool
+         */
+        struct Worker {
+            std::thread thread;
+            timer_t preemptionTimer{}; //!< A kernel timer bound to this host thread, it's lent to every guest thread that runs on it
+            std::shared_ptr<type::KThread> guestThread; //!< The guest thread which has been handed off to this worker, this is null while the worker is idle
+            std::condition_variable condition; //!< Signalled when a guest thread is handed off to this worker or when the pool is being destroyed
+        };
+
+        const DeviceState &state;
+        std::mutex mutex; //!< Synchronizes all accesses to the workers and their hand-off state
+        std::list<Worker> workers; //!< All workers in the pool, a list is used as workers are referenced by pointer from their own host threads
+        std::vector<Worker *> idleWorkers; //!< A LIFO stack of idle workers, the most recently idled worker is reused first as it's the most likely to have its stack in cache
+        bool exiting{}; //!< If the pool is being destroyed and idle workers should exit
+
+        /**
+         * @brief The entry point of every worker, this sets up the per-thread state and runs any guest threads handed off to it until the pool is destroyed
+         */
+        void WorkerMain(Worker *worker);
+
+        /**
+         * @brief Creates a new worker and starts its host thread
+         * @note 'mutex' **must** be locked by the calling thread prior to calling this
+         */
+        Worker &CreateWorker(std::shared_ptr<type::KThread> guestThread);
+
+      public:
+        static constexpr size_t InitialWorkerCount{4}; //!< The amount of workers created up-front, titles commonly create a few threads during startup
+
+        HostThreadPool(const DeviceState &state);
+
+        ~HostThreadPool();
+
+        /**
+         * @brief Runs the supplied guest thread on an idle host thread from the pool, a new host thread is added to the pool if there are no idle ones
+         * @note The host thread is returned to the pool after the guest thread exits
+         */
+        void Run(const std::shared_ptr<type::KThread> &thread);
+    };
+}
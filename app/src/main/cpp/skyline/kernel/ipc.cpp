@@ -1,11 +1,12 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <nce/guest.h>
 #include "ipc.h"
-#include "types/KProcess.h"
 
 namespace skyline::kernel::ipc {
     IpcRequest::IpcRequest(bool isDomain, const DeviceState &state) : isDomain(isDomain) {
+        bool verbose{state.logger->IsEnabled(Logger::LogLevel::Verbose)}; // We check this once upfront as the arguments for the logs are non-trivial to evaluate
         auto tls{state.ctx->tpidrroEl0};
         u8 *pointer{tls};
 
@@ -29,7 +30,8 @@ namespace skyline::kernel::ipc {
             auto bufX{reinterpret_cast<BufferDescriptorX *>(pointer)};
             if (bufX->Pointer()) {
                 inputBuf.emplace_back(bufX->Pointer(), static_cast<u16>(bufX->size));
-                state.logger->Verbose("Buf X #{}: 0x{:X}, 0x{:X}, #{}", index, bufX->Pointer(), static_cast<u16>(bufX->size), static_cast<u16>(bufX->Counter()));
+                if (verbose)
+                    state.logger->Verbose("Buf X #{}: 0x{:X}, 0x{:X}, #{}", index, bufX->Pointer(), static_cast<u16>(bufX->size), static_cast<u16>(bufX->Counter()));
             }
             pointer += sizeof(BufferDescriptorX);
         }
@@ -38,7 +40,8 @@ namespace skyline::kernel::ipc {
             auto bufA{reinterpret_cast<BufferDescriptorABW *>(pointer)};
             if (bufA->Pointer()) {
                 inputBuf.emplace_back(bufA->Pointer(), bufA->Size());
-                state.logger->Verbose("Buf A #{}: 0x{:X}, 0x{:X}", index, bufA->Pointer(), static_cast<u64>(bufA->Size()));
+                if (verbose)
+                    state.logger->Verbose("Buf A #{}: 0x{:X}, 0x{:X}", index, bufA->Pointer(), static_cast<u64>(bufA->Size()));
             }
             pointer += sizeof(BufferDescriptorABW);
         }
@@ -47,7 +50,8 @@ namespace skyline::kernel::ipc {
             auto bufB{reinterpret_cast<BufferDescriptorABW *>(pointer)};
             if (bufB->Pointer()) {
                 outputBuf.emplace_back(bufB->Pointer(), bufB->Size());
-                state.logger->Verbose("Buf B #{}: 0x{:X}, 0x{:X}", index, bufB->Pointer(), static_cast<u64>(bufB->Size()));
+                if (verbose)
+                    state.logger->Verbose("Buf B #{}: 0x{:X}, 0x{:X}", index, bufB->Pointer(), static_cast<u64>(bufB->Size()));
             }
             pointer += sizeof(BufferDescriptorABW);
         }
@@ -57,7 +61,8 @@ namespace skyline::kernel::ipc {
             if (bufW->Pointer()) {
                 outputBuf.emplace_back(bufW->Pointer(), bufW->Size());
                 outputBuf.emplace_back(bufW->Pointer(), bufW->Size());
-                state.logger->Verbose("Buf W #{}: 0x{:X}, 0x{:X}", index, bufW->Pointer(), static_cast<u16>(bufW->Size()));
+                if (verbose)
+                    state.logger->Verbose("Buf W #{}: 0x{:X}, 0x{:X}", index, bufW->Pointer(), static_cast<u16>(bufW->Size()));
             }
             pointer += sizeof(BufferDescriptorABW);
         }
@@ -94,27 +99,29 @@ namespace skyline::kernel::ipc {
         payloadOffset = cmdArg;
 
         if (payload->magic != util::MakeMagic<u32>("SFCI") && (header->type != CommandType::Control && header->type != CommandType::ControlWithContext && header->type != CommandType::Close) && (!domain || domain->command != DomainCommand::CloseVHandle)) // SFCI is the magic in received IPC messages
-            state.logger->Debug("Unexpected Magic in PayloadHeader: 0x{:X}", static_cast<u32>(payload->magic));
+            LOG_DEBUG(state.logger, "Unexpected Magic in PayloadHeader: 0x{:X}", static_cast<u32>(payload->magic));
 
 
         if (header->cFlag == BufferCFlag::SingleDescriptor) {
             auto bufC{reinterpret_cast<BufferDescriptorC *>(bufCPointer)};
             if (bufC->address) {
                 outputBuf.emplace_back(bufC->Pointer(), static_cast<u16>(bufC->size));
-                state.logger->Verbose("Buf C: 0x{:X}, 0x{:X}", bufC->Pointer(), static_cast<u16>(bufC->size));
+                if (verbose)
+                    state.logger->Verbose("Buf C: 0x{:X}, 0x{:X}", bufC->Pointer(), static_cast<u16>(bufC->size));
             }
         } else if (header->cFlag > BufferCFlag::SingleDescriptor) {
             for (u8 index{}; (static_cast<u8>(header->cFlag) - 2) > index; index++) { // (cFlag - 2) C descriptors are present
                 auto bufC{reinterpret_cast<BufferDescriptorC *>(bufCPointer)};
                 if (bufC->address) {
                     outputBuf.emplace_back(bufC->Pointer(), static_cast<u16>(bufC->size));
-                    state.logger->Verbose("Buf C #{}: 0x{:X}, 0x{:X}", index, bufC->Pointer(), static_cast<u16>(bufC->size));
+                    if (verbose)
+                        state.logger->Verbose("Buf C #{}: 0x{:X}, 0x{:X}", index, bufC->Pointer(), static_cast<u16>(bufC->size));
                 }
                 bufCPointer += sizeof(BufferDescriptorC);
             }
         }
 
-        if (header->type == CommandType::Request || header->type == CommandType::RequestWithContext) {
+        if (verbose && (header->type == CommandType::Request || header->type == CommandType::RequestWithContext)) {
             state.logger->Verbose("Header: Input No: {}, Output No: {}, Raw Size: {}", inputBuf.size(), outputBuf.size(), static_cast<u64>(cmdArgSz));
             if (header->handleDesc)
                 state.logger->Verbose("Handle Descriptor: Send PID: {}, Copy Count: {}, Move Count: {}", static_cast<bool>(handleDesc->sendPid), static_cast<u32>(handleDesc->copyCount), static_cast<u32>(handleDesc->moveCount));
@@ -130,15 +137,16 @@ namespace skyline::kernel::ipc {
         auto tls{state.ctx->tpidrroEl0};
         u8 *pointer{tls};
 
-        memset(tls, 0, constant::TlsIpcSize);
-
+        // Every structure is zero-initialized individually rather than clearing the entire TLS IPC buffer upfront
         auto header{reinterpret_cast<CommandHeader *>(pointer)};
-        header->rawSize = static_cast<u32>((sizeof(PayloadHeader) + payload.size() + (domainObjects.size() * sizeof(KHandle)) + constant::IpcPaddingSum + (isDomain ? sizeof(DomainHeaderRequest) : 0)) / sizeof(u32)); // Size is in 32-bit units because Nintendo
+        *header = {};
+        header->rawSize = static_cast<u32>((sizeof(PayloadHeader) + payloadSize + (domainObjects.size() * sizeof(KHandle)) + constant::IpcPaddingSum + (isDomain ? sizeof(DomainHeaderRequest) : 0)) / sizeof(u32)); // Size is in 32-bit units because Nintendo
         header->handleDesc = (!copyHandles.empty() || !moveHandles.empty());
         pointer += sizeof(CommandHeader);
 
         if (header->handleDesc) {
             auto handleDesc{reinterpret_cast<HandleDescriptor *>(pointer)};
+            *handleDesc = {};
             handleDesc->copyCount = static_cast<u8>(copyHandles.size());
             handleDesc->moveCount = static_cast<u8>(moveHandles.size());
             pointer += sizeof(HandleDescriptor);
@@ -156,10 +164,12 @@ namespace skyline::kernel::ipc {
 
         auto offset{pointer - tls}; // We calculate the relative offset as the absolute one might differ
         auto padding{util::AlignUp(offset, constant::IpcPaddingSum) - offset}; // Calculate the amount of padding at the front
+        std::memset(pointer, 0, padding);
         pointer += padding;
 
         if (isDomain) {
             auto domain{reinterpret_cast<DomainHeaderResponse *>(pointer)};
+            *domain = {};
             domain->outputCount = static_cast<u32>(domainObjects.size());
             pointer += sizeof(DomainHeaderResponse);
         }
@@ -168,11 +178,12 @@ namespace skyline::kernel::ipc {
         payloadHeader->magic = util::MakeMagic<u32>("SFCO"); // SFCO is the magic in IPC responses
         payloadHeader->version = 1;
         payloadHeader->value = errorCode;
+        payloadHeader->token = 0;
         pointer += sizeof(PayloadHeader);
 
-        if (!payload.empty())
-            std::memcpy(pointer, payload.data(), payload.size());
-        pointer += payload.size();
+        if (payloadSize)
+            std::memcpy(pointer, payload.data(), payloadSize);
+        pointer += payloadSize;
 
         if (isDomain) {
             for (auto &domainObject : domainObjects) {
@@ -181,6 +192,8 @@ namespace skyline::kernel::ipc {
             }
         }
 
-        state.logger->Verbose("Output: Raw Size: {}, Result: 0x{:X}, Copy Handles: {}, Move Handles: {}", static_cast<u32>(header->rawSize), static_cast<u32>(payloadHeader->value), copyHandles.size(), moveHandles.size());
+        std::memset(pointer, 0, std::min<size_t>(constant::IpcPaddingSum, static_cast<size_t>((tls + constant::TlsIpcSize) - pointer))); // The trailing padding accounted for in the raw size needs to be cleared as the request may have left data there
+
+        LOG_VERBOSE(state.logger, "Output: Raw Size: {}, Result: 0x{:X}, Copy Handles: {}, Move Handles: {}", static_cast<u32>(header->rawSize), static_cast<u32>(payloadHeader->value), copyHandles.size(), moveHandles.size());
     }
 }
@@ -4,11 +4,15 @@
 #pragma once
 
 #include <common.h>
+#include <common/inline_vector.h>
 
 namespace skyline {
     namespace constant {
         constexpr u8 IpcPaddingSum{0x10}; // The sum of the padding surrounding the data payload
         constexpr u16 TlsIpcSize{0x100}; // The size of the IPC command buffer in a TLS slot
+        constexpr u8 IpcMaxHandles{0xF}; // The maximum amount of copy or move handles, the counts are 4-bit fields in the handle descriptor
+        constexpr u8 IpcMaxBuffers{0xF}; // The maximum amount of buffers of a single type, the counts are 4-bit fields in the command header
+        constexpr u8 IpcMaxDomainObjects{0x10}; // The maximum amount of domain objects in a single message, this is bounded by the TLS IPC buffer rather than the format
     }
 
     namespace kernel::ipc {
@@ -198,11 +202,11 @@ namespace skyline {
             PayloadHeader *payload{};
             u8 *cmdArg{}; //!< A pointer to the data payload
             u64 cmdArgSz{}; //!< The size of the data payload
-            std::vector<KHandle> copyHandles; //!< The handles that should be copied from the server to the client process (The difference is just to match application expectations, there is no real difference b/w copying and moving handles)
-            std::vector<KHandle> moveHandles; //!< The handles that should be moved from the server to the client process rather than copied
-            std::vector<KHandle> domainObjects;
-            std::vector<span<u8>> inputBuf;
-            std::vector<span<u8>> outputBuf;
+            InlineVector<KHandle, constant::IpcMaxHandles> copyHandles; //!< The handles that should be copied from the server to the client process (The difference is just to match application expectations, there is no real difference b/w copying and moving handles)
+            InlineVector<KHandle, constant::IpcMaxHandles> moveHandles; //!< The handles that should be moved from the server to the client process rather than copied
+            InlineVector<KHandle, constant::IpcMaxDomainObjects> domainObjects;
+            InlineVector<span<u8>, constant::IpcMaxBuffers * 2> inputBuf; //!< X and A buffers
+            InlineVector<span<u8>, constant::IpcMaxBuffers * 5> outputBuf; //!< B, W (Inserted twice) and C buffers, C buffer counts are also limited to a 4-bit field
 
             IpcRequest(bool isDomain, const DeviceState &state);
 
@@ -247,13 +251,25 @@ namespace skyline {
         class IpcResponse {
           private:
             const DeviceState &state;
-            std::vector<u8> payload; //!< The contents to be pushed to the data payload
+            std::array<u8, constant::TlsIpcSize> payload; //!< The contents to be pushed to the data payload, this can't be written directly into TLS as the request is read from there while the response is being built
+            size_t payloadSize{}; //!< The amount of bytes which have been pushed to the payload
+
+            /**
+             * @return A pointer to the end of the payload after reserving the supplied amount of bytes at it
+             */
+            u8 *ReservePayload(size_t size) {
+                if (payloadSize + size > payload.size()) [[unlikely]]
+                    throw exception("IPC response payload exceeds the TLS IPC buffer: 0x{:X} + 0x{:X}", payloadSize, size);
+                auto pointer{payload.data() + payloadSize};
+                payloadSize += size;
+                return pointer;
+            }
 
           public:
             Result errorCode{}; //!< The error code to respond with, it's 0 (Success) by default
-            std::vector<KHandle> copyHandles;
-            std::vector<KHandle> moveHandles;
-            std::vector<KHandle> domainObjects;
+            InlineVector<KHandle, constant::IpcMaxHandles> copyHandles;
+            InlineVector<KHandle, constant::IpcMaxHandles> moveHandles;
+            InlineVector<KHandle, constant::IpcMaxDomainObjects> domainObjects;
 
             IpcResponse(const DeviceState &state);
 
@@ -264,9 +280,7 @@ namespace skyline {
              */
             template<typename ValueType>
             void Push(const ValueType &value) {
-                auto size{payload.size()};
-                payload.resize(size + sizeof(ValueType));
-                std::memcpy(payload.data() + size, reinterpret_cast<const u8 *>(&value), sizeof(ValueType));
+                std::memcpy(ReservePayload(sizeof(ValueType)), reinterpret_cast<const u8 *>(&value), sizeof(ValueType));
             }
 
             /**
@@ -274,9 +288,7 @@ namespace skyline {
              * @param string The string to write to the payload
              */
             void Push(std::string_view string) {
-                auto size{payload.size()};
-                payload.resize(size + string.size());
-                std::memcpy(payload.data() + size, string.data(), string.size());
+                std::memcpy(ReservePayload(string.size()), string.data(), string.size());
             }
 
             /**
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::kernel {
+    /**
+     * @brief Raises the priority of an owner thread to the supplied priority if it's higher than the owner's current priority
+     * @tparam ThreadType A thread type with an atomic 'priority' member, this is KThread outside of tests
+     * @return If the owner's priority was raised, this is false if it already had an equal or higher priority
+     */
+    template<typename ThreadType>
+    bool InheritPriority(ThreadType &owner, u8 priority) {
+        u8 ownerPriority;
+        do {
+            // If the owner's priority is already equivalent or higher then we don't need to CAS
+            ownerPriority = owner.priority.load();
+            if (ownerPriority <= priority)
+                return false;
+        } while (!owner.priority.compare_exchange_strong(ownerPriority, priority));
+        return true;
+    }
+
+    /**
+     * @brief Propagates the supplied priority along the chain of threads that a thread is transitively waiting on, stopping at the first owner which already has an equal or higher priority
+     * @tparam ThreadType A thread type with an atomic 'priority', 'waiterMutex', 'waitThread' and 'waiters' members alongside a static 'IsHigherPriority' comparator, this is KThread outside of tests
+     * @param waitingOn The thread that's directly being waited on
+     * @param onBoost A function called with every owner after its priority was raised and its position in the waiter queue of the thread it's waiting on was updated
+     * @note Every boosted owner is reinserted into the priority-sorted waiter queue of the thread it's waiting on, so that the owner of that is boosted in turn
+     */
+    template<typename ThreadType, typename BoostFunction>
+    void PropagatePriorityInheritance(std::shared_ptr<ThreadType> waitingOn, u8 priority, BoostFunction &&onBoost) {
+        while (waitingOn && InheritPriority(*waitingOn, priority)) {
+            std::shared_ptr<ThreadType> nextThread;
+            {
+                std::lock_guard waiterLock(waitingOn->waiterMutex);
+                nextThread = waitingOn->waitThread;
+                if (nextThread) {
+                    // We need to update the location of the owner thread in the waiter queue of the thread it's waiting on
+                    std::lock_guard nextWaiterLock(nextThread->waiterMutex);
+                    auto &piWaiters{nextThread->waiters};
+                    piWaiters.erase(std::find(piWaiters.begin(), piWaiters.end(), waitingOn));
+                    piWaiters.insert(std::upper_bound(piWaiters.begin(), piWaiters.end(), priority, ThreadType::IsHigherPriority), waitingOn);
+                }
+            }
+
+            onBoost(waitingOn);
+            waitingOn = std::move(nextThread);
+        }
+    }
+}
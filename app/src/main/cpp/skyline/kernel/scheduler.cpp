@@ -4,7 +4,8 @@
 #include <unistd.h>
 #include <common/signal.h>
 #include <common/trace.h>
-#include "types/KThread.h"
+#include "types/KProcess.h"
+#include "host_affinity.h"
 #include "scheduler.h"
 
 namespace skyline::kernel {
@@ -84,6 +85,7 @@ namespace skyline::kernel {
 
     void Scheduler::InsertThread(const std::shared_ptr<type::KThread> &thread) {
         auto &core{cores.at(thread->coreId)};
+        thread->readyTimestamp.store(util::GetTimeTicks(), std::memory_order_relaxed);
         std::unique_lock lock(core.mutex);
         auto nextThread{std::upper_bound(core.queue.begin(), core.queue.end(), thread->priority.load(), type::KThread::IsHigherPriority)};
         if (nextThread == core.queue.begin()) {
@@ -132,6 +134,7 @@ namespace skyline::kernel {
         lock.unlock();
 
         thread->coreId = targetCore->id;
+        thread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
         if (wasInserted)
             // We need to add the thread to the ideal core queue, if it was previously its resident core's queue
             InsertThread(thread);
@@ -173,11 +176,45 @@ namespace skyline::kernel {
             thread->scheduleCondition.wait(lock, wakeFunction);
         }
 
-        if (thread->priority == core->preemptionPriority)
+        OnScheduled(thread, *core);
+    }
+
+    void Scheduler::OnScheduled(const std::shared_ptr<type::KThread> &thread, CoreContext &core) {
+        if (thread->priority == core.preemptionPriority)
             // If the thread needs to be preempted then arm its preemption timer
             thread->ArmPreemptionTimer(PreemptiveTimeslice);
 
-        thread->timesliceStart = util::GetTimeTicks();
+        if (thread->pinnedCoreId != core.id) [[unlikely]] {
+            // The host thread needs to follow the guest thread onto the host CPU set of its new resident core
+            thread->pinnedCoreId = core.id;
+            state.hostAffinity->PinToGuestCore(core.id);
+        }
+
+        auto now{util::GetTimeTicks()};
+        auto &statistics{thread->statistics};
+        if (auto readyTimestamp{thread->readyTimestamp.exchange(0, std::memory_order_relaxed)}) {
+            auto readyTicks{now - readyTimestamp};
+            statistics.readyTicks.fetch_add(readyTicks, std::memory_order_relaxed);
+            if (readyTicks > statistics.maxReadyTicks.load(std::memory_order_relaxed))
+                statistics.maxReadyTicks.store(readyTicks, std::memory_order_relaxed); // Only the thread itself updates this, it doesn't need to be a CAS
+        }
+        statistics.scheduleCount.fetch_add(1, std::memory_order_relaxed);
+
+        thread->timesliceStart = now;
+    }
+
+    void Scheduler::OnTimesliceEnd(const std::shared_ptr<type::KThread> &thread) {
+        auto &statistics{thread->statistics};
+        statistics.runTicks.fetch_add(util::GetTimeTicks() - thread->timesliceStart, std::memory_order_relaxed);
+
+        TRACE_EVENT_INSTANT("scheduler", "ThreadStatistics",
+                            "RunTimeNs", util::TicksToNs(statistics.runTicks.load(std::memory_order_relaxed)),
+                            "ReadyTimeNs", util::TicksToNs(statistics.readyTicks.load(std::memory_order_relaxed)),
+                            "MaxReadyTimeNs", util::TicksToNs(statistics.maxReadyTicks.load(std::memory_order_relaxed)),
+                            "Preemptions", statistics.preemptions.load(std::memory_order_relaxed),
+                            "Yields", statistics.yields.load(std::memory_order_relaxed),
+                            "Migrations", statistics.migrations.load(std::memory_order_relaxed),
+                            "PriorityBoosts", statistics.priorityBoosts.load(std::memory_order_relaxed));
     }
 
     bool Scheduler::TimedWaitSchedule(std::chrono::nanoseconds timeout) {
@@ -193,11 +230,7 @@ namespace skyline::kernel {
             }
             return !core->queue.empty() && core->queue.front() == thread;
         })) {
-            if (thread->priority == core->preemptionPriority)
-                thread->ArmPreemptionTimer(PreemptiveTimeslice);
-
-            thread->timesliceStart = util::GetTimeTicks();
-
+            OnScheduled(thread, *core);
             return true;
         } else {
             return false;
@@ -223,6 +256,13 @@ namespace skyline::kernel {
             throw exception("T{} called Rotate while not being in C{}'s queue", thread->id, thread->coreId);
         }
 
+        if (cooperative)
+            thread->statistics.yields.fetch_add(1, std::memory_order_relaxed);
+        else
+            thread->statistics.preemptions.fetch_add(1, std::memory_order_relaxed);
+        OnTimesliceEnd(thread);
+        thread->readyTimestamp.store(util::GetTimeTicks(), std::memory_order_relaxed);
+
         thread->averageTimeslice = (thread->averageTimeslice / 4) + (3 * (util::GetTimeTicks() - thread->timesliceStart / 4));
 
         thread->DisarmPreemptionTimer(); // If a preemptive thread did a cooperative yield then we need to disarm the preemptive timer
@@ -240,8 +280,10 @@ namespace skyline::kernel {
                 it = core.queue.erase(it);
                 if (it == core.queue.begin()) {
                     // We need to update the averageTimeslice accordingly, if we've been unscheduled by this
-                    if (thread->timesliceStart)
+                    if (thread->timesliceStart) {
                         thread->averageTimeslice = (thread->averageTimeslice / 4) + (3 * (util::GetTimeTicks() - thread->timesliceStart / 4));
+                        OnTimesliceEnd(thread);
+                    }
 
                     if (it != core.queue.end())
                         (*it)->scheduleCondition.notify_one(); // We need to wake the thread at the front of the queue, if we were at the front previously
@@ -256,6 +298,8 @@ namespace skyline::kernel {
     }
 
     void Scheduler::UpdatePriority(const std::shared_ptr<type::KThread> &thread) {
+        thread->UpdateHostPriority();
+
         std::lock_guard migrationLock(thread->coreMigrationMutex);
         auto *core{&cores.at(thread->coreId)};
         std::unique_lock coreLock(core->mutex);
@@ -321,6 +365,9 @@ namespace skyline::kernel {
             thread->scheduleCondition.wait(lock, [&]() { return parkedQueue.front() == thread && thread->coreId != constant::ParkedCoreId; });
         }
 
+        if (thread->coreId != originalCoreId)
+            thread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
+
         InsertThread(thread);
     }
 
@@ -343,4 +390,47 @@ namespace skyline::kernel {
             }
         }
     }
+
+    std::vector<Scheduler::ThreadStatistics> Scheduler::GetThreadStatistics() {
+        std::vector<ThreadStatistics> snapshot;
+        if (!state.process)
+            return snapshot;
+
+        for (const auto &thread : state.process->GetThreads()) {
+            const auto &statistics{thread->statistics};
+            auto scheduleCount{statistics.scheduleCount.load(std::memory_order_relaxed)};
+            auto readyTimeNs{util::TicksToNs(statistics.readyTicks.load(std::memory_order_relaxed))};
+            snapshot.push_back(ThreadStatistics{
+                .id = thread->id,
+                .priority = thread->priority.load(),
+                .coreId = thread->coreId,
+                .runTimeNs = util::TicksToNs(statistics.runTicks.load(std::memory_order_relaxed)),
+                .readyTimeNs = readyTimeNs,
+                .maxReadyTimeNs = util::TicksToNs(statistics.maxReadyTicks.load(std::memory_order_relaxed)),
+                .averageReadyTimeNs = scheduleCount ? readyTimeNs / scheduleCount : 0,
+                .scheduleCount = scheduleCount,
+                .preemptions = statistics.preemptions.load(std::memory_order_relaxed),
+                .yields = statistics.yields.load(std::memory_order_relaxed),
+                .migrations = statistics.migrations.load(std::memory_order_relaxed),
+                .priorityBoosts = statistics.priorityBoosts.load(std::memory_order_relaxed),
+            });
+        }
+
+        std::sort(snapshot.begin(), snapshot.end(), [](const ThreadStatistics &a, const ThreadStatistics &b) {
+            return a.averageReadyTimeNs > b.averageReadyTimeNs;
+        });
+        return snapshot;
+    }
+
+    void Scheduler::LogThreadStatistics() {
+        std::string table;
+        for (const auto &thread : GetThreadStatistics())
+            table += fmt::format("\n  T{:<3} P{:<2} C{:<2} Run: {:>10}us Ready: {:>10}us (Avg: {:>8}us, Max: {:>8}us) Scheduled: {:<8} Preempted: {:<6} Yielded: {:<8} Migrated: {:<6} PI Boosted: {}",
+                                 thread.id, thread.priority, thread.coreId,
+                                 thread.runTimeNs / constant::NsInMicrosecond, thread.readyTimeNs / constant::NsInMicrosecond,
+                                 thread.averageReadyTimeNs / constant::NsInMicrosecond, thread.maxReadyTimeNs / constant::NsInMicrosecond,
+                                 thread.scheduleCount, thread.preemptions, thread.yields, thread.migrations, thread.priorityBoosts);
+        if (!table.empty())
+            state.logger->InfoNoPrefix("Scheduler Statistics (Sorted by average ready-queue latency):{}", table);
+    }
 }
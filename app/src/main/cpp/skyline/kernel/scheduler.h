@@ -64,6 +64,17 @@ namespace skyline {
              */
             void MigrateToCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&currentCore, CoreContext *targetCore, std::unique_lock<std::mutex> &lock);
 
+            /**
+             * @brief Updates the state of the calling thread after it has been scheduled on its resident core
+             * @note 'CoreContext::mutex' of the resident core **must** be locked by the calling thread prior to calling this
+             */
+            void OnScheduled(const std::shared_ptr<type::KThread> &thread, CoreContext &core);
+
+            /**
+             * @brief Accounts for the end of the current timeslice of the calling thread in its statistics
+             */
+            static void OnTimesliceEnd(const std::shared_ptr<type::KThread> &thread);
+
           public:
             static constexpr std::chrono::milliseconds PreemptiveTimeslice{10}; //!< The duration of time a preemptive thread can run before yielding
             inline static int YieldSignal{SIGRTMIN}; //!< The signal used to cause a non-cooperative yield in running threads
@@ -137,6 +148,34 @@ namespace skyline {
              * @note We will only wake a thread if it's determined to be a better pick than the thread which would be run on this core next
              */
             void WakeParkedThread();
+
+            /**
+             * @brief A point-in-time copy of the scheduler statistics of a single thread
+             */
+            struct ThreadStatistics {
+                size_t id;
+                u8 priority;
+                i8 coreId;
+                u64 runTimeNs; //!< The total duration the thread has been running on a core
+                u64 readyTimeNs; //!< The total duration the thread has been ready but waiting to be scheduled
+                u64 maxReadyTimeNs; //!< The longest single duration the thread has been ready but waiting to be scheduled
+                u64 averageReadyTimeNs; //!< The average ready-queue latency of the thread
+                u32 scheduleCount;
+                u32 preemptions;
+                u32 yields;
+                u32 migrations;
+                u32 priorityBoosts;
+            };
+
+            /**
+             * @return The scheduler statistics of all threads in the current process, sorted by their average ready-queue latency from the highest to the lowest
+             */
+            std::vector<ThreadStatistics> GetThreadStatistics();
+
+            /**
+             * @brief Writes a table of the scheduler statistics of all threads in the current process to the log
+             */
+            void LogThreadStatistics();
         };
 
         /**
@@ -435,6 +435,7 @@ namespace skyline::kernel::svc {
                 if (thread == state.thread) {
                     state.scheduler->RemoveThread();
                     thread->coreId = idealCore;
+                    thread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
                     state.scheduler->InsertThread(state.thread);
                     state.scheduler->WaitSchedule();
                 } else if (!thread->running) {
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <bit>
+#include <numeric>
+#include "svc.h"
+#include "svc_statistics.h"
+
+namespace skyline::kernel::svc {
+    static_assert(SvcStatistics::SvcCount == SvcTable.size());
+
+    namespace {
+        /**
+         * @brief The counters of a single SVC in a thread's block, these are atomic to allow merging from other threads but are only ever written by the owning thread
+         */
+        struct ThreadCounters {
+            std::atomic<u64> calls;
+            std::atomic<u64> totalNs;
+            std::atomic<u64> maxNs;
+            std::atomic<u64> reschedules;
+            std::array<std::atomic<u64>, SvcStatistics::HistogramBucketCount> histogram;
+        };
+
+        /**
+         * @brief Adds to a counter which only has a single writer, this avoids the cost of an atomic read-modify-write
+         */
+        void Add(std::atomic<u64> &counter, u64 value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        struct ThreadBlock;
+
+        /**
+         * @brief The registry of all live thread blocks alongside the merged counters of threads which have exited
+         */
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadBlock *> blocks;
+            std::array<SvcStatistics::Counters, SvcStatistics::SvcCount> retired{};
+            u64 retiredCalls{};
+        };
+
+        Registry &GetRegistry() {
+            static Registry registry; // This is never destroyed prior to any thread blocks as it's constructed before the first of them
+            return registry;
+        }
+
+        void Merge(std::array<SvcStatistics::Counters, SvcStatistics::SvcCount> &output, const std::array<ThreadCounters, SvcStatistics::SvcCount> &input) {
+            for (size_t id{}; id < SvcStatistics::SvcCount; id++) {
+                auto &out{output[id]};
+                const auto &in{input[id]};
+                out.calls += in.calls.load(std::memory_order_relaxed);
+                out.totalNs += in.totalNs.load(std::memory_order_relaxed);
+                out.maxNs = std::max(out.maxNs, in.maxNs.load(std::memory_order_relaxed));
+                out.reschedules += in.reschedules.load(std::memory_order_relaxed);
+                for (size_t bucket{}; bucket < SvcStatistics::HistogramBucketCount; bucket++)
+                    out.histogram[bucket] += in.histogram[bucket].load(std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief The counter block of a single host thread, it registers itself on construction and folds its counters into the retired counters on thread exit
+         */
+        struct ThreadBlock {
+            std::array<ThreadCounters, SvcStatistics::SvcCount> counters{};
+            std::atomic<u64> totalCalls{};
+
+            ThreadBlock() {
+                auto &registry{GetRegistry()};
+                std::lock_guard lock(registry.mutex);
+                registry.blocks.push_back(this);
+            }
+
+            ~ThreadBlock() {
+                auto &registry{GetRegistry()};
+                std::lock_guard lock(registry.mutex);
+                Merge(registry.retired, counters);
+                registry.retiredCalls += totalCalls.load(std::memory_order_relaxed);
+                registry.blocks.erase(std::find(registry.blocks.begin(), registry.blocks.end(), this));
+            }
+        };
+
+        thread_local ThreadBlock threadBlock;
+    }
+
+    void SvcStatistics::Record(u8 svcId, u64 durationNs, bool rescheduled) {
+        auto &counters{threadBlock.counters[svcId]};
+        Add(counters.calls, 1);
+        Add(counters.totalNs, durationNs);
+        if (durationNs > counters.maxNs.load(std::memory_order_relaxed))
+            counters.maxNs.store(durationNs, std::memory_order_relaxed);
+        if (rescheduled)
+            Add(counters.reschedules, 1);
+
+        auto bucket{static_cast<size_t>(std::bit_width(durationNs >> HistogramBaseShift))};
+        Add(counters.histogram[std::min(bucket, HistogramBucketCount - 1)], 1);
+
+        Add(threadBlock.totalCalls, 1);
+    }
+
+    std::array<SvcStatistics::Counters, SvcStatistics::SvcCount> SvcStatistics::Collect() {
+        auto &registry{GetRegistry()};
+        std::lock_guard lock(registry.mutex);
+        auto counters{registry.retired};
+        for (auto block : registry.blocks)
+            Merge(counters, block->counters);
+        return counters;
+    }
+
+    u64 SvcStatistics::GetTotalCalls() {
+        auto &registry{GetRegistry()};
+        std::lock_guard lock(registry.mutex);
+        u64 calls{registry.retiredCalls};
+        for (auto block : registry.blocks)
+            calls += block->totalCalls.load(std::memory_order_relaxed);
+        return calls;
+    }
+
+    void SvcStatistics::Reset() {
+        auto &registry{GetRegistry()};
+        std::lock_guard lock(registry.mutex);
+        registry.retired = {};
+        registry.retiredCalls = 0;
+        for (auto block : registry.blocks) {
+            for (auto &counters : block->counters) {
+                counters.calls.store(0, std::memory_order_relaxed);
+                counters.totalNs.store(0, std::memory_order_relaxed);
+                counters.maxNs.store(0, std::memory_order_relaxed);
+                counters.reschedules.store(0, std::memory_order_relaxed);
+                for (auto &bucket : counters.histogram)
+                    bucket.store(0, std::memory_order_relaxed);
+            }
+            block->totalCalls.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void SvcStatistics::Log(const DeviceState &state) {
+        auto counters{Collect()};
+
+        std::array<u8, SvcCount> order;
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](u8 a, u8 b) { return counters[a].totalNs > counters[b].totalNs; });
+
+        std::string table;
+        for (auto id : order) {
+            const auto &svc{counters[id]};
+            if (!svc.calls)
+                continue; // SVCs which were called can still have a total time of 0ns with a coarse clock, so this can't stop at the first uncalled SVC
+
+            std::string histogram;
+            for (auto count : svc.histogram)
+                histogram += fmt::format("{}{}", histogram.empty() ? "" : " ", count);
+
+            table += fmt::format("\n  {:<28} Calls: {:<10} Total: {:>10}us Avg: {:>8}ns Max: {:>10}ns Rescheduled: {:<8} Histogram: [{}]",
+                                 SvcTable[id].function ? SvcTable[id].name : "Unknown", svc.calls, svc.totalNs / constant::NsInMicrosecond,
+                                 svc.totalNs / svc.calls, svc.maxNs, svc.reschedules, histogram);
+        }
+
+        if (!table.empty())
+            state.logger->InfoNoPrefix("SVC Statistics (Sorted by total host time):{}", table);
+    }
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::kernel::svc {
+    /**
+     * @brief SvcStatistics aggregates the call count and host latency of every SVC, each host thread records into its own counter block and blocks are only merged when read
+     * @note The counters are process-global rather than tied to a DeviceState as host threads may outlive the emulation session which their counters were recorded in
+     */
+    class SvcStatistics {
+      public:
+        static constexpr size_t SvcCount{0x80}; //!< The amount of SVC IDs, this matches the size of the SVC table
+        static constexpr size_t HistogramBucketCount{24}; //!< The amount of log2-scale latency buckets
+        static constexpr size_t HistogramBaseShift{8}; //!< Bucket 0 contains latencies below 2^8 nanoseconds while bucket N contains latencies in the range [2^(N+7), 2^(N+8)) nanoseconds
+
+        /**
+         * @brief The merged statistics of a single SVC
+         */
+        struct Counters {
+            u64 calls;
+            u64 totalNs; //!< The cumulative host time spent inside the SVC
+            u64 maxNs; //!< The longest host time spent inside a single call to the SVC
+            u64 reschedules; //!< The amount of calls which ended with the calling thread being rescheduled due to a pending yield
+            std::array<u64, HistogramBucketCount> histogram;
+        };
+
+        /**
+         * @brief Records a single call to an SVC into the counter block of the calling thread
+         */
+        static void Record(u8 svcId, u64 durationNs, bool rescheduled);
+
+        /**
+         * @return The statistics of every SVC merged across all host threads, including ones which have exited
+         */
+        static std::array<Counters, SvcCount> Collect();
+
+        /**
+         * @return The total amount of SVCs which have been called across all host threads, this is significantly cheaper than Collect
+         */
+        static u64 GetTotalCalls();
+
+        /**
+         * @brief Clears all counters, this should be called prior to any guest threads running
+         */
+        static void Reset();
+
+        /**
+         * @brief Writes a table of the statistics of all SVCs which have been called to the log, sorted by the cumulative host time spent inside them
+         */
+        static void Log(const DeviceState &state);
+    };
+}
@@ -5,6 +5,7 @@
 #include <os.h>
 #include <common/trace.h>
 #include <kernel/results.h>
+#include <kernel/priority_inheritance.h>
 #include "KProcess.h"
 
 namespace skyline::kernel::type {
@@ -63,6 +64,11 @@ namespace skyline::kernel::type {
         return tlsPage->ReserveSlot();
     }
 
+    std::vector<std::shared_ptr<KThread>> KProcess::GetThreads() {
+        std::lock_guard guard(threadMutex);
+        return threads;
+    }
+
     std::shared_ptr<KThread> KProcess::CreateThread(void *entry, u64 argument, void *stackTop, std::optional<u8> priority, std::optional<u8> idealCore) {
         std::lock_guard guard(threadMutex);
         if (disableThreadCreation)
@@ -191,11 +197,8 @@ namespace skyline::kernel::type {
 
             if (nextWaiter) {
                 // If there is a waiter on the new owner then try to inherit its priority
-                u8 priority, ownerPriority;
-                do {
-                    ownerPriority = nextOwner->priority.load();
-                    priority = std::min(ownerPriority, nextWaiter->priority.load());
-                } while (ownerPriority != priority && nextOwner->priority.compare_exchange_strong(ownerPriority, priority));
+                if (InheritPriority(*nextOwner, nextWaiter->priority.load()))
+                    nextOwner->statistics.priorityBoosts.fetch_add(1, std::memory_order_relaxed);
 
                 __atomic_store_n(mutex, nextOwner->waitTag | HandleWaitersBit, __ATOMIC_SEQ_CST);
             } else {
@@ -79,6 +79,11 @@ namespace skyline {
              */
             void Kill(bool join, bool all = false, bool disableCreation = false);
 
+            /**
+             * @return A copy of the list of all threads which have been created in this process
+             */
+            std::vector<std::shared_ptr<KThread>> GetThreads();
+
             /**
              * @brief This initializes the process heap and TLS Error Context slot pointer, it should be called prior to creating the first thread
              * @note This requires VMM regions to be initialized, it will map heap at an arbitrary location otherwise
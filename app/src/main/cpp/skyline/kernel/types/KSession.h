@@ -16,10 +16,11 @@ namespace skyline::kernel::type {
     class KSession : public KSyncObject {
       public:
         std::shared_ptr<service::BaseService> serviceObject;
+        std::mutex domainMutex; //!< Synchronizes accesses to 'domains' and 'handleIndex' as a session may be used from multiple guest threads
         std::vector<std::shared_ptr<service::BaseService>> domains; //!< A vector of services that correspond to virtual handles
         KHandle handleIndex{}; //!< The currently allocated handle index
-        bool isOpen{true}; //!< If the session is open or not
-        bool isDomain{}; //!< If this is a domain session or not
+        std::atomic<bool> isOpen{true}; //!< If the session is open or not
+        std::atomic<bool> isDomain{}; //!< If this is a domain session or not, it's only set while holding 'domainMutex' and needs to be read under it when 'domains' is accessed based on it
 
         /**
          * @param serviceObject A shared pointer to the service class
@@ -32,6 +33,7 @@ namespace skyline::kernel::type {
          * @return The virtual handle of this service in the domain
          */
         KHandle ConvertDomain() {
+            std::lock_guard domainLock(domainMutex);
             isDomain = true;
             domains.push_back(serviceObject);
             return handleIndex++;
@@ -7,6 +7,8 @@
 #include <common/trace.h>
 #include <nce.h>
 #include <os.h>
+#include <kernel/host_affinity.h>
+#include <kernel/priority_inheritance.h>
 #include "KProcess.h"
 #include "KThread.h"
 
@@ -17,8 +19,6 @@ namespace skyline::kernel::type {
 
     KThread::~KThread() {
         Kill(true);
-        if (thread.joinable())
-            thread.join();
         if (preemptionTimer)
             timer_delete(preemptionTimer);
     }
@@ -29,6 +29,10 @@ namespace skyline::kernel::type {
         pthread_setname_np(pthread, fmt::format("HOS-{}", id).c_str());
         state.logger->UpdateTag();
 
+        hostTid = gettid();
+        pinnedCoreId = constant::ParkedCoreId;
+        state.hostAffinity->ApplyPriority(hostTid, priority);
+
         if (!ctx.tpidrroEl0)
             ctx.tpidrroEl0 = parent->AllocateTlsSlot();
 
@@ -43,11 +47,14 @@ namespace skyline::kernel::type {
                 std::lock_guard lock(statusMutex);
                 running = false;
                 ready = false;
+                hostTid = 0;
                 statusCondition.notify_all();
             }
 
             Signal();
 
+            state.hostAffinity->ResetThread(); // The host thread may continue running host code after this (Eg: The main thread), it shouldn't retain the guest's host affinity or scheduling policy
+
             if (threadName[0] != 'H' || threadName[1] != 'O' || threadName[2] != 'S' || threadName[3] != '-') {
                 pthread_setname_np(pthread, threadName.data());
                 state.logger->UpdateTag();
@@ -56,16 +63,19 @@ namespace skyline::kernel::type {
             return;
         }
 
-        struct sigevent event{
-            .sigev_signo = Scheduler::PreemptionSignal,
-            .sigev_notify = SIGEV_THREAD_ID,
-            .sigev_notify_thread_id = gettid(),
-        };
-        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preemptionTimer))
-            throw exception("timer_create has failed with '{}'", strerror(errno));
+        if (!preemptionTimer) {
+            // Threads run on a HostThreadPool worker have their timer and signal handlers set up by the worker, only threads started on the calling thread need to do so
+            struct sigevent event{
+                .sigev_signo = Scheduler::PreemptionSignal,
+                .sigev_notify = SIGEV_THREAD_ID,
+                .sigev_notify_thread_id = gettid(),
+            };
+            if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preemptionTimer))
+                throw exception("timer_create has failed with '{}'", strerror(errno));
 
-        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
-        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
+            signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
+        }
 
         {
             std::lock_guard lock(statusMutex);
@@ -203,8 +213,7 @@ namespace skyline::kernel::type {
                 lock.unlock();
                 StartThread();
             } else {
-                thread = std::thread(&KThread::StartThread, this);
-                pthread = thread.native_handle();
+                state.threadPool->Run(shared_from_this());
             }
         }
     }
@@ -256,35 +265,16 @@ namespace skyline::kernel::type {
         }
     }
 
-    void KThread::UpdatePriorityInheritance() {
-        auto waitingOn{waitThread};
-        u8 currentPriority{priority.load()};
-        while (waitingOn) {
-            u8 ownerPriority;
-            do {
-                // Try to CAS the priority of the owner with the current thread
-                // If the new priority is equivalent to the current priority then we don't need to CAS
-                ownerPriority = waitingOn->priority.load();
-                if (ownerPriority <= currentPriority)
-                    return;
-            } while (waitingOn->priority.compare_exchange_strong(ownerPriority, currentPriority));
+    void KThread::UpdateHostPriority() {
+        std::lock_guard lock(statusMutex);
+        if (hostTid)
+            state.hostAffinity->ApplyPriority(hostTid, priority);
+    }
 
-            if (ownerPriority != currentPriority) {
-                std::lock_guard waiterLock(waitingOn->waiterMutex);
-                auto nextThread{waitingOn->waitThread};
-                if (nextThread) {
-                    // We need to update the location of the owner thread in the waiter queue of the thread it's waiting on
-                    std::lock_guard nextWaiterLock(nextThread->waiterMutex);
-                    auto &piWaiters{nextThread->waiters};
-                    piWaiters.erase(std::find(piWaiters.begin(), piWaiters.end(), waitingOn));
-                    piWaiters.insert(std::upper_bound(piWaiters.begin(), piWaiters.end(), currentPriority, KThread::IsHigherPriority), waitingOn);
-                    break;
-                }
-                state.scheduler->UpdatePriority(waitingOn);
-                waitingOn = nextThread;
-            } else {
-                break;
-            }
-        }
+    void KThread::UpdatePriorityInheritance() {
+        PropagatePriorityInheritance(waitThread, priority.load(), [this](const std::shared_ptr<KThread> &owner) {
+            owner->statistics.priorityBoosts.fetch_add(1, std::memory_order_relaxed);
+            state.scheduler->UpdatePriority(owner);
+        });
     }
 }
@@ -6,6 +6,7 @@
 #include <csetjmp>
 #include <nce/guest.h>
 #include <kernel/scheduler.h>
+#include <kernel/host_thread_pool.h>
 #include <common/signal.h>
 #include "KSyncObject.h"
 #include "KPrivateMemory.h"
@@ -19,13 +20,14 @@ namespace skyline {
         class KThread : public KSyncObject, public std::enable_shared_from_this<KThread> {
           private:
             KProcess *parent;
-            std::thread thread; //!< If this KThread is backed by a host thread then this'll hold it
             pthread_t pthread{}; //!< The pthread_t for the host thread running this guest thread
-            timer_t preemptionTimer{}; //!< A kernel timer used for preemption interrupts
+            timer_t preemptionTimer{}; //!< A kernel timer used for preemption interrupts, this is lent by the HostThreadPool worker running this thread if it isn't started on the calling thread
+
+            friend HostThreadPool;
 
             /**
              * @brief Entry function any guest threads, sets up necessary context and jumps into guest code from the calling thread
-             * @note This function also serves as the entry point for host threads created in StartThread
+             * @note This function also serves as the entry point for guest threads run on a HostThreadPool worker
              */
             void StartThread();
 
@@ -55,8 +57,26 @@ namespace skyline {
             i8 coreId; //!< The CPU core on which this thread is running
             CoreMask affinityMask{}; //!< A mask of CPU cores this thread is allowed to run on
 
+            std::atomic<pid_t> hostTid{}; //!< The TID of the host thread running this guest thread, this is 0 while the thread isn't running and it's only cleared while holding 'statusMutex'
+            u8 pinnedCoreId{constant::ParkedCoreId}; //!< The guest core whose host CPU set the host thread is currently pinned to
+
             u64 timesliceStart{}; //!< A timestamp in host CNTVCT ticks of when the thread's current timeslice started
             u64 averageTimeslice{}; //!< A weighted average of the timeslice duration for this thread
+            std::atomic<u64> readyTimestamp{}; //!< A timestamp in host CNTVCT ticks of when the thread was last made ready to run in its resident core's queue, it's written by the readying thread and consumed by the thread itself once scheduled
+
+            /**
+             * @brief Cumulative scheduler statistics for this thread, all counters are relaxed atomics as they're only read for diagnostics
+             */
+            struct SchedulerStatistics {
+                std::atomic<u64> runTicks; //!< The total duration this thread has been scheduled on a core in CNTVCT ticks
+                std::atomic<u64> readyTicks; //!< The total duration this thread has been ready but waiting to be scheduled in CNTVCT ticks
+                std::atomic<u64> maxReadyTicks; //!< The longest duration this thread has been ready but waiting to be scheduled in CNTVCT ticks
+                std::atomic<u32> scheduleCount; //!< The amount of times this thread has been scheduled
+                std::atomic<u32> preemptions; //!< The amount of times this thread has been forcefully yielded (Preemption or a higher priority thread)
+                std::atomic<u32> yields; //!< The amount of times this thread has cooperatively yielded
+                std::atomic<u32> migrations; //!< The amount of times this thread has been migrated to another core
+                std::atomic<u32> priorityBoosts; //!< The amount of times this thread's priority has been raised due to priority-inheritance
+            } statistics{};
 
             bool isPreempted{}; //!< If the preemption timer has been armed and will fire
             bool pendingYield{}; //!< If the thread has been yielded and hasn't been acted upon it yet
@@ -103,6 +123,12 @@ namespace skyline {
              */
             void DisarmPreemptionTimer();
 
+            /**
+             * @brief Maps the current priority of the thread onto the host thread backing it, if there is one
+             * @note The host TID is only used while holding the status lock as the host thread could otherwise exit (or move onto another guest thread) and its TID be reused
+             */
+            void UpdateHostPriority();
+
             /**
              * @brief Recursively updates the priority for any threads this thread might be waiting on
              * @note PI is performed by temporarily upgrading a thread's priority if a thread waiting on it has a higher priority to prevent priority inversion
@@ -9,6 +9,7 @@
 #include "jvm.h"
 #include "kernel/types/KProcess.h"
 #include "kernel/svc.h"
+#include "kernel/svc_statistics.h"
 #include "nce/guest.h"
 #include "nce/instructions.h"
 #include "nce.h"
@@ -20,18 +21,24 @@ namespace skyline::nce {
         const auto &state{*ctx->state};
         auto svc{kernel::svc::SvcTable[svcId]};
         try {
+            u64 durationTicks{};
             if (svc) [[likely]] {
                 TRACE_EVENT("kernel", perfetto::StaticString{svc.name});
+                auto start{util::GetTimeTicks()};
                 (svc.function)(state);
+                durationTicks = util::GetTimeTicks() - start;
             } else {
                 throw exception("Unimplemented SVC 0x{:X}", svcId);
             }
 
+            bool rescheduled{kernel::Scheduler::YieldPending};
             while (kernel::Scheduler::YieldPending) [[unlikely]] {
                 state.scheduler->Rotate(false);
                 kernel::Scheduler::YieldPending = false;
                 state.scheduler->WaitSchedule();
             }
+
+            kernel::svc::SvcStatistics::Record(static_cast<u8>(svcId), util::TicksToNs(durationTicks), rescheduled);
         } catch (const signal::SignalException &e) {
             if (e.signal != SIGINT) {
                 state.logger->ErrorNoPrefix("{} (SVC: {})\nStack Trace:{}", e.what(), svc.name, state.loader->GetStackTrace(e.frames));
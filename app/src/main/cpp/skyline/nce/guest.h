@@ -123,7 +123,7 @@ namespace skyline {
              * @brief Rescales the host clock to Tegra X1 levels
              * @note Output is on stack with the stack pointer offset 32B from the initial point
              */
-            extern "C" __noreturn void RescaleClock(void);
+            extern "C" [[noreturn]] void RescaleClock(void);
         }
     }
 }
@@ -3,7 +3,9 @@
 
 #include "nce.h"
 #include "nce/guest.h"
+#include "kernel/scheduler.h"
 #include "kernel/types/KProcess.h"
+#include "kernel/svc_statistics.h"
 #include "vfs/os_backing.h"
 #include "loader/nro.h"
 #include "loader/nso.h"
@@ -55,8 +57,12 @@ namespace skyline::kernel {
         process->InitializeHeapTls();
         auto thread{process->CreateThread(entry)};
         if (thread) {
+            kernel::svc::SvcStatistics::Reset();
             state.logger->Debug("Starting main HOS thread");
             thread->Start(true);
+            state.scheduler->LogThreadStatistics();
+            serviceManager.profiler.LogStatistics();
+            kernel::svc::SvcStatistics::Log(state);
             process->Kill(true, true, true);
         }
     }
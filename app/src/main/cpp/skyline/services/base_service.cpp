@@ -28,7 +28,7 @@ namespace skyline::service {
             state.logger->Warn("Cannot find function in service '{0}': 0x{1:X} ({1})", GetName(), static_cast<u32>(request.payload->value));
             return {};
         }
-        TRACE_EVENT("service", perfetto::StaticString{function.name});
+        TRACE_EVENT("service", perfetto::StaticString{function.name}, "CommandId", static_cast<u32>(request.payload->value));
         try {
             return function(session, request, response);
         } catch (const std::exception &e) {
@@ -36,6 +36,7 @@ namespace skyline::service {
     using ServiceName = u64; //!< Service names are a maximum of 8 bytes so we use a u64 to store them
 
     class ServiceManager;
+    struct ServiceSlot;
 
     /**
      * @brief The base class for the HOS service interfaces hosted by sysmodules
@@ -43,6 +44,10 @@ namespace skyline::service {
     class BaseService {
       private:
         std::string name; //!< The name of the service, it's only assigned after GetName is called and shouldn't be used directly
+        ServiceSlot *registrySlot{}; //!< The slot of this service in ServiceManager if it was created by name, this allows it to be evicted without a search when its session is closed
+        u32 sessionCount{}; //!< The amount of sessions and domain objects referencing this service, this is only tracked for services created by name as it determines when they're evicted from their slot and it's guarded by the mutex of the slot
+
+        friend ServiceManager;
 
       protected:
         const DeviceState &state;
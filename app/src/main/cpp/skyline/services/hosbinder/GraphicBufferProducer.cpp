@@ -3,6 +3,7 @@
 // Copyright © 2005 The Android Open Source Project
 // Copyright © 2019-2020 Ryujinx Team and Contributors
 
+#include <common/trace.h>
 #include <gpu.h>
 #include <gpu/texture/format.h>
 #include <soc.h>
@@ -13,13 +14,24 @@
 namespace skyline::service::hosbinder {
     GraphicBufferProducer::GraphicBufferProducer(const DeviceState &state, nvdrv::core::NvMap &nvMap) : state(state), bufferEvent(std::make_shared<kernel::type::KEvent>(state, true)), nvMap(nvMap) {}
 
-    void GraphicBufferProducer::FreeGraphicBufferNvMap(GraphicBuffer &buffer) {
+    void GraphicBufferProducer::FreeGraphicBufferNvMap(BufferSlot &slot) {
+        state.gpu->uploader.Wait(std::exchange(slot.uploadId, 0)); // The guest buffer can't be freed while an upload may still be reading from it
+
+        auto &buffer{*slot.graphicBuffer};
         auto surface{buffer.graphicHandle.surfaces.at(0)};
         u32 nvMapHandleId{surface.nvmapHandle ? surface.nvmapHandle : buffer.graphicHandle.nvmapId};
         nvMap.FreeHandle(nvMapHandleId, true);
     }
 
+    void GraphicBufferProducer::ReleasePresentedBuffers() {
+        for (auto &slot : queue) {
+            if (slot.state == BufferState::Queued && state.gpu->uploader.IsCallbackComplete(slot.uploadId))
+                slot.state = BufferState::Free;
+        }
+    }
+
     u32 GraphicBufferProducer::GetPendingBufferCount() {
+        ReleasePresentedBuffers();
         u32 count{};
         for (auto it{queue.begin()}, end{it + activeSlotCount}; it < end; it++)
             if (it->state == BufferState::Queued)
@@ -72,7 +84,7 @@ namespace skyline::service::hosbinder {
 
                 if (slot.texture) {
                     slot.texture = {};
-                    FreeGraphicBufferNvMap(*slot.graphicBuffer);
+                    FreeGraphicBufferNvMap(slot);
                 }
 
                 slot.graphicBuffer = nullptr;
@@ -97,20 +109,36 @@ namespace skyline::service::hosbinder {
         slot = InvalidGraphicBufferSlot;
 
         std::scoped_lock lock(mutex);
-        // We don't need a loop here since the consumer is blocking and instantly frees all buffers
-        // If a valid slot is not found on the first iteration then it would be stuck in an infloop
+        // Queued buffers are freed by the consumer once they've been presented, we block on the oldest presentation if there are no free buffers
+        // If a valid slot is not found when there are no queued buffers then it would be stuck in an infloop
         // As a result of this, we simply warn and return InvalidOperation to the guest
         auto buffer{queue.end()};
         size_t dequeuedSlotCount{};
-        for (auto it{queue.begin()}; it != std::min(queue.begin() + activeSlotCount, queue.end()); it++) {
-            // We want to select the oldest slot that's free to use as we'd want all slots to be used
-            // If we go linearly then we have a higher preference for selecting the former slots and being out of order
-            if (it->state == BufferState::Free) {
-                if (buffer == queue.end() || it->frameNumber < buffer->frameNumber)
-                    buffer = it;
-            } else if (it->state == BufferState::Dequeued) {
-                dequeuedSlotCount++;
+        while (true) {
+            ReleasePresentedBuffers();
+
+            u64 oldestUploadId{};
+            buffer = queue.end();
+            dequeuedSlotCount = 0;
+            for (auto it{queue.begin()}; it != std::min(queue.begin() + activeSlotCount, queue.end()); it++) {
+                // We want to select the oldest slot that's free to use as we'd want all slots to be used
+                // If we go linearly then we have a higher preference for selecting the former slots and being out of order
+                if (it->state == BufferState::Free) {
+                    if (buffer == queue.end() || it->frameNumber < buffer->frameNumber)
+                        buffer = it;
+                } else if (it->state == BufferState::Dequeued) {
+                    dequeuedSlotCount++;
+                } else if (it->state == BufferState::Queued) {
+                    oldestUploadId = oldestUploadId ? std::min(oldestUploadId, it->uploadId) : it->uploadId;
+                }
             }
+
+            if (buffer != queue.end() || async || !oldestUploadId)
+                break;
+
+            TRACE_EVENT("service", "GraphicBufferProducer::WaitForFreeBuffer");
+            if (!state.gpu->uploader.WaitCallback(oldestUploadId))
+                break;
         }
 
         if (buffer != queue.end()) {
@@ -174,7 +202,7 @@ namespace skyline::service::hosbinder {
 
         if (bufferSlot.texture) {
             bufferSlot.texture = {};
-            FreeGraphicBufferNvMap(*bufferSlot.graphicBuffer);
+            FreeGraphicBufferNvMap(bufferSlot);
         }
 
         bufferSlot.graphicBuffer = nullptr;
@@ -187,6 +215,7 @@ namespace skyline::service::hosbinder {
 
     AndroidStatus GraphicBufferProducer::DetachNextBuffer(std::optional<GraphicBuffer> &graphicBuffer, std::optional<AndroidFence> &fence) {
         std::scoped_lock lock(mutex);
+        ReleasePresentedBuffers();
         auto bufferSlot{queue.end()};
         for (auto it{queue.begin()}; it != queue.end(); it++) {
             if (it->state == BufferState::Free && it->graphicBuffer) {
@@ -203,7 +232,7 @@ namespace skyline::service::hosbinder {
 
         if (bufferSlot->texture) {
             bufferSlot->texture = {};
-            FreeGraphicBufferNvMap(*bufferSlot->graphicBuffer);
+            FreeGraphicBufferNvMap(*bufferSlot);
         }
 
         graphicBuffer = *std::exchange(bufferSlot->graphicBuffer, nullptr);
@@ -217,6 +246,7 @@ namespace skyline::service::hosbinder {
 
     AndroidStatus GraphicBufferProducer::AttachBuffer(i32 &slot, const GraphicBuffer &graphicBuffer) {
         std::scoped_lock lock(mutex);
+        ReleasePresentedBuffers();
         auto bufferSlot{queue.end()};
         for (auto it{queue.begin()}; it != queue.end(); it++) {
             if (it->state == BufferState::Free) {
@@ -227,7 +257,7 @@ namespace skyline::service::hosbinder {
 
         if (bufferSlot->texture) {
             bufferSlot->texture = {};
-            FreeGraphicBufferNvMap(*bufferSlot->graphicBuffer);
+            FreeGraphicBufferNvMap(*bufferSlot);
         }
 
         if (bufferSlot == queue.end()) {
@@ -269,6 +299,7 @@ namespace skyline::service::hosbinder {
     }
 
     AndroidStatus GraphicBufferProducer::QueueBuffer(i32 slot, i64 timestamp, bool isAutoTimestamp, AndroidRect crop, NativeWindowScalingMode scalingMode, NativeWindowTransform transform, NativeWindowTransform stickyTransform, bool async, u32 swapInterval, const AndroidFence &fence, u32 &width, u32 &height, NativeWindowTransform &transformHint, u32 &pendingBufferCount) {
+        TRACE_EVENT("service", "GraphicBufferProducer::QueueBuffer", "slot", slot);
         switch (scalingMode) {
             case NativeWindowScalingMode::Freeze:
             case NativeWindowScalingMode::ScaleToWindow:
@@ -358,8 +389,8 @@ namespace skyline::service::hosbinder {
                 throw exception("Legacy 16Bx16 tiled surfaces are not supported");
             }
 
-            auto guestTexture{std::make_shared<gpu::GuestTexture>(state, nvMapHandleObj->GetPointer() + surface.offset, gpu::texture::Dimensions(surface.width, surface.height), format, tileMode, tileConfig)};
-            buffer.texture = guestTexture->CreateTexture({}, vk::ImageTiling::eLinear);
+            auto guestTexture{std::make_shared<gpu::GuestTexture>(state, nvMapHandleObj->GetPointer() + surface.offset, surface.size, gpu::texture::Dimensions(surface.width, surface.height), format, tileMode, tileConfig)};
+            buffer.texture = state.gpu->texture.FindOrCreate(guestTexture, {}, vk::ImageTiling::eLinear); // The texture is only synchronized by the upload below, creating it doesn't read the guest buffer
         }
 
         switch (transform) {
@@ -398,17 +429,17 @@ namespace skyline::service::hosbinder {
 
         fence.Wait(state.soc->host1x);
 
-        {
-            auto &texture{buffer.texture};
-            std::scoped_lock textureLock(*texture);
-            texture->SynchronizeHost();
+        // The texture is synchronized on the upload thread and presented on the callback thread, the buffer stays queued till presentation has copied the texture which is when the consumer releases it
+        // Releasing it any earlier would allow the guest to requeue the buffer and overwrite the texture while it's still pending presentation
+        buffer.uploadId = state.gpu->uploader.Enqueue(buffer.texture, [&presentation = state.gpu->presentation, bufferEvent = bufferEvent, timestamp = isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform](const std::shared_ptr<gpu::Texture> &texture) {
+            bufferEvent->Signal();
+
             u64 frameId;
-            state.gpu->presentation.Present(texture, isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform, frameId);
-        }
+            presentation.Present(texture, timestamp, swapInterval, crop, scalingMode, transform, frameId);
+        });
 
         buffer.frameNumber = ++frameNumber;
-        buffer.state = BufferState::Free;
-        bufferEvent->Signal();
+        buffer.state = BufferState::Queued;
 
         width = defaultWidth;
         height = defaultHeight;
@@ -546,7 +577,7 @@ namespace skyline::service::hosbinder {
 
             if (slot.texture) {
                 slot.texture = {};
-                FreeGraphicBufferNvMap(*slot.graphicBuffer);
+                FreeGraphicBufferNvMap(slot);
             }
 
             slot.graphicBuffer = nullptr;
@@ -566,7 +597,7 @@ namespace skyline::service::hosbinder {
         auto &buffer{queue[slot]};
         if (buffer.texture) {
             buffer.texture = {};
-            FreeGraphicBufferNvMap(*buffer.graphicBuffer);
+            FreeGraphicBufferNvMap(buffer);
         }
 
         buffer.state = BufferState::Free;
@@ -44,6 +44,7 @@ namespace skyline::service::hosbinder {
         u64 frameNumber{}; //!< The amount of frames that have been queued using this slot
         bool wasBufferRequested{}; //!< If GraphicBufferProducer::RequestBuffer has been called with this buffer
         bool isPreallocated{}; //!< If this slot's graphic buffer has been preallocated or attached
+        u64 uploadId{}; //!< The ID of the latest upload of the texture by the TextureUploader, a queued buffer is released once the callback of this upload has presented it
         std::shared_ptr<gpu::Texture> texture{};
         std::unique_ptr<GraphicBuffer> graphicBuffer{};
     };
@@ -72,7 +73,16 @@ namespace skyline::service::hosbinder {
         u64 frameNumber{}; //!< The amount of frames that have been presented so far
         nvdrv::core::NvMap &nvMap;
 
-        void FreeGraphicBufferNvMap(GraphicBuffer &buffer);
+        /**
+         * @brief Frees the NvMap handle of the graphic buffer in the supplied slot after waiting on any pending upload from it
+         */
+        void FreeGraphicBufferNvMap(BufferSlot &slot);
+
+        /**
+         * @brief Frees all queued buffers which have been presented by the callback of their upload, this is equivalent to the consumer releasing them
+         * @note 'GraphicBufferProducer::mutex' **must** be locked prior to calling this
+         */
+        void ReleasePresentedBuffers();
 
         /**
          * @return The amount of buffers which have been queued onto the consumer
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <nce/guest.h>
+#include "ipc_capture.h"
+
+namespace skyline::service {
+    IpcCapture::IpcCapture(const DeviceState &state, const std::string &path) : state(state) {
+        if (path.empty())
+            return;
+
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            state.logger->Warn("Failed to open the IPC capture file: {}", path);
+            return;
+        }
+
+        FileHeader header{};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        state.logger->Info("Capturing IPC requests to {}", path);
+    }
+
+    void IpcCapture::CaptureBuffer(Record &record, span<u8> buffer, bool isOutput, u8 index) {
+        BufferHeader header{
+            .isOutput = isOutput,
+            .index = index,
+            .originalSize = static_cast<u32>(buffer.size()),
+            .size = static_cast<u32>(std::min<size_t>(buffer.size(), MaxBufferSize)),
+        };
+
+        auto offset{record.data.size()};
+        record.data.resize(offset + sizeof(BufferHeader) + header.size);
+        std::memcpy(record.data.data() + offset, &header, sizeof(BufferHeader));
+        std::memcpy(record.data.data() + offset + sizeof(BufferHeader), buffer.data(), header.size);
+        record.header.bufferCount++;
+    }
+
+    std::unique_ptr<IpcCapture::Record> IpcCapture::Begin(ipc::IpcRequest &request) {
+        if (!IsEnabled()) [[likely]]
+            return nullptr;
+
+        auto record{std::make_unique<Record>()};
+        record->header.timestampNs = util::GetTimeNs();
+        record->header.commandId = request.payload->value;
+        record->header.isDomain = request.isDomain;
+        std::memcpy(record->header.request.data(), state.ctx->tpidrroEl0, constant::TlsIpcSize);
+
+        for (u8 index{}; index < request.inputBuf.size(); index++)
+            CaptureBuffer(*record, request.inputBuf[index], false, index);
+
+        record->startTicks = util::GetTimeTicks();
+        return record;
+    }
+
+    void IpcCapture::Commit(Record &record, ipc::IpcRequest &request) {
+        record.header.durationNs = util::TicksToNs(util::GetTimeTicks() - record.startTicks);
+        std::memcpy(record.header.response.data(), state.ctx->tpidrroEl0, constant::TlsIpcSize);
+
+        for (u8 index{}; index < request.outputBuf.size(); index++)
+            CaptureBuffer(record, request.outputBuf[index], true, index);
+
+        record.header.serviceNameSize = static_cast<u16>(record.serviceName.size());
+        record.header.size = static_cast<u32>(sizeof(RecordHeader) + record.serviceName.size() + record.data.size());
+
+        std::lock_guard lock(mutex);
+        file.write(reinterpret_cast<const char *>(&record.header), sizeof(RecordHeader));
+        file.write(record.serviceName.data(), static_cast<std::streamsize>(record.serviceName.size()));
+        file.write(reinterpret_cast<const char *>(record.data.data()), static_cast<std::streamsize>(record.data.size()));
+    }
+}
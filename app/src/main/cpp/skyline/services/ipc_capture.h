@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "base_service.h"
+
+namespace skyline::service {
+    /**
+     * @brief IpcCapture writes every HLE service request alongside its response into a compact binary log, this allows service implementations to be replayed and benchmarked offline
+     * @note The capture file is laid out as a FileHeader followed by a sequence of records, each record is a RecordHeader followed by the service name and then 'bufferCount' pairs of BufferHeader and the buffer contents
+     * @note Input buffers (X/A) are captured prior to the request being handled while output buffers (B/W/C) are captured after the response has been written, handles and the result are a part of the raw TLS command buffers
+     */
+    class IpcCapture {
+      public:
+        constexpr static u32 FileMagic{util::MakeMagic<u32>("SKIC")};
+        constexpr static u32 RecordMagic{util::MakeMagic<u32>("SKIR")};
+        constexpr static u32 Version{1};
+        constexpr static u32 MaxBufferSize{0x100000}; //!< The maximum amount of bytes captured from a single buffer, any data beyond this is truncated
+
+        struct FileHeader {
+            u32 magic{FileMagic};
+            u32 version{Version};
+        };
+        static_assert(sizeof(FileHeader) == 0x8);
+
+        struct RecordHeader {
+            u32 magic{RecordMagic};
+            u32 size; //!< The total size of the record including this header in bytes
+            u64 timestampNs; //!< The host timestamp at which the request was received
+            u64 durationNs; //!< The host time taken to handle the request and write the response
+            u32 commandId;
+            u16 serviceNameSize; //!< The size of the service name which directly follows this header
+            u8 isDomain;
+            u8 bufferCount;
+            std::array<u8, constant::TlsIpcSize> request; //!< The raw TLS command buffer prior to the request being handled
+            std::array<u8, constant::TlsIpcSize> response; //!< The raw TLS command buffer after the response has been written
+        };
+        static_assert(sizeof(RecordHeader) == 0x20 + (constant::TlsIpcSize * 2));
+
+        struct BufferHeader {
+            u8 isOutput; //!< If this is an output buffer (B/W/C) rather than an input buffer (X/A)
+            u8 index; //!< The index of the buffer in IpcRequest::inputBuf or IpcRequest::outputBuf
+            u16 _pad_;
+            u32 originalSize; //!< The size of the buffer in the guest
+            u32 size; //!< The amount of captured bytes which follow this header, this may be lower than the original size if it was truncated
+        };
+        static_assert(sizeof(BufferHeader) == 0xC);
+
+        /**
+         * @brief The capture of a request which is still being handled
+         */
+        struct Record {
+            RecordHeader header{};
+            std::string serviceName;
+            std::vector<u8> data; //!< The serialized buffer headers and contents
+            u64 startTicks;
+        };
+
+      private:
+        const DeviceState &state;
+        std::mutex mutex; //!< Synchronizes writes to the capture file
+        std::ofstream file;
+
+        /**
+         * @brief Appends the contents of a buffer to the supplied record
+         */
+        static void CaptureBuffer(Record &record, span<u8> buffer, bool isOutput, u8 index);
+
+      public:
+        /**
+         * @param path The path of the capture file, an empty path disables capturing
+         */
+        IpcCapture(const DeviceState &state, const std::string &path);
+
+        bool IsEnabled() const {
+            return file.is_open();
+        }
+
+        /**
+         * @brief Snapshots the request in TLS and its input buffers
+         * @return A record for the request if capturing is enabled, otherwise nullptr
+         */
+        std::unique_ptr<Record> Begin(ipc::IpcRequest &request);
+
+        /**
+         * @brief Snapshots the response in TLS and the output buffers of the request, then writes the record out to the capture file
+         */
+        void Commit(Record &record, ipc::IpcRequest &request);
+    };
+}
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <bit>
+#include <common/settings.h>
+#include "ipc_profiler.h"
+
+namespace skyline::service {
+    IpcProfiler::IpcProfiler(const DeviceState &state) : state(state), enabled(state.settings->ipcProfiling) {}
+
+    IpcProfiler::CommandEntry &IpcProfiler::GetEntry(BaseService &service, u32 commandId) {
+        CommandKey key{&typeid(service), commandId};
+        {
+            std::shared_lock lock(mutex);
+            auto it{commands.find(key)};
+            if (it != commands.end())
+                return *it->second;
+        }
+
+        std::string function;
+        try {
+            function = service.GetServiceFunction(commandId).name;
+        } catch (const std::out_of_range &) {
+            function = fmt::format("0x{:X} (Unimplemented)", commandId);
+        }
+
+        std::unique_lock lock(mutex);
+        auto &entry{commands[key]};
+        if (!entry) {
+            entry = std::make_unique<CommandEntry>();
+            entry->service = service.GetName();
+            entry->function = std::move(function);
+        }
+        return *entry;
+    }
+
+    void IpcProfiler::Record(BaseService &service, u32 commandId, u64 durationNs) {
+        auto &entry{GetEntry(service, commandId)};
+        entry.calls.fetch_add(1, std::memory_order_relaxed);
+        entry.totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+
+        auto max{entry.maxNs.load(std::memory_order_relaxed)};
+        while (durationNs > max && !entry.maxNs.compare_exchange_weak(max, durationNs, std::memory_order_relaxed));
+
+        auto bucket{std::min<size_t>(static_cast<size_t>(std::bit_width(durationNs)), HistogramBucketCount - 1)};
+        entry.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void IpcProfiler::Reset() {
+        // Entries are never freed as Record uses them without holding the lock, their counters are zeroed in-place instead
+        std::shared_lock lock(mutex);
+        for (const auto &[key, entry] : commands) {
+            entry->calls.store(0, std::memory_order_relaxed);
+            entry->totalNs.store(0, std::memory_order_relaxed);
+            entry->maxNs.store(0, std::memory_order_relaxed);
+            for (auto &bucket : entry->histogram)
+                bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<IpcProfiler::CommandStatistics> IpcProfiler::GetStatistics() {
+        std::vector<CommandStatistics> statistics;
+        {
+            std::shared_lock lock(mutex);
+            statistics.reserve(commands.size());
+            for (const auto &[key, entry] : commands) {
+                if (!entry->calls.load(std::memory_order_relaxed))
+                    continue; // The command hasn't been called since the last reset
+
+                CommandStatistics command{
+                    .service = entry->service,
+                    .function = entry->function,
+                    .commandId = key.commandId,
+                    .calls = entry->calls.load(std::memory_order_relaxed),
+                    .totalNs = entry->totalNs.load(std::memory_order_relaxed),
+                    .maxNs = entry->maxNs.load(std::memory_order_relaxed),
+                };
+                for (size_t bucket{}; bucket < HistogramBucketCount; bucket++)
+                    command.histogram[bucket] = entry->histogram[bucket].load(std::memory_order_relaxed);
+                statistics.push_back(std::move(command));
+            }
+        }
+
+        std::sort(statistics.begin(), statistics.end(), [](const CommandStatistics &a, const CommandStatistics &b) {
+            return a.totalNs > b.totalNs;
+        });
+        return statistics;
+    }
+
+    void IpcProfiler::LogStatistics() {
+        auto statistics{GetStatistics()};
+        if (statistics.empty())
+            return;
+
+        std::string table;
+        for (const auto &command : statistics) {
+            // The histogram is condensed into the range of populated buckets to keep the table readable
+            auto first{std::find_if(command.histogram.begin(), command.histogram.end(), [](u64 count) { return count != 0; })};
+            auto last{std::find_if(command.histogram.rbegin(), command.histogram.rend(), [](u64 count) { return count != 0; }).base()};
+            std::string histogram;
+            for (auto it{first}; it != last; it++)
+                histogram += fmt::format("{}{}", histogram.empty() ? "" : " ", *it);
+
+            table += fmt::format("\n  {:<40} 0x{:<4X} Calls: {:<8} Total: {:>10}us Avg: {:>8}ns Max: {:>10}ns Histogram (2^{}ns+): [{}]",
+                                 command.function, command.commandId, command.calls,
+                                 command.totalNs / constant::NsInMicrosecond, command.calls ? command.totalNs / command.calls : 0, command.maxNs,
+                                 first == command.histogram.end() ? 0 : std::max<ssize_t>(std::distance(command.histogram.begin(), first) - 1, 0), histogram);
+        }
+
+        state.logger->InfoNoPrefix("IPC Profile (Sorted by total time):{}", table);
+    }
+}
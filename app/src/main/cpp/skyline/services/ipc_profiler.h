@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <shared_mutex>
+#include "base_service.h"
+
+namespace skyline::service {
+    /**
+     * @brief IpcProfiler aggregates the call count and latency of every HLE service command, it's always compiled in but only records while it's enabled
+     * @note The profiler is enabled by the 'ipc_profiling' setting which is only read when emulation starts, toggling it doesn't affect a running application
+     * @note Individual calls are already traced as Perfetto slices in BaseService::HandleRequest, this provides aggregated statistics on top of those
+     */
+    class IpcProfiler {
+      public:
+        static constexpr size_t HistogramBucketCount{32}; //!< The amount of log2-scale latency buckets, bucket N contains latencies in the range [2^(N-1), 2^N) nanoseconds
+
+        /**
+         * @brief A point-in-time copy of the statistics of a single command
+         */
+        struct CommandStatistics {
+            std::string service;
+            std::string function; //!< The "Class::Function" name of the command or its ID if it isn't implemented
+            u32 commandId;
+            u64 calls;
+            u64 totalNs;
+            u64 maxNs;
+            std::array<u64, HistogramBucketCount> histogram;
+        };
+
+      private:
+        /**
+         * @brief The live statistics of a single (service, command ID) pair
+         */
+        struct CommandEntry {
+            std::string service;
+            std::string function;
+            std::atomic<u64> calls{};
+            std::atomic<u64> totalNs{};
+            std::atomic<u64> maxNs{};
+            std::array<std::atomic<u64>, HistogramBucketCount> histogram{};
+        };
+
+        /**
+         * @brief The key of a command, services are identified by their dynamic type as a class may have several instances
+         */
+        struct CommandKey {
+            const std::type_info *service;
+            u32 commandId;
+
+            bool operator==(const CommandKey &) const = default;
+        };
+
+        struct CommandKeyHash {
+            size_t operator()(const CommandKey &key) const {
+                return std::hash<const std::type_info *>{}(key.service) ^ (static_cast<size_t>(key.commandId) << 1);
+            }
+        };
+
+        const DeviceState &state;
+        const bool enabled;
+        std::shared_mutex mutex; //!< Synchronizes insertions into 'commands', lookups of existing commands only require a shared lock
+        std::unordered_map<CommandKey, std::unique_ptr<CommandEntry>, CommandKeyHash> commands; //!< All commands which have been called, entries are never removed as references to them are used without holding the lock
+
+        CommandEntry &GetEntry(BaseService &service, u32 commandId);
+
+      public:
+        IpcProfiler(const DeviceState &state);
+
+        bool IsEnabled() const {
+            return enabled;
+        }
+
+        /**
+         * @brief Records a single call to a service command
+         */
+        void Record(BaseService &service, u32 commandId, u64 durationNs);
+
+        /**
+         * @brief Clears the statistics of all commands
+         * @note Calls which are concurrently being recorded may be partially retained
+         */
+        void Reset();
+
+        /**
+         * @return The statistics of all commands which have been called, sorted by the total time spent in them from the highest to the lowest
+         */
+        std::vector<CommandStatistics> GetStatistics();
+
+        /**
+         * @brief Writes a table of the statistics of all commands to the log
+         */
+        void LogStatistics();
+    };
+}
@@ -10,7 +10,8 @@ namespace skyline::service::nvdrv::device::nvhost {
         NvDevice(state, core, ctx),
         smExceptionBreakpointIntReportEvent(std::make_shared<type::KEvent>(state, false)),
         smExceptionBreakpointPauseReportEvent(std::make_shared<type::KEvent>(state, false)),
-        errorNotifierEvent(std::make_shared<type::KEvent>(state, false)) {
+        errorNotifierEvent(std::make_shared<type::KEvent>(state, false)),
+        channelCtx(std::make_unique<soc::gm20b::ChannelContext>(state)) {
         channelSyncpoint = core.syncpointManager.AllocateSyncpoint(false);
     }
 
@@ -35,15 +36,18 @@ namespace skyline::service::nvdrv::device::nvhost {
         if (numEntries > gpEntries.size())
             throw exception("GpEntry size mismatch!");
 
+        std::scoped_lock lock(submitMutex);
+
         if (flags.fenceWait) {
             if (flags.incrementWithValue)
                 return PosixResult::InvalidArgument;
 
-            if (core.syncpointManager.IsFenceSignalled(fence))
-                throw exception("Waiting on a fence through SubmitGpfifo is unimplemented");
+            // The fence is waited on by the channel's thread, this orders the submission after the work of other channels without blocking the guest
+            if (!core.syncpointManager.IsFenceSignalled(fence))
+                channelCtx->gpfifo.Push(soc::gm20b::SyncpointAction{soc::gm20b::SyncpointAction::Type::Wait, fence.id, fence.threshold});
         }
 
-        state.soc->gm20b.gpfifo.Push(gpEntries.subspan(0, numEntries));
+        channelCtx->gpfifo.Push(gpEntries.subspan(0, numEntries));
 
         fence.id = channelSyncpoint;
 
@@ -51,7 +55,7 @@ namespace skyline::service::nvdrv::device::nvhost {
         fence.threshold = core.syncpointManager.IncrementSyncpointMaxExt(channelSyncpoint, increment);
 
         if (flags.fenceIncrement)
-            throw exception("Incrementing a fence through SubmitGpfifo is unimplemented");
+            channelCtx->gpfifo.Push(soc::gm20b::SyncpointAction{soc::gm20b::SyncpointAction::Type::Increment, channelSyncpoint, 2});
 
         flags.raw = 0;
 
@@ -84,7 +88,7 @@ namespace skyline::service::nvdrv::device::nvhost {
 
     PosixResult GpuChannel::AllocGpfifoEx2(In<u32> numEntries, In<u32> numJobs, In<u32> flags, Out<Fence> fence) {
         state.logger->Debug("numEntries: {}, numJobs: {}, flags: 0x{:X}", numEntries, numJobs, flags);
-        state.soc->gm20b.gpfifo.Initialize(numEntries);
+        channelCtx->gpfifo.Initialize(numEntries);
 
         fence = core.syncpointManager.GetSyncpointFence(channelSyncpoint);
 
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <soc/gm20b/gpfifo.h>
+#include <soc/gm20b/channel.h>
 #include <services/common/fence.h>
 #include "services/nvdrv/devices/nvdevice.h"
 
@@ -16,6 +16,8 @@ namespace skyline::service::nvdrv::device::nvhost {
       private:
         u32 channelSyncpoint{};
         u32 channelUserData{};
+        std::unique_ptr<soc::gm20b::ChannelContext> channelCtx; //!< The GPU state of this channel, it's created when the channel is opened
+        std::mutex submitMutex; //!< Synchronizes submissions so the syncpoint actions of a submission are queued contiguously with its entries
         std::shared_ptr<type::KEvent> smExceptionBreakpointIntReportEvent;
         std::shared_ptr<type::KEvent> smExceptionBreakpointPauseReportEvent;
         std::shared_ptr<type::KEvent> errorNotifierEvent;
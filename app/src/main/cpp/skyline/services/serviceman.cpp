@@ -2,7 +2,9 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <kernel/types/KProcess.h>
+#include <common/settings.h>
 #include <common/trace.h>
+#include <os.h>
 #include "sm/IUserInterface.h"
 #include "settings/ISettingsServer.h"
 #include "settings/ISystemSettingsServer.h"
@@ -39,12 +41,10 @@
 #include "mmnv/IRequest.h"
 #include "serviceman.h"
 
-#define SERVICE_CASE(class, name, ...) \
-    case util::MakeMagic<ServiceName>(name): { \
-            std::shared_ptr<BaseService> serviceObject{std::make_shared<class>(state, *this, ##__VA_ARGS__)}; \
-            serviceMap[util::MakeMagic<ServiceName>(name)] = serviceObject; \
-            return serviceObject; \
-        }
+#define SERVICE_ENTRY(class, name, ...) \
+    std::pair<ServiceName, ServiceFactory>{util::MakeMagic<ServiceName>(name), [](const DeviceState &state, ServiceManager &manager) -> std::shared_ptr<BaseService> { \
+        return std::make_shared<class>(state, manager, ##__VA_ARGS__); \
+    }}
 
 namespace skyline::service {
     struct GlobalServiceState {
@@ -54,107 +54,151 @@ namespace skyline::service {
         explicit GlobalServiceState(const DeviceState &state) : timesrv(state), nvdrv(state) {}
     };
 
-    ServiceManager::ServiceManager(const DeviceState &state) : state(state), smUserInterface(std::make_shared<sm::IUserInterface>(state, *this)), globalServiceState(std::make_shared<GlobalServiceState>(state)) {}
+    using ServiceFactory = std::shared_ptr<BaseService> (*)(const DeviceState &, ServiceManager &);
 
-    std::shared_ptr<BaseService> ServiceManager::CreateOrGetService(ServiceName name) {
-        auto serviceIter{serviceMap.find(name)};
-        if (serviceIter != serviceMap.end())
-            return (*serviceIter).second;
-
-        switch (name) {
-            SERVICE_CASE(fatalsrv::IService, "fatal:u")
-            SERVICE_CASE(settings::ISettingsServer, "set")
-            SERVICE_CASE(settings::ISystemSettingsServer, "set:sys")
-            SERVICE_CASE(apm::IManager, "apm")
-            SERVICE_CASE(am::IApplicationProxyService, "appletOE")
-            SERVICE_CASE(am::IAllSystemAppletProxiesService, "appletAE")
-            SERVICE_CASE(audio::IAudioOutManager, "audout:u")
-            SERVICE_CASE(audio::IAudioRendererManager, "audren:u")
-            SERVICE_CASE(codec::IHardwareOpusDecoderManager, "hwopus")
-            SERVICE_CASE(hid::IHidServer, "hid")
-            SERVICE_CASE(timesrv::IStaticService, "time:s", globalServiceState->timesrv, timesrv::constant::StaticServiceSystemPermissions) // Both of these would be registered after TimeServiceManager::Setup normally but we call that in the GlobalServiceState constructor so can just list them here directly
-            SERVICE_CASE(timesrv::IStaticService, "time:su", globalServiceState->timesrv, timesrv::constant::StaticServiceSystemUpdatePermissions)
-            SERVICE_CASE(glue::IStaticService, "time:a", globalServiceState->timesrv.managerServer.GetStaticServiceAsAdmin(state, *this), globalServiceState->timesrv, timesrv::constant::StaticServiceAdminPermissions)
-            SERVICE_CASE(glue::IStaticService, "time:r", globalServiceState->timesrv.managerServer.GetStaticServiceAsRepair(state, *this), globalServiceState->timesrv, timesrv::constant::StaticServiceRepairPermissions)
-            SERVICE_CASE(glue::IStaticService, "time:u", globalServiceState->timesrv.managerServer.GetStaticServiceAsUser(state, *this), globalServiceState->timesrv, timesrv::constant::StaticServiceUserPermissions)
-            SERVICE_CASE(fssrv::IFileSystemProxy, "fsp-srv")
-            SERVICE_CASE(nvdrv::INvDrvServices, "nvdrv", globalServiceState->nvdrv, nvdrv::ApplicationSessionPermissions)
-            SERVICE_CASE(hosbinder::IHOSBinderDriver, "dispdrv", globalServiceState->nvdrv.core.nvMap)
-            SERVICE_CASE(visrv::IApplicationRootService, "vi:u")
-            SERVICE_CASE(visrv::ISystemRootService, "vi:s")
-            SERVICE_CASE(visrv::IManagerRootService, "vi:m")
-            SERVICE_CASE(pl::IPlatformServiceManager, "pl:u")
-            SERVICE_CASE(aocsrv::IAddOnContentManager, "aoc:u")
-            SERVICE_CASE(pctl::IParentalControlServiceFactory, "pctl")
-            SERVICE_CASE(pctl::IParentalControlServiceFactory, "pctl:a")
-            SERVICE_CASE(pctl::IParentalControlServiceFactory, "pctl:s")
-            SERVICE_CASE(pctl::IParentalControlServiceFactory, "pctl:r")
-            SERVICE_CASE(lm::ILogService, "lm")
-            SERVICE_CASE(account::IAccountServiceForApplication, "acc:u0")
-            SERVICE_CASE(friends::IServiceCreator, "friend:u")
-            SERVICE_CASE(nfp::IUserManager, "nfp:user")
-            SERVICE_CASE(nifm::IStaticService, "nifm:u")
-            SERVICE_CASE(socket::IClient, "bsd:u")
-            SERVICE_CASE(spl::IRandomInterface, "csrng")
-            SERVICE_CASE(ssl::ISslService, "ssl")
-            SERVICE_CASE(prepo::IPrepoService, "prepo:u")
-            SERVICE_CASE(mmnv::IRequest, "mm:u")
-            default:
-                std::string_view nameString(span(reinterpret_cast<char *>(&name), sizeof(name)).as_string(true));
-                throw std::out_of_range(fmt::format("CreateService called with an unknown service name: {}", nameString));
+    /**
+     * @brief A compile-time table of all services which can be created by name, the position of a service in this table is also the index of its slot in ServiceManager::services
+     */
+    constexpr auto ServiceTable{frz::make_unordered_map<ServiceName, ServiceFactory>({
+        SERVICE_ENTRY(fatalsrv::IService, "fatal:u"),
+        SERVICE_ENTRY(settings::ISettingsServer, "set"),
+        SERVICE_ENTRY(settings::ISystemSettingsServer, "set:sys"),
+        SERVICE_ENTRY(apm::IManager, "apm"),
+        SERVICE_ENTRY(am::IApplicationProxyService, "appletOE"),
+        SERVICE_ENTRY(am::IAllSystemAppletProxiesService, "appletAE"),
+        SERVICE_ENTRY(audio::IAudioOutManager, "audout:u"),
+        SERVICE_ENTRY(audio::IAudioRendererManager, "audren:u"),
+        SERVICE_ENTRY(codec::IHardwareOpusDecoderManager, "hwopus"),
+        SERVICE_ENTRY(hid::IHidServer, "hid"),
+        SERVICE_ENTRY(timesrv::IStaticService, "time:s", manager.globalServiceState->timesrv, timesrv::constant::StaticServiceSystemPermissions), // Both of these would be registered after TimeServiceManager::Setup normally but we call that in the GlobalServiceState constructor so can just list them here directly
+        SERVICE_ENTRY(timesrv::IStaticService, "time:su", manager.globalServiceState->timesrv, timesrv::constant::StaticServiceSystemUpdatePermissions),
+        SERVICE_ENTRY(glue::IStaticService, "time:a", manager.globalServiceState->timesrv.managerServer.GetStaticServiceAsAdmin(state, manager), manager.globalServiceState->timesrv, timesrv::constant::StaticServiceAdminPermissions),
+        SERVICE_ENTRY(glue::IStaticService, "time:r", manager.globalServiceState->timesrv.managerServer.GetStaticServiceAsRepair(state, manager), manager.globalServiceState->timesrv, timesrv::constant::StaticServiceRepairPermissions),
+        SERVICE_ENTRY(glue::IStaticService, "time:u", manager.globalServiceState->timesrv.managerServer.GetStaticServiceAsUser(state, manager), manager.globalServiceState->timesrv, timesrv::constant::StaticServiceUserPermissions),
+        SERVICE_ENTRY(fssrv::IFileSystemProxy, "fsp-srv"),
+        SERVICE_ENTRY(nvdrv::INvDrvServices, "nvdrv", manager.globalServiceState->nvdrv, nvdrv::ApplicationSessionPermissions),
+        SERVICE_ENTRY(hosbinder::IHOSBinderDriver, "dispdrv", manager.globalServiceState->nvdrv.core.nvMap),
+        SERVICE_ENTRY(visrv::IApplicationRootService, "vi:u"),
+        SERVICE_ENTRY(visrv::ISystemRootService, "vi:s"),
+        SERVICE_ENTRY(visrv::IManagerRootService, "vi:m"),
+        SERVICE_ENTRY(pl::IPlatformServiceManager, "pl:u"),
+        SERVICE_ENTRY(aocsrv::IAddOnContentManager, "aoc:u"),
+        SERVICE_ENTRY(pctl::IParentalControlServiceFactory, "pctl"),
+        SERVICE_ENTRY(pctl::IParentalControlServiceFactory, "pctl:a"),
+        SERVICE_ENTRY(pctl::IParentalControlServiceFactory, "pctl:s"),
+        SERVICE_ENTRY(pctl::IParentalControlServiceFactory, "pctl:r"),
+        SERVICE_ENTRY(lm::ILogService, "lm"),
+        SERVICE_ENTRY(account::IAccountServiceForApplication, "acc:u0"),
+        SERVICE_ENTRY(friends::IServiceCreator, "friend:u"),
+        SERVICE_ENTRY(nfp::IUserManager, "nfp:user"),
+        SERVICE_ENTRY(nifm::IStaticService, "nifm:u"),
+        SERVICE_ENTRY(socket::IClient, "bsd:u"),
+        SERVICE_ENTRY(spl::IRandomInterface, "csrng"),
+        SERVICE_ENTRY(ssl::ISslService, "ssl"),
+        SERVICE_ENTRY(prepo::IPrepoService, "prepo:u"),
+        SERVICE_ENTRY(mmnv::IRequest, "mm:u")
+    })};
+
+    ServiceManager::ServiceManager(const DeviceState &state) : state(state), services(ServiceTable.size()), smUserInterface(std::make_shared<sm::IUserInterface>(state, *this)), globalServiceState(std::make_shared<GlobalServiceState>(state)), profiler(state), ipcCapture(state, state.settings->ipcCapture ? state.os->appFilesPath + "ipc_capture.bin" : "") {}
+
+    ServiceSlot &ServiceManager::GetServiceSlot(ServiceName name) {
+        auto entry{ServiceTable.find(name)};
+        if (entry == ServiceTable.end()) {
+            std::string_view nameString(span(reinterpret_cast<char *>(&name), sizeof(name)).as_string(true));
+            throw std::out_of_range(fmt::format("CreateService called with an unknown service name: {}", nameString));
         }
+        return services[static_cast<size_t>(std::distance(ServiceTable.begin(), entry))];
     }
 
-    std::shared_ptr<BaseService> ServiceManager::NewService(ServiceName name, type::KSession &session, ipc::IpcResponse &response) {
-        std::lock_guard serviceGuard(mutex);
-        auto serviceObject{CreateOrGetService(name)};
-        KHandle handle{};
+    std::shared_ptr<BaseService> ServiceManager::CreateOrGetServiceLocked(ServiceName name, ServiceSlot &slot) {
+        if (!slot.service) {
+            slot.service = ServiceTable.find(name)->second(state, *this);
+            slot.service->registrySlot = &slot;
+        }
+        return slot.service;
+    }
+
+    std::shared_ptr<BaseService> ServiceManager::CreateOrGetService(ServiceName name) {
+        auto &slot{GetServiceSlot(name)};
+        std::scoped_lock lock(slot.mutex);
+        return CreateOrGetServiceLocked(name, slot);
+    }
+
+    void ServiceManager::ReleaseService(const std::shared_ptr<BaseService> &serviceObject) {
+        if (!serviceObject || !serviceObject->registrySlot)
+            return;
+
+        std::shared_ptr<BaseService> evictedService; // The service is destroyed after the slot has been unlocked
+        auto &slot{*serviceObject->registrySlot};
+        std::scoped_lock lock(slot.mutex);
+        if (--serviceObject->sessionCount == 0 && slot.service == serviceObject)
+            evictedService = std::move(slot.service); // The service is only evicted once the last session referencing it has been closed and if it's still the instance in the slot, any session opened after this will create a new instance
+    }
+
+    KHandle ServiceManager::InsertService(const std::shared_ptr<BaseService> &serviceObject, type::KSession &session, ipc::IpcResponse &response) {
+        std::unique_lock domainLock(session.domainMutex); // The session could be concurrently converted into a domain, it needs to be locked prior to checking if it's a domain
         if (session.isDomain) {
             session.domains.push_back(serviceObject);
             response.domainObjects.push_back(session.handleIndex);
-            handle = session.handleIndex++;
-        } else {
-            handle = state.process->NewHandle<type::KSession>(serviceObject).handle;
-            response.moveHandles.push_back(handle);
+            return session.handleIndex++;
         }
+        domainLock.unlock();
+
+        KHandle handle{state.process->NewHandle<type::KSession>(serviceObject).handle};
+        response.moveHandles.push_back(handle);
+        return handle;
+    }
+
+    std::shared_ptr<BaseService> ServiceManager::NewService(ServiceName name, type::KSession &session, ipc::IpcResponse &response) {
+        std::shared_ptr<BaseService> serviceObject;
+        {
+            // The service is referenced while its slot is locked, it'd otherwise be possible for the last session to it to be closed and for it to be evicted in between
+            auto &slot{GetServiceSlot(name)};
+            std::scoped_lock lock(slot.mutex);
+            serviceObject = CreateOrGetServiceLocked(name, slot);
+            serviceObject->sessionCount++;
+        }
+        auto handle{InsertService(serviceObject, session, response)};
         state.logger->Debug("Service has been created: \"{}\" (0x{:X})", serviceObject->GetName(), handle);
         return serviceObject;
     }
 
     void ServiceManager::RegisterService(std::shared_ptr<BaseService> serviceObject, type::KSession &session, ipc::IpcResponse &response) { // NOLINT(performance-unnecessary-value-param)
-        std::lock_guard serviceGuard(mutex);
-        KHandle handle{};
-
-        if (session.isDomain) {
-            session.domains.push_back(serviceObject);
-            response.domainObjects.push_back(session.handleIndex);
-            handle = session.handleIndex++;
-        } else {
-            handle = state.process->NewHandle<type::KSession>(serviceObject).handle;
-            response.moveHandles.push_back(handle);
+        if (serviceObject->registrySlot) {
+            // A service created by name that's registered again is referenced by the session even if it has been evicted, it won't be evicted again as it's no longer the instance in the slot
+            std::scoped_lock lock(serviceObject->registrySlot->mutex);
+            serviceObject->sessionCount++;
         }
-
+        auto handle{InsertService(serviceObject, session, response)};
         state.logger->Debug("Service has been registered: \"{}\" (0x{:X})", serviceObject->GetName(), handle);
     }
 
     void ServiceManager::CloseSession(KHandle handle) {
-        std::lock_guard serviceGuard(mutex);
         auto session{state.process->GetHandle<type::KSession>(handle)};
-        if (session->isOpen) {
+        if (session->isOpen.exchange(false)) {
+            std::lock_guard domainLock(session->domainMutex);
             if (session->isDomain) {
                 for (const auto &domainService : session->domains)
-                    std::erase_if(serviceMap, [domainService](const auto &entry) {
-                        return entry.second == domainService;
-                    });
+                    ReleaseService(domainService);
             } else {
-                std::erase_if(serviceMap, [session](const auto &entry) {
-                    return entry.second == session->serviceObject;
-                });
+                ReleaseService(session->serviceObject);
             }
-            session->isOpen = false;
         }
     }
 
+    Result ServiceManager::DispatchRequest(BaseService &service, type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response, IpcCapture::Record *record) {
+        if (record)
+            record->serviceName = service.GetName();
+
+        if (!profiler.IsEnabled()) [[likely]]
+            return service.HandleRequest(session, request, response);
+
+        auto start{util::GetTimeNs()};
+        auto result{service.HandleRequest(session, request, response)};
+        profiler.Record(service, request.payload->value, util::GetTimeNs() - start);
+        return result;
+    }
+
     void ServiceManager::SyncRequestHandler(KHandle handle) {
         TRACE_EVENT("kernel", "ServiceManager::SyncRequestHandler");
         auto session{state.process->GetHandle<type::KSession>(handle)};
@@ -167,32 +211,47 @@ namespace skyline::service {
 
             switch (request.header->type) {
                 case ipc::CommandType::Request:
-                case ipc::CommandType::RequestWithContext:
+                case ipc::CommandType::RequestWithContext: {
+                    auto record{ipcCapture.Begin(request)};
                     if (session->isDomain) {
                         try {
-                            auto service{session->domains.at(request.domain->objectId)};
+                            std::shared_ptr<BaseService> service;
+                            {
+                                std::lock_guard domainLock(session->domainMutex);
+                                service = session->domains.at(request.domain->objectId);
+                            }
                             if (service == nullptr)
                                 throw exception("Domain request used an expired handle");
                             switch (request.domain->command) {
                                 case ipc::DomainCommand::SendMessage:
-                                    response.errorCode = service->HandleRequest(*session, request, response);
+                                    response.errorCode = DispatchRequest(*service, *session, request, response, record.get());
                                     break;
 
-                                case ipc::DomainCommand::CloseVHandle:
-                                    std::erase_if(serviceMap, [service](const auto &entry) {
-                                        return entry.second == service;
-                                    });
-                                    session->domains.at(request.domain->objectId).reset();
+                                case ipc::DomainCommand::CloseVHandle: {
+                                    if (record)
+                                        record->serviceName = service->GetName(); // The name is resolved prior to closing the object as this may release the last reference to the service
+
+                                    std::shared_ptr<BaseService> closedService;
+                                    {
+                                        // The object is moved out under the lock so concurrent closes of the same object only release its reference once
+                                        std::lock_guard domainLock(session->domainMutex);
+                                        closedService = std::move(session->domains.at(request.domain->objectId));
+                                    }
+                                    ReleaseService(closedService);
                                     break;
+                                }
                             }
                         } catch (std::out_of_range &) {
                             throw exception("Invalid object ID was used with domain request");
                         }
                     } else {
-                        response.errorCode = session->serviceObject->HandleRequest(*session, request, response);
+                        response.errorCode = DispatchRequest(*session->serviceObject, *session, request, response, record.get());
                     }
                     response.WriteResponse(session->isDomain);
+                    if (record)
+                        ipcCapture.Commit(*record, request);
                     break;
+                }
 
                 case ipc::CommandType::Control:
                 case ipc::CommandType::ControlWithContext:
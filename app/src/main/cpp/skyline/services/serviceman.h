@@ -5,6 +5,8 @@
 
 #include <kernel/types/KSession.h>
 #include "base_service.h"
+#include "ipc_profiler.h"
+#include "ipc_capture.h"
 
 namespace skyline::service {
     /**
@@ -12,18 +14,56 @@ namespace skyline::service {
      */
     struct GlobalServiceState;
 
+    /**
+     * @brief The slot of a service which can be created by name in ServiceManager
+     */
+    struct ServiceSlot {
+        std::mutex mutex; //!< Synchronizes the creation and eviction of the service with references being taken to it
+        std::shared_ptr<BaseService> service; //!< The current instance of the service, it's null if it hasn't been created yet or was evicted
+    };
+
     /**
      * @brief The ServiceManager class manages passing IPC requests to the right Service and running event loops of Services
      */
     class ServiceManager {
       private:
         const DeviceState &state;
-        std::unordered_map<ServiceName, std::shared_ptr<BaseService>> serviceMap; //!< A mapping from a Service to the underlying object
-        std::mutex mutex; //!< Synchronizes concurrent access to services to prevent crashes
+        std::vector<ServiceSlot> services; //!< The slots of services created by name, indexed by their position in the service table, the vector itself is never resized
+
+        /**
+         * @return The slot of the service with the supplied name in 'services'
+         */
+        ServiceSlot &GetServiceSlot(ServiceName name);
+
+        /**
+         * @brief Creates the service in the supplied slot if it doesn't hold an instance already
+         * @note The mutex of the slot **must** be locked prior to calling this
+         */
+        std::shared_ptr<BaseService> CreateOrGetServiceLocked(ServiceName name, ServiceSlot &slot);
+
+        /**
+         * @brief Drops a reference to a service from a session or domain object, a service created by name is evicted from its slot in 'services' once no sessions reference it and if it's still the instance in the slot
+         */
+        void ReleaseService(const std::shared_ptr<BaseService> &serviceObject);
+
+        /**
+         * @brief Inserts a service into the supplied session and writes its handle or virtual handle (If it's a domain session) to IpcResponse
+         * @return The handle or virtual handle of the service
+         * @note This doesn't take a reference to a service created by name, the caller is responsible for doing so
+         */
+        KHandle InsertService(const std::shared_ptr<BaseService> &serviceObject, type::KSession &session, ipc::IpcResponse &response);
+
+        /**
+         * @brief Passes a request to a service and records it with the profiler if it's enabled
+         * @param record The capture record of the request if it's being captured
+         */
+        Result DispatchRequest(BaseService &service, type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response, IpcCapture::Record *record);
 
       public:
         std::shared_ptr<BaseService> smUserInterface; //!< Used by applications to open connections to services
         std::shared_ptr<GlobalServiceState> globalServiceState;
+        IpcProfiler profiler;
+        IpcCapture ipcCapture;
 
         ServiceManager(const DeviceState &state);
 
@@ -50,6 +90,7 @@ namespace skyline::service {
 
         /**
          * @brief Creates an instance of the service if it doesn't already exist, otherwise returns an existing instance
+         * @note This doesn't reference the service on behalf of a session, it may be evicted once all of its sessions are closed and a new instance created after that
          */
         std::shared_ptr<BaseService> CreateOrGetService(ServiceName name);
 
@@ -59,7 +100,7 @@ namespace skyline::service {
         }
 
         /**
-         * @brief Closes an existing session to a service
+         * @brief Closes an existing session to a service, this is O(1) in the amount of services as every service tracks its own slot
          * @param service The handle of the KService object
          */
         void CloseSession(KHandle handle);
@@ -10,11 +10,5 @@ namespace skyline {
 }
 
 namespace skyline::soc::gm20b {
-    GM20B::GM20B(const DeviceState &state) :
-        fermi2D(state),
-        keplerMemory(state),
-        maxwell3D(state),
-        maxwellCompute(state),
-        maxwellDma(state),
-        gpfifo(state) {}
+    GM20B::GM20B(const DeviceState &state) {}
 }
@@ -4,12 +4,11 @@
 #pragma once
 
 #include <common/address_space.h>
-#include "gm20b/engines/maxwell_3d.h"
-#include "gm20b/gpfifo.h"
+#include "gm20b/channel.h"
 
 namespace skyline::soc::gm20b {
     /**
-     * @brief The GPU block in the X1, it contains all GPU engines required for accelerating graphics operations
+     * @brief The GPU block in the X1, it contains the GMMU which is shared by all channels while the GPU engines are instantiated per-channel in ChannelContext
      * @note We omit parts of components related to external access such as the grhost, all accesses to the external components are done directly
      */
     class GM20B {
@@ -17,13 +16,18 @@ namespace skyline::soc::gm20b {
         static constexpr u8 AddressSpaceBits{40}; //!< The width of the GMMU AS
         using GMMU = FlatMemoryManager<u64, 0, AddressSpaceBits>;
 
-        engine::Engine fermi2D;
-        engine::maxwell3d::Maxwell3D maxwell3D;
-        engine::Engine maxwellCompute;
-        engine::Engine maxwellDma;
-        engine::Engine keplerMemory;
-        GPFIFO gpfifo;
+        /**
+         * @brief Totals of pushbuffer fetches across all channels, these are sampled every frame to derive per-frame counts
+         */
+        struct PushBufferCounters {
+            std::atomic<u64> direct; //!< The amount of pushbuffers which were parsed in-place from guest memory
+            std::atomic<u64> copied; //!< The amount of pushbuffers which had to be copied out of guest memory
+            std::atomic<u64> copiedBytes; //!< The total size of all pushbuffers which were copied out of guest memory
+        };
+
         GMMU gmmu;
+        std::atomic_flag gpfifoCpuClaimed{}; //!< If the host CPU set for GPFIFO threads has been claimed by a channel
+        PushBufferCounters pushBufferCounters{};
 
         GM20B(const DeviceState &state);
     };
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "engines/maxwell_3d.h"
+#include "gpfifo.h"
+
+namespace skyline::soc::gm20b {
+    /**
+     * @brief The state of a single GPU channel, every channel has its own engine state and GPFIFO with a thread for processing pushbuffers so work on separate channels doesn't serialize
+     * @note Channels share the GMMU address space in GM20B, any ordering between channels is done through host1x syncpoints
+     */
+    struct ChannelContext {
+        engine::Engine fermi2D;
+        engine::maxwell3d::Maxwell3D maxwell3D;
+        engine::Engine maxwellCompute;
+        engine::Engine maxwellDma;
+        engine::Engine keplerMemory;
+        GPFIFO gpfifo;
+
+        ChannelContext(const DeviceState &state) :
+            fermi2D(state),
+            maxwell3D(state),
+            maxwellCompute(state),
+            maxwellDma(state),
+            keplerMemory(state),
+            gpfifo(state, *this) {}
+    };
+}
@@ -33,6 +33,14 @@ namespace skyline::soc::gm20b {
             void CallMethod(u32 method, u32 argument, bool lastCall) {
                 state.logger->Warn("Called method in unimplemented engine: 0x{:X} args: 0x{:X}", method, argument);
             };
+
+            /**
+             * @brief Calls a sequence of engine methods with the given arguments, the final argument is treated as the last call
+             * @param incrementing If the method is incremented after each argument, otherwise all arguments are passed to the same method
+             */
+            void CallMethodBatch(u32 method, span<u32> arguments, bool incrementing) {
+                state.logger->Warn("Called method batch in unimplemented engine: 0x{:X} args: {}", method, arguments.size());
+            };
         };
     }
 }
@@ -168,9 +168,21 @@ namespace skyline::soc::gm20b::engine {
         GPFIFO(const DeviceState &state) : Engine(state) {}
 
         void CallMethod(u32 method, u32 argument, bool lastCall) {
-            state.logger->Debug("Called method in GPFIFO: 0x{:X} args: 0x{:X}", method, argument);
+            LOG_DEBUG(state.logger, "Called method in GPFIFO: 0x{:X} args: 0x{:X}", method, argument);
 
             registers.raw[method] = argument;
         };
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool incrementing) {
+            LOG_DEBUG(state.logger, "Called method batch in GPFIFO: 0x{:X} args: {}", method, arguments.size());
+
+            if (method + (incrementing ? arguments.size() : 1) > RegisterCount) [[unlikely]]
+                throw exception("GPFIFO method batch exceeds the register file: 0x{:X} args: {}", method, arguments.size());
+
+            if (incrementing)
+                std::memcpy(&registers.raw[method], arguments.data(), arguments.size_bytes());
+            else
+                registers.raw[method] = arguments.back();
+        };
     };
 }
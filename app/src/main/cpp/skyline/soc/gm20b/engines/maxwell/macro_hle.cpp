@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <soc/gm20b/engines/maxwell_3d.h>
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    /**
+     * @brief The native implementation of MacroHle::BindConstantBufferMacro, the selector and the bind are written as two runs of incrementing methods
+     */
+    void BindConstantBuffer(Maxwell3D &maxwell3D, span<u32> arguments) {
+        using Registers = Maxwell3D::Registers;
+        constexpr u32 BindGroupStride{sizeof(Registers::BindGroup) / sizeof(u32)};
+        constexpr u32 BindMethod{MAXWELL3D_OFFSET(bindGroups) + U32_OFFSET(Registers::BindGroup, constantBuffer)}; //!< The method of the constant buffer bind of the first stage
+
+        maxwell3D.CallMethodBatch(MAXWELL3D_OFFSET(constantBufferSelector.size), arguments.subspan(1, 3), true);
+
+        u32 stage{arguments[0] & 0x7}; // The macro only uses the low 3 bits of the stage, this matches it for out-of-range stages as well
+        maxwell3D.CallMethodBatch(BindMethod + (stage * BindGroupStride), arguments.subspan(4, 1), true);
+    }
+
+    /**
+     * @brief The registry of all macros with native implementations
+     * @note Hashes of candidate macros can be found from the miss counters logged when the Maxwell 3D is destroyed, an implementation must match the macro's effects exactly as it fully replaces it
+     */
+    constexpr std::array HleMacros{
+        MacroHle::HleMacro{MacroHle::HashMacro(MacroHle::BindConstantBufferMacro), 5, BindConstantBuffer},
+    };
+
+    MacroHle::~MacroHle() {
+        if (counters.empty())
+            return;
+
+        u64 hits{}, misses{};
+        for (const auto &[hash, counter] : counters) {
+            state.logger->Debug("Macro 0x{:016X}: {} HLE hits, {} misses", hash, counter.hits, counter.misses);
+            hits += counter.hits;
+            misses += counter.misses;
+        }
+        state.logger->Info("Macro HLE: {} hits, {} misses across {} unique macros", hits, misses, counters.size());
+    }
+
+    bool MacroHle::Execute(u32 offset, span<u32> args) {
+        if (invalidated) {
+            std::erase_if(cachedMacros, [this](const auto &entry) {
+                for (u32 index{}; index < entry.second.length; index++)
+                    if (dirtyWords.test((entry.first + index) % MacroInterpreter::MacroCodeSize))
+                        return true;
+                return false;
+            });
+            dirtyWords.reset();
+            invalidated = false;
+        }
+
+        auto it{cachedMacros.find(offset)};
+        if (it == cachedMacros.end()) {
+            size_t length{};
+            u64 hash{HashMacro([this, offset](size_t index) { return maxwell3D.macroCode[(offset + index) % MacroInterpreter::MacroCodeSize]; }, length)};
+            auto hleMacro{std::find_if(HleMacros.begin(), HleMacros.end(), [hash](const HleMacro &macro) { return macro.hash == hash; })};
+            it = cachedMacros.emplace(offset, CachedMacro{static_cast<u32>(length), hleMacro != HleMacros.end() ? &*hleMacro : nullptr, &counters[hash]}).first;
+        }
+
+        auto &macro{it->second};
+        if (!macro.hleMacro || args.size() != macro.hleMacro->argumentCount) {
+            macro.counters->misses++;
+            return false;
+        }
+
+        macro.counters->hits++;
+        macro.hleMacro->function(maxwell3D, args);
+        return true;
+    }
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <bitset>
+#include "macro_interpreter.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    /**
+     * @brief The MacroHle class identifies well-known macros by a hash of their code and executes native implementations of them rather than emulating them instruction-by-instruction
+     * @note Any macro without a native implementation falls through to the JIT or the interpreter
+     */
+    class MacroHle {
+      public:
+        /**
+         * @brief A native implementation of a macro, it must have the same effect on the Maxwell 3D as executing the macro would
+         */
+        using HleFunction = void (*)(Maxwell3D &maxwell3D, span<u32> arguments);
+
+        /**
+         * @brief A macro with a native implementation, identified by the hash of its code
+         */
+        struct HleMacro {
+            u64 hash; //!< The hash of the macro code as computed by HashMacro
+            size_t argumentCount; //!< The exact amount of arguments the implementation handles, calls with any other amount are emulated
+            HleFunction function;
+        };
+
+        /**
+         * @brief The amount of times a macro with a certain hash has been executed natively or fell through to emulation
+         */
+        struct HleCounters {
+            u64 hits;
+            u64 misses;
+        };
+
+        /**
+         * @brief A macro which binds a constant buffer to a shader stage, it takes the stage, the size and address of the buffer and the bind configuration as arguments
+         * @note The buffer is selected by writing to the selector registers and then bound by writing the configuration to the bind group of the stage
+         */
+        static constexpr std::array<u32, 7> BindConstantBufferMacro{
+            0x18C04212, // r2 = (r1 & 0x7) << 3
+            0x06380061, // method = constantBufferSelector.size (increment 1), send the size
+            0x00000301, // r3 = addressHigh
+            0x00001C31, // r4 = addressLow, send r3
+            0x00002531, // r5 = bind configuration, send r4
+            0x024110A1, // method = bindGroups[r2 / 8].constantBuffer, exit
+            0x00002841, // send r5
+        };
+
+        /**
+         * @return A 64-bit FNV-1a hash of macro code, this covers all instructions up to and including the delay slot of the first exit
+         * @param readWord A function returning the instruction at an index relative to the start of the macro
+         * @param length This is set to the amount of instructions that were hashed
+         */
+        template<typename ReadWord>
+        static constexpr u64 HashMacro(ReadWord readWord, size_t &length) {
+            constexpr u32 ExitBit{1U << 7}; //!< The bit of MacroInterpreter::Opcode::exit, the union can't be used in constant expressions
+            constexpr u64 FnvOffsetBasis{0xCBF29CE484222325}, FnvPrime{0x100000001B3};
+            u64 hash{FnvOffsetBasis};
+            auto hashWord{[&](u32 word) {
+                for (size_t byte{}; byte < sizeof(u32); byte++) {
+                    hash ^= (word >> (byte * 8)) & 0xFF;
+                    hash *= FnvPrime;
+                }
+            }};
+
+            for (length = 0; length < MacroInterpreter::MacroCodeSize; length++) {
+                u32 word{readWord(length)};
+                hashWord(word);
+                if (word & ExitBit) {
+                    hashWord(readWord(++length)); // The delay slot of the exit
+                    length++;
+                    break;
+                }
+            }
+
+            return hash;
+        }
+
+        /**
+         * @return The hash of a macro which is contained entirely in the supplied code
+         */
+        static constexpr u64 HashMacro(span<const u32> code) {
+            size_t length{};
+            return HashMacro([code](size_t index) { return code[index]; }, length);
+        }
+
+      private:
+        /**
+         * @brief The HLE state of a macro at a specific offset in macro memory
+         */
+        struct CachedMacro {
+            u32 length; //!< The amount of words of macro memory which were hashed, a write to any of them invalidates this
+            const HleMacro *hleMacro; //!< The native implementation of the macro or null if there's none
+            HleCounters *counters; //!< The counters for the hash of the macro, these are stable as 'counters' is node-based
+        };
+
+        const DeviceState &state;
+        Maxwell3D &maxwell3D;
+        std::unordered_map<u32, CachedMacro> cachedMacros; //!< A map from the start offset of a macro in macro memory to its implementation
+        std::unordered_map<u64, HleCounters> counters; //!< A map from the hash of a macro to how often it has been executed natively or not
+        std::bitset<MacroInterpreter::MacroCodeSize> dirtyWords; //!< The words of macro memory which have been written to since cached macros were last invalidated
+        bool invalidated{}; //!< If any bit in 'dirtyWords' is set, this avoids scanning the bitset on every execution
+
+      public:
+        MacroHle(const DeviceState &state, Maxwell3D &maxwell3D) : state(state), maxwell3D(maxwell3D) {}
+
+        ~MacroHle();
+
+        /**
+         * @brief Marks a word of macro memory as written to, this must be called whenever macro memory is written to
+         * @note Cached macros which cover the word are only discarded on the next execution
+         */
+        void Invalidate(size_t index) {
+            dirtyWords.set(index);
+            invalidated = true;
+        }
+
+        /**
+         * @brief Executes the macro at the supplied offset in macro memory natively if it is a known macro
+         * @return If the macro was executed, it must be emulated if this is false
+         */
+        bool Execute(u32 offset, span<u32> args);
+
+        /**
+         * @return The counters of the macro with the supplied hash, these are zero if it has never been executed
+         */
+        HleCounters GetCounters(u64 hash) const {
+            auto it{counters.find(hash)};
+            return it != counters.end() ? it->second : HleCounters{};
+        }
+    };
+}
@@ -5,113 +5,145 @@
 #include <soc/gm20b/engines/maxwell_3d.h>
 
 namespace skyline::soc::gm20b::engine::maxwell3d {
-    void MacroInterpreter::Execute(size_t offset, const std::vector<u32> &args) {
+    void MacroInterpreter::Execute(size_t offset, span<u32> args) {
+        static_assert(MacroCodeSize == std::tuple_size_v<decltype(Maxwell3D::macroCode)>);
+
+        // A macro may call another macro through a method call, the state of the calling macro is restored after the nested macro returns
+        auto outerState{std::tuple{pc, registers, argument, methodAddress.raw, carryFlag}};
+
         // Reset the interpreter state
         registers = {};
         carryFlag = false;
         methodAddress.raw = 0;
-        opcode = reinterpret_cast<Opcode *>(&maxwell3D.macroCode[offset]);
+        pc = static_cast<u32>(offset);
         argument = args.data();
 
         // The first argument is stored in register 1
         registers[1] = *argument++;
 
         while (Step());
+
+        std::tie(pc, registers, argument, methodAddress.raw, carryFlag) = outerState;
     }
 
-    FORCE_INLINE bool MacroInterpreter::Step(Opcode *delayedOpcode) {
-        switch (opcode->operation) {
+    FORCE_INLINE const MacroInterpreter::DecodedOpcode &MacroInterpreter::Decode(u32 index) {
+        auto &decoded{decodedCode[index]};
+        if (decoded.valid) [[likely]]
+            return decoded;
+
+        Opcode opcode{.raw = maxwell3D.macroCode[index]};
+        decoded = DecodedOpcode{
+            .valid = true,
+            .operation = opcode.operation,
+            .assignmentOperation = opcode.assignmentOperation,
+            .aluOperation = opcode.aluOperation,
+            .branchCondition = opcode.branchCondition,
+            .noDelay = opcode.noDelay,
+            .exit = static_cast<bool>(opcode.exit),
+            .dest = opcode.dest,
+            .srcA = opcode.srcA,
+            .srcB = opcode.srcB,
+            .srcBit = opcode.bitfield.srcBit,
+            .destBit = opcode.bitfield.destBit,
+            .mask = opcode.bitfield.GetMask(),
+            .immediate = opcode.immediate,
+        };
+        return decoded;
+    }
+
+    FORCE_INLINE bool MacroInterpreter::Step(bool inDelaySlot, u32 delayedPc) {
+        auto opcode{Decode(pc)}; // This is copied as a nested macro may overwrite the cached instruction
+        switch (opcode.operation) {
             case Opcode::Operation::AluRegister: {
-                u32 result{HandleAlu(opcode->aluOperation, registers[opcode->srcA], registers[opcode->srcB])};
+                u32 result{HandleAlu(opcode.aluOperation, registers[opcode.srcA], registers[opcode.srcB])};
 
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, result);
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, result);
                 break;
             }
 
             case Opcode::Operation::AddImmediate:
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, registers[opcode->srcA] + opcode->immediate);
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, registers[opcode.srcA] + opcode.immediate);
                 break;
 
             case Opcode::Operation::BitfieldReplace: {
-                u32 src{registers[opcode->srcB]};
-                u32 dest{registers[opcode->srcA]};
+                u32 src{registers[opcode.srcB]};
+                u32 dest{registers[opcode.srcA]};
 
                 // Extract the source region
-                src = (src >> opcode->bitfield.srcBit) & opcode->bitfield.GetMask();
+                src = (src >> opcode.srcBit) & opcode.mask;
 
                 // Mask out the bits that we will replace
-                dest &= ~(opcode->bitfield.GetMask() << opcode->bitfield.destBit);
+                dest &= ~(opcode.mask << opcode.destBit);
 
                 // Replace the bitfield region in the destination with the region from the source
-                dest |= src << opcode->bitfield.destBit;
+                dest |= src << opcode.destBit;
 
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, dest);
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, dest);
                 break;
             }
 
             case Opcode::Operation::BitfieldExtractShiftLeftImmediate: {
-                u32 src{registers[opcode->srcB]};
-                u32 dest{registers[opcode->srcA]};
+                u32 src{registers[opcode.srcB]};
+                u32 dest{registers[opcode.srcA]};
 
-                u32 result{((src >> dest) & opcode->bitfield.GetMask()) << opcode->bitfield.destBit};
+                u32 result{((src >> (dest & 31)) & opcode.mask) << opcode.destBit}; // Register shift amounts wrap around, as they do with the JIT
 
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, result);
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, result);
                 break;
             }
 
             case Opcode::Operation::BitfieldExtractShiftLeftRegister: {
-                u32 src{registers[opcode->srcB]};
-                u32 dest{registers[opcode->srcA]};
+                u32 src{registers[opcode.srcB]};
+                u32 dest{registers[opcode.srcA]};
 
-                u32 result{((src >> opcode->bitfield.srcBit) & opcode->bitfield.GetMask()) << dest};
+                u32 result{((src >> opcode.srcBit) & opcode.mask) << (dest & 31)};
 
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, result);
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, result);
                 break;
             }
 
             case Opcode::Operation::ReadImmediate: {
-                u32 result{maxwell3D.registers.raw[registers[opcode->srcA] + opcode->immediate]};
-                HandleAssignment(opcode->assignmentOperation, opcode->dest, result);
+                u32 result{maxwell3D.registers.raw[registers[opcode.srcA] + opcode.immediate]};
+                HandleAssignment(opcode.assignmentOperation, opcode.dest, result);
                 break;
             }
 
             case Opcode::Operation::Branch: {
-                if (delayedOpcode != nullptr)
+                if (inDelaySlot)
                     throw exception("Cannot branch while inside a delay slot");
 
-                u32 value{registers[opcode->srcA]};
-                bool branch{(opcode->branchCondition == Opcode::BranchCondition::Zero) ? (value == 0) : (value != 0)};
+                u32 value{registers[opcode.srcA]};
+                bool branch{(opcode.branchCondition == Opcode::BranchCondition::Zero) ? (value == 0) : (value != 0)};
 
                 if (branch) {
-                    if (opcode->noDelay) {
-                        opcode += opcode->immediate;
+                    u32 targetPc{static_cast<u32>(pc + opcode.immediate) % MacroCodeSize};
+                    if (opcode.noDelay) {
+                        pc = targetPc;
                         return true;
                     } else {
-                        Opcode *targetOpcode{opcode + opcode->immediate};
-
                         // Step into delay slot
-                        opcode++;
-                        return Step(targetOpcode);
+                        pc = (pc + 1) % MacroCodeSize;
+                        return Step(true, targetPc);
                     }
                 }
                 break;
             }
 
             default:
-                throw exception("Unknown MME opcode encountered: 0x{:X}", static_cast<u8>(opcode->operation));
+                throw exception("Unknown MME opcode encountered: 0x{:X}", static_cast<u8>(opcode.operation));
         }
 
-        if (opcode->exit && (delayedOpcode == nullptr)) {
+        if (opcode.exit && !inDelaySlot) {
             // Exit has a delay slot
-            opcode++;
-            Step(opcode);
+            pc = (pc + 1) % MacroCodeSize;
+            Step(true, pc);
             return false;
         }
 
-        if (delayedOpcode != nullptr)
-            opcode = delayedOpcode;
+        if (inDelaySlot)
+            pc = delayedPc;
         else
-            opcode++;
+            pc = (pc + 1) % MacroCodeSize;
 
         return true;
     }
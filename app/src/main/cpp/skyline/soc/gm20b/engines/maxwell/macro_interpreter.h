@@ -13,6 +13,9 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
      */
     class MacroInterpreter {
       private:
+        friend class MacroJit; // The JIT shares the instruction encoding with the interpreter
+        friend class MacroHle;
+
         #pragma pack(push, 1)
         union Opcode {
             u32 raw;
@@ -85,7 +88,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 u8 destBit : 5;
 
                 u32 GetMask() {
-                    return (1 << size) - 1;
+                    return (1U << size) - 1;
                 }
             } bitfield;
         };
@@ -98,24 +101,52 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         union MethodAddress {
             u32 raw;
             struct {
-                u16 address : 12;
-                u8 increment : 6;
+                u32 address : 12;
+                u32 increment : 6; //!< This must have a 32-bit type as a u8 bitfield can't straddle a byte boundary and would be placed at bit 16 instead
             };
         };
 
+        /**
+         * @brief A macro instruction which has been decoded into a form that can be executed without extracting any bitfields
+         */
+        struct DecodedOpcode {
+            bool valid; //!< If this has been decoded from the current contents of macro memory
+            Opcode::Operation operation;
+            Opcode::AssignmentOperation assignmentOperation;
+            Opcode::AluOperation aluOperation;
+            Opcode::BranchCondition branchCondition;
+            bool noDelay;
+            bool exit;
+            u8 dest;
+            u8 srcA;
+            u8 srcB;
+            u8 srcBit;
+            u8 destBit;
+            u32 mask; //!< The mask for bitfield operations, this is derived from the bitfield size
+            i32 immediate;
+        };
+
         Maxwell3D &maxwell3D; //!< A reference to the parent engine object
 
-        Opcode *opcode{}; //!< A pointer to the instruction that is currently being executed
+        static constexpr size_t MacroCodeSize{0x2000}; //!< The size of macro memory in instructions, this must match the size of Maxwell3D::macroCode
+        std::array<DecodedOpcode, MacroCodeSize> decodedCode{}; //!< A cache of decoded instructions for every word of macro memory, entries are decoded on their first execution and invalidated when the corresponding word is written to
+
+        u32 pc{}; //!< The index of the instruction that is currently being executed in macro memory
         std::array<u32, 8> registers{}; //!< The state of all the general-purpose registers in the macro interpreter
         const u32 *argument{}; //!< A pointer to the argument buffer for the program, it is read from sequentially
         MethodAddress methodAddress{};
         bool carryFlag{}; //!< A flag representing if an arithmetic operation has set the most significant bit
 
+        /**
+         * @return The decoded form of the instruction at the supplied index in macro memory, it's decoded if it isn't in the cache
+         */
+        const DecodedOpcode &Decode(u32 index);
+
         /**
          * @brief Steps forward one macro instruction, including delay slots
-         * @param delayedOpcode The target opcode to be jumped to after executing the instruction
+         * @param delayedPc The index of the instruction to be jumped to after executing the instruction, this is only valid if 'inDelaySlot' is true
          */
-        bool Step(Opcode *delayedOpcode = nullptr);
+        bool Step(bool inDelaySlot = false, u32 delayedPc = 0);
 
         /**
          * @brief Performs an ALU operation on the given source values and returns the result as a u32
@@ -140,9 +171,16 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
       public:
         MacroInterpreter(Maxwell3D &maxwell3D) : maxwell3D(maxwell3D) {}
 
+        /**
+         * @brief Invalidates the decoded instruction for a word of macro memory, this must be called whenever macro memory is written to
+         */
+        void Invalidate(size_t index) {
+            decodedCode[index].valid = false;
+        }
+
         /**
          * @brief Executes a GPU macro from macro memory with the given arguments
          */
-        void Execute(size_t offset, const std::vector<u32> &args);
+        void Execute(size_t offset, span<u32> args);
     };
 }
@@ -0,0 +1,626 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/mman.h>
+#include <bit>
+#include <bitset>
+#include <utility>
+#include <common/settings.h>
+#include <soc/gm20b/engines/maxwell_3d.h>
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    namespace {
+        /**
+         * @brief A minimal AArch64 assembler which only supports the instructions that compiled macros require, all data processing is done on 32-bit registers
+         */
+        class Arm64Emitter {
+          public:
+            using Reg = u32; //!< The index of a general-purpose register, 31 is the zero register or the stack pointer depending on the instruction
+
+            static constexpr Reg Zr{31}, Sp{31}, Fp{29}, Lr{30};
+
+            enum class Condition : u32 {
+                Eq = 0,
+                Ne = 1,
+                Cs = 2,
+            };
+
+            std::vector<u32> code;
+
+            size_t Size() const {
+                return code.size();
+            }
+
+            void Emit(u32 instruction) {
+                code.push_back(instruction);
+            }
+
+            void DataProcessing(u32 opcode, Reg d, Reg n, Reg m) {
+                Emit(opcode | (m << 16) | (n << 5) | d);
+            }
+
+            void Add(Reg d, Reg n, Reg m) { DataProcessing(0x0B000000, d, n, m); }
+            void Adds(Reg d, Reg n, Reg m) { DataProcessing(0x2B000000, d, n, m); }
+            void Adcs(Reg d, Reg n, Reg m) { DataProcessing(0x3A000000, d, n, m); }
+            void Sub(Reg d, Reg n, Reg m) { DataProcessing(0x4B000000, d, n, m); }
+            void Sbc(Reg d, Reg n, Reg m) { DataProcessing(0x5A000000, d, n, m); }
+            void And(Reg d, Reg n, Reg m) { DataProcessing(0x0A000000, d, n, m); }
+            void Bic(Reg d, Reg n, Reg m) { DataProcessing(0x0A200000, d, n, m); }
+            void Orr(Reg d, Reg n, Reg m) { DataProcessing(0x2A000000, d, n, m); }
+            void Orn(Reg d, Reg n, Reg m) { DataProcessing(0x2A200000, d, n, m); }
+            void Eor(Reg d, Reg n, Reg m) { DataProcessing(0x4A000000, d, n, m); }
+            void Lslv(Reg d, Reg n, Reg m) { DataProcessing(0x1AC02000, d, n, m); }
+            void Lsrv(Reg d, Reg n, Reg m) { DataProcessing(0x1AC02400, d, n, m); }
+
+            void Mov(Reg d, Reg m) { Orr(d, Zr, m); }
+
+            void MovX(Reg d, Reg m) { DataProcessing(0xAA000000, d, Zr, m); }
+
+            void Ubfm(Reg d, Reg n, u32 immr, u32 imms) {
+                Emit(0x53000000 | (immr << 16) | (imms << 10) | (n << 5) | d);
+            }
+
+            void Lsr(Reg d, Reg n, u32 shift) { Ubfm(d, n, shift, 31); }
+            void Lsl(Reg d, Reg n, u32 shift) { Ubfm(d, n, (32 - shift) % 32, 31 - shift); }
+            void Ubfx(Reg d, Reg n, u32 lsb, u32 width) { Ubfm(d, n, lsb, lsb + width - 1); }
+
+            void MovImm(Reg d, u32 value) {
+                Emit(0x52800000 | ((value & 0xFFFF) << 5) | d); // MOVZ
+                if (value >> 16)
+                    Emit(0x72A00000 | ((value >> 16) << 5) | d); // MOVK LSL #16
+            }
+
+            void MovImmX(Reg d, u64 value) {
+                Emit(0xD2800000 | ((value & 0xFFFF) << 5) | d); // MOVZ
+                for (u32 shift{1}; shift < 4; shift++)
+                    if (u32 half{static_cast<u32>((value >> (shift * 16)) & 0xFFFF)})
+                        Emit(0xF2800000 | (shift << 21) | (half << 5) | d); // MOVK LSL #(shift * 16)
+            }
+
+            void LdrPostIndex(Reg t, Reg n, u32 increment) {
+                Emit(0xB8400400 | ((increment & 0x1FF) << 12) | (n << 5) | t);
+            }
+
+            void Ldr(Reg t, Reg n, u32 offset) {
+                Emit(0xB9400000 | ((offset / 4) << 10) | (n << 5) | t);
+            }
+
+            void Str(Reg t, Reg n, u32 offset) {
+                Emit(0xB9000000 | ((offset / 4) << 10) | (n << 5) | t);
+            }
+
+            void CmpImm(Reg n, u32 immediate) {
+                Emit(0x7100001F | (immediate << 10) | (n << 5));
+            }
+
+            void Cset(Reg d, Condition condition) {
+                Emit(0x1A9F07E0 | ((static_cast<u32>(condition) ^ 1) << 12) | d); // CSINC Wd, WZR, WZR, !condition
+            }
+
+            void Cbz(Reg t, i32 offset) {
+                Emit(0x34000000 | ((static_cast<u32>(offset) & 0x7FFFF) << 5) | t);
+            }
+
+            void Cbnz(Reg t, i32 offset) {
+                Emit(0x35000000 | ((static_cast<u32>(offset) & 0x7FFFF) << 5) | t);
+            }
+
+            /**
+             * @brief Branches if bit 63 of the supplied 64-bit register is clear
+             */
+            void TbzSign(Reg t, i32 offset) {
+                Emit(0xB6F80000 | ((static_cast<u32>(offset) & 0x3FFF) << 5) | t);
+            }
+
+            void B(i32 offset) {
+                Emit(0x14000000 | (static_cast<u32>(offset) & 0x3FFFFFF));
+            }
+
+            void Blr(Reg n) {
+                Emit(0xD63F0000 | (n << 5));
+            }
+
+            void Ret() {
+                Emit(0xD65F03C0);
+            }
+
+            void StpPreIndex(Reg t1, Reg t2, Reg n, i32 offset) {
+                Emit(0xA9800000 | ((static_cast<u32>(offset / 8) & 0x7F) << 15) | (t2 << 10) | (n << 5) | t1);
+            }
+
+            void Stp(Reg t1, Reg t2, Reg n, i32 offset) {
+                Emit(0xA9000000 | ((static_cast<u32>(offset / 8) & 0x7F) << 15) | (t2 << 10) | (n << 5) | t1);
+            }
+
+            void Ldp(Reg t1, Reg t2, Reg n, i32 offset) {
+                Emit(0xA9400000 | ((static_cast<u32>(offset / 8) & 0x7F) << 15) | (t2 << 10) | (n << 5) | t1);
+            }
+
+            void LdpPostIndex(Reg t1, Reg t2, Reg n, i32 offset) {
+                Emit(0xA8C00000 | ((static_cast<u32>(offset / 8) & 0x7F) << 15) | (t2 << 10) | (n << 5) | t1);
+            }
+
+            void MovFromSp(Reg d) {
+                Emit(0x91000000 | (Sp << 5) | d); // ADD Xd, SP, #0
+            }
+
+            /**
+             * @brief Patches the offset of a previously emitted B/CBZ/CBNZ at the supplied index to target another index
+             */
+            void PatchBranch(size_t index, size_t target) {
+                auto offset{static_cast<u32>(static_cast<i32>(target) - static_cast<i32>(index))};
+                auto &instruction{code[index]};
+                if ((instruction & 0xFC000000) == 0x14000000)
+                    instruction = (instruction & 0xFC000000) | (offset & 0x3FFFFFF);
+                else
+                    instruction = (instruction & 0xFF00001F) | ((offset & 0x7FFFF) << 5);
+            }
+        };
+    }
+
+    MacroJit::MacroJit(const DeviceState &state, Maxwell3D &maxwell3D) : state(state), maxwell3D(maxwell3D) {
+        #if defined(__aarch64__)
+        if (!state.settings->macroJit)
+            return;
+
+        auto region{mmap(nullptr, CodeRegionSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+        if (region == MAP_FAILED)
+            state.logger->Warn("Failed to map the macro JIT code region, macros will be interpreted: {}", strerror(errno));
+        else
+            codeRegion = static_cast<u32 *>(region);
+        #endif
+    }
+
+    MacroJit::~MacroJit() {
+        if (codeRegion)
+            munmap(codeRegion, CodeRegionSize);
+    }
+
+    MacroJit::CachedMacro MacroJit::Compile(u32 offset) {
+        using Opcode = MacroInterpreter::Opcode;
+        using Reg = Arm64Emitter::Reg;
+        constexpr size_t MacroCodeSize{MacroInterpreter::MacroCodeSize};
+
+        CachedMacro macro{};
+        if (!codeRegion || offset >= MacroCodeSize)
+            return macro;
+
+        auto fetch{[&](u32 pc) -> Opcode { return Opcode{.raw = maxwell3D.macroCode[pc]}; }};
+        auto isSupported{[](Opcode opcode) {
+            switch (opcode.operation) {
+                case Opcode::Operation::AluRegister:
+                    switch (opcode.aluOperation) {
+                        case Opcode::AluOperation::Add:
+                        case Opcode::AluOperation::AddWithCarry:
+                        case Opcode::AluOperation::Subtract:
+                        case Opcode::AluOperation::SubtractWithBorrow:
+                        case Opcode::AluOperation::BitwiseXor:
+                        case Opcode::AluOperation::BitwiseOr:
+                        case Opcode::AluOperation::BitwiseAnd:
+                        case Opcode::AluOperation::BitwiseAndNot:
+                        case Opcode::AluOperation::BitwiseNand:
+                            return true;
+                        default:
+                            return false;
+                    }
+                case Opcode::Operation::AddImmediate:
+                case Opcode::Operation::BitfieldReplace:
+                case Opcode::Operation::BitfieldExtractShiftLeftImmediate:
+                case Opcode::Operation::BitfieldExtractShiftLeftRegister:
+                case Opcode::Operation::ReadImmediate:
+                case Opcode::Operation::Branch:
+                    return true;
+                default:
+                    return false;
+            }
+        }};
+        auto isBranch{[](Opcode opcode) { return opcode.operation == Opcode::Operation::Branch; }};
+        auto nextPc{[](u32 pc) { return (pc + 1) % MacroCodeSize; }};
+        auto branchTarget{[](u32 pc, Opcode opcode) { return static_cast<u32>(pc + opcode.immediate) % MacroCodeSize; }};
+
+        // Discover all instructions reachable from the entry point, delay slots are inlined into the instruction they belong to so they're validated but not added
+        // Every word which is read is recorded in the macro's words, including when compilation fails as the outcome only depends on the words read up to that point
+        std::bitset<MacroCodeSize> reachable;
+        std::vector<u32> worklist{offset};
+        size_t instructionCount{};
+        auto addDelaySlot{[&](u32 pc) {
+            macro.words.set(pc);
+            auto slot{fetch(pc)};
+            return isSupported(slot) && !isBranch(slot); // The interpreter throws on a branch in a delay slot, we leave that to it
+        }};
+        while (!worklist.empty()) {
+            u32 pc{worklist.back()};
+            worklist.pop_back();
+            if (reachable.test(pc))
+                continue;
+            reachable.set(pc);
+            macro.words.set(pc);
+
+            if (++instructionCount > MaxMacroInstructions)
+                return macro;
+
+            auto opcode{fetch(pc)};
+            if (!isSupported(opcode))
+                return macro;
+
+            if (isBranch(opcode)) {
+                if (!opcode.noDelay && !addDelaySlot(nextPc(pc)))
+                    return macro;
+                worklist.push_back(branchTarget(pc, opcode));
+                if (opcode.exit) {
+                    if (!addDelaySlot(nextPc(pc)))
+                        return macro;
+                } else {
+                    worklist.push_back(nextPc(pc));
+                }
+            } else if (opcode.exit) {
+                if (!addDelaySlot(nextPc(pc)))
+                    return macro;
+            } else {
+                worklist.push_back(nextPc(pc));
+            }
+        }
+
+        /*
+         * Register allocation:
+         * W19-W25 hold MME registers 1-7 while MME register 0 is always WZR
+         * W26 holds the method address, X27 the argument pointer and X28 the MacroJit pointer
+         * W9-W12 are temporaries and X16 is used for helper calls, the carry flag is stored on the stack as it's rarely used
+         */
+        constexpr Reg MethodReg{26}, ArgumentReg{27}, JitReg{28}, ResultReg{9}, Temp0{10}, Temp1{11}, CallReg{16};
+        constexpr u32 FrameSize{112}, CarryOffset{96};
+        auto mmeReg{[](u8 reg) -> Reg { return reg ? 18U + reg : Arm64Emitter::Zr; }};
+
+        MacroInterpreter::MethodAddress incrementMask{};
+        incrementMask.increment = 0x3F;
+        auto incrementShift{static_cast<u32>(std::countr_zero(incrementMask.raw))}; // The position of the increment is derived from the bitfield layout the interpreter uses
+
+        Arm64Emitter emitter;
+        std::vector<size_t> epilogueFixups; //!< The indices of branches to the epilogue
+        std::vector<std::pair<size_t, u32>> branchFixups; //!< The indices of branches to the compiled code of an instruction in macro memory
+        std::unordered_map<u32, size_t> labels; //!< A map from instructions in macro memory to the index of their compiled code
+
+        auto callHelper{[&](auto helper) {
+            emitter.MovImmX(CallReg, reinterpret_cast<u64>(helper));
+            emitter.Blr(CallReg);
+        }};
+        auto checkAbort{[&]() {
+            emitter.TbzSign(0, 2);
+            epilogueFixups.push_back(emitter.Size());
+            emitter.B(0);
+        }};
+
+        auto emitSend{[&](Reg value) {
+            emitter.Mov(2, value);
+            emitter.Mov(1, MethodReg);
+            emitter.MovX(0, JitReg);
+            callHelper(&SendHelper);
+            checkAbort();
+            emitter.Mov(MethodReg, 0);
+        }};
+
+        auto emitFetch{[&](Reg reg) {
+            emitter.LdrPostIndex(reg, ArgumentReg, sizeof(u32));
+        }};
+
+        auto emitAssignment{[&](Opcode opcode) {
+            Reg dest{mmeReg(opcode.dest)};
+            switch (opcode.assignmentOperation) {
+                case Opcode::AssignmentOperation::IgnoreAndFetch:
+                    emitFetch(dest);
+                    break;
+                case Opcode::AssignmentOperation::Move:
+                    emitter.Mov(dest, ResultReg);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethod:
+                    emitter.Mov(dest, ResultReg);
+                    emitter.Mov(MethodReg, ResultReg);
+                    break;
+                case Opcode::AssignmentOperation::FetchAndSend:
+                    emitFetch(dest);
+                    emitSend(ResultReg);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSend:
+                    emitter.Mov(dest, ResultReg);
+                    emitSend(ResultReg);
+                    break;
+                case Opcode::AssignmentOperation::FetchAndSetMethod:
+                    emitFetch(dest);
+                    emitter.Mov(MethodReg, ResultReg);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethodThenFetchAndSend:
+                    emitter.Mov(dest, ResultReg);
+                    emitter.Mov(MethodReg, ResultReg);
+                    emitFetch(Temp0);
+                    emitSend(Temp0);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethodThenSendHigh:
+                    emitter.Mov(dest, ResultReg);
+                    emitter.Mov(MethodReg, ResultReg);
+                    emitter.Ubfx(Temp0, ResultReg, incrementShift, 6);
+                    emitSend(Temp0);
+                    break;
+            }
+        }};
+
+        // Emits a non-branch instruction, this matches the semantics of MacroInterpreter::Step and its helpers
+        auto emitOperation{[&](Opcode opcode) {
+            Reg srcA{mmeReg(opcode.srcA)}, srcB{mmeReg(opcode.srcB)};
+            u32 mask{opcode.bitfield.GetMask()};
+            switch (opcode.operation) {
+                case Opcode::Operation::AluRegister:
+                    switch (opcode.aluOperation) {
+                        case Opcode::AluOperation::Add:
+                            emitter.Adds(ResultReg, srcA, srcB);
+                            emitter.Cset(Temp0, Arm64Emitter::Condition::Cs);
+                            emitter.Str(Temp0, Arm64Emitter::Sp, CarryOffset);
+                            break;
+                        case Opcode::AluOperation::AddWithCarry:
+                            emitter.Ldr(Temp0, Arm64Emitter::Sp, CarryOffset);
+                            emitter.CmpImm(Temp0, 1); // C = carry != 0
+                            emitter.Adcs(ResultReg, srcA, srcB);
+                            emitter.Cset(Temp0, Arm64Emitter::Condition::Cs);
+                            emitter.Str(Temp0, Arm64Emitter::Sp, CarryOffset);
+                            break;
+                        case Opcode::AluOperation::Subtract:
+                            emitter.Sub(ResultReg, srcA, srcB);
+                            emitter.Str(ResultReg, Arm64Emitter::Sp, CarryOffset); // The carry flag is set to the result being non-zero
+                            break;
+                        case Opcode::AluOperation::SubtractWithBorrow:
+                            emitter.Ldr(Temp0, Arm64Emitter::Sp, CarryOffset);
+                            emitter.CmpImm(Temp0, 1);
+                            emitter.Sbc(ResultReg, srcA, srcB); // srcA - srcB - !carry
+                            emitter.Str(ResultReg, Arm64Emitter::Sp, CarryOffset);
+                            break;
+                        case Opcode::AluOperation::BitwiseXor:
+                            emitter.Eor(ResultReg, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseOr:
+                            emitter.Orr(ResultReg, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseAnd:
+                            emitter.And(ResultReg, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseAndNot:
+                            emitter.Bic(ResultReg, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseNand:
+                            emitter.And(ResultReg, srcA, srcB);
+                            emitter.Orn(ResultReg, Arm64Emitter::Zr, ResultReg);
+                            break;
+                    }
+                    break;
+
+                case Opcode::Operation::AddImmediate:
+                    if (opcode.immediate) {
+                        emitter.MovImm(Temp0, static_cast<u32>(opcode.immediate));
+                        emitter.Add(ResultReg, srcA, Temp0);
+                    } else {
+                        emitter.Mov(ResultReg, srcA); // Moves and fetches are encoded as an addition of zero
+                    }
+                    break;
+
+                case Opcode::Operation::BitfieldReplace:
+                    emitter.Lsr(Temp0, srcB, opcode.bitfield.srcBit);
+                    emitter.MovImm(Temp1, mask);
+                    emitter.And(Temp0, Temp0, Temp1);
+                    emitter.Lsl(Temp0, Temp0, opcode.bitfield.destBit);
+                    emitter.MovImm(Temp1, mask << opcode.bitfield.destBit);
+                    emitter.Bic(ResultReg, srcA, Temp1);
+                    emitter.Orr(ResultReg, ResultReg, Temp0);
+                    break;
+
+                case Opcode::Operation::BitfieldExtractShiftLeftImmediate:
+                    emitter.Lsrv(Temp0, srcB, srcA);
+                    emitter.MovImm(Temp1, mask);
+                    emitter.And(Temp0, Temp0, Temp1);
+                    emitter.Lsl(ResultReg, Temp0, opcode.bitfield.destBit);
+                    break;
+
+                case Opcode::Operation::BitfieldExtractShiftLeftRegister:
+                    emitter.Lsr(Temp0, srcB, opcode.bitfield.srcBit);
+                    emitter.MovImm(Temp1, mask);
+                    emitter.And(Temp0, Temp0, Temp1);
+                    emitter.Lslv(ResultReg, Temp0, srcA);
+                    break;
+
+                case Opcode::Operation::ReadImmediate:
+                    emitter.MovImm(Temp0, static_cast<u32>(opcode.immediate));
+                    emitter.Add(1, srcA, Temp0);
+                    emitter.MovX(0, JitReg);
+                    callHelper(&ReadHelper);
+                    checkAbort();
+                    emitter.Mov(ResultReg, 0);
+                    break;
+
+                default:
+                    break; // Branches are handled by the caller and unsupported operations are rejected during discovery
+            }
+            emitAssignment(opcode);
+        }};
+
+        auto emitBranch{[&](u32 pc) {
+            branchFixups.emplace_back(emitter.Size(), pc);
+            emitter.B(0);
+        }};
+        auto emitExit{[&](u32 slotPc) {
+            emitOperation(fetch(slotPc));
+            epilogueFixups.push_back(emitter.Size());
+            emitter.B(0);
+        }};
+
+        // Prologue
+        emitter.StpPreIndex(Arm64Emitter::Fp, Arm64Emitter::Lr, Arm64Emitter::Sp, -static_cast<i32>(FrameSize));
+        emitter.MovFromSp(Arm64Emitter::Fp);
+        for (Reg reg{19}; reg < 29; reg += 2)
+            emitter.Stp(reg, reg + 1, Arm64Emitter::Sp, static_cast<i32>((reg - 17) * 8));
+        emitter.MovX(JitReg, 0);
+        emitter.MovX(ArgumentReg, 1);
+        emitter.Str(Arm64Emitter::Zr, Arm64Emitter::Sp, CarryOffset);
+        emitFetch(mmeReg(1)); // The first argument is stored in register 1
+        for (u8 reg{2}; reg < 8; reg++)
+            emitter.Mov(mmeReg(reg), Arm64Emitter::Zr);
+        emitter.Mov(MethodReg, Arm64Emitter::Zr);
+
+        // Instructions are emitted in order starting from the entry point so most fall-throughs don't require a branch
+        std::optional<u32> fallthroughPc{offset};
+        for (u32 index{}; index < MacroCodeSize; index++) {
+            u32 pc{(offset + index) % static_cast<u32>(MacroCodeSize)};
+            if (!reachable.test(pc))
+                continue;
+
+            if (fallthroughPc && *fallthroughPc != pc)
+                emitBranch(*fallthroughPc);
+            fallthroughPc = std::nullopt;
+            labels[pc] = emitter.Size();
+
+            auto opcode{fetch(pc)};
+            if (isBranch(opcode)) {
+                size_t notTaken{emitter.Size()};
+                if (opcode.branchCondition == Opcode::BranchCondition::Zero)
+                    emitter.Cbnz(mmeReg(opcode.srcA), 0);
+                else
+                    emitter.Cbz(mmeReg(opcode.srcA), 0);
+
+                if (!opcode.noDelay)
+                    emitOperation(fetch(nextPc(pc)));
+                emitBranch(branchTarget(pc, opcode));
+
+                emitter.PatchBranch(notTaken, emitter.Size());
+                if (opcode.exit)
+                    emitExit(nextPc(pc));
+                else
+                    fallthroughPc = nextPc(pc);
+            } else {
+                emitOperation(opcode);
+                if (opcode.exit)
+                    emitExit(nextPc(pc));
+                else
+                    fallthroughPc = nextPc(pc);
+            }
+        }
+        if (fallthroughPc)
+            emitBranch(*fallthroughPc);
+
+        // Epilogue
+        size_t epilogue{emitter.Size()};
+        emitter.MovX(0, JitReg);
+        callHelper(&ExitHelper);
+        for (Reg reg{19}; reg < 29; reg += 2)
+            emitter.Ldp(reg, reg + 1, Arm64Emitter::Sp, static_cast<i32>((reg - 17) * 8));
+        emitter.LdpPostIndex(Arm64Emitter::Fp, Arm64Emitter::Lr, Arm64Emitter::Sp, static_cast<i32>(FrameSize));
+        emitter.Ret();
+
+        for (size_t fixup : epilogueFixups)
+            emitter.PatchBranch(fixup, epilogue);
+        for (auto [fixup, pc] : branchFixups)
+            emitter.PatchBranch(fixup, labels.at(pc));
+
+        constexpr size_t CodeRegionCapacity{CodeRegionSize / sizeof(u32)};
+        if (emitter.Size() > CodeRegionCapacity)
+            return macro;
+
+        if (codeOffset + emitter.Size() > CodeRegionCapacity) {
+            // The code region is full, all existing macros are discarded and recompiled on demand
+            // This can't be done while a macro is executing as its code would be overwritten, the nested macro is interpreted instead and retried once the region has been reset
+            if (executionDepth)
+                return macro;
+
+            compiledMacros.clear();
+            codeOffset = 0;
+        }
+
+        auto code{codeRegion + codeOffset};
+        std::memcpy(code, emitter.code.data(), emitter.Size() * sizeof(u32));
+        codeOffset += emitter.Size();
+        __builtin___clear_cache(reinterpret_cast<char *>(code), reinterpret_cast<char *>(code + emitter.Size()));
+
+        macro.code = reinterpret_cast<CompiledMacro>(code);
+        return macro;
+    }
+
+    void MacroJit::Flush() {
+        if (pendingArguments.empty())
+            return;
+
+        maxwell3D.CallMethodBatch(pendingMethod, pendingArguments, true);
+        pendingArguments.clear();
+    }
+
+    u64 MacroJit::SendHelper(MacroJit *jit, u32 methodAddressRaw, u32 argument) {
+        MacroInterpreter::MethodAddress methodAddress{.raw = methodAddressRaw};
+        try {
+            u32 method{methodAddress.address};
+            if (method >= Maxwell3D::RegisterCount) [[unlikely]] {
+                // Macro methods depend on each individual call, they can't be batched
+                jit->Flush();
+                jit->maxwell3D.CallMethod(method, argument, true);
+            } else {
+                if (!jit->pendingArguments.empty() && method != jit->pendingMethod + jit->pendingArguments.size())
+                    jit->Flush();
+                if (jit->pendingArguments.empty())
+                    jit->pendingMethod = method;
+                jit->pendingArguments.push_back(argument);
+            }
+        } catch (...) {
+            jit->caughtException = std::current_exception();
+            return AbortFlag;
+        }
+
+        methodAddress.address += methodAddress.increment;
+        return methodAddress.raw;
+    }
+
+    u64 MacroJit::ReadHelper(MacroJit *jit, u32 index) {
+        try {
+            jit->Flush();
+            if (index >= Maxwell3D::RegisterCount)
+                throw exception("Macro read from an out of bounds register: 0x{:X}", index);
+            return jit->maxwell3D.registers.raw[index];
+        } catch (...) {
+            jit->caughtException = std::current_exception();
+            return AbortFlag;
+        }
+    }
+
+    void MacroJit::ExitHelper(MacroJit *jit) {
+        if (jit->caughtException)
+            return;
+
+        try {
+            jit->Flush();
+        } catch (...) {
+            jit->caughtException = std::current_exception();
+        }
+    }
+
+    bool MacroJit::Execute(u32 offset, span<u32> args) {
+        if (!codeRegion)
+            return false;
+
+        if (invalidated) {
+            // Only macros which were compiled from words that have since been written to are discarded, their code remains in the code region till it's reset as an outer macro may still be executing it
+            std::erase_if(compiledMacros, [this](const auto &entry) { return (entry.second.words & dirtyWords).any(); });
+            dirtyWords.reset();
+            invalidated = false;
+        }
+
+        auto it{compiledMacros.find(offset)};
+        if (it == compiledMacros.end())
+            it = compiledMacros.emplace(offset, Compile(offset)).first;
+
+        auto macro{it->second.code}; // The entry may be erased by a nested macro, the code itself remains valid till the outermost macro returns
+        if (!macro)
+            return false;
+
+        // Any pending method calls were flushed by the outer macro prior to the macro method call which led to this one
+        pendingArguments.clear();
+        executionDepth++;
+        macro(this, args.data());
+        executionDepth--;
+
+        if (caughtException) [[unlikely]]
+            std::rethrow_exception(std::exchange(caughtException, nullptr));
+        return true;
+    }
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <bitset>
+#include "macro_interpreter.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    /**
+     * @brief The MacroJit class compiles macros into AArch64 host code, any macros which can't be compiled are left to the MacroInterpreter which is the reference implementation
+     * @note Method calls made by a compiled macro are queued up and sent to the Maxwell 3D in batches of incrementing methods, the queue is flushed prior to any register reads and at the end of the macro
+     */
+    class MacroJit {
+      private:
+        /**
+         * @brief The signature of a compiled macro
+         * @param jit The MacroJit which compiled the macro, it's passed to all helper functions
+         * @param arguments The arguments for the macro, the first one is loaded into register 1
+         */
+        using CompiledMacro = void (*)(MacroJit *jit, const u32 *arguments);
+
+        /**
+         * @brief The compiled code of a macro alongside the words of macro memory it was compiled from
+         */
+        struct CachedMacro {
+            CompiledMacro code; //!< The compiled code of the macro or null if it cannot be compiled
+            std::bitset<MacroInterpreter::MacroCodeSize> words; //!< The words of macro memory which affect the compiled code, a write to any of them invalidates it
+        };
+
+        static constexpr size_t CodeRegionSize{0x100000}; //!< The size of the code region shared by all compiled macros
+        static constexpr size_t MaxMacroInstructions{0x400}; //!< The maximum amount of reachable instructions in a macro for it to be compiled, larger macros are interpreted
+
+        const DeviceState &state;
+        Maxwell3D &maxwell3D;
+        u32 *codeRegion{}; //!< An RWX mapping which compiled macros are written into
+        size_t codeOffset{}; //!< The offset in instructions of the free space in the code region
+        std::unordered_map<u32, CachedMacro> compiledMacros; //!< A map from the start offset of a macro in macro memory to its compiled code
+        std::bitset<MacroInterpreter::MacroCodeSize> dirtyWords; //!< The words of macro memory which have been written to since compiled macros were last invalidated
+        bool invalidated{}; //!< If any bit in 'dirtyWords' is set, this avoids scanning the bitset on every execution
+        u32 executionDepth{}; //!< The amount of compiled macros currently executing, macros can be nested through method calls to macro methods
+
+        u32 pendingMethod{}; //!< The method of the first argument in 'pendingArguments'
+        std::vector<u32> pendingArguments; //!< Arguments to incrementing methods which are pending being sent to the Maxwell 3D
+        std::exception_ptr caughtException; //!< An exception thrown while a compiled macro was running, exceptions can't be unwound through JIT code so they're rethrown after it returns
+
+        static constexpr u64 AbortFlag{1ULL << 63}; //!< A flag set in the return value of a helper when an exception was caught, compiled code jumps to its epilogue when it's set
+
+        /**
+         * @return A compiled version of the macro at the supplied offset in macro memory, its code is null if it cannot be compiled
+         */
+        CachedMacro Compile(u32 offset);
+
+        /**
+         * @brief Sends all pending method calls to the Maxwell 3D
+         */
+        void Flush();
+
+        /**
+         * @brief Queues a method call from a compiled macro
+         * @return The method address after the increment has been applied or AbortFlag
+         */
+        static u64 SendHelper(MacroJit *jit, u32 methodAddress, u32 argument);
+
+        /**
+         * @return The value of the supplied Maxwell 3D register after flushing all pending method calls or AbortFlag
+         */
+        static u64 ReadHelper(MacroJit *jit, u32 index);
+
+        /**
+         * @brief Flushes all pending method calls at the end of a compiled macro
+         */
+        static void ExitHelper(MacroJit *jit);
+
+      public:
+        MacroJit(const DeviceState &state, Maxwell3D &maxwell3D);
+
+        ~MacroJit();
+
+        /**
+         * @brief Marks a word of macro memory as written to, this must be called whenever macro memory is written to
+         * @note Compiled macros which depend on the word are only discarded on the next execution, this makes uploading macro memory cheap regardless of the amount of compiled macros
+         */
+        void Invalidate(size_t index) {
+            dirtyWords.set(index);
+            invalidated = true;
+        }
+
+        /**
+         * @brief Executes the macro at the supplied offset in macro memory if it can be compiled
+         * @return If the macro was executed, the macro must be interpreted if this is false
+         */
+        bool Execute(u32 offset, span<u32> args);
+    };
+}
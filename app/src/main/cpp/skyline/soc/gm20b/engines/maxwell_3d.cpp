@@ -4,7 +4,117 @@
 #include <soc.h>
 
 namespace skyline::soc::gm20b::engine::maxwell3d {
-    Maxwell3D::Maxwell3D(const DeviceState &state) : Engine(state), macroInterpreter(*this) {
+    /**
+     * @brief A table of all registers which have side-effects when written to, these need to go through CallMethod while all other registers can be written directly
+     * @note This must be kept in sync with the switch in CallMethod
+     */
+    constexpr std::array<bool, Maxwell3D::RegisterCount> RegisterSideEffects{[] {
+        using Registers = Maxwell3D::Registers;
+        std::array<bool, Maxwell3D::RegisterCount> table{};
+        for (size_t method : {
+            MAXWELL3D_OFFSET(mme.instructionRamLoad),
+            MAXWELL3D_OFFSET(mme.startAddressRamLoad),
+            MAXWELL3D_OFFSET(mme.shadowRamControl),
+            MAXWELL3D_OFFSET(syncpointAction),
+            MAXWELL3D_OFFSET(semaphore.info),
+            MAXWELL3D_OFFSET(firmwareCall[4]),
+        })
+            table[method] = true;
+        return table;
+    }()};
+
+    /**
+     * @brief A contiguous range of registers which belongs to a state group
+     */
+    struct StateGroupRange {
+        Maxwell3D::StateGroup group;
+        u32 offset; //!< The offset of the first register in the range
+        u32 size; //!< The amount of registers in the range
+    };
+
+    #define STATE_GROUP_RANGE(stateGroup, field) StateGroupRange{StateGroup::stateGroup, MAXWELL3D_OFFSET(field), sizeof(Registers::field) / sizeof(u32)}
+
+    /**
+     * @brief The register ranges which make up each state group, these are derived from the register layout so they can't go out of sync with it
+     */
+    constexpr auto StateGroupRanges{[] {
+        using Registers = Maxwell3D::Registers;
+        using StateGroup = Maxwell3D::StateGroup;
+        return std::array{
+            STATE_GROUP_RANGE(Viewport, viewportTransform),
+            STATE_GROUP_RANGE(Viewport, viewport),
+            STATE_GROUP_RANGE(Viewport, viewportTransformEnable),
+
+            STATE_GROUP_RANGE(Rasterizer, rasterizerEnable),
+            STATE_GROUP_RANGE(Rasterizer, polygonMode),
+            STATE_GROUP_RANGE(Rasterizer, lineWidthSmooth),
+            STATE_GROUP_RANGE(Rasterizer, lineWidthAliased),
+            STATE_GROUP_RANGE(Rasterizer, clipDistanceEnable),
+            STATE_GROUP_RANGE(Rasterizer, pointSpriteSize),
+            STATE_GROUP_RANGE(Rasterizer, pointSpriteEnable),
+            STATE_GROUP_RANGE(Rasterizer, polygonOffsetFactor),
+            STATE_GROUP_RANGE(Rasterizer, lineSmoothEnable),
+            STATE_GROUP_RANGE(Rasterizer, pointCoordReplace),
+            STATE_GROUP_RANGE(Rasterizer, cullFaceEnable),
+            STATE_GROUP_RANGE(Rasterizer, frontFace),
+            STATE_GROUP_RANGE(Rasterizer, cullFace),
+            STATE_GROUP_RANGE(Rasterizer, pixelCentreImage),
+
+            STATE_GROUP_RANGE(DepthStencil, stencilBackExtra),
+            STATE_GROUP_RANGE(DepthStencil, depthTestFunc),
+            STATE_GROUP_RANGE(DepthStencil, stencilEnable),
+            STATE_GROUP_RANGE(DepthStencil, stencilFront),
+            STATE_GROUP_RANGE(DepthStencil, depthTargetEnable),
+            STATE_GROUP_RANGE(DepthStencil, stencilTwoSideEnable),
+            STATE_GROUP_RANGE(DepthStencil, stencilBack),
+
+            STATE_GROUP_RANGE(Blend, rtSeparateFragData),
+            STATE_GROUP_RANGE(Blend, alphaTestRef),
+            STATE_GROUP_RANGE(Blend, alphaTestFunc),
+            STATE_GROUP_RANGE(Blend, blendConstant),
+            STATE_GROUP_RANGE(Blend, blend),
+            STATE_GROUP_RANGE(Blend, colorMask),
+            STATE_GROUP_RANGE(Blend, independentBlend),
+
+            STATE_GROUP_RANGE(VertexAttributes, vertexAttributeState),
+
+            STATE_GROUP_RANGE(Multisample, sampleCounterEnable),
+            STATE_GROUP_RANGE(Multisample, multisampleEnable),
+            STATE_GROUP_RANGE(Multisample, multisampleControl),
+
+            STATE_GROUP_RANGE(TexturePools, texSamplerPool),
+            STATE_GROUP_RANGE(TexturePools, texHeaderPool),
+        };
+    }()};
+
+    #undef STATE_GROUP_RANGE
+
+    static_assert([] {
+        std::array<bool, Maxwell3D::StateGroupCount> populated{};
+        for (const auto &range : StateGroupRanges) {
+            if (static_cast<size_t>(range.group) >= Maxwell3D::StateGroupCount || range.size == 0 || range.offset + range.size > Maxwell3D::RegisterCount)
+                return false;
+            for (u32 index{range.offset}; index < range.offset + range.size; index++)
+                if (RegisterSideEffects[index])
+                    return false; // Registers with side-effects aren't pipeline state
+            populated[static_cast<size_t>(range.group)] = true;
+        }
+        return std::all_of(populated.begin(), populated.end(), [](bool value) { return value; });
+    }(), "Every state group must consist of valid registers without side-effects");
+
+    /**
+     * @brief A table of the StateGroups that each register belongs to as a bitmask
+     */
+    constexpr std::array<u16, Maxwell3D::RegisterCount> RegisterStateGroups{[] {
+        static_assert(Maxwell3D::StateGroupCount <= std::numeric_limits<u16>::digits);
+        std::array<u16, Maxwell3D::RegisterCount> table{};
+        for (const auto &range : StateGroupRanges)
+            for (u32 index{range.offset}; index < range.offset + range.size; index++)
+                table[index] |= static_cast<u16>(1U << static_cast<u8>(range.group));
+        return table;
+    }()};
+
+    Maxwell3D::Maxwell3D(const DeviceState &state) : Engine(state), macroInterpreter(*this), macroJit(state, *this), macroHle(state, *this) {
         ResetRegs();
     }
 
@@ -70,19 +180,53 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         }
 
         registers.viewportTransformEnable = true;
+
+        dirtyStateGroups = static_cast<u16>((1U << StateGroupCount) - 1); // All state is considered dirty after a reset
+    }
+
+    u64 Maxwell3D::HashState(StateGroup group) const {
+        u64 hash{};
+        for (const auto &range : StateGroupRanges) {
+            if (range.group != group)
+                continue;
+
+            std::string_view bytes{reinterpret_cast<const char *>(&registers.raw[range.offset]), range.size * sizeof(u32)};
+            hash ^= util::Hash(bytes) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    bool Maxwell3D::ConsumeDirty(StateGroup group, u64 &hash) {
+        if (!IsDirty(group))
+            return false;
+        ClearDirty(group);
+
+        u64 newHash{HashState(group)};
+        if (newHash == hash)
+            return false;
+        hash = newHash;
+        return true;
+    }
+
+    void Maxwell3D::ExecuteMacro(size_t offset, span<u32> arguments) {
+        if (offset < macroCode.size() && (macroHle.Execute(static_cast<u32>(offset), arguments) || macroJit.Execute(static_cast<u32>(offset), arguments)))
+            return;
+
+        macroInterpreter.Execute(offset, arguments);
     }
 
     void Maxwell3D::CallMethod(u32 method, u32 argument, bool lastCall) {
-        state.logger->Debug("Called method in Maxwell 3D: 0x{:X} args: 0x{:X}", method, argument);
+        LOG_DEBUG(state.logger, "Called method in Maxwell 3D: 0x{:X} args: 0x{:X}", method, argument);
 
-        // Methods that are greater than the register size are for macro control
-        if (method > RegisterCount) [[unlikely]] {
+        // Methods past the end of the registers are for macro control
+        if (method >= RegisterCount) [[unlikely]] {
             // Starting a new macro at index 'method - RegisterCount'
             if (!(method & 1)) {
                 if (macroInvocation.index != -1) {
-                    // Flush the current macro as we are switching to another one
-                    macroInterpreter.Execute(macroPositions[macroInvocation.index], macroInvocation.arguments);
+                    // Flush the current macro as we are switching to another one, the arguments are moved out as the macro may call other macros
+                    auto arguments{std::move(macroInvocation.arguments)};
                     macroInvocation.arguments.clear();
+                    ExecuteMacro(macroPositions[macroInvocation.index], arguments);
                 }
 
                 // Setup for the new macro index
@@ -93,9 +237,11 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
             // Flush macro after all of the data in the method call has been sent
             if (lastCall && macroInvocation.index != -1) {
-                macroInterpreter.Execute(macroPositions[macroInvocation.index], macroInvocation.arguments);
+                auto position{macroPositions[macroInvocation.index]};
+                auto arguments{std::move(macroInvocation.arguments)};
                 macroInvocation.arguments.clear();
                 macroInvocation.index = -1;
+                ExecuteMacro(position, arguments);
             }
 
             // Bail out early
@@ -103,6 +249,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         }
 
         registers.raw[method] = argument;
+        dirtyStateGroups |= RegisterStateGroups[method];
 
         if (shadowRegisters.mme.shadowRamControl == Registers::MmeShadowRamControl::MethodTrack || shadowRegisters.mme.shadowRamControl == Registers::MmeShadowRamControl::MethodTrackWithFilter)
             shadowRegisters.raw[method] = argument;
@@ -114,6 +261,9 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 if (registers.mme.instructionRamPointer >= macroCode.size())
                     throw exception("Macro memory is full!");
 
+                macroInterpreter.Invalidate(registers.mme.instructionRamPointer);
+                macroJit.Invalidate(registers.mme.instructionRamPointer);
+                macroHle.Invalidate(registers.mme.instructionRamPointer);
                 macroCode[registers.mme.instructionRamPointer++] = argument;
 
                 // Wraparound writes
@@ -130,7 +280,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 shadowRegisters.mme.shadowRamControl = static_cast<Registers::MmeShadowRamControl>(argument);
                 break;
             case MAXWELL3D_OFFSET(syncpointAction):
-                state.logger->Debug("Increment syncpoint: {}", static_cast<u16>(registers.syncpointAction.id));
+                LOG_DEBUG(state.logger, "Increment syncpoint: {}", static_cast<u16>(registers.syncpointAction.id));
                 state.soc->host1x.syncpoints.at(registers.syncpointAction.id).Increment();
                 break;
             case MAXWELL3D_OFFSET(semaphore.info):
@@ -154,6 +304,62 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         }
     }
 
+    void Maxwell3D::WriteRegisters(u32 method, span<u32> arguments) {
+        std::memcpy(&registers.raw[method], arguments.data(), arguments.size_bytes());
+        for (size_t index{method}; index < method + arguments.size(); index++)
+            dirtyStateGroups |= RegisterStateGroups[index];
+
+        if (shadowRegisters.mme.shadowRamControl == Registers::MmeShadowRamControl::MethodTrack || shadowRegisters.mme.shadowRamControl == Registers::MmeShadowRamControl::MethodTrackWithFilter)
+            std::memcpy(&shadowRegisters.raw[method], arguments.data(), arguments.size_bytes());
+    }
+
+    void Maxwell3D::CallMethodBatch(u32 method, span<u32> arguments, bool incrementing) {
+        LOG_DEBUG(state.logger, "Called method batch in Maxwell 3D: 0x{:X} args: {} incrementing: {}", method, arguments.size(), incrementing);
+
+        if (method >= RegisterCount && (method & 1) && !incrementing && macroInvocation.index != -1) {
+            // A run of arguments to a pending macro can be appended in one go and the macro executed immediately as this is the last call
+            macroInvocation.arguments.insert(macroInvocation.arguments.end(), arguments.begin(), arguments.end());
+            auto position{macroPositions[macroInvocation.index]};
+            auto macroArguments{std::move(macroInvocation.arguments)};
+            macroInvocation.arguments.clear();
+            macroInvocation.index = -1;
+            ExecuteMacro(position, macroArguments);
+            return;
+        }
+
+        while (!arguments.empty()) {
+            if (method >= RegisterCount || shadowRegisters.mme.shadowRamControl == Registers::MmeShadowRamControl::MethodReplay) [[unlikely]] {
+                // Macro methods and shadow RAM replay depend on each individual call, they are dispatched one at a time
+                for (size_t index{}; index < arguments.size(); index++)
+                    CallMethod(incrementing ? method + static_cast<u32>(index) : method, arguments[index], index == arguments.size() - 1);
+                return;
+            }
+
+            if (!incrementing) {
+                if (RegisterSideEffects[method]) {
+                    for (size_t index{}; index < arguments.size(); index++)
+                        CallMethod(method, arguments[index], index == arguments.size() - 1);
+                } else {
+                    WriteRegisters(method, arguments.last(1)); // Only the final write to a register without side-effects is observable
+                }
+                return;
+            }
+
+            // Write all registers up to the next one with side-effects directly, that one is dispatched individually before continuing
+            auto rangeEnd{RegisterSideEffects.begin() + method + std::min<size_t>(arguments.size(), RegisterCount - method)};
+            auto count{static_cast<u32>(std::distance(RegisterSideEffects.begin() + method, std::find(RegisterSideEffects.begin() + method, rangeEnd, true)))};
+            if (count) {
+                WriteRegisters(method, arguments.first(count));
+            } else {
+                count = 1;
+                CallMethod(method, arguments.front(), arguments.size() == 1);
+            }
+
+            method += count;
+            arguments = arguments.subspan(count);
+        }
+    }
+
     void Maxwell3D::HandleSemaphoreCounterOperation() {
         switch (registers.semaphore.info.counterType) {
             case Registers::SemaphoreInfo::CounterType::Zero:
@@ -5,6 +5,8 @@
 
 #include "engine.h"
 #include "maxwell/macro_interpreter.h"
+#include "maxwell/macro_jit.h"
+#include "maxwell/macro_hle.h"
 
 #define MAXWELL3D_OFFSET(field) U32_OFFSET(Registers, field)
 
@@ -22,6 +24,21 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         } macroInvocation{}; //!< Data for a macro that is pending execution
 
         MacroInterpreter macroInterpreter;
+        MacroJit macroJit;
+        MacroHle macroHle;
+
+        u16 dirtyStateGroups{}; //!< A bitmask of all StateGroups which have been written to since they were last cleared
+
+        /**
+         * @brief Executes a macro natively if it's a known macro, with the JIT if it can be compiled or otherwise with the interpreter
+         */
+        void ExecuteMacro(size_t offset, span<u32> arguments);
+
+        /**
+         * @brief Writes a contiguous range of registers which have no side-effects, this is equivalent to calling CallMethod for each register
+         * @note The range isn't bounds-checked, it must be within the register file which CallMethodBatch ensures by clamping every run to it
+         */
+        void WriteRegisters(u32 method, span<u32> arguments);
 
         void HandleSemaphoreCounterOperation();
 
@@ -30,6 +47,21 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
       public:
         static constexpr u32 RegisterCount{0xE00}; //!< The number of Maxwell 3D registers
 
+        /**
+         * @brief Groups of registers which make up a distinct piece of pipeline state, a write to any register in a group marks the entire group as dirty
+         * @note The registers which belong to each group are defined by StateGroupRanges in maxwell_3d.cpp
+         */
+        enum class StateGroup : u8 {
+            Viewport,
+            Rasterizer,
+            DepthStencil,
+            Blend,
+            VertexAttributes,
+            Multisample,
+            TexturePools,
+        };
+        static constexpr size_t StateGroupCount{7};
+
         /**
          * @url https://github.com/devkitPro/deko3d/blob/master/source/maxwell/engine_3d.def#L478
          */
@@ -373,6 +405,26 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 UpperLeft = 1,
             };
 
+            /**
+             * @brief The bindings of a single shader stage, writing to 'constantBuffer' binds the buffer described by 'constantBufferSelector'
+             */
+            struct BindGroup {
+                u32 _pad0_[0x4]; // 0x0
+
+                union {
+                    u32 raw;
+                    struct {
+                        bool valid : 1;
+                        u8 _pad1_ : 3;
+                        u8 index : 5;
+                        u32 _pad2_ : 23;
+                    };
+                } constantBuffer; // 0x4
+
+                u32 _pad3_[0x3]; // 0x5
+            };
+            static_assert(sizeof(BindGroup) == (0x8 * sizeof(u32)));
+
             struct {
                 u32 _pad0_[0x40]; // 0x0
                 u32 noOperation; // 0x40
@@ -549,6 +601,16 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 std::array<Blend, 8> independentBlend; // 0x780 For each render target
                 u32 _pad25_[0x100]; // 0x7C0
                 u32 firmwareCall[0x20]; // 0x8C0
+
+                struct {
+                    u32 size; // 0x8E0
+                    Address address; // 0x8E1
+                    u32 offset; // 0x8E3
+                    std::array<u32, 0x10> data; // 0x8E4
+                } constantBufferSelector;
+
+                u32 _pad26_[0xC]; // 0x8F4
+                std::array<BindGroup, 5> bindGroups; // 0x900 For each shader stage
             };
         };
         static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
@@ -567,5 +629,36 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         void ResetRegs();
 
         void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        /**
+         * @brief Calls a sequence of methods, runs of registers without side-effects are written directly rather than being dispatched individually
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool incrementing);
+
+        /**
+         * @return If any register in the supplied state group has been written to since the group was last cleared
+         */
+        bool IsDirty(StateGroup group) const {
+            return dirtyStateGroups & (1U << static_cast<u8>(group));
+        }
+
+        /**
+         * @brief Clears the dirty flag of a state group, this should be done by the consumer after it has validated the state
+         */
+        void ClearDirty(StateGroup group) {
+            dirtyStateGroups &= ~(1U << static_cast<u8>(group));
+        }
+
+        /**
+         * @return A hash of the values of all registers in the supplied state group
+         */
+        u64 HashState(StateGroup group) const;
+
+        /**
+         * @brief Clears the dirty flag of a state group and checks if its contents actually changed, groups are often rewritten with identical values so this allows skipping redundant re-validation
+         * @param hash The hash of the group from the last time it was validated, this is updated to the current hash if the group was dirty
+         * @return If the group needs to be re-validated
+         */
+        bool ConsumeDirty(StateGroup group, u64 &hash);
     };
 }
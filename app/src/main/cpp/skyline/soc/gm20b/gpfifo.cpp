@@ -2,89 +2,41 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <common/signal.h>
+#include <common/trace.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
+#include <kernel/host_affinity.h>
 #include <soc.h>
 #include <os.h>
 
 namespace skyline::soc::gm20b {
-    /**
-     * @brief A single pushbuffer method header that describes a compressed method sequence
-     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/manuals/volta/gv100/dev_ram.ref.txt#L850
-     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/classes/host/clb06f.h#L179
-     */
-    union PushBufferMethodHeader {
-        u32 raw;
-
-        enum class TertOp : u8 {
-            Grp0IncMethod = 0,
-            Grp0SetSubDevMask = 1,
-            Grp0StoreSubDevMask = 2,
-            Grp0UseSubDevMask = 3,
-            Grp2NonIncMethod = 0,
-        };
-
-        enum class SecOp : u8 {
-            Grp0UseTert = 0,
-            IncMethod = 1,
-            Grp2UseTert = 2,
-            NonIncMethod = 3,
-            ImmdDataMethod = 4,
-            OneInc = 5,
-            Reserved6 = 6,
-            EndPbSegment = 7,
-        };
-
-        u16 methodAddress : 12;
-        struct {
-            u8 _pad0_ : 4;
-            u16 subDeviceMask : 12;
-        };
-
-        struct {
-            u16 _pad1_ : 13;
-            u8 methodSubChannel : 3;
-            union {
-                TertOp tertOp : 3;
-                u16 methodCount : 13;
-                u16 immdData : 13;
-            };
-        };
-
-        struct {
-            u32 _pad2_ : 29;
-            SecOp secOp : 3;
-        };
-    };
-    static_assert(sizeof(PushBufferMethodHeader) == sizeof(u32));
+    constexpr u32 ThreeDSubChannel{0};
+    constexpr u32 ComputeSubChannel{1};
+    constexpr u32 Inline2MemorySubChannel{2};
+    constexpr u32 TwoDSubChannel{3};
+    constexpr u32 CopySubChannel{4}; // HW forces a memory flush on a switch from this subchannel to others
 
     void GPFIFO::Send(u32 method, u32 argument, u32 subChannel, bool lastCall) {
-        constexpr u32 ThreeDSubChannel{0};
-        constexpr u32 ComputeSubChannel{1};
-        constexpr u32 Inline2MemorySubChannel{2};
-        constexpr u32 TwoDSubChannel{3};
-        constexpr u32 CopySubChannel{4}; // HW forces a memory flush on a switch from this subchannel to others
-
-        state.logger->Debug("Called GPU method - method: 0x{:X} argument: 0x{:X} subchannel: 0x{:X} last: {}", method, argument, subChannel, lastCall);
+        LOG_DEBUG(state.logger, "Called GPU method - method: 0x{:X} argument: 0x{:X} subchannel: 0x{:X} last: {}", method, argument, subChannel, lastCall);
 
         if (method < engine::GPFIFO::RegisterCount) {
             gpfifoEngine.CallMethod(method, argument, lastCall);
         } else {
             switch (subChannel) {
                 case ThreeDSubChannel:
-                    state.soc->gm20b.maxwell3D.CallMethod(method, argument, lastCall);
+                    channelCtx.maxwell3D.CallMethod(method, argument, lastCall);
                     break;
                 case ComputeSubChannel:
-                    state.soc->gm20b.maxwellCompute.CallMethod(method, argument, lastCall);
+                    channelCtx.maxwellCompute.CallMethod(method, argument, lastCall);
                     break;
                 case Inline2MemorySubChannel:
-                    state.soc->gm20b.keplerMemory.CallMethod(method, argument, lastCall);
+                    channelCtx.keplerMemory.CallMethod(method, argument, lastCall);
                     break;
                 case TwoDSubChannel:
-                    state.soc->gm20b.fermi2D.CallMethod(method, argument, lastCall);
+                    channelCtx.fermi2D.CallMethod(method, argument, lastCall);
                     break;
                 case CopySubChannel:
-                    state.soc->gm20b.maxwellDma.CallMethod(method, argument, lastCall);
+                    channelCtx.maxwellDma.CallMethod(method, argument, lastCall);
                     break;
                 default:
                     throw exception("Tried to call into a software subchannel: {}!", subChannel);
@@ -92,6 +44,43 @@ namespace skyline::soc::gm20b {
         }
     }
 
+    void GPFIFO::SendBatch(u32 method, span<u32> arguments, u32 subChannel, bool incrementing) {
+        if (arguments.empty())
+            return;
+
+        if (method < engine::GPFIFO::RegisterCount) [[unlikely]] {
+            if (!incrementing || method + arguments.size() <= engine::GPFIFO::RegisterCount) {
+                gpfifoEngine.CallMethodBatch(method, arguments, incrementing);
+                return;
+            }
+
+            // A batch may span both GPFIFO and engine methods, these are rare enough that they're just sent individually
+            for (size_t index{}; index < arguments.size(); index++)
+                Send(incrementing ? method + static_cast<u32>(index) : method, arguments[index], subChannel, index == arguments.size() - 1);
+            return;
+        }
+
+        switch (subChannel) {
+            case ThreeDSubChannel:
+                channelCtx.maxwell3D.CallMethodBatch(method, arguments, incrementing);
+                break;
+            case ComputeSubChannel:
+                channelCtx.maxwellCompute.CallMethodBatch(method, arguments, incrementing);
+                break;
+            case Inline2MemorySubChannel:
+                channelCtx.keplerMemory.CallMethodBatch(method, arguments, incrementing);
+                break;
+            case TwoDSubChannel:
+                channelCtx.fermi2D.CallMethodBatch(method, arguments, incrementing);
+                break;
+            case CopySubChannel:
+                channelCtx.maxwellDma.CallMethodBatch(method, arguments, incrementing);
+                break;
+            default:
+                throw exception("Tried to call into a software subchannel: {}!", subChannel);
+        }
+    }
+
     void GPFIFO::Process(GpEntry gpEntry) {
         if (!gpEntry.size) {
             // This is a GPFIFO control entry, all control entries have a zero length and contain no pushbuffers
@@ -104,41 +93,43 @@ namespace skyline::soc::gm20b {
             }
         }
 
-        pushBufferData.resize(gpEntry.size);
-        state.soc->gm20b.gmmu.Read<u32>(pushBufferData, gpEntry.Address());
-
-        for (auto entry{pushBufferData.begin()}; entry != pushBufferData.end(); entry++) {
-            // An entry containing all zeroes is a NOP, skip over it
-            if (*entry == 0)
-                continue;
-
-            PushBufferMethodHeader methodHeader{.raw = *entry};
-            switch (methodHeader.secOp) {
-                case PushBufferMethodHeader::SecOp::IncMethod:
-                    for (u32 i{}; i < methodHeader.methodCount; i++)
-                        Send(methodHeader.methodAddress + i, *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
-                    break;
-
-                case PushBufferMethodHeader::SecOp::NonIncMethod:
-                    for (u32 i{}; i < methodHeader.methodCount; i++)
-                        Send(methodHeader.methodAddress, *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
-                    break;
-
-                case PushBufferMethodHeader::SecOp::OneInc:
-                    for (u32 i{}; i < methodHeader.methodCount; i++)
-                        Send(methodHeader.methodAddress + !!i, *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
-                    break;
-
-                case PushBufferMethodHeader::SecOp::ImmdDataMethod:
-                    Send(methodHeader.methodAddress, methodHeader.immdData, methodHeader.methodSubChannel, true);
-                    break;
+        // Pushbuffers are parsed in-place from guest memory when they're contiguous, they only need to be copied out if they span multiple mappings
+        span<u32> pushBuffer{state.soc->gm20b.gmmu.TranslateContiguous(gpEntry.Address(), gpEntry.size * sizeof(u32)).cast<u32>()};
+        bool contiguous{!pushBuffer.empty()};
+        if (!contiguous) [[unlikely]] {
+            pushBufferData.resize(gpEntry.size);
+            state.soc->gm20b.gmmu.Read<u32>(pushBufferData, gpEntry.Address());
+            pushBuffer = pushBufferData;
+
+            copiedPushBuffers++;
+            copiedPushBufferBytes += pushBuffer.size_bytes();
+            state.soc->gm20b.pushBufferCounters.copied.fetch_add(1, std::memory_order_relaxed);
+            state.soc->gm20b.pushBufferCounters.copiedBytes.fetch_add(pushBuffer.size_bytes(), std::memory_order_relaxed);
+        } else {
+            directPushBuffers++;
+            state.soc->gm20b.pushBufferCounters.direct.fetch_add(1, std::memory_order_relaxed);
+        }
+        TRACE_EVENT("gpu", "GPFIFO::Process", "Size", pushBuffer.size_bytes(), "Contiguous", contiguous);
 
-                case PushBufferMethodHeader::SecOp::EndPbSegment:
-                    return;
+        DecodePushBuffer(pushBuffer, [this](u32 method, u32 argument, u32 subChannel, bool lastCall) {
+            Send(method, argument, subChannel, lastCall);
+        }, [this](u32 method, span<u32> arguments, u32 subChannel, bool incrementing) {
+            SendBatch(method, arguments, subChannel, incrementing);
+        });
+    }
 
-                default:
-                    throw exception("Unsupported pushbuffer method SecOp: {}", static_cast<u8>(methodHeader.secOp));
-            }
+    void GPFIFO::Process(SyncpointAction action) {
+        auto &syncpoint{state.soc->host1x.syncpoints.at(action.id)};
+        switch (action.type) {
+            case SyncpointAction::Type::Wait:
+                TRACE_EVENT("gpu", "GPFIFO::SyncpointWait", "Id", action.id, "Threshold", action.value);
+                syncpoint.Wait(action.value, std::chrono::steady_clock::duration::max());
+                break;
+
+            case SyncpointAction::Type::Increment:
+                for (u32 increment{}; increment < action.value; increment++)
+                    syncpoint.Increment();
+                break;
         }
     }
 
@@ -151,11 +142,17 @@ namespace skyline::soc::gm20b {
 
     void GPFIFO::Run() {
         pthread_setname_np(pthread_self(), "GPFIFO");
+        if (!state.soc->gm20b.gpfifoCpuClaimed.test_and_set())
+            state.hostAffinity->PinHostThread(kernel::HostAffinity::HostThread::Gpfifo); // Only the first channel is pinned as the GPFIFO CPU set may be a single dedicated CPU which would serialize all channels
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
-            pushBuffers->Process([this](GpEntry gpEntry) {
-                state.logger->Debug("Processing pushbuffer: 0x{:X}", gpEntry.Address());
-                Process(gpEntry);
+            pushBuffers->Process([this](const QueueEntry &entry) {
+                if (auto gpEntry{std::get_if<GpEntry>(&entry)}) [[likely]] {
+                    LOG_DEBUG(state.logger, "Processing pushbuffer: 0x{:X}", gpEntry->Address());
+                    Process(*gpEntry);
+                } else {
+                    Process(std::get<SyncpointAction>(entry));
+                }
             });
         } catch (const signal::SignalException &e) {
             if (e.signal != SIGINT) {
@@ -171,7 +168,11 @@ namespace skyline::soc::gm20b {
     }
 
     void GPFIFO::Push(span<GpEntry> entries) {
-        pushBuffers->Append(entries);
+        pushBuffers->AppendTransform(entries, [](GpEntry entry) { return QueueEntry{entry}; });
+    }
+
+    void GPFIFO::Push(SyncpointAction action) {
+        pushBuffers->Push(action);
     }
 
     GPFIFO::~GPFIFO() {
@@ -179,5 +180,13 @@ namespace skyline::soc::gm20b {
             pthread_kill(thread.native_handle(), SIGINT);
             thread.join();
         }
+
+        if (directPushBuffers || copiedPushBuffers)
+            state.logger->Info("Pushbuffers: {} parsed in-place, {} copied ({} bytes)", directPushBuffers, copiedPushBuffers, copiedPushBufferBytes);
+
+        if (pushBuffers) {
+            auto stats{pushBuffers->GetStatistics()};
+            state.logger->Info("GPFIFO queue: {} entries, maximum depth {}, {} producer stalls ({} ns)", stats.produced, stats.maxDepth, stats.stalls, stats.stallTime);
+        }
     }
 }
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <common/circular_queue.h>
+#include <common/mpsc_ring.h>
 #include "engines/gpfifo.h"
 
 namespace skyline::soc::gm20b {
@@ -72,31 +72,165 @@ namespace skyline::soc::gm20b {
     };
     static_assert(sizeof(GpEntry) == sizeof(u64));
 
+    /**
+     * @brief A host1x syncpoint operation which is performed by a channel in-order with its GP entries, these are used for ordering work across channels
+     */
+    struct SyncpointAction {
+        enum class Type : u8 {
+            Wait, //!< Waits for the syncpoint to reach 'value' before processing any subsequent entries
+            Increment, //!< Increments the syncpoint 'value' times after all prior entries have been processed
+        } type;
+        u32 id; //!< The ID of the syncpoint
+        u32 value;
+    };
+
+    /**
+     * @brief A single pushbuffer method header that describes a compressed method sequence
+     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/manuals/volta/gv100/dev_ram.ref.txt#L850
+     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/classes/host/clb06f.h#L179
+     */
+    union PushBufferMethodHeader {
+        u32 raw;
+
+        enum class TertOp : u8 {
+            Grp0IncMethod = 0,
+            Grp0SetSubDevMask = 1,
+            Grp0StoreSubDevMask = 2,
+            Grp0UseSubDevMask = 3,
+            Grp2NonIncMethod = 0,
+        };
+
+        enum class SecOp : u8 {
+            Grp0UseTert = 0,
+            IncMethod = 1,
+            Grp2UseTert = 2,
+            NonIncMethod = 3,
+            ImmdDataMethod = 4,
+            OneInc = 5,
+            Reserved6 = 6,
+            EndPbSegment = 7,
+        };
+
+        u16 methodAddress : 12;
+        struct {
+            u8 _pad0_ : 4;
+            u16 subDeviceMask : 12;
+        };
+
+        struct {
+            u16 _pad1_ : 13;
+            u8 methodSubChannel : 3;
+            union {
+                TertOp tertOp : 3;
+                u16 methodCount : 13;
+                u16 immdData : 13;
+            };
+        };
+
+        struct {
+            u32 _pad2_ : 29;
+            SecOp secOp : 3;
+        };
+    };
+    static_assert(sizeof(PushBufferMethodHeader) == sizeof(u32));
+
+    /**
+     * @brief Decodes the method headers of a pushbuffer and dispatches their arguments, this is separate from GPFIFO so the parsing can be tested and benchmarked without a channel
+     * @param send A callable with the signature (u32 method, u32 argument, u32 subChannel, bool lastCall) for single method calls
+     * @param sendBatch A callable with the signature (u32 method, span<u32> arguments, u32 subChannel, bool incrementing) for runs of method calls
+     */
+    template<typename SendFunction, typename SendBatchFunction>
+    void DecodePushBuffer(span<u32> pushBuffer, SendFunction &&send, SendBatchFunction &&sendBatch) {
+        for (auto entry{pushBuffer.begin()}; entry != pushBuffer.end(); entry++) {
+            // An entry containing all zeroes is a NOP, skip over it
+            if (*entry == 0)
+                continue;
+
+            PushBufferMethodHeader methodHeader{.raw = *entry};
+            auto methodArguments{[&]() -> span<u32> {
+                if (methodHeader.methodCount > std::distance(entry, pushBuffer.end()) - 1)
+                    throw exception("Pushbuffer method with {} arguments exceeds the bounds of the pushbuffer", static_cast<u16>(methodHeader.methodCount));
+                span<u32> arguments(&*std::next(entry), methodHeader.methodCount);
+                entry += methodHeader.methodCount;
+                return arguments;
+            }};
+
+            switch (methodHeader.secOp) {
+                case PushBufferMethodHeader::SecOp::IncMethod:
+                    sendBatch(methodHeader.methodAddress, methodArguments(), methodHeader.methodSubChannel, true);
+                    break;
+
+                case PushBufferMethodHeader::SecOp::NonIncMethod:
+                    sendBatch(methodHeader.methodAddress, methodArguments(), methodHeader.methodSubChannel, false);
+                    break;
+
+                case PushBufferMethodHeader::SecOp::OneInc: {
+                    auto arguments{methodArguments()};
+                    if (arguments.empty())
+                        break;
+                    send(methodHeader.methodAddress, arguments.front(), methodHeader.methodSubChannel, arguments.size() == 1);
+                    if (arguments.size() > 1)
+                        sendBatch(methodHeader.methodAddress + 1, arguments.subspan(1), methodHeader.methodSubChannel, false);
+                    break;
+                }
+
+                case PushBufferMethodHeader::SecOp::ImmdDataMethod:
+                    send(methodHeader.methodAddress, methodHeader.immdData, methodHeader.methodSubChannel, true);
+                    break;
+
+                case PushBufferMethodHeader::SecOp::EndPbSegment:
+                    return;
+
+                default:
+                    throw exception("Unsupported pushbuffer method SecOp: {}", static_cast<u8>(methodHeader.secOp));
+            }
+        }
+    }
+
+    struct ChannelContext;
+
     /**
      * @brief The GPFIFO class handles creating pushbuffers from GP entries and then processing them
      * @note This class doesn't perfectly map to any particular hardware component on the X1, it does a mix of the GPU Host PBDMA (With  and handling the GPFIFO entries
      * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/manuals/volta/gv100/dev_pbdma.ref.txt#L62
      */
     class GPFIFO {
+        using QueueEntry = std::variant<GpEntry, SyncpointAction>;
+
         const DeviceState &state;
+        ChannelContext &channelCtx; //!< The channel which this GPFIFO belongs to, its engines are the targets of all methods
         engine::GPFIFO gpfifoEngine; //!< The engine for processing GPFIFO method calls
         std::array<engine::Engine*, 8> subchannels;
-        std::optional<CircularQueue<GpEntry>> pushBuffers;
+        std::optional<MpscRing<QueueEntry>> pushBuffers;
         std::thread thread; //!< The thread that manages processing of pushbuffers
-        std::vector<u32> pushBufferData; //!< Persistent vector storing pushbuffer data to avoid constant reallocations
+        std::vector<u32> pushBufferData; //!< Persistent vector storing pushbuffer data which isn't contiguous in guest memory to avoid constant reallocations
+        u64 directPushBuffers{}; //!< The amount of pushbuffers which were parsed in-place from guest memory
+        u64 copiedPushBuffers{}; //!< The amount of pushbuffers which had to be copied out of guest memory
+        u64 copiedPushBufferBytes{}; //!< The total size of all pushbuffers which were copied out of guest memory
 
         /**
          * @brief Sends a method call to the GPU hardware
          */
         void Send(u32 method, u32 argument, u32 subchannel, bool lastCall);
 
+        /**
+         * @brief Sends a sequence of method calls to a single subchannel of the GPU hardware, this avoids dispatching each method individually
+         * @param incrementing If the method is incremented after each argument, otherwise all arguments are sent to the same method
+         */
+        void SendBatch(u32 method, span<u32> arguments, u32 subchannel, bool incrementing);
+
         /**
          * @brief Processes the pushbuffer contained within the given GpEntry, calling methods as needed
          */
         void Process(GpEntry gpEntry);
 
+        /**
+         * @brief Performs a syncpoint action, this blocks the channel's thread for waits
+         */
+        void Process(SyncpointAction action);
+
       public:
-        GPFIFO(const DeviceState &state) : state(state), gpfifoEngine(state) {}
+        GPFIFO(const DeviceState &state, ChannelContext &channelCtx) : state(state), channelCtx(channelCtx), gpfifoEngine(state) {}
 
         ~GPFIFO();
 
@@ -114,5 +248,10 @@ namespace skyline::soc::gm20b {
          * @brief Pushes a list of entries to the FIFO, these commands will be executed on calls to 'Step'
          */
         void Push(span<GpEntry> entries);
+
+        /**
+         * @brief Pushes a syncpoint action to the FIFO, it's performed after all previously pushed entries have been processed
+         */
+        void Push(SyncpointAction action);
     };
 }
@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <sys/mman.h>
+#include <common/address_space.inc>
+#include <test.h>
+
+namespace skyline {
+    template class FlatAddressSpaceMap<u32, 0, bool, false, false, 32>;
+    template class FlatAllocator<u32, 0, 32>;
+
+    template class FlatAddressSpaceMap<u64, 0, u8 *, nullptr, true, 40, MemoryManagerBlockInfo>;
+    template class FlatMemoryManager<u64, 0, 40>;
+}
+
+namespace skyline::test {
+    using Allocator = FlatAllocator<u32, 0, 32>;
+    using MemoryManager = FlatMemoryManager<u64, 0, 40>; //!< The same configuration as the GMMU
+
+    constexpr u64 PageSize{0x1000}; //!< The size of a page in the page table of FlatMemoryManager
+    constexpr u64 LeafSize{PageSize << 14}; //!< The size of the region covered by a single leaf of the page table
+
+    void ZeroSizeAllocations() {
+        Allocator allocator{1, 0x1000};
+        EXPECT_THROW(allocator.Allocate(0));
+
+        // A zero-size fixed allocation mustn't split the free region it's inside, otherwise an allocation spanning the split would fail
+        allocator.AllocateFixed(0x800, 0);
+        EXPECT(allocator.Allocate(0xFFF) == 1);
+    }
+
+    void LinearAllocationScansForward() {
+        Allocator allocator{1, 0x1000};
+        EXPECT(allocator.Allocate(0x20) == 0x1);
+        EXPECT(allocator.Allocate(0x10) == 0x21);
+        allocator.Free(0x1, 0x20);
+        allocator.AllocateFixed(0x31, 0x10);
+        allocator.AllocateFixed(0x50, 0x10);
+
+        // The free region directly after the last linear allocation is too small, the next one after it should be used rather than the best fit behind it
+        EXPECT(allocator.Allocate(0x20) == 0x60);
+        EXPECT(allocator.Allocate(0x10) == 0x80);
+    }
+
+    void FreeRegionsMerge() {
+        Allocator allocator{1, 0x1000};
+        auto first{allocator.Allocate(0x100)}, second{allocator.Allocate(0x100)}, third{allocator.Allocate(0x100)};
+        allocator.Free(second, 0x100);
+        allocator.Free(first, 0x100);
+        allocator.Free(third, 0x100);
+
+        // All free regions should have been merged back into a single region covering the entire AS
+        EXPECT(allocator.Allocate(0xFFF) == 1);
+        EXPECT_THROW(allocator.Allocate(1));
+    }
+
+    /**
+     * @brief Repeatedly allocates and frees regions of random sizes to fragment the AS, the latency of every allocation is reported as percentiles
+     */
+    void FragmentationStress() {
+        constexpr u32 VaStart{1}, VaLimit{1U << 24};
+        constexpr size_t Iterations{200000}, MaxLiveAllocations{4096};
+        Allocator allocator{VaStart, VaLimit};
+
+        std::mt19937 random{0x5EED};
+        std::map<u32, u32> allocations; //!< A map from the start to the end of every live allocation
+        std::vector<u64> latencies;
+        latencies.reserve(Iterations);
+
+        auto checkedInsert{[&](u32 start, u32 size) {
+            EXPECT(start >= VaStart && start + size <= VaLimit);
+            auto successor{allocations.lower_bound(start)};
+            EXPECT(successor == allocations.end() || successor->first >= start + size);
+            EXPECT(successor == allocations.begin() || std::prev(successor)->second <= start);
+            allocations.emplace(start, start + size);
+        }};
+
+        auto freeRandom{[&]() {
+            auto allocation{std::next(allocations.begin(), static_cast<std::ptrdiff_t>(random() % allocations.size()))};
+            allocator.Free(allocation->first, allocation->second - allocation->first);
+            allocations.erase(allocation);
+        }};
+
+        for (size_t iteration{}; iteration < Iterations; iteration++) {
+            if (allocations.size() >= MaxLiveAllocations || (!allocations.empty() && random() % 2)) {
+                freeRandom();
+                continue;
+            }
+
+            // Sizes are skewed towards small allocations with occasional large ones, similar to the mix of buffers mapped by titles
+            u32 size{static_cast<u32>(random() % 8 ? (random() % 0x40) + 1 : (random() % 0x4000) + 1)};
+            if (random() % 16 == 0) {
+                u32 virt{VaStart + static_cast<u32>(random() % (VaLimit - VaStart - size))};
+                auto successor{allocations.lower_bound(virt)};
+                if ((successor == allocations.end() || successor->first >= virt + size) && (successor == allocations.begin() || std::prev(successor)->second <= virt)) {
+                    allocator.AllocateFixed(virt, size);
+                    checkedInsert(virt, size);
+                }
+                continue;
+            }
+
+            try {
+                auto start{util::GetTimeNs()};
+                auto virt{allocator.Allocate(size)};
+                latencies.push_back(util::GetTimeNs() - start);
+                checkedInsert(virt, size);
+            } catch (const exception &) {
+                freeRandom(); // The AS is too fragmented to fit the allocation, this is expected with a bounded AS
+            }
+        }
+
+        fmt::print("FlatAllocator::Allocate latency over {} allocations: p50 {}ns, p99 {}ns, p99.9 {}ns, max {}ns\n", latencies.size(), Percentile(latencies, 50), Percentile(latencies, 99), Percentile(latencies, 99.9), Percentile(latencies, 100));
+
+        while (!allocations.empty())
+            freeRandom();
+        EXPECT(allocator.Allocate(VaLimit - VaStart) == VaStart);
+    }
+
+    /**
+     * @brief A reservation of host address space which is never accessed, it provides valid pointers for mappings that are only translated
+     */
+    class HostReservation {
+      private:
+        u8 *base;
+        size_t size;
+
+      public:
+        HostReservation(size_t size) : size(size) {
+            base = static_cast<u8 *>(mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+            if (base == MAP_FAILED)
+                throw exception("Failed to reserve 0x{:X} bytes of host address space", size);
+        }
+
+        ~HostReservation() {
+            munmap(base, size);
+        }
+
+        u8 *data() const {
+            return base;
+        }
+    };
+
+    /**
+     * @return All host ranges that ForEachRange calls back with for the supplied region
+     */
+    std::vector<span<u8>> CollectRanges(MemoryManager &manager, u64 virt, u64 size) {
+        std::vector<span<u8>> ranges;
+        manager.ForEachRange(virt, size, [&](span<u8> range) {
+            ranges.push_back(range);
+        });
+        return ranges;
+    }
+
+    bool IsSpan(span<u8> range, u8 *data, size_t size) {
+        return range.data() == data && range.size() == size;
+    }
+
+    /**
+     * @brief Maps and unmaps regions covering entire leaves of the page table, these are only represented by the linear base of the leaf
+     */
+    void WholeLeafMapUnmap() {
+        HostReservation host{3 * LeafSize};
+        MemoryManager manager;
+        manager.Map(LeafSize, host.data(), 2 * LeafSize);
+
+        EXPECT(IsSpan(manager.TranslateContiguous(LeafSize, 2 * LeafSize), host.data(), 2 * LeafSize));
+        EXPECT(IsSpan(manager.TranslateContiguous((2 * LeafSize) - 0x10, 0x20), host.data() + LeafSize - 0x10, 0x20)); // Across the boundary between both leaves
+        EXPECT(manager.TranslateContiguous(LeafSize - 0x10, 0x20).empty()); // The region prior to the mapping is unmapped
+
+        manager.Unmap(LeafSize, LeafSize);
+        auto ranges{CollectRanges(manager, LeafSize, 2 * LeafSize)};
+        EXPECT(ranges.size() == 2 && !ranges[0].data() && ranges[0].size() == LeafSize && IsSpan(ranges[1], host.data() + LeafSize, LeafSize));
+
+        // Remapping the leaf to a different host address must replace its linear base rather than retain the prior one
+        manager.Map(LeafSize, host.data() + (2 * LeafSize), LeafSize);
+        EXPECT(IsSpan(manager.TranslateContiguous(LeafSize + 0x1234, 0x10), host.data() + (2 * LeafSize) + 0x1234, 0x10));
+        EXPECT(manager.TranslateContiguous(LeafSize, 2 * LeafSize).empty());
+
+        manager.Unmap(LeafSize, 2 * LeafSize);
+        ranges = CollectRanges(manager, 0, 4 * LeafSize);
+        EXPECT(ranges.size() == 1 && !ranges[0].data());
+    }
+
+    /**
+     * @brief An update of part of a leaf that's represented by its linear base must split it into page entries without affecting the rest of the leaf
+     */
+    void PartialUpdateSplitsLinearBase() {
+        HostReservation host{2 * LeafSize};
+        MemoryManager manager;
+        u8 *other{host.data() + LeafSize};
+        constexpr u64 Base{LeafSize}; // VA 0 is the unmapped VA of the GMMU configuration and can't be mapped
+        manager.Map(Base, host.data(), LeafSize);
+
+        constexpr u64 HoleOffset{0x123000}, HoleSize{2 * PageSize};
+        manager.Unmap(Base + HoleOffset, HoleSize);
+        auto ranges{CollectRanges(manager, Base, LeafSize)};
+        EXPECT(ranges.size() == 3);
+        EXPECT(IsSpan(ranges[0], host.data(), HoleOffset));
+        EXPECT(!ranges[1].data() && ranges[1].size() == HoleSize);
+        EXPECT(IsSpan(ranges[2], host.data() + HoleOffset + HoleSize, LeafSize - HoleOffset - HoleSize));
+
+        // The first and last pages of the leaf must still translate from their page entries
+        EXPECT(IsSpan(manager.TranslateContiguous(Base, PageSize), host.data(), PageSize));
+        EXPECT(IsSpan(manager.TranslateContiguous(Base + LeafSize - PageSize, PageSize), host.data() + LeafSize - PageSize, PageSize));
+
+        manager.Map(Base + HoleOffset, other, HoleSize);
+        EXPECT(IsSpan(manager.TranslateContiguous(Base + HoleOffset, HoleSize), other, HoleSize));
+        EXPECT(manager.TranslateContiguous(Base + HoleOffset - 0x10, 0x20).empty());
+        ranges = CollectRanges(manager, Base + HoleOffset - PageSize, HoleSize + (2 * PageSize));
+        EXPECT(ranges.size() == 3 && IsSpan(ranges[0], host.data() + HoleOffset - PageSize, PageSize) && IsSpan(ranges[1], other, HoleSize) && IsSpan(ranges[2], host.data() + HoleOffset + HoleSize, PageSize));
+
+        // Mapping the entire leaf again must return it to a single contiguous range
+        manager.Map(Base, host.data(), LeafSize);
+        EXPECT(IsSpan(manager.TranslateContiguous(Base, LeafSize), host.data(), LeafSize));
+    }
+
+    /**
+     * @brief Mappings which don't start or end on a page boundary only have their fully covered pages in the page table, the edges must still translate through the block list
+     */
+    void UnalignedEdges() {
+        std::vector<u8> first(0x4000), second(0x4000);
+        std::iota(first.begin(), first.end(), 0);
+        std::iota(second.begin(), second.end(), 0x80);
+        MemoryManager manager;
+
+        constexpr u64 FirstVirt{0x10800}, FirstSize{0x2000}, SecondVirt{FirstVirt + FirstSize}, SecondSize{0x1000};
+        manager.Map(FirstVirt, first.data() + 0x100, FirstSize);
+        manager.Map(SecondVirt, second.data(), SecondSize); // This shares the page at 0x12000 with the first mapping
+
+        EXPECT(IsSpan(manager.TranslateContiguous(FirstVirt, FirstSize), first.data() + 0x100, FirstSize));
+        EXPECT(IsSpan(manager.TranslateContiguous(SecondVirt, SecondSize), second.data(), SecondSize));
+        EXPECT(manager.TranslateContiguous(SecondVirt - 0x10, 0x20).empty());
+
+        auto ranges{CollectRanges(manager, 0x10000, 0x4000)};
+        EXPECT(ranges.size() == 4);
+        EXPECT(!ranges[0].data() && ranges[0].size() == 0x800);
+        EXPECT(IsSpan(ranges[1], first.data() + 0x100, FirstSize));
+        EXPECT(IsSpan(ranges[2], second.data(), SecondSize));
+        EXPECT(!ranges[3].data() && ranges[3].size() == 0x800);
+
+        std::vector<u8> buffer(FirstSize + SecondSize);
+        manager.Read(buffer.data(), FirstVirt, buffer.size());
+        EXPECT(std::equal(buffer.begin(), buffer.begin() + FirstSize, first.begin() + 0x100));
+        EXPECT(std::equal(buffer.begin() + FirstSize, buffer.end(), second.begin()));
+        EXPECT_THROW(manager.Read(buffer.data(), FirstVirt - 1, 2));
+        EXPECT_THROW(manager.Read(buffer.data(), SecondVirt + SecondSize - 1, 2));
+
+        // Unmapping a page-unaligned region removes the entire page containing it from the page table, the rest of the page must still be translated
+        manager.Unmap(FirstVirt + 0x1800, 0x10);
+        EXPECT(IsSpan(manager.TranslateContiguous(FirstVirt + 0x1000, 0x800), first.data() + 0x1100, 0x800));
+        EXPECT(IsSpan(manager.TranslateContiguous(FirstVirt + 0x1810, 0x10), first.data() + 0x1910, 0x10));
+        EXPECT_THROW(manager.Read(buffer.data(), FirstVirt + 0x17F8, 0x10));
+    }
+
+    /**
+     * @brief Sparse mappings read as zeroes and ignore writes, they're never in the page table and can be partially replaced by regular mappings
+     */
+    void SparseMappings() {
+        std::vector<u8> backing(PageSize, 0xAB);
+        MemoryManager manager;
+        manager.Map(0x100000, MemoryManager::SparsePlaceholderAddress(), 0x10000, {true});
+
+        std::vector<u8> buffer(0x10000, 0xFF);
+        manager.Read(buffer.data(), 0x100000, buffer.size());
+        EXPECT(std::all_of(buffer.begin(), buffer.end(), [](u8 value) { return value == 0; }));
+        EXPECT(manager.TranslateContiguous(0x100000, 0x10).empty());
+
+        std::fill(buffer.begin(), buffer.end(), 0xFF);
+        manager.Write(0x100000, buffer.data(), buffer.size());
+        EXPECT(manager.Read<u64>(0x108000) == 0);
+
+        manager.Map(0x104000, backing.data(), PageSize);
+        EXPECT(IsSpan(manager.TranslateContiguous(0x104000, PageSize), backing.data(), PageSize));
+        manager.Read(buffer.data(), 0x103000, 3 * PageSize);
+        EXPECT(std::all_of(buffer.begin(), buffer.begin() + PageSize, [](u8 value) { return value == 0; }));
+        EXPECT(std::all_of(buffer.begin() + PageSize, buffer.begin() + (2 * PageSize), [](u8 value) { return value == 0xAB; }));
+        EXPECT(std::all_of(buffer.begin() + (2 * PageSize), buffer.begin() + (3 * PageSize), [](u8 value) { return value == 0; }));
+    }
+
+    /**
+     * @brief Adjacent blocks which are contiguous in host memory must translate to a single span, they aren't if they're mapped to discontiguous host memory
+     */
+    void TranslateContiguousAcrossBlocks() {
+        std::vector<u8> host(0x8000);
+        MemoryManager manager;
+        manager.Map(0x200000, host.data(), 0x3000);
+        manager.Map(0x203000, host.data() + 0x3000, 0x2800);
+        manager.Map(0x205800, host.data() + 0x6000, 0x800); // This skips 0x800 bytes of host memory
+
+        EXPECT(IsSpan(manager.TranslateContiguous(0x200000, 0x5800), host.data(), 0x5800));
+        EXPECT(IsSpan(manager.TranslateContiguous(0x202FFF, 2), host.data() + 0x2FFF, 2));
+        EXPECT(manager.TranslateContiguous(0x200000, 0x6000).empty());
+        EXPECT(manager.TranslateContiguous(0x2057FF, 2).empty());
+        EXPECT(manager.TranslateContiguous(0x205800, 0x900).empty()); // The last 0x100 bytes are unmapped
+    }
+
+    /**
+     * @brief Reads and writes which span several mappings and page-unaligned boundaries must touch the correct host memory of every mapping
+     */
+    void ReadWriteSpanningMappings() {
+        std::array<std::vector<u8>, 3> hosts{std::vector<u8>(0x1800), std::vector<u8>(0x2400), std::vector<u8>(0x1000)};
+        MemoryManager manager;
+        u64 virt{0x300C00};
+        for (auto &host : hosts) {
+            manager.Map(virt, host.data(), host.size());
+            virt += host.size();
+        }
+
+        std::vector<u8> source(virt - 0x300C00);
+        std::mt19937 random{0x5EED};
+        std::generate(source.begin(), source.end(), [&]() { return static_cast<u8>(random()); });
+        manager.Write(0x300C00, source.data(), source.size());
+
+        auto sourceIt{source.begin()};
+        for (const auto &host : hosts) {
+            EXPECT(std::equal(host.begin(), host.end(), sourceIt));
+            sourceIt += static_cast<std::ptrdiff_t>(host.size());
+        }
+
+        std::vector<u8> destination(0x1000);
+        manager.Read(destination.data(), 0x300C00 + 0x1700, destination.size()); // From the end of the first mapping into the second
+        EXPECT(std::equal(destination.begin(), destination.end(), source.begin() + 0x1700));
+        manager.Read(destination.data(), 0x300C00 + 0x3600, destination.size()); // From the end of the second mapping into the third
+        EXPECT(std::equal(destination.begin(), destination.end(), source.begin() + 0x3600));
+
+        EXPECT_THROW(manager.Write(virt - 0x10, source.data(), 0x20));
+        EXPECT_THROW(manager.Read(destination.data(), 0x300C00 - 0x10, 0x20));
+    }
+
+    /**
+     * @brief Applies random mappings and unmappings to the memory manager and a reference model, ForEachRange must match the model after every operation
+     * @note Mappings are made at a granularity smaller than a page and some cover entire leaves, this exercises every path in UpdatePageTable
+     */
+    void RandomMappingsMatchModel() {
+        constexpr u64 Granularity{0x400}, RegionBase{LeafSize}, RegionSize{3 * LeafSize}, UnitCount{RegionSize / Granularity};
+        constexpr size_t Iterations{2000};
+        HostReservation host{2 * RegionSize};
+        MemoryManager manager;
+        std::vector<u8 *> model(UnitCount); //!< The host pointer of every unit of the region or null if it's unmapped
+
+        std::mt19937 random{0x5EED};
+        auto randomRange{[&](u64 maxUnits) {
+            u64 size{(random() % maxUnits) + 1}, start{random() % (UnitCount - size + 1)};
+            return std::pair{start, size};
+        }};
+
+        for (size_t iteration{}; iteration < Iterations; iteration++) {
+            // Most operations are small with occasional ones covering up to two leaves, those may align with the leaves entirely
+            u64 maxUnits{random() % 8 ? (4 * PageSize) / Granularity : (2 * LeafSize) / Granularity};
+            auto [start, size]{randomRange(maxUnits)};
+            if (random() % 4 == 0) {
+                start = util::AlignDown(start, LeafSize / Granularity);
+                size = std::min(util::AlignUp(size, LeafSize / Granularity), UnitCount - start);
+            }
+
+            if (random() % 3) {
+                u8 *phys{host.data() + ((random() % (RegionSize / Granularity)) * Granularity)};
+                manager.Map(RegionBase + (start * Granularity), phys, size * Granularity);
+                for (u64 unit{}; unit < size; unit++)
+                    model[start + unit] = phys + (unit * Granularity);
+            } else {
+                manager.Unmap(RegionBase + (start * Granularity), size * Granularity);
+                std::fill(model.begin() + static_cast<std::ptrdiff_t>(start), model.begin() + static_cast<std::ptrdiff_t>(start + size), nullptr);
+            }
+
+            // The region around the operation is checked fully alongside a random region
+            std::array<std::pair<u64, u64>, 2> checks{std::pair{start > 4 ? start - 4 : 0, std::min(size + 8, UnitCount - (start > 4 ? start - 4 : 0))}, randomRange((8 * PageSize) / Granularity)};
+            for (auto [checkStart, checkSize] : checks) {
+                u64 unit{checkStart};
+                manager.ForEachRange(RegionBase + (checkStart * Granularity), checkSize * Granularity, [&](span<u8> range) {
+                    EXPECT(range.size() % Granularity == 0);
+                    for (u64 offset{}; offset < range.size(); offset += Granularity, unit++)
+                        EXPECT((range.data() ? range.data() + offset : nullptr) == model[unit]);
+                });
+                EXPECT(unit == checkStart + checkSize);
+            }
+        }
+    }
+
+    /**
+     * @brief Measures the throughput of translating small accesses through the page table against translating them through the block list
+     * @note Sparse mappings are never in the page table so accesses to them always walk the block list, the mappings are interleaved so both walk a block list of the same size
+     */
+    void TranslationThroughput() {
+        constexpr size_t MappingCount{4096}, Translations{1 << 20};
+        constexpr u64 MappingSize{0x10000}, MappingStride{2 * MappingSize}; //!< Every mapping is followed by an unmapped gap so that no blocks are merged
+        HostReservation host{MappingCount * MappingSize};
+        MemoryManager manager;
+        for (size_t index{}; index < MappingCount; index++) {
+            u64 virt{(index + 1) * MappingStride}; // VA 0 can't be mapped
+            if (index % 2)
+                manager.Map(virt, MemoryManager::SparsePlaceholderAddress(), MappingSize, {true});
+            else
+                manager.Map(virt, host.data() + (index * MappingSize), MappingSize);
+        }
+
+        std::mt19937 random{0x5EED};
+        std::vector<u64> addresses(Translations);
+        auto measure{[&](size_t parity) {
+            for (auto &address : addresses)
+                address = ((((random() % (MappingCount / 2)) * 2) + parity + 1) * MappingStride) + (random() % (MappingSize - 8));
+
+            uintptr_t checksum{}; // This prevents the translations from being optimized out
+            auto start{util::GetTimeNs()};
+            for (auto address : addresses)
+                manager.ForEachRange(address, 8, [&](span<u8> range) { checksum += reinterpret_cast<uintptr_t>(range.data()); });
+            auto duration{util::GetTimeNs() - start};
+            EXPECT(checksum != 0);
+            return static_cast<double>(duration) / Translations;
+        }};
+
+        double pageTableNs{measure(0)}, blockListNs{measure(1)};
+        fmt::print("FlatMemoryManager translation over {} blocks: page table {:.1f}ns, block list {:.1f}ns ({:.1f}x)\n", MappingCount * 2, pageTableNs, blockListNs, blockListNs / pageTableNs);
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"ZeroSizeAllocations", ZeroSizeAllocations},
+        {"LinearAllocationScansForward", LinearAllocationScansForward},
+        {"FreeRegionsMerge", FreeRegionsMerge},
+        {"FragmentationStress", FragmentationStress},
+        {"WholeLeafMapUnmap", WholeLeafMapUnmap},
+        {"PartialUpdateSplitsLinearBase", PartialUpdateSplitsLinearBase},
+        {"UnalignedEdges", UnalignedEdges},
+        {"SparseMappings", SparseMappings},
+        {"TranslateContiguousAcrossBlocks", TranslateContiguousAcrossBlocks},
+        {"ReadWriteSpanningMappings", ReadWriteSpanningMappings},
+        {"RandomMappingsMatchModel", RandomMappingsMatchModel},
+        {"TranslationThroughput", TranslationThroughput},
+    });
+}
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <thread>
+#include <common/mpsc_ring.h>
+#include <test.h>
+
+namespace skyline::test {
+    struct Item {
+        u32 producer;
+        u32 sequence; //!< The index of the item in the sequence of items from its producer
+    };
+
+    constexpr u32 StopProducer{std::numeric_limits<u32>::max()}; //!< The producer of an item that stops the consumer, it's never consumed
+
+    struct StopConsumer {};
+
+    /**
+     * @brief Starts a thread consuming from the ring till it receives an item from StopProducer
+     * @note The consumer function must not throw as it runs on another thread, failures need to be recorded and checked after the thread has been joined
+     */
+    template<typename Function>
+    std::thread StartConsumer(MpscRing<Item> &ring, Function function) {
+        return std::thread([&ring, function]() mutable {
+            try {
+                ring.Process([&](Item &item) {
+                    if (item.producer == StopProducer)
+                        throw StopConsumer{}; // Process never returns, the only way out of it is an exception
+                    function(item);
+                });
+            } catch (const StopConsumer &) {}
+        });
+    }
+
+    /**
+     * @brief Several producers push into a ring that's far smaller than their batches, every item must be consumed exactly once and in the order it was produced by its producer
+     */
+    void ProducersPreserveOrder() {
+        constexpr size_t Capacity{8};
+        constexpr u32 ProducerCount{6}, ItemCount{100000}, MaxBatch{3 * Capacity};
+        MpscRing<Item> ring{Capacity};
+
+        std::array<u32, ProducerCount> nextSequence{};
+        size_t consumed{}, failures{};
+        auto consumer{StartConsumer(ring, [&](Item &item) {
+            if (item.producer >= ProducerCount || item.sequence != nextSequence[item.producer]++)
+                failures++; // An item was lost, duplicated or reordered
+            consumed++;
+        })};
+
+        std::vector<std::thread> producers;
+        for (u32 producer{}; producer < ProducerCount; producer++) {
+            producers.emplace_back([&ring, producer]() {
+                std::mt19937 random{producer};
+                std::uniform_int_distribution<u32> batchSize{1, MaxBatch};
+                std::vector<Item> batch;
+                for (u32 sequence{}; sequence < ItemCount;) {
+                    // Single pushes, batches larger than the ring and transformed batches are interleaved so that every path in the producer is exercised
+                    u32 count{std::min(batchSize(random), ItemCount - sequence)};
+                    if (count == 1) {
+                        ring.Push(Item{producer, sequence++});
+                    } else if (count % 2) {
+                        batch.clear();
+                        for (u32 index{}; index < count; index++)
+                            batch.push_back(Item{producer, sequence++});
+                        ring.Append(batch);
+                    } else {
+                        std::vector<u32> sequences(count);
+                        std::iota(sequences.begin(), sequences.end(), sequence);
+                        sequence += count;
+                        ring.AppendTransform(span(sequences), [producer](u32 sequence) { return Item{producer, sequence}; });
+                    }
+                }
+            });
+        }
+        for (auto &producer : producers)
+            producer.join();
+
+        ring.Push(Item{StopProducer});
+        consumer.join();
+
+        EXPECT(failures == 0);
+        EXPECT(consumed == ProducerCount * ItemCount);
+        for (auto sequence : nextSequence)
+            EXPECT(sequence == ItemCount);
+
+        auto statistics{ring.GetStatistics()};
+        EXPECT(statistics.produced == (ProducerCount * ItemCount) + 1);
+        EXPECT(statistics.depth == 1); // The stop item is never consumed
+        EXPECT(statistics.maxDepth > 0 && statistics.maxDepth <= Capacity);
+        EXPECT(statistics.stallTime >= statistics.stalls); // Every stall takes at least a nanosecond
+    }
+
+    /**
+     * @brief A single producer wraps around a tiny ring many times, items must come out intact in every slot position
+     */
+    void WrapAround() {
+        constexpr size_t Capacity{2};
+        constexpr u32 ItemCount{10000};
+        MpscRing<Item> ring{Capacity - 1}; // The capacity is rounded up to a power of two
+
+        u32 nextSequence{};
+        size_t failures{};
+        auto consumer{StartConsumer(ring, [&](Item &item) {
+            if (item.producer != 0 || item.sequence != nextSequence++)
+                failures++;
+        })};
+
+        for (u32 sequence{}; sequence < ItemCount; sequence++)
+            ring.Push(Item{0, sequence});
+        ring.Push(Item{StopProducer});
+        consumer.join();
+
+        EXPECT(failures == 0);
+        EXPECT(nextSequence == ItemCount);
+        auto statistics{ring.GetStatistics()};
+        EXPECT(statistics.produced == ItemCount + 1);
+        EXPECT(statistics.maxDepth <= Capacity);
+    }
+
+    /**
+     * @brief A producer which fills the ring before the consumer is running must block in WaitForSpace and be woken up once the consumer frees a slot
+     */
+    void BlockedProducerWakes() {
+        using namespace std::chrono_literals;
+        constexpr size_t Capacity{4};
+        constexpr auto BlockDuration{50ms};
+        MpscRing<Item> ring{Capacity};
+
+        std::atomic<bool> produced{};
+        std::thread producer([&]() {
+            for (u32 sequence{}; sequence <= Capacity; sequence++)
+                ring.Push(Item{0, sequence});
+            produced = true;
+        });
+
+        while (ring.GetStatistics().depth < Capacity)
+            std::this_thread::yield();
+        std::this_thread::sleep_for(BlockDuration);
+        EXPECT(!produced); // The last item doesn't fit into the ring till the consumer has freed a slot
+
+        auto statistics{ring.GetStatistics()};
+        EXPECT(statistics.depth == Capacity && statistics.maxDepth == Capacity);
+        EXPECT(statistics.produced == Capacity);
+        EXPECT(statistics.stalls == 0); // A stall is only counted once the producer has been woken up
+
+        u32 nextSequence{};
+        size_t failures{};
+        auto consumer{StartConsumer(ring, [&](Item &item) {
+            if (item.sequence != nextSequence++)
+                failures++;
+        })};
+        producer.join();
+        EXPECT(produced);
+
+        statistics = ring.GetStatistics();
+        EXPECT(statistics.produced == Capacity + 1);
+        EXPECT(statistics.stalls == 1);
+        EXPECT(statistics.stallTime >= static_cast<u64>(std::chrono::nanoseconds(BlockDuration).count()));
+
+        ring.Push(Item{StopProducer}); // This may stall as well if the consumer hasn't caught up yet
+        consumer.join();
+
+        EXPECT(failures == 0);
+        EXPECT(nextSequence == Capacity + 1);
+        statistics = ring.GetStatistics();
+        EXPECT(statistics.produced == Capacity + 2);
+        EXPECT(statistics.depth == 1);
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"ProducersPreserveOrder", ProducersPreserveOrder},
+        {"WrapAround", WrapAround},
+        {"BlockedProducerWakes", BlockedProducerWakes},
+    });
+}
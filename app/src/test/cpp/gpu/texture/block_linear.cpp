@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu/texture/block_linear.h>
+#include <gpu/texture/format.h>
+#include <test.h>
+
+namespace skyline::test {
+    using gpu::texture::BlockLinear;
+    using gpu::texture::Dimensions;
+    namespace format = gpu::format;
+
+    /**
+     * @return The offset of a byte of the first level in block-linear memory, this is a direct per-byte implementation of the layout rather than a per-GOB one
+     * @param x The X-axis offset in bytes
+     * @param y The Y-axis offset in lines of format blocks
+     */
+    size_t BlockLinearOffset(const BlockLinear::Level &level, u32 x, u32 y, u32 z) {
+        size_t gobOffset{((x % 64) / 32) * 256 + ((y % 8) / 2) * 64 + ((x % 32) / 16) * 32 + (y % 2) * 16 + (x % 16)};
+        size_t rob{((z / level.blockDepth) * level.robCount) + (y / (BlockLinear::GobHeight * level.blockHeight))};
+        size_t block{(rob * level.robWidth) + (x / BlockLinear::GobWidth)};
+        size_t gob{((z % level.blockDepth) * level.blockHeight) + ((y / BlockLinear::GobHeight) % level.blockHeight)};
+        return (block * level.GetBlockSize()) + (gob * BlockLinear::GobSize) + gobOffset;
+    }
+
+    std::vector<u8> RandomBytes(size_t size, u32 seed) {
+        std::mt19937 random{seed};
+        std::vector<u8> bytes(size);
+        for (auto &byte : bytes)
+            byte = static_cast<u8>(random());
+        return bytes;
+    }
+
+    /**
+     * @brief Deswizzles surfaces with partial GOBs and blocks on every edge and compares them against the per-byte reference, then swizzles them back
+     */
+    void MatchesReference() {
+        struct Surface {
+            Dimensions dimensions;
+            const gpu::texture::Format &format;
+            u32 blockHeight, blockDepth;
+        };
+        std::array surfaces{
+            Surface{{1920, 1080}, format::RGBA8888Unorm, 16, 1},
+            Surface{{1280, 720}, format::RGB565Unorm, 8, 1},
+            Surface{{33, 47}, format::RGBA8888Unorm, 4, 1},
+            Surface{{100, 3}, format::RGBA8888Unorm, 16, 1}, // The block height is reduced to a single GOB for a level this short
+            Surface{{260, 260}, format::BC1Unorm, 2, 1},
+            Surface{{130, 70}, format::BC7Unorm, 8, 1},
+            Surface{{40, 24, 5}, format::RGBA8888Unorm, 2, 4},
+        };
+
+        ThreadPool pool{3};
+        for (const auto &surface : surfaces) {
+            BlockLinear blockLinear{surface.dimensions, surface.format, surface.blockHeight, surface.blockDepth};
+            const auto &level{blockLinear.GetLevels().front()};
+            auto input{RandomBytes(blockLinear.GetBlockLinearSize(), surface.dimensions.width)};
+
+            // The accessed range must end exactly after the furthest byte which corresponds to a pixel
+            size_t accessEnd{};
+            for (u32 z{}; z < level.depth; z++)
+                for (u32 y{}; y < level.height; y++)
+                    for (u32 x{}; x < level.widthBytes; x++)
+                        accessEnd = std::max(accessEnd, BlockLinearOffset(level, x, y, z) + 1);
+            EXPECT(blockLinear.GetBlockLinearAccessSize() == accessEnd);
+            EXPECT(accessEnd <= blockLinear.GetBlockLinearSize());
+
+            for (ThreadPool *threadPool : {static_cast<ThreadPool *>(nullptr), &pool}) {
+                std::vector<u8> linear(blockLinear.GetLinearSize());
+                blockLinear.Deswizzle(input.data(), linear.data(), threadPool);
+
+                for (u32 z{}; z < level.depth; z++)
+                    for (u32 y{}; y < level.height; y++)
+                        for (u32 x{}; x < level.widthBytes; x++)
+                            EXPECT(linear[(static_cast<size_t>(z) * level.height + y) * level.widthBytes + x] == input[BlockLinearOffset(level, x, y, z)]);
+
+                // Swizzling only writes bytes which correspond to pixels, the padding must be retained from the original surface
+                auto output{input};
+                std::fill(output.begin(), output.end(), 0);
+                blockLinear.Swizzle(linear.data(), output.data(), threadPool);
+                for (u32 z{}; z < level.depth; z++)
+                    for (u32 y{}; y < level.height; y++)
+                        for (u32 x{}; x < level.widthBytes; x++)
+                            EXPECT(output[BlockLinearOffset(level, x, y, z)] == input[BlockLinearOffset(level, x, y, z)]);
+            }
+        }
+
+        BlockLinear shortSurface{Dimensions{100, 3}, format::RGBA8888Unorm, 16};
+        EXPECT(shortSurface.GetLevels().front().blockHeight == 1);
+    }
+
+    /**
+     * @brief Measures the deswizzling throughput of a 1080p RGBA8888 surface, which is the size of a typical framebuffer
+     */
+    void DeswizzleThroughput() {
+        constexpr size_t Iterations{50};
+        BlockLinear blockLinear{Dimensions{1920, 1080}, format::RGBA8888Unorm, 16};
+        auto input{RandomBytes(blockLinear.GetBlockLinearSize(), 0)};
+        std::vector<u8> linear(blockLinear.GetLinearSize());
+
+        ThreadPool pool{std::max(std::thread::hardware_concurrency() / 2, 1U)};
+        for (ThreadPool *threadPool : {static_cast<ThreadPool *>(nullptr), &pool}) {
+            blockLinear.Deswizzle(input.data(), linear.data(), threadPool); // The first iteration faults in the output pages
+
+            std::vector<u64> durations;
+            for (size_t iteration{}; iteration < Iterations; iteration++) {
+                auto start{util::GetTimeNs()};
+                blockLinear.Deswizzle(input.data(), linear.data(), threadPool);
+                durations.push_back(util::GetTimeNs() - start);
+            }
+
+            auto median{Percentile(durations, 50)};
+            fmt::print("BlockLinear::Deswizzle 1920x1080 RGBA8888 (Concurrency: {}): {:.2f} GB/s, median of {} iterations: {}ns\n", threadPool ? threadPool->GetConcurrency() : 1, static_cast<double>(linear.size()) / static_cast<double>(median), Iterations, median);
+        }
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"MatchesReference", MatchesReference},
+        {"DeswizzleThroughput", DeswizzleThroughput},
+    });
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu/texture/decoder.h>
+#include <gpu/texture/format.h>
+#include <test.h>
+
+namespace skyline::test {
+    using gpu::texture::Dimensions;
+    namespace decoder = gpu::texture::decoder;
+    namespace format = gpu::format;
+
+    using Texels = std::array<u32, 16>; //!< The texels of a 4x4 block in row-major order, each texel is written as 0xRRGGBBAA
+
+    /**
+     * @brief Decodes a single block and compares every texel against the expected value
+     */
+    void ExpectBlock(decoder::BlockDecoder decode, const gpu::texture::Format &format, std::array<u8, 16> block, const Texels &expected) {
+        std::array<u8, decoder::BlockTexelLimit * 4> output{};
+        decode(block.data(), output.data(), format);
+        for (size_t texel{}; texel < expected.size(); texel++) {
+            u32 value{static_cast<u32>(output[texel * 4] << 24) | static_cast<u32>(output[(texel * 4) + 1] << 16) | static_cast<u32>(output[(texel * 4) + 2] << 8) | output[(texel * 4) + 3]};
+            if (value != expected[texel])
+                throw exception("Texel {} decoded to 0x{:08X} rather than 0x{:08X}", texel, value, expected[texel]);
+        }
+    }
+
+    constexpr std::array<u8, 16> Bc1FourColorBlock{0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4}; //!< Red and blue endpoints with color0 > color1, every row uses indices 0 to 3
+    constexpr Texels Bc1FourColorTexels{
+        0xFF0000FF, 0x0000FFFF, 0xAA0055FF, 0x5500AAFF,
+        0xFF0000FF, 0x0000FFFF, 0xAA0055FF, 0x5500AAFF,
+        0xFF0000FF, 0x0000FFFF, 0xAA0055FF, 0x5500AAFF,
+        0xFF0000FF, 0x0000FFFF, 0xAA0055FF, 0x5500AAFF,
+    };
+
+    constexpr std::array<u8, 16> Bc1PunchThroughBlock{0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4}; //!< The same endpoints swapped so color0 <= color1, index 3 is transparent black
+    constexpr Texels Bc1PunchThroughTexels{
+        0x0000FFFF, 0xFF0000FF, 0x7F007FFF, 0x00000000,
+        0x0000FFFF, 0xFF0000FF, 0x7F007FFF, 0x00000000,
+        0x0000FFFF, 0xFF0000FF, 0x7F007FFF, 0x00000000,
+        0x0000FFFF, 0xFF0000FF, 0x7F007FFF, 0x00000000,
+    };
+
+    /**
+     * @note The BCn reference blocks were cross-checked against the decoder in Pillow, which also agreed on thousands of random blocks in every BC7 mode aside from the reserved one
+     */
+    void Bc1() {
+        ExpectBlock(decoder::DecodeBc1Block, format::BC1Unorm, Bc1FourColorBlock, Bc1FourColorTexels);
+        ExpectBlock(decoder::DecodeBc1Block, format::BC1Unorm, Bc1PunchThroughBlock, Bc1PunchThroughTexels);
+    }
+
+    void Bc3() {
+        // The alpha endpoints are 0xFF and 0x00 with texel N using index N % 8, the color block is white and black in the four-color mode regardless of the endpoint order
+        ExpectBlock(decoder::DecodeBc3Block, format::BC3Unorm, {0xFF, 0x00, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0xFF, 0xFF, 0x00, 0x00, 0xE4, 0xE4, 0xE4, 0xE4}, {
+            0xFFFFFFFF, 0x00000000, 0xAAAAAADA, 0x555555B6,
+            0xFFFFFF91, 0x0000006D, 0xAAAAAA48, 0x55555524,
+            0xFFFFFFFF, 0x00000000, 0xAAAAAADA, 0x555555B6,
+            0xFFFFFF91, 0x0000006D, 0xAAAAAA48, 0x55555524,
+        });
+    }
+
+    void Bc7() {
+        // Mode 6: A single RGBA subset with a P-bit per endpoint and 4-bit indices, texel N uses index N
+        ExpectBlock(decoder::DecodeBc7Block, format::BC7Unorm, {0x40, 0xC0, 0x1F, 0x08, 0xFA, 0x03, 0xFE, 0xC0, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE}, {
+            0x0181FFFF, 0x117DEFF7, 0x2578DBED, 0x3474CBE5,
+            0x4470BBDD, 0x546CABD5, 0x686797CB, 0x786387C3,
+            0x875E78BC, 0x975A68B4, 0xAB5554AA, 0xBB5144A2,
+            0xCB4D349A, 0xDA492492, 0xEE441088, 0xFE400080,
+        });
+
+        // Mode 1: Two subsets in partition 13 (the bottom two rows are the second subset) with shared P-bits, the anchor of the second subset is texel 15
+        ExpectBlock(decoder::DecodeBc7Block, format::BC7Unorm, {0x36, 0xC0, 0xFF, 0x03, 0xC0, 0x0F, 0xFC, 0x3F, 0x00, 0xC1, 0x11, 0x8D, 0xF5, 0x11, 0x8D, 0xF5}, {
+            0x0202FFFF, 0x2626DBFF, 0x4949B8FF, 0x6D6D94FF,
+            0x94946DFF, 0xB8B849FF, 0xDBDB26FF, 0xFFFF02FF,
+            0xFD0040FF, 0xD92452FF, 0xB64764FF, 0x926B76FF,
+            0x6B928BFF, 0x47B69DFF, 0x24D9AFFF, 0x926B76FF,
+        });
+
+        // Mode 4: Separate color and alpha indices with the index selection bit set so color uses the 3-bit indices, the rotation swaps red and alpha
+        ExpectBlock(decoder::DecodeBc7Block, format::BC7Unorm, {0xB0, 0x1F, 0x80, 0x0F, 0x11, 0xF0, 0xCB, 0xC9, 0xC9, 0xC9, 0x89, 0xC6, 0xFA, 0x88, 0xC6, 0xFA}, {
+            0x000084FF, 0x54247BDB, 0xAB4871B7, 0xFF6C6893,
+            0x00935E6C, 0x54B75548, 0xABDB4B24, 0xFFFF4200,
+            0x000084FF, 0x54247BDB, 0xAB4871B7, 0xFF6C6893,
+            0x00935E6C, 0x54B75548, 0xABDB4B24, 0xFFFF4200,
+        });
+
+        // Reserved modes decode to transparent black
+        Texels transparent{};
+        ExpectBlock(decoder::DecodeBc7Block, format::BC7Unorm, {0x00, 0x2C, 0x4E, 0x2D, 0xA6, 0xA3, 0x26, 0x35, 0xDB, 0xC6, 0x22, 0xB1, 0x3E, 0xEB, 0x75, 0xCA}, transparent);
+    }
+
+    /**
+     * @note The ASTC reference blocks were encoded and decoded by a separate implementation of the specification, the unorm8 result is the top 8 bits of the 16-bit interpolation
+     */
+    void Astc() {
+        // Void-extent: An LDR block without an extent and a constant color of (0x2020, 0x8080, 0xC0C0, 0xFFFF)
+        Texels constant;
+        constant.fill(0x2080C0FF);
+        ExpectBlock(decoder::DecodeAstcBlock, format::ASTC4x4Unorm, {0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x20, 0x20, 0x80, 0x80, 0xC0, 0xC0, 0xFF, 0xFF}, constant);
+
+        // Dual-plane: A 2x2 grid of 3-bit weights which are infilled to 4x4 with RGBA direct endpoints, the alpha channel uses the second plane
+        ExpectBlock(decoder::DecodeAstcBlock, format::ASTC4x4Unorm, {0x1F, 0x85, 0x21, 0xE0, 0x41, 0xC0, 0x61, 0xA0, 0xFF, 0x01, 0x00, 0x00, 0xC0, 0x2B, 0x8D, 0x1F}, {
+            0x10203000, 0x565C6250, 0xAAA49EAF, 0xF0E0D0FF,
+            0x2C384444, 0x6065695C, 0xAAA49EA3, 0xDBCEC1BB,
+            0x52595F97, 0x797A7B93, 0x9C98946C, 0xC6BCB268,
+            0x6E7173DB, 0x848383A3, 0x9C98945C, 0xB1AAA324,
+        });
+
+        // Multi-partition: Two partitions with a seed of 1 and RGB direct endpoints (black to white and 0x224466 to 0xCC88AA), texel N uses weight N % 8
+        ExpectBlock(decoder::DecodeAstcBlock, format::ASTC4x4Unorm, {0x53, 0x28, 0x00, 0x10, 0x1E, 0x1E, 0x5E, 0x98, 0xD0, 0x14, 0x5F, 0x63, 0x11, 0x5F, 0x63, 0x11}, {
+            0x000000FF, 0x3A4D70FF, 0x525779FF, 0x6C6C6CFF,
+            0x846B8DFF, 0x9C7597FF, 0xB47EA1FF, 0xFFFFFFFF,
+            0x224466FF, 0x3A4D70FF, 0x484848FF, 0x6C6C6CFF,
+            0x846B8DFF, 0x9C7597FF, 0xDBDBDBFF, 0xFFFFFFFF,
+        });
+
+        // A reserved block mode decodes to the error color
+        Texels error;
+        error.fill(0xFF00FFFF);
+        ExpectBlock(decoder::DecodeAstcBlock, format::ASTC4x4Unorm, {}, error);
+    }
+
+    /**
+     * @brief Decodes a surface which isn't a multiple of the block size, texels outside the surface must be clipped
+     */
+    void DecodeSurface() {
+        constexpr Dimensions dimensions{6, 5};
+        constexpr u32 BlocksX{2}, BlocksY{2};
+        std::vector<u8> input;
+        for (u32 block{}; block < BlocksX * BlocksY; block++) {
+            const auto &source{(block % 2) ? Bc1PunchThroughBlock : Bc1FourColorBlock};
+            input.insert(input.end(), source.begin(), source.begin() + format::BC1Unorm.bpb);
+        }
+
+        std::vector<u8> output(dimensions.width * dimensions.height * 4);
+        gpu::texture::Decode(format::BC1Unorm, dimensions, input.data(), output.data());
+        for (u32 y{}; y < dimensions.height; y++) {
+            for (u32 x{}; x < dimensions.width; x++) {
+                const auto &texels{((x / 4) % 2) ? Bc1PunchThroughTexels : Bc1FourColorTexels};
+                u32 expected{texels[((y % 4) * 4) + (x % 4)]};
+                const u8 *texel{&output[((y * dimensions.width) + x) * 4]};
+                EXPECT(texel[0] == (expected >> 24) && texel[1] == ((expected >> 16) & 0xFF) && texel[2] == ((expected >> 8) & 0xFF) && texel[3] == (expected & 0xFF));
+            }
+        }
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"Bc1", Bc1},
+        {"Bc3", Bc3},
+        {"Bc7", Bc7},
+        {"Astc", Astc},
+        {"DecodeSurface", DecodeSurface},
+    });
+}
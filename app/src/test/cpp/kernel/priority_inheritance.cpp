@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <list>
+#include <thread>
+#include <kernel/priority_inheritance.h>
+#include <test.h>
+
+namespace skyline::test {
+    /**
+     * @brief A thread with only the members that are used by priority inheritance, it stands in for KThread
+     */
+    struct Thread {
+        std::atomic<u8> priority;
+        std::mutex waiterMutex;
+        std::shared_ptr<Thread> waitThread;
+        std::list<std::shared_ptr<Thread>> waiters; //!< A queue of threads waiting on this thread sorted by priority
+
+        Thread(u8 priority) : priority(priority) {}
+
+        static bool IsHigherPriority(const i8 priority, const std::shared_ptr<Thread> &it) {
+            return priority < it->priority;
+        }
+    };
+
+    /**
+     * @brief Makes the waiter wait on the owner, the waiter is inserted into the owner's waiter queue by its priority
+     */
+    void WaitOn(const std::shared_ptr<Thread> &waiter, const std::shared_ptr<Thread> &owner) {
+        waiter->waitThread = owner;
+        owner->waiters.insert(std::upper_bound(owner->waiters.begin(), owner->waiters.end(), waiter->priority.load(), Thread::IsHigherPriority), waiter);
+    }
+
+    /**
+     * @return A chain of threads with the supplied priorities where every thread waits on the one after it
+     */
+    std::vector<std::shared_ptr<Thread>> MakeChain(std::initializer_list<u8> priorities) {
+        std::vector<std::shared_ptr<Thread>> chain;
+        for (auto priority : priorities) {
+            auto thread{std::make_shared<Thread>(priority)};
+            if (!chain.empty())
+                WaitOn(chain.back(), thread);
+            chain.push_back(std::move(thread));
+        }
+        return chain;
+    }
+
+    void InheritPriority() {
+        Thread owner{20};
+        EXPECT(!kernel::InheritPriority(owner, 20));
+        EXPECT(!kernel::InheritPriority(owner, 30));
+        EXPECT(owner.priority == 20);
+        EXPECT(kernel::InheritPriority(owner, 10));
+        EXPECT(owner.priority == 10);
+    }
+
+    /**
+     * @brief A high priority waiter at the start of a chain of owners must boost every owner in the chain and reorder each owner in the waiter queue of the next one
+     */
+    void ChainOfOwners() {
+        auto chain{MakeChain({10, 20, 30, 40})};
+        auto bystander{std::make_shared<Thread>(15)};
+        WaitOn(bystander, chain[2]); // chain[1] starts behind this in the waiter queue of chain[2]
+        EXPECT(chain[2]->waiters.front() == bystander);
+
+        std::vector<std::shared_ptr<Thread>> boosted;
+        kernel::PropagatePriorityInheritance(chain[0]->waitThread, chain[0]->priority.load(), [&](const std::shared_ptr<Thread> &owner) {
+            boosted.push_back(owner);
+        });
+
+        EXPECT(boosted == std::vector(chain.begin() + 1, chain.end()));
+        for (const auto &thread : chain)
+            EXPECT(thread->priority == 10);
+        EXPECT(chain[2]->waiters.front() == chain[1]);
+        EXPECT(chain[2]->waiters.back() == bystander);
+        EXPECT(chain[3]->waiters.size() == 1 && chain[3]->waiters.front() == chain[2]);
+    }
+
+    /**
+     * @brief Propagation must stop at the first owner which already has an equal or higher priority, the owners after it aren't touched
+     */
+    void StopsAtHigherPriorityOwner() {
+        auto chain{MakeChain({10, 20, 5, 40})};
+        size_t boostCount{};
+        kernel::PropagatePriorityInheritance(chain[0]->waitThread, chain[0]->priority.load(), [&](const std::shared_ptr<Thread> &owner) {
+            EXPECT(owner == chain[1]);
+            boostCount++;
+        });
+
+        EXPECT(boostCount == 1);
+        EXPECT(chain[1]->priority == 10);
+        EXPECT(chain[2]->priority == 5);
+        EXPECT(chain[3]->priority == 40);
+
+        // A repeated propagation with the same priority doesn't boost anything
+        kernel::PropagatePriorityInheritance(chain[0]->waitThread, chain[0]->priority.load(), [&](const std::shared_ptr<Thread> &) {
+            boostCount++;
+        });
+        EXPECT(boostCount == 1);
+    }
+
+    /**
+     * @brief Several waiters propagating different priorities along the same chain at once must leave every owner at the highest of them, each owner is only ever boosted to a higher priority
+     */
+    void ConcurrentPropagation() {
+        constexpr size_t WaiterCount{8}, Iterations{2000};
+        for (size_t iteration{}; iteration < Iterations; iteration++) {
+            auto chain{MakeChain({50, 60, 70, 80})};
+            std::vector<std::shared_ptr<Thread>> waiters;
+            for (size_t index{}; index < WaiterCount; index++) {
+                auto waiter{std::make_shared<Thread>(static_cast<u8>(10 + index))};
+                WaitOn(waiter, chain[0]);
+                waiters.push_back(std::move(waiter));
+            }
+
+            std::atomic<size_t> boostCount{};
+            std::vector<std::thread> threads;
+            for (const auto &waiter : waiters)
+                threads.emplace_back([&, waiter]() {
+                    kernel::PropagatePriorityInheritance(waiter->waitThread, waiter->priority.load(), [&](const std::shared_ptr<Thread> &) {
+                        boostCount.fetch_add(1, std::memory_order_relaxed);
+                    });
+                });
+            for (auto &thread : threads)
+                thread.join();
+
+            for (const auto &thread : chain)
+                EXPECT(thread->priority == 10);
+            EXPECT(boostCount >= chain.size() && boostCount <= chain.size() * WaiterCount);
+            for (size_t index{1}; index < chain.size(); index++)
+                EXPECT(chain[index]->waiters.size() == 1 && chain[index]->waiters.front() == chain[index - 1]);
+        }
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"InheritPriority", InheritPriority},
+        {"ChainOfOwners", ChainOfOwners},
+        {"StopsAtHigherPriorityOwner", StopsAtHigherPriorityOwner},
+        {"ConcurrentPropagation", ConcurrentPropagation},
+    });
+}
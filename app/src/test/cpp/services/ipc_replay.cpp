@@ -0,0 +1,643 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <filesystem>
+#include <nce/guest.h>
+#include <common/language.h>
+#include <services/settings/ISettingsServer.h>
+#include <services/settings/ISystemSettingsServer.h>
+#include <services/apm/IManager.h>
+#include <services/apm/ISession.h>
+#include <services/pctl/IParentalControlServiceFactory.h>
+#include <services/pctl/IParentalControlService.h>
+#include <test.h>
+
+/*
+ * ipc_replay replays a capture written by IpcCapture (The "ipc_capture.bin" file in the app's files directory) against the HLE services on a Linux host: ipc_replay <capture>
+ * Every request is handled by the service it was captured from, its latency is measured and its response and output buffers are compared byte-for-byte against the captured ones
+ * Without any arguments it runs a self-test which captures requests to the services it's linked against and replays them, this is what CTest runs
+ *
+ * The tool is only linked against IPC parsing and services which don't depend on the rest of the emulator, the kernel they use is stubbed out here
+ * Requests to other services and requests which transfer handles to the service are skipped, handles in responses are only compared by their amount as the stub kernel allocates its own
+ */
+namespace skyline {
+    DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings, std::shared_ptr<Logger> logger) : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)), logger(std::move(logger)) {}
+
+    Logger::Logger(const std::string &path, LogLevel configLevel) : configLevel(configLevel) {}
+
+    Logger::~Logger() {}
+
+    Logger::Entry *Logger::BeginEntry(LogLevel level) {
+        return nullptr; // Deferred logs are dropped, only errors are written out
+    }
+
+    void Logger::CommitEntry() {}
+
+    void Logger::Write(LogLevel level, const std::string &str) {
+        fmt::print(stderr, "{}\n", str);
+    }
+}
+
+namespace skyline::test {
+    using ServiceRegistry = std::unordered_map<std::string, std::shared_ptr<service::BaseService>>;
+
+    /**
+     * @brief The services of every ServiceManager by their class name, requests are routed by the name as captures don't record which session a request was sent on
+     * @note If there are several instances of a class, requests are routed to the one which was registered last
+     */
+    std::unordered_map<const service::ServiceManager *, ServiceRegistry> registries;
+
+    KHandle nextHandle{0x10}; //!< The next handle allocated by the stub kernel, these never match the ones in a capture
+}
+
+namespace skyline::service {
+    IpcProfiler::IpcProfiler(const DeviceState &state) : state(state), enabled(false) {}
+
+    ServiceManager::ServiceManager(const DeviceState &state) : state(state), profiler(state), ipcCapture(state, "") {}
+
+    void ServiceManager::RegisterService(std::shared_ptr<BaseService> serviceObject, type::KSession &session, ipc::IpcResponse &response) { // NOLINT(performance-unnecessary-value-param)
+        if (session.isDomain) {
+            session.domains.push_back(serviceObject);
+            response.domainObjects.push_back(session.handleIndex++);
+        } else {
+            response.moveHandles.push_back(test::nextHandle++);
+        }
+        test::registries[this][serviceObject->GetName()] = serviceObject;
+    }
+}
+
+namespace skyline::test {
+    using namespace kernel;
+
+    /**
+     * @brief A region of host memory which can be addressed by IPC buffer descriptors, these only hold 39-bit addresses which regular host allocations may exceed
+     */
+    class GuestArena {
+      private:
+        static constexpr size_t Size{1ULL << 28}; //!< The arena is never committed upfront, pages are only backed once they're touched
+        static constexpr size_t Alignment{0x10};
+        u8 *base{};
+        size_t offset{};
+
+      public:
+        GuestArena() {
+            // Any free region addressable in 39 bits is used, the higher ones may be occupied by the shadow memory of sanitizers
+            for (u64 address{1ULL << 38}; address >= Size; address >>= 1) {
+                auto pointer{mmap(reinterpret_cast<void *>(address), Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0)};
+                if (pointer == MAP_FAILED)
+                    continue;
+                if (reinterpret_cast<u64>(pointer) == address) { // Kernels prior to 4.17 treat the address as a hint
+                    base = static_cast<u8 *>(pointer);
+                    return;
+                }
+                munmap(pointer, Size);
+            }
+            throw exception("Failed to map a guest arena addressable by buffer descriptors");
+        }
+
+        ~GuestArena() {
+            munmap(base, Size);
+        }
+
+        span<u8> Allocate(size_t size) {
+            if (size > Size - offset)
+                throw exception("Buffer of 0x{:X} bytes doesn't fit into the guest arena", size);
+            span<u8> buffer{base + offset, size};
+            offset = util::AlignUp(offset + size, Alignment);
+            return buffer;
+        }
+
+        /**
+         * @brief Frees and zeroes all allocations
+         */
+        void Reset() {
+            if (offset)
+                madvise(base, offset, MADV_DONTNEED);
+            offset = 0;
+        }
+    };
+
+    GuestArena &GetArena() {
+        static GuestArena arena;
+        return arena;
+    }
+
+    /**
+     * @brief Points an X, A, B or W buffer descriptor at a buffer in the guest arena
+     */
+    template<typename Descriptor>
+    void SetAddress(Descriptor &descriptor, span<u8> buffer) {
+        auto address{reinterpret_cast<u64>(buffer.data())};
+        descriptor.address0_31 = static_cast<u32>(address);
+        descriptor.address32_35 = static_cast<u8>((address >> 32) & 0xF);
+        descriptor.address36_38 = static_cast<u8>((address >> 36) & 0x7);
+    }
+
+    /**
+     * @brief Clears the handles in a response in TLS as they're allocated by the kernel which handled it
+     * @return The amount of bytes of the TLS IPC buffer which were written by IpcResponse::WriteResponse
+     */
+    size_t MaskResponse(std::array<u8, constant::TlsIpcSize> &tls, bool isDomain) {
+        auto header{reinterpret_cast<ipc::CommandHeader *>(tls.data())};
+        size_t offset{sizeof(ipc::CommandHeader)};
+        if (header->handleDesc) {
+            auto handleDesc{reinterpret_cast<ipc::HandleDescriptor *>(tls.data() + offset)};
+            offset += sizeof(ipc::HandleDescriptor) + (handleDesc->sendPid ? sizeof(u64) : 0);
+            size_t handleSize{std::min((handleDesc->copyCount + handleDesc->moveCount) * sizeof(KHandle), tls.size() - offset)};
+            std::memset(tls.data() + offset, 0, handleSize);
+            offset += handleSize;
+        }
+
+        offset = util::AlignUp(offset, constant::IpcPaddingSum);
+        size_t end{std::min<size_t>(offset + (header->rawSize * sizeof(u32)), tls.size())};
+
+        if (isDomain && offset + sizeof(ipc::DomainHeaderResponse) <= end) {
+            // Domain objects directly precede the trailing padding, their IDs are allocated by the session
+            auto domain{reinterpret_cast<ipc::DomainHeaderResponse *>(tls.data() + offset)};
+            size_t objectSize{domain->outputCount * sizeof(KHandle)};
+            if (objectSize + constant::IpcPaddingSum <= end - offset)
+                std::memset(tls.data() + end - constant::IpcPaddingSum - objectSize, 0, objectSize);
+        }
+
+        return end;
+    }
+
+    /**
+     * @brief A single request from a capture
+     */
+    struct CapturedRecord {
+        service::IpcCapture::RecordHeader header;
+        std::string serviceName;
+        std::vector<std::pair<service::IpcCapture::BufferHeader, span<const u8>>> buffers;
+    };
+
+    /**
+     * @return All records in a capture, their buffers reference the supplied capture
+     */
+    std::vector<CapturedRecord> ParseCapture(span<const u8> capture) {
+        using IpcCapture = service::IpcCapture;
+
+        IpcCapture::FileHeader fileHeader;
+        if (capture.size() < sizeof(fileHeader))
+            throw exception("Capture is truncated: 0x{:X} bytes", capture.size());
+        std::memcpy(&fileHeader, capture.data(), sizeof(fileHeader));
+        if (fileHeader.magic != IpcCapture::FileMagic || fileHeader.version != IpcCapture::Version)
+            throw exception("Capture has an invalid header: magic 0x{:X}, version {}", fileHeader.magic, fileHeader.version);
+
+        std::vector<CapturedRecord> records;
+        size_t offset{sizeof(fileHeader)};
+        while (offset < capture.size()) {
+            auto &record{records.emplace_back()};
+            if (capture.size() - offset < sizeof(record.header))
+                throw exception("Record at 0x{:X} is truncated", offset);
+            std::memcpy(&record.header, capture.data() + offset, sizeof(record.header)); // Records aren't aligned in the capture
+            if (record.header.magic != IpcCapture::RecordMagic || record.header.size > capture.size() - offset || record.header.size < sizeof(record.header) + record.header.serviceNameSize)
+                throw exception("Record at 0x{:X} is invalid: magic 0x{:X}, size 0x{:X}", offset, record.header.magic, record.header.size);
+
+            auto recordData{capture.subspan(offset, record.header.size)};
+            size_t recordOffset{sizeof(record.header)};
+            record.serviceName = recordData.subspan(recordOffset, record.header.serviceNameSize).as_string();
+            recordOffset += record.header.serviceNameSize;
+
+            for (u8 index{}; index < record.header.bufferCount; index++) {
+                IpcCapture::BufferHeader bufferHeader;
+                if (recordData.size() - recordOffset < sizeof(bufferHeader))
+                    throw exception("Buffer #{} of the record at 0x{:X} is truncated", index, offset);
+                std::memcpy(&bufferHeader, recordData.data() + recordOffset, sizeof(bufferHeader));
+                recordOffset += sizeof(bufferHeader);
+                if (bufferHeader.size > recordData.size() - recordOffset)
+                    throw exception("Buffer #{} of the record at 0x{:X} is truncated", index, offset);
+                record.buffers.emplace_back(bufferHeader, recordData.subspan(recordOffset, bufferHeader.size));
+                recordOffset += bufferHeader.size;
+            }
+
+            offset += record.header.size;
+        }
+        return records;
+    }
+
+    using ServiceFactory = std::shared_ptr<service::BaseService> (*)(const DeviceState &state, service::ServiceManager &manager);
+
+    template<typename ServiceType>
+    std::shared_ptr<service::BaseService> MakeService(const DeviceState &state, service::ServiceManager &manager) {
+        return std::make_shared<ServiceType>(state, manager);
+    }
+
+    /**
+     * @brief The services which are linked into the tool by their class name, a service that's used before it was registered in the replay is created from here
+     */
+    const std::unordered_map<std::string_view, ServiceFactory> ServiceFactories{
+        {"settings::ISettingsServer", MakeService<service::settings::ISettingsServer>},
+        {"settings::ISystemSettingsServer", MakeService<service::settings::ISystemSettingsServer>},
+        {"apm::IManager", MakeService<service::apm::IManager>},
+        {"apm::ISession", MakeService<service::apm::ISession>},
+        {"pctl::IParentalControlServiceFactory", MakeService<service::pctl::IParentalControlServiceFactory>},
+        {"pctl::IParentalControlService", MakeService<service::pctl::IParentalControlService>},
+    };
+
+    /**
+     * @brief Replays captured requests against the services, the state of services carries over between requests the same way it did when they were captured
+     */
+    class Replayer {
+      private:
+        DeviceState state;
+        service::ServiceManager manager;
+        nce::ThreadContext context{};
+        alignas(0x10) std::array<u8, constant::TlsIpcSize> tls{};
+
+        struct CommandLatency {
+            std::vector<u64> replayedNs;
+            std::vector<u64> capturedNs;
+        };
+
+        std::map<std::pair<std::string, u32>, CommandLatency> latencies; //!< The latencies of every (service, command ID) pair which was replayed
+        std::map<std::string, size_t> skippedServices; //!< The amount of skipped requests by the name of their service
+
+        /**
+         * @return A description of the first difference between the replayed response and output buffers and the captured ones, this is empty if there are none
+         */
+        std::string Compare(const CapturedRecord &record, span<const span<u8>> outputs) {
+            auto captured{record.header.response};
+            auto capturedEnd{MaskResponse(captured, record.header.isDomain)};
+            auto replayed{tls};
+            auto replayedEnd{MaskResponse(replayed, record.header.isDomain)};
+            if (capturedEnd != replayedEnd)
+                return fmt::format("response size differs: 0x{:X} bytes rather than 0x{:X}", replayedEnd, capturedEnd);
+            auto mismatch{std::mismatch(captured.begin(), captured.begin() + static_cast<ssize_t>(capturedEnd), replayed.begin())};
+            if (mismatch.first != captured.begin() + static_cast<ssize_t>(capturedEnd))
+                return fmt::format("response differs at 0x{:X}: 0x{:02X} rather than 0x{:02X}", std::distance(captured.begin(), mismatch.first), *mismatch.second, *mismatch.first);
+
+            for (const auto &[bufferHeader, data] : record.buffers) {
+                if (!bufferHeader.isOutput)
+                    continue;
+                if (bufferHeader.index >= outputs.size() || outputs[bufferHeader.index].size() < data.size())
+                    return fmt::format("output buffer #{} is missing", bufferHeader.index);
+                auto output{outputs[bufferHeader.index].first(data.size())};
+                auto bufferMismatch{std::mismatch(data.begin(), data.end(), output.begin())};
+                if (bufferMismatch.first != data.end())
+                    return fmt::format("output buffer #{} differs at 0x{:X}: 0x{:02X} rather than 0x{:02X}", bufferHeader.index, std::distance(data.begin(), bufferMismatch.first), *bufferMismatch.second, *bufferMismatch.first);
+            }
+
+            return {};
+        }
+
+      public:
+        size_t replayed{};
+        size_t skipped{};
+        std::vector<std::string> mismatches; //!< A description of every request that didn't match its capture
+
+        Replayer() : state{nullptr, nullptr, nullptr, std::make_shared<Logger>("", Logger::LogLevel::Warn)}, manager{state} {
+            context.tpidrroEl0 = tls.data();
+        }
+
+        ~Replayer() {
+            registries.erase(&manager);
+        }
+
+        void Replay(const CapturedRecord &record) {
+            auto &registry{registries[&manager]};
+            std::shared_ptr<service::BaseService> service;
+            if (auto it{registry.find(record.serviceName)}; it != registry.end()) {
+                service = it->second;
+            } else if (auto factory{ServiceFactories.find(record.serviceName)}; factory != ServiceFactories.end()) {
+                service = factory->second(state, manager);
+                registry[record.serviceName] = service;
+            } else {
+                skipped++;
+                skippedServices[record.serviceName]++;
+                return;
+            }
+
+            auto &arena{GetArena()};
+            arena.Reset();
+            DeviceState::ctx = &context;
+            tls = record.header.request;
+
+            // The buffer descriptors in the request are pointed at copies of the captured buffers as guest memory isn't a part of the capture
+            auto header{reinterpret_cast<ipc::CommandHeader *>(tls.data())};
+            u8 *pointer{tls.data() + sizeof(ipc::CommandHeader)};
+            if (header->handleDesc) {
+                auto handleDesc{reinterpret_cast<ipc::HandleDescriptor *>(pointer)};
+                if (handleDesc->copyCount || handleDesc->moveCount) {
+                    skipped++;
+                    skippedServices[record.serviceName]++;
+                    return;
+                }
+                pointer += sizeof(ipc::HandleDescriptor) + (handleDesc->sendPid ? sizeof(u64) : 0);
+            }
+
+            std::vector<span<u8>> inputs, outputs; // These correspond to IpcRequest::inputBuf and IpcRequest::outputBuf
+            try {
+                for (u8 index{}; index < header->xNo; index++, pointer += sizeof(ipc::BufferDescriptorX)) {
+                    auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorX *>(pointer)};
+                    if (descriptor.Pointer())
+                        SetAddress(descriptor, inputs.emplace_back(arena.Allocate(descriptor.size)));
+                }
+                for (u8 index{}; index < header->aNo; index++, pointer += sizeof(ipc::BufferDescriptorABW)) {
+                    auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorABW *>(pointer)};
+                    if (descriptor.Pointer())
+                        SetAddress(descriptor, inputs.emplace_back(arena.Allocate(descriptor.Size())));
+                }
+                for (u8 index{}; index < header->bNo; index++, pointer += sizeof(ipc::BufferDescriptorABW)) {
+                    auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorABW *>(pointer)};
+                    if (descriptor.Pointer())
+                        SetAddress(descriptor, outputs.emplace_back(arena.Allocate(descriptor.Size())));
+                }
+                for (u8 index{}; index < header->wNo; index++, pointer += sizeof(ipc::BufferDescriptorABW)) {
+                    auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorABW *>(pointer)};
+                    if (descriptor.Pointer()) {
+                        SetAddress(descriptor, outputs.emplace_back(arena.Allocate(descriptor.Size())));
+                        outputs.push_back(outputs.back()); // W buffers are inserted twice into IpcRequest::outputBuf
+                    }
+                }
+
+                auto bufCPointer{pointer + (header->rawSize * sizeof(u32))};
+                u8 cCount{header->cFlag == ipc::BufferCFlag::SingleDescriptor ? u8{1} : (header->cFlag > ipc::BufferCFlag::SingleDescriptor ? static_cast<u8>(static_cast<u8>(header->cFlag) - 2) : u8{})};
+                for (u8 index{}; index < cCount; index++, bufCPointer += sizeof(ipc::BufferDescriptorC)) {
+                    auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorC *>(bufCPointer)};
+                    if (descriptor.address)
+                        descriptor.address = reinterpret_cast<u64>(outputs.emplace_back(arena.Allocate(descriptor.size)).data());
+                }
+
+                for (const auto &[bufferHeader, data] : record.buffers)
+                    if (!bufferHeader.isOutput)
+                        inputs.at(bufferHeader.index).copy_from(data);
+            } catch (const std::exception &e) {
+                state.logger->Warn("Skipping request to {} (0x{:X}): {}", record.serviceName, record.header.commandId, e.what());
+                skipped++;
+                skippedServices[record.serviceName]++;
+                return;
+            }
+
+            ipc::IpcRequest request(record.header.isDomain, state);
+            if (!request.copyHandles.empty() || !request.moveHandles.empty() || !request.domainObjects.empty()) {
+                skipped++;
+                skippedServices[record.serviceName]++;
+                return;
+            }
+            ipc::IpcResponse response(state);
+            type::KSession session{state, service};
+            session.isDomain = record.header.isDomain;
+
+            std::string mismatch;
+            auto startNs{util::GetTimeNs()};
+            try {
+                if (!request.domain || request.domain->command == ipc::DomainCommand::SendMessage)
+                    response.errorCode = service->HandleRequest(session, request, response);
+                response.WriteResponse(record.header.isDomain);
+            } catch (const std::exception &e) {
+                mismatch = fmt::format("threw: {}", e.what());
+            }
+            auto durationNs{util::GetTimeNs() - startNs};
+
+            auto &latency{latencies[{record.serviceName, record.header.commandId}]};
+            latency.replayedNs.push_back(durationNs);
+            latency.capturedNs.push_back(record.header.durationNs);
+            replayed++;
+
+            if (mismatch.empty())
+                mismatch = Compare(record, outputs);
+            if (!mismatch.empty())
+                mismatches.push_back(fmt::format("{} 0x{:X} (Request #{}): {}", record.serviceName, record.header.commandId, replayed + skipped - 1, mismatch));
+        }
+
+        void Replay(span<const u8> capture) {
+            for (const auto &record : ParseCapture(capture))
+                Replay(record);
+        }
+
+        /**
+         * @brief Prints the latency of every command alongside the latency when it was captured and all mismatches
+         */
+        void PrintReport() {
+            fmt::print("{:<48} {:>8} {:>10} {:>10} {:>10} {:>14}\n", "Command", "Calls", "P50 (ns)", "P99 (ns)", "Max (ns)", "Captured P50");
+            for (auto &[command, latency] : latencies) {
+                auto p50{Percentile(latency.replayedNs, 50)}, p99{Percentile(latency.replayedNs, 99)}; // The samples are sorted by Percentile, the last one is the maximum
+                fmt::print("{:<48} {:>8} {:>10} {:>10} {:>10} {:>14}\n", fmt::format("{} 0x{:X}", command.first, command.second), latency.replayedNs.size(), p50, p99, latency.replayedNs.back(), Percentile(latency.capturedNs, 50));
+            }
+
+            for (const auto &[name, count] : skippedServices)
+                fmt::print("Skipped {} requests to {}\n", count, name);
+            for (const auto &mismatch : mismatches)
+                fmt::print("Mismatch: {}\n", mismatch);
+            fmt::print("Replayed {} requests with {} mismatches, skipped {} requests\n", replayed, mismatches.size(), skipped);
+        }
+    };
+
+    /**
+     * @brief Sends requests to services and captures them the same way as ServiceManager::SyncRequestHandler, this stands in for running a title in the self-test
+     */
+    class Capturer {
+      private:
+        DeviceState state;
+        service::ServiceManager manager;
+        nce::ThreadContext context{};
+        alignas(0x10) std::array<u8, constant::TlsIpcSize> tls{};
+        service::IpcCapture capture;
+
+      public:
+        Capturer(const std::string &path) : state{nullptr, nullptr, nullptr, std::make_shared<Logger>("", Logger::LogLevel::Error)}, manager{state}, capture{state, path} {
+            context.tpidrroEl0 = tls.data();
+        }
+
+        ~Capturer() {
+            registries.erase(&manager);
+        }
+
+        template<typename ServiceType>
+        std::shared_ptr<service::BaseService> MakeService() {
+            return std::make_shared<ServiceType>(state, manager);
+        }
+
+        /**
+         * @return The last service with the supplied name which was registered by another service
+         */
+        std::shared_ptr<service::BaseService> GetRegisteredService(const std::string &name) {
+            return registries.at(&manager).at(name);
+        }
+
+        /**
+         * @brief Sends a request to the service with the supplied arguments and a B buffer of each of the supplied sizes, the request is then captured
+         * @param serviceName The name the request is captured with, this overrides the name of the service if it isn't empty
+         */
+        void Request(const std::shared_ptr<service::BaseService> &service, bool isDomain, u32 commandId, span<const u8> arguments = {}, std::initializer_list<u32> outputSizes = {}, const std::string &serviceName = {}) {
+            GetArena().Reset();
+            DeviceState::ctx = &context;
+            tls = {};
+
+            auto header{reinterpret_cast<ipc::CommandHeader *>(tls.data())};
+            header->type = ipc::CommandType::Request;
+            header->bNo = static_cast<u8>(outputSizes.size());
+            u8 *pointer{tls.data() + sizeof(ipc::CommandHeader)};
+            for (auto size : outputSizes) {
+                auto &descriptor{*reinterpret_cast<ipc::BufferDescriptorABW *>(pointer)};
+                descriptor.size0_31 = size;
+                SetAddress(descriptor, GetArena().Allocate(size));
+                pointer += sizeof(ipc::BufferDescriptorABW);
+            }
+            pointer = tls.data() + util::AlignUp(static_cast<size_t>(pointer - tls.data()), constant::IpcPaddingSum);
+
+            if (isDomain) {
+                auto domain{reinterpret_cast<ipc::DomainHeaderRequest *>(pointer)};
+                domain->command = ipc::DomainCommand::SendMessage;
+                domain->payloadSz = static_cast<u16>(sizeof(ipc::PayloadHeader) + arguments.size());
+                pointer += sizeof(ipc::DomainHeaderRequest);
+            }
+
+            auto payload{reinterpret_cast<ipc::PayloadHeader *>(pointer)};
+            payload->magic = util::MakeMagic<u32>("SFCI");
+            payload->value = commandId;
+            if (!arguments.empty())
+                std::memcpy(pointer + sizeof(ipc::PayloadHeader), arguments.data(), arguments.size());
+            header->rawSize = static_cast<u32>(util::AlignUp(constant::IpcPaddingSum + (isDomain ? sizeof(ipc::DomainHeaderRequest) : 0) + sizeof(ipc::PayloadHeader) + arguments.size(), sizeof(u32)) / sizeof(u32));
+
+            auto sessionService{service};
+            type::KSession session{state, sessionService};
+            session.isDomain = isDomain;
+            ipc::IpcRequest request(isDomain, state);
+            ipc::IpcResponse response(state);
+            auto record{capture.Begin(request)};
+            record->serviceName = serviceName.empty() ? service->GetName() : serviceName;
+            response.errorCode = service->HandleRequest(session, request, response);
+            response.WriteResponse(isDomain);
+            capture.Commit(*record, request);
+        }
+    };
+
+    /**
+     * @return The path of a capture file which is unique to this process
+     */
+    std::string CapturePath() {
+        return (std::filesystem::temp_directory_path() / fmt::format("skyline_ipc_replay_{}.bin", getpid())).string();
+    }
+
+    std::vector<u8> ReadFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            throw exception("Failed to open {}", path);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    /**
+     * @brief Captures a session with every linked service which covers output buffers, state carried across requests and sub-services in domains and regular sessions
+     * @return The raw capture
+     */
+    std::vector<u8> CaptureSession(const std::function<void(Capturer &)> &extraRequests = {}) {
+        auto path{CapturePath()};
+        {
+            Capturer capturer(path);
+            auto settings{capturer.MakeService<service::settings::ISettingsServer>()};
+            capturer.Request(settings, false, 0x1, {}, {constant::OldLanguageCodeListSize * sizeof(u64)}); // GetAvailableLanguageCodes
+            std::array<i32, 1> languageIndex{2};
+            capturer.Request(settings, false, 0x2, span(languageIndex).cast<u8>()); // MakeLanguageCode
+            capturer.Request(settings, false, 0x5, {}, {0x100}); // GetAvailableLanguageCodes2
+            capturer.Request(settings, false, 0x7F); // An unimplemented command
+
+            auto systemSettings{capturer.MakeService<service::settings::ISystemSettingsServer>()};
+            capturer.Request(systemSettings, false, 0x3, {}, {0x100}); // GetFirmwareVersion
+
+            auto apm{capturer.MakeService<service::apm::IManager>()};
+            capturer.Request(apm, true, 0x0); // OpenSession
+            auto apmSession{capturer.GetRegisteredService("apm::ISession")};
+            std::array<u32, 2> configuration{1, 0x92220007};
+            capturer.Request(apmSession, true, 0x0, span(configuration).cast<u8>()); // SetPerformanceConfiguration
+            capturer.Request(apmSession, true, 0x1, span(configuration).first(1).cast<u8>()); // GetPerformanceConfiguration
+
+            auto pctl{capturer.MakeService<service::pctl::IParentalControlServiceFactory>()};
+            capturer.Request(pctl, false, 0x0); // CreateService
+            capturer.Request(capturer.GetRegisteredService("pctl::IParentalControlService"), false, 0x1); // Initialize
+
+            if (extraRequests)
+                extraRequests(capturer);
+        }
+
+        auto capture{ReadFile(path)};
+        std::filesystem::remove(path);
+        return capture;
+    }
+
+    constexpr size_t CapturedRequestCount{10}; //!< The amount of requests in CaptureSession without any extra requests
+
+    /**
+     * @brief Replaying a capture against the same services must reproduce every response and output buffer exactly
+     */
+    void RoundTrip() {
+        auto capture{CaptureSession()};
+        Replayer replayer;
+        replayer.Replay(capture);
+        EXPECT(replayer.replayed == CapturedRequestCount);
+        EXPECT(replayer.skipped == 0);
+        EXPECT(replayer.mismatches.empty());
+    }
+
+    /**
+     * @brief A response or output buffer which differs from the capture must be reported
+     */
+    void DetectsMismatch() {
+        auto capture{CaptureSession()};
+        auto records{ParseCapture(capture)};
+
+        // GetPerformanceConfiguration returns the configuration set by the prior request, it's changed in the capture to what a faulty implementation would return
+        auto &configRecord{records.at(7)};
+        EXPECT(configRecord.serviceName == "apm::ISession" && configRecord.header.commandId == 0x1);
+        constexpr size_t ConfigurationOffset{constant::IpcPaddingSum + sizeof(ipc::DomainHeaderResponse) + sizeof(ipc::PayloadHeader)}; // The command header is padded to the first 0x10 bytes
+        auto &configuration{configRecord.header.response.at(ConfigurationOffset)};
+        EXPECT(configuration == 0x07);
+        configuration = 0x08;
+
+        // GetFirmwareVersion writes the version into an output buffer
+        auto &versionRecord{records.at(4)};
+        std::vector<u8> version{versionRecord.buffers.at(0).second.begin(), versionRecord.buffers.at(0).second.end()};
+        version.at(0)++;
+        versionRecord.buffers.at(0).second = span<const u8>(version);
+
+        Replayer replayer;
+        for (const auto &record : records)
+            replayer.Replay(record);
+        EXPECT(replayer.replayed == CapturedRequestCount);
+        EXPECT(replayer.mismatches.size() == 2);
+    }
+
+    /**
+     * @brief Requests to services which aren't linked into the tool are skipped rather than failing the replay
+     */
+    void SkipsUnknownServices() {
+        auto capture{CaptureSession([](Capturer &capturer) {
+            capturer.Request(capturer.MakeService<service::pctl::IParentalControlService>(), false, 0x1, {}, {}, "fssrv::IFileSystemProxy");
+        })};
+        Replayer replayer;
+        replayer.Replay(capture);
+        EXPECT(replayer.replayed == CapturedRequestCount);
+        EXPECT(replayer.skipped == 1);
+        EXPECT(replayer.mismatches.empty());
+    }
+
+    /**
+     * @brief Replays a capture file and prints the latency of every command alongside all mismatches
+     * @return The exit status of the tool, it's non-zero if any request didn't match its capture
+     */
+    int ReplayFile(const std::string &path) {
+        try {
+            auto capture{ReadFile(path)};
+            Replayer replayer;
+            replayer.Replay(capture);
+            replayer.PrintReport();
+            return replayer.mismatches.empty() ? 0 : 1;
+        } catch (const std::exception &e) {
+            fmt::print(stderr, "Failed to replay {}: {}\n", path, e.what());
+            return 1;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    using namespace skyline::test;
+    if (argc > 1)
+        return ReplayFile(argv[1]);
+
+    return Run({
+        {"RoundTrip", RoundTrip},
+        {"DetectsMismatch", DetectsMismatch},
+        {"SkipsUnknownServices", SkipsUnknownServices},
+    });
+}
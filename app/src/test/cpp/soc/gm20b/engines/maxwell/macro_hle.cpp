@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <common/settings.h>
+#include <soc/gm20b/engines/maxwell_3d.h>
+#include <test.h>
+#include "mme.h"
+
+/*
+ * This test is only linked against the macro interpreter, JIT and HLE, the parts of the emulator they depend on are defined here
+ * The Maxwell 3D records every method call alongside the amount of batches so native implementations can be compared against interpreting the macros they replace
+ */
+namespace skyline {
+    DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings, std::shared_ptr<Logger> logger) : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)), logger(std::move(logger)) {}
+
+    Settings::Settings(int fd) {}
+
+    Logger::Logger(const std::string &path, LogLevel configLevel) : configLevel(configLevel) {}
+
+    Logger::~Logger() {}
+
+    Logger::Entry *Logger::BeginEntry(LogLevel level) {
+        return nullptr; // Deferred logs are dropped, only errors are written out
+    }
+
+    void Logger::CommitEntry() {}
+
+    void Logger::Write(LogLevel level, const std::string &str) {
+        fmt::print(stderr, "{}\n", str);
+    }
+}
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    struct MethodCall {
+        u32 method;
+        u32 argument;
+
+        bool operator==(const MethodCall &) const = default;
+    };
+
+    /**
+     * @brief The state shared between the test and the Maxwell 3D methods defined below
+     */
+    struct {
+        bool useHle; //!< If macros should be executed natively when they're known, otherwise they're always interpreted
+        bool executedNatively; //!< If the last macro was executed by the HLE
+        size_t batches; //!< The amount of calls to CallMethodBatch since this was last cleared
+        std::vector<MethodCall> calls; //!< All method calls made since this was last cleared
+        MacroHle *constructedHle; //!< The HLE of the last constructed Maxwell 3D, it's a private member so this is the only way for the test to read its counters
+    } recorder{};
+
+    Maxwell3D::Maxwell3D(const DeviceState &state) : Engine(state), macroInterpreter(*this), macroJit(state, *this), macroHle(state, *this) {
+        recorder.constructedHle = &macroHle;
+    }
+
+    void Maxwell3D::ExecuteMacro(size_t offset, span<u32> arguments) {
+        recorder.executedNatively = recorder.useHle && macroHle.Execute(static_cast<u32>(offset), arguments);
+        if (!recorder.executedNatively)
+            macroInterpreter.Execute(offset, arguments); // The JIT is skipped as it's covered by its own test and isn't supported on every host
+    }
+
+    void Maxwell3D::CallMethod(u32 method, u32 argument, bool lastCall) {
+        if (method >= RegisterCount) {
+            if (!(method & 1))
+                macroInvocation.index = ((method - RegisterCount) >> 1) % macroPositions.size();
+
+            macroInvocation.arguments.emplace_back(argument);
+            if (lastCall) {
+                auto position{macroPositions[macroInvocation.index]};
+                auto arguments{std::move(macroInvocation.arguments)};
+                macroInvocation.arguments.clear();
+                macroInvocation.index = -1;
+                ExecuteMacro(position, arguments);
+            }
+            return;
+        }
+
+        recorder.calls.push_back(MethodCall{method, argument});
+        registers.raw[method] = argument;
+
+        switch (method) {
+            case MAXWELL3D_OFFSET(mme.instructionRamLoad):
+                macroInterpreter.Invalidate(registers.mme.instructionRamPointer);
+                macroJit.Invalidate(registers.mme.instructionRamPointer);
+                macroHle.Invalidate(registers.mme.instructionRamPointer);
+                macroCode[registers.mme.instructionRamPointer++] = argument;
+                registers.mme.instructionRamPointer %= macroCode.size();
+                break;
+            case MAXWELL3D_OFFSET(mme.startAddressRamLoad):
+                macroPositions[registers.mme.startAddressRamPointer++ % macroPositions.size()] = argument;
+                break;
+            default:
+                break;
+        }
+    }
+
+    void Maxwell3D::CallMethodBatch(u32 method, span<u32> arguments, bool incrementing) {
+        recorder.batches++;
+        for (size_t index{}; index < arguments.size(); index++)
+            CallMethod(incrementing ? method + static_cast<u32>(index) : method, arguments[index], index == arguments.size() - 1);
+    }
+}
+
+namespace skyline::test {
+    using Maxwell3D = soc::gm20b::engine::maxwell3d::Maxwell3D;
+    using Registers = Maxwell3D::Registers; // Required by MAXWELL3D_OFFSET
+    using soc::gm20b::engine::maxwell3d::MacroHle;
+    using soc::gm20b::engine::maxwell3d::MethodCall;
+    using soc::gm20b::engine::maxwell3d::recorder;
+
+    /**
+     * @brief The observable effects of executing a macro
+     */
+    struct MacroResult {
+        std::vector<MethodCall> calls;
+        std::array<u32, Maxwell3D::RegisterCount> registers;
+        bool executedNatively;
+        size_t batches;
+    };
+
+    /**
+     * @brief A Maxwell 3D with macro memory uploaded through methods, as a guest would do it
+     */
+    class TestEngine {
+      private:
+        std::shared_ptr<Settings> settings;
+        DeviceState state;
+
+      public:
+        std::unique_ptr<Maxwell3D> maxwell3D;
+        MacroHle *macroHle;
+
+        TestEngine() : settings{std::make_shared<Settings>(-1)}, state{nullptr, nullptr, settings, std::make_shared<Logger>("", Logger::LogLevel::Warn)}, maxwell3D{std::make_unique<Maxwell3D>(state)}, macroHle{recorder.constructedHle} {}
+
+        void Upload(u32 offset, span<const u32> code) {
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamPointer), offset, true);
+            for (u32 word : code)
+                maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamLoad), word, true);
+        }
+
+        void SetPosition(u32 index, u32 offset) {
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamPointer), index, true);
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamLoad), offset, true);
+        }
+
+        MacroResult Call(u32 index, span<const u32> arguments, bool useHle) {
+            recorder.useHle = useHle;
+            recorder.executedNatively = false;
+            recorder.batches = 0;
+            recorder.calls.clear();
+
+            u32 method{Maxwell3D::RegisterCount + (index * 2)};
+            for (size_t argument{}; argument < arguments.size(); argument++)
+                maxwell3D->CallMethod(argument ? method + 1 : method, arguments[argument], argument == arguments.size() - 1);
+
+            return MacroResult{recorder.calls, maxwell3D->registers.raw, recorder.executedNatively, recorder.batches};
+        }
+    };
+
+    constexpr u64 BindConstantBufferHash{MacroHle::HashMacro(MacroHle::BindConstantBufferMacro)};
+
+    /**
+     * @brief The constant buffer bind macro must be encoded as its comments describe, this assembles the same macro from the instructions in them
+     */
+    void BindConstantBufferEncoding() {
+        using namespace mme;
+        std::array code{
+            Bitfield(Operation::BitfieldReplace, Assignment::Move, 2, 0, 1, 0, 3, 3),
+            AddImmediate(Assignment::MoveAndSetMethodThenFetchAndSend, 0, 0, Method(MAXWELL3D_OFFSET(constantBufferSelector.size))),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AddImmediate(Assignment::FetchAndSend, 4, 3, 0),
+            AddImmediate(Assignment::FetchAndSend, 5, 4, 0),
+            Exit(AddImmediate(Assignment::MoveAndSetMethod, 0, 2, Method(MAXWELL3D_OFFSET(bindGroups) + U32_OFFSET(Registers::BindGroup, constantBuffer), 0))),
+            AddImmediate(Assignment::MoveAndSend, 0, 5, 0),
+        };
+        EXPECT(code == MacroHle::BindConstantBufferMacro);
+    }
+
+    /**
+     * @brief Binds random constant buffers natively and through the interpreter, the registers and every method call must match while the native bind only takes two batches
+     * @note Stages past the last bind group are included as the macro doesn't bound-check them either
+     */
+    void BindConstantBuffer() {
+        constexpr u32 MacroOffset{0x40}, Iterations{256};
+        std::mt19937 random{0x434F4E53};
+        TestEngine native, interpreted;
+        for (auto engine : {&native, &interpreted}) {
+            engine->Upload(MacroOffset, MacroHle::BindConstantBufferMacro);
+            engine->SetPosition(3, MacroOffset);
+        }
+
+        for (u32 iteration{}; iteration < Iterations; iteration++) {
+            std::array<u32, 5> arguments{iteration % 8, static_cast<u32>(random() & 0x10000), static_cast<u32>(random() & 0xFF), static_cast<u32>(random()), static_cast<u32>((random() & 0x1F) << 4) | (iteration % 3 != 0)};
+            auto nativeResult{native.Call(3, arguments, true)}, interpretedResult{interpreted.Call(3, arguments, false)};
+
+            EXPECT(nativeResult.executedNatively && !interpretedResult.executedNatively);
+            EXPECT(nativeResult.batches == 2);
+            EXPECT(nativeResult.calls == interpretedResult.calls);
+            EXPECT(nativeResult.registers == interpretedResult.registers);
+        }
+
+        auto counters{native.macroHle->GetCounters(BindConstantBufferHash)};
+        EXPECT(counters.hits == Iterations && counters.misses == 0);
+    }
+
+    /**
+     * @brief Macros without a native implementation and calls with an unexpected amount of arguments must fall through to emulation and be counted as misses
+     */
+    void FallThrough() {
+        using namespace mme;
+        std::array unknown{
+            AddImmediate(Assignment::MoveAndSetMethod, 0, 0, Method(0x200)),
+            Exit(AluRegister(Alu::Add, Assignment::MoveAndSend, 2, 1, 1)),
+            AddImmediate(Assignment::Move, 0, 0, 0),
+        };
+
+        TestEngine engine;
+        engine.Upload(0, MacroHle::BindConstantBufferMacro);
+        engine.Upload(0x10, unknown);
+        engine.SetPosition(0, 0);
+        engine.SetPosition(1, 0x10);
+
+        auto result{engine.Call(1, std::array<u32, 1>{21}, true)};
+        EXPECT(!result.executedNatively);
+        EXPECT((result.calls == std::vector{MethodCall{0x200, 42}}));
+
+        // The bind macro with a trailing argument is still interpreted correctly, the interpreter simply ignores it
+        result = engine.Call(0, std::array<u32, 6>{1, 0x100, 0x1, 0x2000, 0x11, 0xDEAD}, true);
+        EXPECT(!result.executedNatively);
+        EXPECT(engine.maxwell3D->registers.bindGroups[1].constantBuffer.index == 1 && engine.maxwell3D->registers.bindGroups[1].constantBuffer.valid);
+
+        auto unknownCounters{engine.macroHle->GetCounters(MacroHle::HashMacro(unknown))}, bindCounters{engine.macroHle->GetCounters(BindConstantBufferHash)};
+        EXPECT(unknownCounters.hits == 0 && unknownCounters.misses == 1);
+        EXPECT(bindCounters.hits == 0 && bindCounters.misses == 1);
+    }
+
+    /**
+     * @brief Rewriting any word of a known macro must stop it from being executed natively, restoring the word must make it native again
+     */
+    void Invalidation() {
+        using namespace mme;
+        constexpr u32 MacroOffset{0x1FFC}; // The macro wraps around the end of macro memory
+        std::array<u32, 5> arguments{2, 0x400, 0x1, 0x8000, 0x31};
+        TestEngine engine;
+        engine.Upload(MacroOffset, MacroHle::BindConstantBufferMacro);
+        engine.SetPosition(0, MacroOffset);
+        EXPECT(engine.Call(0, arguments, true).executedNatively);
+
+        // A write past the end of the macro doesn't affect it
+        engine.Upload((MacroOffset + static_cast<u32>(MacroHle::BindConstantBufferMacro.size())) % 0x2000, std::array<u32, 1>{AddImmediate(Assignment::Move, 1, 1, 1)});
+        EXPECT(engine.Call(0, arguments, true).executedNatively);
+
+        // The delay slot of the exit is a part of the macro, it's modified to send the bind configuration plus one
+        std::array<u32, 1> patched{AddImmediate(Assignment::MoveAndSend, 0, 5, 1)};
+        engine.Upload((MacroOffset + 6) % 0x2000, patched);
+        auto result{engine.Call(0, arguments, true)};
+        EXPECT(!result.executedNatively);
+        EXPECT(engine.maxwell3D->registers.bindGroups[2].constantBuffer.raw == arguments[4] + 1);
+
+        engine.Upload((MacroOffset + 6) % 0x2000, std::array<u32, 1>{MacroHle::BindConstantBufferMacro.back()});
+        result = engine.Call(0, arguments, true);
+        EXPECT(result.executedNatively);
+        EXPECT(engine.maxwell3D->registers.bindGroups[2].constantBuffer.raw == arguments[4]);
+
+        auto counters{engine.macroHle->GetCounters(BindConstantBufferHash)};
+        EXPECT(counters.hits == 3 && counters.misses == 0);
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"BindConstantBufferEncoding", BindConstantBufferEncoding},
+        {"BindConstantBuffer", BindConstantBuffer},
+        {"FallThrough", FallThrough},
+        {"Invalidation", Invalidation},
+    });
+}
@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/settings.h>
+#include <soc/gm20b/engines/maxwell_3d.h>
+#include <test.h>
+#include "mme.h"
+
+/*
+ * This test is only linked against the macro interpreter, JIT and HLE, the parts of the emulator they depend on are defined here
+ * Rather than emulating methods, the Maxwell 3D records every method call so the effects of a macro can be compared between the interpreter and the JIT
+ */
+namespace skyline {
+    DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings, std::shared_ptr<Logger> logger) : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)), logger(std::move(logger)) {}
+
+    Settings::Settings(int fd) {}
+
+    Logger::Logger(const std::string &path, LogLevel configLevel) : configLevel(configLevel) {}
+
+    Logger::~Logger() {}
+
+    Logger::Entry *Logger::BeginEntry(LogLevel level) {
+        return nullptr; // Deferred logs are dropped, only errors are written out
+    }
+
+    void Logger::CommitEntry() {}
+
+    void Logger::Write(LogLevel level, const std::string &str) {
+        fmt::print(stderr, "{}\n", str);
+    }
+}
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    struct MethodCall {
+        u32 method;
+        u32 argument;
+
+        bool operator==(const MethodCall &) const = default;
+    };
+
+    /**
+     * @brief The state shared between the test and the Maxwell 3D methods defined below
+     */
+    struct {
+        bool useJit; //!< If macros should be executed with the JIT rather than the interpreter
+        bool jitFallback; //!< If the JIT couldn't compile a macro and it was interpreted instead
+        bool macroMethods; //!< If macro memory uploads and macro calls made by macros should be emulated, otherwise they're only recorded
+        u32 depth; //!< The amount of macros that are currently executing
+        std::vector<MethodCall> calls; //!< All method calls made since this was last cleared
+    } recorder{};
+
+    Maxwell3D::Maxwell3D(const DeviceState &state) : Engine(state), macroInterpreter(*this), macroJit(state, *this), macroHle(state, *this) {}
+
+    void Maxwell3D::ExecuteMacro(size_t offset, span<u32> arguments) {
+        recorder.depth++;
+        if (!recorder.useJit || !macroJit.Execute(static_cast<u32>(offset), arguments)) {
+            recorder.jitFallback |= recorder.useJit;
+            macroInterpreter.Execute(offset, arguments);
+        }
+        recorder.depth--;
+    }
+
+    void Maxwell3D::CallMethod(u32 method, u32 argument, bool lastCall) {
+        recorder.calls.push_back(MethodCall{method, argument});
+        bool emulate{!recorder.depth || recorder.macroMethods};
+
+        if (method >= RegisterCount) {
+            if (!emulate)
+                return;
+
+            if (!(method & 1)) {
+                if (macroInvocation.index != -1) {
+                    auto arguments{std::move(macroInvocation.arguments)};
+                    macroInvocation.arguments.clear();
+                    ExecuteMacro(macroPositions[macroInvocation.index], arguments);
+                }
+                macroInvocation.index = ((method - RegisterCount) >> 1) % macroPositions.size();
+            }
+
+            macroInvocation.arguments.emplace_back(argument);
+            if (lastCall && macroInvocation.index != -1) {
+                auto arguments{std::move(macroInvocation.arguments)};
+                auto position{macroPositions[macroInvocation.index]};
+                macroInvocation.arguments.clear();
+                macroInvocation.index = -1;
+                ExecuteMacro(position, arguments);
+            }
+            return;
+        }
+
+        registers.raw[method] = argument;
+        if (!emulate)
+            return;
+
+        switch (method) {
+            case MAXWELL3D_OFFSET(mme.instructionRamLoad):
+                macroInterpreter.Invalidate(registers.mme.instructionRamPointer);
+                macroJit.Invalidate(registers.mme.instructionRamPointer);
+                macroHle.Invalidate(registers.mme.instructionRamPointer);
+                macroCode[registers.mme.instructionRamPointer++] = argument;
+                registers.mme.instructionRamPointer %= macroCode.size();
+                break;
+            case MAXWELL3D_OFFSET(mme.startAddressRamLoad):
+                macroPositions[registers.mme.startAddressRamPointer++ % macroPositions.size()] = argument;
+                break;
+            default:
+                break;
+        }
+    }
+
+    void Maxwell3D::CallMethodBatch(u32 method, span<u32> arguments, bool incrementing) {
+        for (size_t index{}; index < arguments.size(); index++)
+            CallMethod(incrementing ? method + static_cast<u32>(index) : method, arguments[index], index == arguments.size() - 1);
+    }
+}
+
+namespace skyline::test {
+    using Maxwell3D = soc::gm20b::engine::maxwell3d::Maxwell3D;
+    using Registers = Maxwell3D::Registers; // Required by MAXWELL3D_OFFSET
+    using soc::gm20b::engine::maxwell3d::MethodCall;
+    using soc::gm20b::engine::maxwell3d::recorder;
+
+    /**
+     * @brief The observable effects of executing a macro
+     */
+    struct MacroResult {
+        std::vector<MethodCall> calls;
+        std::array<u32, Maxwell3D::RegisterCount> registers;
+        bool jitFallback;
+    };
+
+    /**
+     * @brief A Maxwell 3D with macro memory uploaded through methods, as a guest would do it
+     */
+    class TestEngine {
+      private:
+        std::shared_ptr<Settings> settings;
+        DeviceState state;
+
+      public:
+        std::unique_ptr<Maxwell3D> maxwell3D;
+
+        TestEngine() : settings{std::make_shared<Settings>(-1)}, state{nullptr, nullptr, settings, std::make_shared<Logger>("", Logger::LogLevel::Warn)} {
+            settings->macroJit = true;
+            maxwell3D = std::make_unique<Maxwell3D>(state);
+        }
+
+        void Upload(u32 offset, span<const u32> code) {
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamPointer), offset, true);
+            for (u32 word : code)
+                maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamLoad), word, true);
+        }
+
+        void SetPosition(u32 index, u32 offset) {
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamPointer), index, true);
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamLoad), offset, true);
+        }
+
+        MacroResult Call(u32 index, span<const u32> arguments, bool useJit, bool macroMethods) {
+            recorder.useJit = useJit;
+            recorder.jitFallback = false;
+            recorder.macroMethods = macroMethods;
+            recorder.calls.clear();
+
+            u32 method{Maxwell3D::RegisterCount + (index * 2)};
+            for (size_t argument{}; argument < arguments.size(); argument++)
+                maxwell3D->CallMethod(argument ? method + 1 : method, arguments[argument], argument == arguments.size() - 1);
+
+            return MacroResult{recorder.calls, maxwell3D->registers.raw, recorder.jitFallback};
+        }
+    };
+
+    /**
+     * @brief Runs a macro on two identical engines with the interpreter and the JIT, checking that the method calls and registers match
+     * @return If the JIT compiled the macro, it's always interpreted otherwise
+     */
+    bool CompareMacro(span<const u32> code, span<const u32> arguments, const std::array<u32, Maxwell3D::RegisterCount> &initialRegisters, bool macroMethods = false) {
+        auto run{[&](bool useJit) {
+            TestEngine engine;
+            engine.maxwell3D->registers.raw = initialRegisters;
+            engine.Upload(0, code);
+            engine.SetPosition(0, 0);
+            return engine.Call(0, arguments, useJit, macroMethods);
+        }};
+
+        auto interpreted{run(false)}, compiled{run(true)};
+        if (compiled.jitFallback)
+            return false;
+
+        auto mismatch{std::mismatch(interpreted.calls.begin(), interpreted.calls.end(), compiled.calls.begin(), compiled.calls.end())};
+        if (mismatch.first != interpreted.calls.end() || mismatch.second != compiled.calls.end()) {
+            auto index{std::distance(interpreted.calls.begin(), mismatch.first)};
+            auto format{[](auto it, auto end) { return it != end ? fmt::format("0x{:X} = 0x{:X}", it->method, it->argument) : std::string{"none"}; }};
+            throw exception("Method call #{} differs: interpreter {}, JIT {}", index, format(mismatch.first, interpreted.calls.end()), format(mismatch.second, compiled.calls.end()));
+        }
+
+        for (size_t index{}; index < interpreted.registers.size(); index++)
+            if (interpreted.registers[index] != compiled.registers[index])
+                throw exception("Register 0x{:X} differs: interpreter 0x{:X}, JIT 0x{:X}", index, interpreted.registers[index], compiled.registers[index]);
+
+        return true;
+    }
+
+    std::array<u32, Maxwell3D::RegisterCount> RandomRegisters(std::mt19937 &random) {
+        std::array<u32, Maxwell3D::RegisterCount> registers;
+        for (auto &reg : registers)
+            reg = static_cast<u32>(random());
+        return registers;
+    }
+
+    /**
+     * @brief A loop which sends a variable amount of arguments to incrementing methods, similar to the multi-draw macros used by titles
+     */
+    void LoopMacro() {
+        using namespace mme;
+        std::array code{
+            AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(0x200)),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AluRegister(Alu::Add, Assignment::MoveAndSend, 4, 3, 1),
+            AddImmediate(Assignment::Move, 1, 1, -1),
+            Branch(false, false, 1, -3),
+            AluRegister(Alu::AddWithCarry, Assignment::Move, 5, 5, 4), // Delay slot
+            ReadImmediate(Assignment::Move, 6, 0, 0x201), // A read after sends requires any batched sends to be flushed first
+            AddImmediate(Assignment::MoveAndSetMethod, 7, 0, Method(0x300, 0)),
+            Exit(AluRegister(Alu::BitwiseXor, Assignment::MoveAndSend, 7, 5, 6)),
+            AddImmediate(Assignment::MoveAndSend, 7, 6, 1), // Delay slot
+        };
+
+        std::mt19937 random{0x4D4D45};
+        for (u32 count{1}; count < 64; count++) {
+            std::vector<u32> arguments{count};
+            for (u32 argument{}; argument < count; argument++)
+                arguments.push_back(static_cast<u32>(random()));
+            EXPECT(CompareMacro(code, arguments, RandomRegisters(random)));
+        }
+    }
+
+    /**
+     * @brief Covers every assignment operation, ALU operation and bitfield operation with edge-case values
+     */
+    void OperationMacro() {
+        using namespace mme;
+        std::vector<u32> code;
+        code.push_back(AddImmediate(Assignment::FetchAndSetMethod, 2, 0, Method(0x100)));
+        for (u32 assignment{}; assignment < 8; assignment++)
+            for (u32 alu : {0U, 1U, 2U, 3U, 8U, 9U, 10U, 11U, 12U})
+                code.push_back(AluRegister(static_cast<Alu>(alu), static_cast<Assignment>(assignment), 1 + (alu % 7), 2 + (assignment % 6), 1 + ((alu + assignment) % 7)));
+        for (auto operation : {Operation::BitfieldReplace, Operation::BitfieldExtractShiftLeftImmediate, Operation::BitfieldExtractShiftLeftRegister})
+            for (u32 size : {1U, 5U, 16U, 31U})
+                code.push_back(Bitfield(operation, Assignment::MoveAndSend, 3, 4, 5, (size * 7) % 32, size, (size * 3) % 32));
+        code.push_back(AddImmediate(Assignment::MoveAndSetMethodThenFetchAndSend, 6, 0, Method(0x180, 2)));
+        code.push_back(AddImmediate(Assignment::MoveAndSetMethodThenSendHigh, 6, 0, Method(0x190, 3)));
+        code.push_back(Exit(AddImmediate(Assignment::MoveAndSend, 7, 6, 0)));
+        code.push_back(AddImmediate(Assignment::Move, 7, 7, 1));
+
+        std::mt19937 random{0x414C55};
+        for (u32 iteration{}; iteration < 64; iteration++) {
+            std::vector<u32> arguments(256);
+            for (auto &argument : arguments)
+                argument = iteration % 4 == 0 ? std::array<u32, 4>{0, 1, 0xFFFFFFFF, 0x80000000}[random() % 4] : static_cast<u32>(random());
+            EXPECT(CompareMacro(code, arguments, RandomRegisters(random)));
+        }
+    }
+
+    /**
+     * @brief Generates random terminating macros from all supported instructions, branches only go forward so every macro exits
+     */
+    void RandomMacros() {
+        using namespace mme;
+        std::mt19937 random{0x52414E44};
+        size_t compiledCount{};
+        constexpr size_t MacroCount{5000};
+        for (size_t macro{}; macro < MacroCount; macro++) {
+            auto length{static_cast<u32>(4 + (random() % 60))};
+            std::vector<u32> code(length);
+            auto randomReg{[&]() { return static_cast<u32>(random() % 8); }};
+            auto randomOperation{[&]() -> u32 {
+                auto assignment{static_cast<Assignment>(random() % 8)};
+                switch (random() % 6) {
+                    case 0:
+                        return AluRegister(std::array{Alu::Add, Alu::AddWithCarry, Alu::Subtract, Alu::SubtractWithBorrow, Alu::BitwiseXor, Alu::BitwiseOr, Alu::BitwiseAnd, Alu::BitwiseAndNot, Alu::BitwiseNand}[random() % 9], assignment, randomReg(), randomReg(), randomReg());
+                    case 1:
+                        return AddImmediate(assignment, randomReg(), randomReg(), static_cast<i32>(random() % 0x40000) - 0x20000);
+                    case 2:
+                        return ReadImmediate(assignment, randomReg(), 0, static_cast<i32>(random() % Maxwell3D::RegisterCount)); // Reads are relative to register 0 so they're always in bounds
+                    default:
+                        return Bitfield(std::array{Operation::BitfieldReplace, Operation::BitfieldExtractShiftLeftImmediate, Operation::BitfieldExtractShiftLeftRegister}[random() % 3], assignment, randomReg(), randomReg(), randomReg(), static_cast<u32>(random() % 32), static_cast<u32>(random() % 32), static_cast<u32>(random() % 32));
+                }
+            }};
+
+            for (u32 pc{}; pc < length; pc++) {
+                bool afterBranch{pc && (code[pc - 1] & 7) == static_cast<u32>(Operation::Branch)};
+                if (!afterBranch && pc + 4 < length && random() % 5 == 0) {
+                    auto target{pc + 2 + static_cast<u32>(random() % (length - 2 - (pc + 2)))};
+                    code[pc] = Branch(random() % 2, random() % 2, randomReg(), static_cast<i32>(target - pc));
+                } else {
+                    code[pc] = randomOperation();
+                }
+            }
+            code[length - 2] = Exit(randomOperation());
+            code[length - 1] = randomOperation();
+
+            std::vector<u32> arguments(length + 1);
+            for (auto &argument : arguments)
+                argument = static_cast<u32>(random());
+            compiledCount += CompareMacro(code, arguments, RandomRegisters(random));
+        }
+
+        EXPECT(compiledCount == MacroCount); // Every instruction in the generated macros is supported by the JIT
+    }
+
+    /**
+     * @brief A macro calling another macro through a macro method, the nested macro is re-uploaded by the outer one prior to being called
+     * @note This requires the JIT to not reuse the code region of the outer macro while it's still executing
+     */
+    void NestedMacros() {
+        using namespace mme;
+        constexpr u32 InnerOffset{0x100};
+        auto inner{[](i32 value) {
+            return std::array{
+                AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(0x400)),
+                Exit(AddImmediate(Assignment::MoveAndSend, 3, 1, value)),
+                AddImmediate(Assignment::MoveAndSend, 3, 3, value),
+            };
+        }};
+
+        // The outer macro uploads its arguments as the code of the inner macro and then calls it
+        std::array outer{
+            AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(MAXWELL3D_OFFSET(mme.instructionRamPointer), 0)),
+            AddImmediate(Assignment::MoveAndSend, 3, 0, InnerOffset),
+            AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(MAXWELL3D_OFFSET(mme.instructionRamLoad), 0)),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AddImmediate(Assignment::MoveAndSend, 3, 3, 0),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AddImmediate(Assignment::MoveAndSend, 3, 3, 0),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AddImmediate(Assignment::MoveAndSend, 3, 3, 0),
+            AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(Maxwell3D::RegisterCount + 2, 0)),
+            AluRegister(Alu::Add, Assignment::MoveAndSend, 4, 1, 0),
+            Exit(AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(0x500))),
+            AluRegister(Alu::Add, Assignment::MoveAndSend, 4, 4, 4),
+        };
+
+        auto run{[&](bool useJit) {
+            TestEngine engine;
+            engine.Upload(0, outer);
+            engine.Upload(InnerOffset, inner(1));
+            engine.SetPosition(0, 0);
+            engine.SetPosition(1, InnerOffset);
+
+            std::vector<MacroResult> results;
+            for (i32 value{}; value < 4; value++) {
+                auto code{inner(value)};
+                results.push_back(engine.Call(1, std::array<u32, 1>{static_cast<u32>(value)}, useJit, true)); // The inner macro is compiled before it's rewritten
+                results.push_back(engine.Call(0, std::array<u32, 4>{static_cast<u32>(value) + 10, code[0], code[1], code[2]}, useJit, true));
+            }
+            return results;
+        }};
+
+        auto interpreted{run(false)}, compiled{run(true)};
+        EXPECT(interpreted.size() == compiled.size());
+        for (size_t index{}; index < interpreted.size(); index++) {
+            EXPECT(!compiled[index].jitFallback);
+            EXPECT(interpreted[index].calls == compiled[index].calls);
+            EXPECT(interpreted[index].registers == compiled[index].registers);
+        }
+    }
+
+    /**
+     * @return If the JIT can execute macros on this host, it's only supported on AArch64
+     */
+    bool IsJitSupported() {
+        std::array code{mme::Exit(mme::AddImmediate(mme::Assignment::Move, 1, 1, 0)), mme::AddImmediate(mme::Assignment::Move, 1, 1, 0)};
+        TestEngine engine;
+        engine.Upload(0, code);
+        engine.SetPosition(0, 0);
+        return !engine.Call(0, std::array<u32, 1>{}, true, false).jitFallback;
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    if (!IsJitSupported()) {
+        fmt::print("The macro JIT isn't supported on this host, skipping\n");
+        return SkipExitCode;
+    }
+
+    return Run({
+        {"LoopMacro", LoopMacro},
+        {"OperationMacro", OperationMacro},
+        {"RandomMacros", RandomMacros},
+        {"NestedMacros", NestedMacros},
+    });
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::test {
+    /**
+     * @brief An assembler for macro instructions, the encoding matches MacroInterpreter::Opcode
+     */
+    namespace mme {
+        enum class Operation : u32 {
+            AluRegister = 0,
+            AddImmediate = 1,
+            BitfieldReplace = 2,
+            BitfieldExtractShiftLeftImmediate = 3,
+            BitfieldExtractShiftLeftRegister = 4,
+            ReadImmediate = 5,
+            Branch = 7,
+        };
+
+        enum class Assignment : u32 {
+            IgnoreAndFetch = 0,
+            Move = 1,
+            MoveAndSetMethod = 2,
+            FetchAndSend = 3,
+            MoveAndSend = 4,
+            FetchAndSetMethod = 5,
+            MoveAndSetMethodThenFetchAndSend = 6,
+            MoveAndSetMethodThenSendHigh = 7,
+        };
+
+        enum class Alu : u32 {
+            Add = 0,
+            AddWithCarry = 1,
+            Subtract = 2,
+            SubtractWithBorrow = 3,
+            BitwiseXor = 8,
+            BitwiseOr = 9,
+            BitwiseAnd = 10,
+            BitwiseAndNot = 11,
+            BitwiseNand = 12,
+        };
+
+        constexpr u32 Encode(Operation operation, Assignment assignment, u32 dest, u32 srcA, u32 srcB = 0) {
+            return static_cast<u32>(operation) | (static_cast<u32>(assignment) << 4) | (dest << 8) | (srcA << 11) | (srcB << 14);
+        }
+
+        constexpr u32 AluRegister(Alu alu, Assignment assignment, u32 dest, u32 srcA, u32 srcB) {
+            return Encode(Operation::AluRegister, assignment, dest, srcA, srcB) | (static_cast<u32>(alu) << 17);
+        }
+
+        constexpr u32 AddImmediate(Assignment assignment, u32 dest, u32 srcA, i32 immediate) {
+            return Encode(Operation::AddImmediate, assignment, dest, srcA) | ((static_cast<u32>(immediate) & 0x3FFFF) << 14);
+        }
+
+        constexpr u32 ReadImmediate(Assignment assignment, u32 dest, u32 srcA, i32 immediate) {
+            return Encode(Operation::ReadImmediate, assignment, dest, srcA) | ((static_cast<u32>(immediate) & 0x3FFFF) << 14);
+        }
+
+        constexpr u32 Bitfield(Operation operation, Assignment assignment, u32 dest, u32 srcA, u32 srcB, u32 srcBit, u32 size, u32 destBit) {
+            return Encode(operation, assignment, dest, srcA, srcB) | (srcBit << 17) | (size << 22) | (destBit << 27);
+        }
+
+        /**
+         * @param ifZero If the branch is taken when the register is zero, otherwise it's taken when it's non-zero
+         */
+        constexpr u32 Branch(bool ifZero, bool noDelay, u32 srcA, i32 offset) {
+            return static_cast<u32>(Operation::Branch) | (ifZero ? 0 : (1U << 4)) | (noDelay ? (1U << 5) : 0) | (srcA << 11) | ((static_cast<u32>(offset) & 0x3FFFF) << 14);
+        }
+
+        constexpr u32 Exit(u32 instruction) {
+            return instruction | (1U << 7);
+        }
+
+        /**
+         * @return A method address for the method registers with the supplied increment applied after every send
+         */
+        constexpr i32 Method(u32 method, u32 increment = 1) {
+            return static_cast<i32>(method | (increment << 12));
+        }
+    }
+}
@@ -0,0 +1,592 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <thread>
+#include <common/settings.h>
+#include <soc.h>
+#include <test.h>
+#include "maxwell/mme.h"
+
+/*
+ * This test is linked against the Maxwell 3D alongside its macro interpreter, JIT and HLE, the GMMU and the host1x syncpoints, the parts of the emulator they depend on are defined here
+ * Pushbuffers are decoded with the same code as GPFIFO so batched method calls can be compared against calling every method individually, channels are replayed on their own threads as GPFIFO does it
+ */
+namespace skyline {
+    DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings, std::shared_ptr<Logger> logger) : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)), logger(std::move(logger)) {}
+
+    Settings::Settings(int fd) {}
+
+    Logger::Logger(const std::string &path, LogLevel configLevel) : configLevel(configLevel) {}
+
+    Logger::~Logger() {}
+
+    Logger::Entry *Logger::BeginEntry(LogLevel level) {
+        return nullptr; // Deferred logs are dropped, only errors are written out
+    }
+
+    void Logger::CommitEntry() {}
+
+    void Logger::Write(LogLevel level, const std::string &str) {
+        fmt::print(stderr, "{}\n", str);
+    }
+}
+
+namespace skyline::test {
+    using Maxwell3D = soc::gm20b::engine::maxwell3d::Maxwell3D;
+    using Registers = Maxwell3D::Registers; // Required by MAXWELL3D_OFFSET
+    using SecOp = soc::gm20b::PushBufferMethodHeader::SecOp;
+    using soc::gm20b::engine::maxwell3d::MacroHle;
+
+    constexpr u64 SemaphoreAddress{0x10000}; //!< The GPU VA of the memory which semaphores are written to, VA 0 can't be mapped
+    constexpr u64 SemaphoreSize{0x10000};
+    constexpr u32 BindMacroIndex{0}, LoopMacroIndex{1};
+    constexpr u32 BindMacroOffset{0}, LoopMacroOffset{8};
+    constexpr u32 ScratchPositions{0x40}; //!< Macro positions at or past this index may be written to by pushbuffers, the ones below it always refer to the uploaded macros
+    constexpr u32 ScratchCode{0x1000}; //!< Macro code at or past this offset may be written to by pushbuffers
+
+    /**
+     * @brief Writes 'count' arguments to incrementing registers starting at 0x200 with r1 added to them, then writes the XOR of their sum and register 0x201 to 0x300
+     * @note This reads a register after its sends so the order of writes from the pushbuffer and from the macro is observable
+     */
+    constexpr std::array LoopMacro{[] {
+        using namespace mme;
+        return std::array{
+            AddImmediate(Assignment::MoveAndSetMethod, 2, 0, Method(0x200)),
+            AddImmediate(Assignment::IgnoreAndFetch, 3, 0, 0),
+            AluRegister(Alu::Add, Assignment::MoveAndSend, 4, 3, 1),
+            AddImmediate(Assignment::Move, 1, 1, -1),
+            Branch(false, false, 1, -3),
+            AluRegister(Alu::AddWithCarry, Assignment::Move, 5, 5, 4), // Delay slot
+            ReadImmediate(Assignment::Move, 6, 0, 0x201),
+            AddImmediate(Assignment::MoveAndSetMethod, 7, 0, Method(0x300, 0)),
+            Exit(AluRegister(Alu::BitwiseXor, Assignment::MoveAndSend, 7, 5, 6)),
+            AddImmediate(Assignment::MoveAndSend, 7, 6, 1), // Delay slot
+        };
+    }()};
+
+    /**
+     * @return The encoded header of a pushbuffer method
+     * @param countOrData The amount of arguments following the header or the data of an immediate method
+     */
+    constexpr u32 MethodHeader(SecOp secOp, u32 method, u32 countOrData) {
+        return method | (countOrData << 16) | (static_cast<u32>(secOp) << 29); // Only subchannel 0 is used as the 3D engine is bound to it
+    }
+
+    /**
+     * @return A semaphore operation which writes a single word, four word results aren't used as their timestamp would differ between channels
+     */
+    u32 SemaphoreInfo(Registers::SemaphoreInfo::Op op) {
+        Registers::SemaphoreInfo info{};
+        info.op = op;
+        info.counterType = Registers::SemaphoreInfo::CounterType::Zero;
+        info.structureSize = Registers::SemaphoreInfo::StructureSize::OneWord;
+        return std::bit_cast<u32>(info);
+    }
+
+    /**
+     * @brief A Maxwell 3D with its own SOC for syncpoints and the GMMU, the macros are uploaded through methods as a guest would do it
+     */
+    class Channel {
+      private:
+        std::shared_ptr<Settings> settings;
+        DeviceState state;
+
+      public:
+        std::vector<u8> semaphoreMemory;
+        std::unique_ptr<Maxwell3D> maxwell3D;
+
+        Channel() : settings{std::make_shared<Settings>(-1)}, state{nullptr, nullptr, settings, std::make_shared<Logger>("", Logger::LogLevel::Error)}, semaphoreMemory(SemaphoreSize) {
+            settings->macroJit = true; // The JIT is only used on AArch64 hosts, macros are interpreted on all others
+            state.soc = std::make_shared<soc::SOC>(state);
+            state.soc->gm20b.gmmu.Map(SemaphoreAddress, semaphoreMemory.data(), SemaphoreSize);
+            maxwell3D = std::make_unique<Maxwell3D>(state);
+
+            auto upload{[&](u32 index, u32 offset, span<const u32> code) {
+                maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamPointer), offset, true);
+                for (u32 word : code)
+                    maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.instructionRamLoad), word, true);
+                maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamPointer), index, true);
+                maxwell3D->CallMethod(MAXWELL3D_OFFSET(mme.startAddressRamLoad), offset, true);
+            }};
+            upload(BindMacroIndex, BindMacroOffset, MacroHle::BindConstantBufferMacro);
+            upload(LoopMacroIndex, LoopMacroOffset, LoopMacro);
+
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(semaphore.address.high), static_cast<u32>(SemaphoreAddress >> 32), true);
+            maxwell3D->CallMethod(MAXWELL3D_OFFSET(semaphore.address.low), static_cast<u32>(SemaphoreAddress), true);
+        }
+
+        u32 Syncpoint(u32 id) {
+            return state.soc->host1x.syncpoints.at(id).Load();
+        }
+
+        span<u32> Semaphores() {
+            return span<u8>(semaphoreMemory).cast<u32>();
+        }
+
+        /**
+         * @brief Decodes a pushbuffer into the 3D engine the way GPFIFO does
+         * @param batched If runs of arguments are sent with CallMethodBatch, otherwise every argument is sent with its own CallMethod
+         */
+        void Dispatch(span<u32> pushBuffer, bool batched) {
+            soc::gm20b::DecodePushBuffer(pushBuffer, [&](u32 method, u32 argument, u32, bool lastCall) {
+                maxwell3D->CallMethod(method, argument, lastCall);
+            }, [&](u32 method, span<u32> arguments, u32, bool incrementing) {
+                if (batched) {
+                    maxwell3D->CallMethodBatch(method, arguments, incrementing);
+                    return;
+                }
+
+                for (size_t index{}; index < arguments.size(); index++)
+                    maxwell3D->CallMethod(incrementing ? method + static_cast<u32>(index) : method, arguments[index], index == arguments.size() - 1);
+            });
+        }
+
+        /**
+         * @brief Calls every scratch macro index with arguments that are valid for both uploaded macros, their results depend on which macro each index refers to
+         * @note Macro positions are private to the engine, this makes writes to them observable through the registers
+         */
+        void ProbeMacroPositions() {
+            for (u32 index{ScratchPositions}; index < 0x80; index++) {
+                u32 method{Maxwell3D::RegisterCount + (index * 2)};
+                std::array<u32, 5> arguments{4, index, index * 3, index * 5, index * 7};
+                for (size_t argument{}; argument < arguments.size(); argument++)
+                    maxwell3D->CallMethod(argument ? method + 1 : method, arguments[argument], argument == arguments.size() - 1);
+            }
+        }
+    };
+
+    /**
+     * @return If all observable state of both channels matches, the first difference is printed otherwise
+     */
+    bool Matches(Channel &batched, Channel &reference) {
+        auto compare{[](std::string_view name, span<const u32> batchedValues, span<const u32> referenceValues) {
+            auto mismatch{std::mismatch(batchedValues.begin(), batchedValues.end(), referenceValues.begin())};
+            if (mismatch.first == batchedValues.end())
+                return true;
+            fmt::print(stderr, "{} mismatch at 0x{:X}: 0x{:X} batched, 0x{:X} reference\n", name, std::distance(batchedValues.begin(), mismatch.first), *mismatch.first, *mismatch.second);
+            return false;
+        }};
+
+        bool matches{compare("Registers", batched.maxwell3D->registers.raw, reference.maxwell3D->registers.raw)};
+        matches &= compare("Shadow registers", batched.maxwell3D->shadowRegisters.raw, reference.maxwell3D->shadowRegisters.raw);
+        matches &= compare("Macro code", batched.maxwell3D->macroCode, reference.maxwell3D->macroCode);
+        matches &= compare("Semaphore memory", batched.Semaphores(), reference.Semaphores());
+
+        for (u32 id{}; id < soc::host1x::SyncpointCount; id++) {
+            if (batched.Syncpoint(id) != reference.Syncpoint(id)) {
+                fmt::print(stderr, "Syncpoint {} differs: {} batched, {} reference\n", id, batched.Syncpoint(id), reference.Syncpoint(id));
+                matches = false;
+            }
+        }
+
+        for (size_t group{}; group < Maxwell3D::StateGroupCount; group++) {
+            if (batched.maxwell3D->IsDirty(static_cast<Maxwell3D::StateGroup>(group)) != reference.maxwell3D->IsDirty(static_cast<Maxwell3D::StateGroup>(group))) {
+                fmt::print(stderr, "Dirty state of group {} differs\n", group);
+                matches = false;
+            }
+        }
+
+        return matches;
+    }
+
+    /**
+     * @brief Runs through the MME registers, the syncpoint action, the semaphore and the firmware call which all have side-effects, alongside a run of plain registers
+     */
+    void IncMethod() {
+        std::vector<u32> pushBuffer{MethodHeader(SecOp::IncMethod, 0x44, 6), 0, ScratchCode, 0xC0DE, ScratchPositions, BindMacroOffset, 0};
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, 0xB0, 4), 1, 2, 5, 3});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, 0x6BE, 6), 1, 2, static_cast<u32>(SemaphoreAddress >> 32), static_cast<u32>(SemaphoreAddress) + 0x10, 0xFEED, SemaphoreInfo(Registers::SemaphoreInfo::Op::Release)});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, 0x8C2, 4), 1, 2, 3, 4});
+        pushBuffer.push_back(MethodHeader(SecOp::IncMethod, 0x280, 0x100));
+        for (u32 index{}; index < 0x100; index++)
+            pushBuffer.push_back(index * 0x10001);
+
+        Channel batched, reference;
+        batched.Dispatch(pushBuffer, true);
+        reference.Dispatch(pushBuffer, false);
+        EXPECT(Matches(batched, reference));
+
+        // The side-effects must have happened at all for the comparison to be meaningful
+        EXPECT(batched.maxwell3D->macroCode[ScratchCode] == 0xC0DE);
+        EXPECT(batched.Syncpoint(5) == 1);
+        EXPECT(batched.Semaphores()[4] == 0xFEED);
+        EXPECT(batched.maxwell3D->registers.raw[0xD00] == 1);
+    }
+
+    /**
+     * @brief Only the last argument of a non-incrementing run to a plain register is written while every argument to a register with side-effects must be dispatched
+     */
+    void NonIncMethod() {
+        std::vector<u32> pushBuffer{MethodHeader(SecOp::NonIncMethod, 0x4C7, 4), 1, 2, 3, 4};
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::ImmdDataMethod, MAXWELL3D_OFFSET(mme.instructionRamPointer), ScratchCode)});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(mme.instructionRamLoad), 3), 0xA, 0xB, 0xC});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(syncpointAction), 3), 7, 7, 8});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, MAXWELL3D_OFFSET(semaphore.payload), 1), 0x1234});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(semaphore.info), 2), SemaphoreInfo(Registers::SemaphoreInfo::Op::Release), SemaphoreInfo(Registers::SemaphoreInfo::Op::Counter)});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(constantBufferSelector.data), 16)});
+        for (u32 index{}; index < 16; index++)
+            pushBuffer.push_back(~index);
+
+        Channel batched, reference;
+        batched.Dispatch(pushBuffer, true);
+        reference.Dispatch(pushBuffer, false);
+        EXPECT(Matches(batched, reference));
+
+        EXPECT(batched.maxwell3D->registers.raw[0x4C7] == 4);
+        EXPECT((batched.maxwell3D->macroCode[ScratchCode + 2] == 0xC));
+        EXPECT(batched.Syncpoint(7) == 2 && batched.Syncpoint(8) == 1);
+        EXPECT(batched.Semaphores()[0] == 0); // The counter is written after the release
+    }
+
+    /**
+     * @brief The first argument of a OneInc method goes to its method and all others go to the following method
+     */
+    void OneInc() {
+        std::vector<u32> pushBuffer{MethodHeader(SecOp::OneInc, 0x4C7, 4), 1, 2, 3, 4};
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, MAXWELL3D_OFFSET(mme.instructionRamPointer), 4), ScratchCode, 0xA, 0xB, 0xC});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, MAXWELL3D_OFFSET(mme.startAddressRamPointer), 3), ScratchPositions, LoopMacroOffset, BindMacroOffset});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, MAXWELL3D_OFFSET(syncpointAction) - 1, 3), 0, 9, 9});
+
+        Channel batched, reference;
+        batched.Dispatch(pushBuffer, true);
+        reference.Dispatch(pushBuffer, false);
+        batched.ProbeMacroPositions();
+        reference.ProbeMacroPositions();
+        EXPECT(Matches(batched, reference));
+
+        EXPECT(batched.maxwell3D->registers.raw[0x4C7] == 1 && batched.maxwell3D->registers.raw[0x4C8] == 4);
+        EXPECT((batched.maxwell3D->macroCode[ScratchCode + 2] == 0xC));
+        EXPECT(batched.Syncpoint(9) == 2);
+    }
+
+    /**
+     * @brief Macros are called with OneInc and IncMethod runs, they're interleaved with writes to registers which the macros read and overwrite
+     */
+    void MacroRuns() {
+        constexpr u32 BindMethod{Maxwell3D::RegisterCount + (BindMacroIndex * 2)}, LoopMethod{Maxwell3D::RegisterCount + (LoopMacroIndex * 2)};
+        std::vector<u32> pushBuffer{MethodHeader(SecOp::IncMethod, 0x200, 4), 1, 2, 3, 4};
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, LoopMethod, 4), 3, 10, 20, 30});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, BindMethod, 5), 2, 0, 0x12, 0x3400, 0x11});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, LoopMethod, 2), 1, 40}); // The macro is called once its single method argument is sent as that's the last call of the run
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, 0x201, 2), 5, 6});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::OneInc, LoopMethod, 2), 1, 50});
+
+        Channel batched, reference;
+        batched.Dispatch(pushBuffer, true);
+        reference.Dispatch(pushBuffer, false);
+        EXPECT(Matches(batched, reference));
+
+        EXPECT(batched.maxwell3D->registers.raw[0x200] == 51);
+        EXPECT(batched.maxwell3D->registers.raw[0x300] == 7); // The delay slot after the exit overwrites the result with the value read from 0x201 plus one
+        EXPECT(batched.maxwell3D->registers.bindGroups[2].constantBuffer.raw == 0x11);
+    }
+
+    /**
+     * @brief The side-effects of methods called while shadow RAM is replayed use the tracked arguments, batches must switch to dispatching every method once replay is enabled by the batch itself
+     */
+    void ShadowRamReplay() {
+        using MmeShadowRamControl = Registers::MmeShadowRamControl;
+        std::vector<u32> pushBuffer{MethodHeader(SecOp::IncMethod, 0x4C7, 4), 1, 2, 3, 4};
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::ImmdDataMethod, MAXWELL3D_OFFSET(mme.instructionRamPointer), ScratchCode)});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, MAXWELL3D_OFFSET(mme.instructionRamLoad), 5), 0xA, 0, 0, static_cast<u32>(MmeShadowRamControl::MethodReplay), 0xB});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::IncMethod, 0x4C7, 4), 5, 6, 7, 8});
+        pushBuffer.insert(pushBuffer.end(), {MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(mme.instructionRamLoad), 2), 0xC, 0xD});
+
+        Channel batched, reference;
+        batched.Dispatch(pushBuffer, true);
+        reference.Dispatch(pushBuffer, false);
+        EXPECT(Matches(batched, reference));
+
+        EXPECT(batched.maxwell3D->shadowRegisters.mme.shadowRamControl == MmeShadowRamControl::MethodReplay);
+        EXPECT((batched.maxwell3D->macroCode[ScratchCode + 1] == 0xA)); // Replayed loads write the last tracked argument
+    }
+
+    /**
+     * @brief Generates pushbuffers with random runs of methods, arguments to registers with side-effects are constrained so they stay valid
+     * @note Macro code and positions are only written in the scratch ranges and the macros which are called always receive the arguments they fetch
+     */
+    class PushBufferGenerator {
+      private:
+        std::mt19937 &random;
+        std::vector<u32> pushBuffer;
+
+        u32 Method() {
+            if (random() % 2) {
+                constexpr std::array SideEffectRegions{0x45U, 0x47U, 0x49U, 0xB2U, 0x6C0U, 0x6C3U, 0x8C4U};
+                return SideEffectRegions[random() % SideEffectRegions.size()] - (random() % 4);
+            }
+            return 0x40 + static_cast<u32>(random() % (Maxwell3D::RegisterCount - 0x40));
+        }
+
+        u32 Argument(u32 method) {
+            switch (method) {
+                case MAXWELL3D_OFFSET(mme.instructionRamPointer):
+                    return ScratchCode + static_cast<u32>(random() % 0xE00);
+                case MAXWELL3D_OFFSET(mme.startAddressRamPointer):
+                    return ScratchPositions + static_cast<u32>(random() % 0x30);
+                case MAXWELL3D_OFFSET(mme.startAddressRamLoad):
+                    return (random() % 2) ? BindMacroOffset : LoopMacroOffset; // Positions are probed with arguments that are valid for both macros
+                case MAXWELL3D_OFFSET(mme.shadowRamControl):
+                    return static_cast<u32>((random() % 8) ? (random() % 3) : static_cast<u32>(Registers::MmeShadowRamControl::MethodReplay)); // Replay can't be left once entered so it's rare
+                case MAXWELL3D_OFFSET(syncpointAction):
+                    return (static_cast<u32>(random()) & ~0xFFFU) | static_cast<u32>(random() % soc::host1x::SyncpointCount);
+                case MAXWELL3D_OFFSET(semaphore.address.high):
+                    return static_cast<u32>(SemaphoreAddress >> 32);
+                case MAXWELL3D_OFFSET(semaphore.address.low):
+                    return static_cast<u32>(SemaphoreAddress) + static_cast<u32>((random() % (SemaphoreSize / sizeof(u32))) * sizeof(u32));
+                case MAXWELL3D_OFFSET(semaphore.info): {
+                    constexpr std::array Ops{Registers::SemaphoreInfo::Op::Release, Registers::SemaphoreInfo::Op::Counter, Registers::SemaphoreInfo::Op::Acquire};
+                    return SemaphoreInfo(Ops[random() % Ops.size()]);
+                }
+                default:
+                    return static_cast<u32>(random());
+            }
+        }
+
+        /**
+         * @brief Appends a method with arguments for the supplied registers, the MME pointers are reset first if the method loads macro code or positions so they can't leave the scratch ranges
+         */
+        void Emit(SecOp secOp, u32 method, u32 count) {
+            auto target{[&](u32 index) {
+                if (secOp == SecOp::IncMethod)
+                    return method + index;
+                return (secOp == SecOp::OneInc && index) ? method + 1 : method;
+            }};
+
+            for (u32 index{}; index < count; index++) {
+                u32 written{target(index)};
+                if (written == MAXWELL3D_OFFSET(mme.instructionRamLoad) || written == MAXWELL3D_OFFSET(mme.startAddressRamLoad)) {
+                    for (u32 pointer : {MAXWELL3D_OFFSET(mme.instructionRamPointer), MAXWELL3D_OFFSET(mme.startAddressRamPointer)})
+                        pushBuffer.push_back(MethodHeader(SecOp::ImmdDataMethod, pointer, Argument(pointer)));
+                    break;
+                }
+            }
+
+            pushBuffer.push_back(MethodHeader(secOp, method, count));
+            for (u32 index{}; index < count; index++)
+                pushBuffer.push_back(Argument(target(index)));
+        }
+
+        void EmitMacroCall() {
+            if (random() % 2) {
+                pushBuffer.push_back(MethodHeader(SecOp::OneInc, Maxwell3D::RegisterCount + (BindMacroIndex * 2), 5));
+                pushBuffer.insert(pushBuffer.end(), {static_cast<u32>(random() % 8), static_cast<u32>(random() & 0x10000), static_cast<u32>(random() & 0xFF), static_cast<u32>(random()), static_cast<u32>(random())});
+                return;
+            }
+
+            u32 method{Maxwell3D::RegisterCount + (LoopMacroIndex * 2)};
+            u32 count{static_cast<u32>(1 + (random() % 8))};
+            if (count == 1 && random() % 2)
+                pushBuffer.push_back(MethodHeader(SecOp::IncMethod, method, 2)); // The loop count and value are sent to the macro's method and argument method
+            else
+                pushBuffer.push_back(MethodHeader(SecOp::OneInc, method, count + 1));
+            pushBuffer.push_back(count);
+            for (u32 index{}; index < count; index++)
+                pushBuffer.push_back(static_cast<u32>(random()));
+        }
+
+      public:
+        PushBufferGenerator(std::mt19937 &random) : random{random} {}
+
+        std::vector<u32> Generate() {
+            pushBuffer.clear();
+            for (size_t methods{1 + (random() % 24)}; methods; methods--) {
+                switch (random() % 8) {
+                    case 0:
+                    case 1:
+                    case 2: {
+                        u32 method{Method()};
+                        Emit(SecOp::IncMethod, method, std::min(static_cast<u32>(1 + (random() % 32)), Maxwell3D::RegisterCount - method));
+                        break;
+                    }
+
+                    case 3:
+                    case 4:
+                        Emit(SecOp::NonIncMethod, Method(), static_cast<u32>(1 + (random() % 8)));
+                        break;
+
+                    case 5: {
+                        u32 method{Method()};
+                        Emit(SecOp::OneInc, method, method + 1 < Maxwell3D::RegisterCount ? static_cast<u32>(1 + (random() % 8)) : 1);
+                        break;
+                    }
+
+                    case 6: {
+                        u32 method{Method()}, argument{Argument(method)};
+                        if (argument <= 0x1FFF && method != MAXWELL3D_OFFSET(mme.instructionRamLoad) && method != MAXWELL3D_OFFSET(mme.startAddressRamLoad))
+                            pushBuffer.push_back(MethodHeader(SecOp::ImmdDataMethod, method, argument));
+                        else
+                            Emit(SecOp::IncMethod, method, 1); // Immediate data is limited to 13 bits
+                        break;
+                    }
+
+                    default:
+                        EmitMacroCall();
+                        break;
+                }
+
+                if (random() % 16 == 0)
+                    pushBuffer.push_back(0); // NOP
+            }
+            return pushBuffer;
+        }
+    };
+
+    /**
+     * @brief Dispatches random pushbuffers to both channels which are compared after each one, the macro positions are probed as they aren't otherwise observable
+     */
+    void RandomPushBuffers() {
+        constexpr size_t Iterations{512};
+        std::mt19937 random{0x50554348};
+        PushBufferGenerator generator{random};
+        Channel batched, reference;
+        for (size_t iteration{}; iteration < Iterations; iteration++) {
+            // Shadow RAM replay can't be left with methods, every pushbuffer starts in a random mode which isn't replay as most would be fully replayed otherwise
+            auto shadowRamControl{static_cast<Registers::MmeShadowRamControl>(random() % 3)};
+            batched.maxwell3D->shadowRegisters.mme.shadowRamControl = reference.maxwell3D->shadowRegisters.mme.shadowRamControl = shadowRamControl;
+
+            auto pushBuffer{generator.Generate()};
+            batched.Dispatch(pushBuffer, true);
+            reference.Dispatch(pushBuffer, false);
+            if (iteration % 8 == 0) {
+                batched.ProbeMacroPositions();
+                reference.ProbeMacroPositions();
+            }
+
+            if (!Matches(batched, reference)) {
+                fmt::print(stderr, "Pushbuffer {} differs\n", iteration);
+                EXPECT(false);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @return A pushbuffer that resembles a game's draws, it's dominated by state updates, constant buffer uploads and binds
+     * @param methods This is set to the amount of methods in the pushbuffer
+     */
+    std::vector<u32> DrawPushBuffer(size_t draws, size_t &methods) {
+        constexpr u32 BindMethod{Maxwell3D::RegisterCount + (BindMacroIndex * 2)};
+        std::vector<u32> pushBuffer;
+        methods = 0;
+        auto emit{[&](SecOp secOp, u32 method, std::initializer_list<u32> arguments) {
+            pushBuffer.push_back(MethodHeader(secOp, method, static_cast<u32>(arguments.size())));
+            pushBuffer.insert(pushBuffer.end(), arguments);
+            methods += arguments.size();
+        }};
+
+        for (u32 draw{}; draw < draws; draw++) {
+            pushBuffer.push_back(MethodHeader(SecOp::IncMethod, MAXWELL3D_OFFSET(viewportTransform), 8));
+            for (u32 index{}; index < 8; index++)
+                pushBuffer.push_back(draw + index);
+            methods += 8;
+
+            emit(SecOp::IncMethod, MAXWELL3D_OFFSET(constantBufferSelector), {0x100, 0, draw * 0x100, 0});
+            pushBuffer.push_back(MethodHeader(SecOp::NonIncMethod, MAXWELL3D_OFFSET(constantBufferSelector.data), 16)); // Uniforms are streamed through a non-incrementing method
+            for (u32 index{}; index < 16; index++)
+                pushBuffer.push_back(draw ^ index);
+            methods += 16;
+
+            emit(SecOp::OneInc, BindMethod, {draw % 5, 0, draw, draw * 0x100, 0x11});
+            emit(SecOp::IncMethod, MAXWELL3D_OFFSET(blend), {1, 0, 2, 3, 0, 4, 5, 1});
+            emit(SecOp::IncMethod, MAXWELL3D_OFFSET(depthTestFunc), {draw % 8});
+            pushBuffer.push_back(MethodHeader(SecOp::ImmdDataMethod, MAXWELL3D_OFFSET(cullFaceEnable), draw & 1));
+            methods++;
+
+            if (draw % 64 == 0)
+                emit(SecOp::IncMethod, MAXWELL3D_OFFSET(semaphore.payload), {draw, SemaphoreInfo(Registers::SemaphoreInfo::Op::Release)});
+        }
+        return pushBuffer;
+    }
+
+    /**
+     * @brief Replays a pushbuffer of draws with batched method calls and with every method called individually
+     */
+    void PushBufferReplay() {
+        constexpr size_t Replays{16};
+        size_t methods;
+        auto pushBuffer{DrawPushBuffer(1024, methods)};
+
+        auto measure{[&](bool batched) {
+            Channel channel;
+            auto start{util::GetTimeNs()};
+            for (size_t replay{}; replay < Replays; replay++)
+                channel.Dispatch(pushBuffer, batched);
+            return static_cast<double>(util::GetTimeNs() - start) / static_cast<double>(methods * Replays);
+        }};
+
+        double batchedNs{measure(true)}, individualNs{measure(false)};
+        fmt::print("Pushbuffer replay of {} methods: batched {:.1f}ns, individual {:.1f}ns per method ({:.1f}x)\n", methods, batchedNs, individualNs, individualNs / batchedNs);
+    }
+
+    /**
+     * @brief A pushbuffer submitted to a channel, a submission without a channel stops the thread consuming it
+     */
+    struct Submission {
+        Channel *channel;
+        span<u32> pushBuffer;
+    };
+
+    struct StopConsumer {};
+
+    /**
+     * @brief Replays submissions to several channels with a GPFIFO thread for every channel and with all channels serialized behind a single thread, the state of every channel must match between both
+     */
+    void MultiChannelThroughput() {
+        constexpr size_t ChannelCount{4}, Submissions{64};
+        size_t methods;
+        auto pushBuffer{DrawPushBuffer(256, methods)};
+
+        auto replay{[&](bool threadPerChannel, std::vector<std::unique_ptr<Channel>> &channels) {
+            for (size_t index{}; index < ChannelCount; index++)
+                channels.emplace_back(std::make_unique<Channel>());
+
+            std::vector<std::unique_ptr<MpscRing<Submission>>> rings;
+            std::vector<std::thread> threads;
+            for (size_t index{}; index < (threadPerChannel ? ChannelCount : 1); index++) {
+                auto &ring{*rings.emplace_back(std::make_unique<MpscRing<Submission>>(Submissions))};
+                threads.emplace_back([&ring]() {
+                    try {
+                        ring.Process([](Submission &submission) {
+                            if (!submission.channel)
+                                throw StopConsumer{}; // Process never returns, the only way out of it is an exception
+                            submission.channel->Dispatch(submission.pushBuffer, true);
+                        });
+                    } catch (const StopConsumer &) {}
+                });
+            }
+
+            auto start{util::GetTimeNs()};
+            for (size_t submission{}; submission < Submissions; submission++)
+                for (size_t index{}; index < ChannelCount; index++)
+                    rings[threadPerChannel ? index : 0]->Push(Submission{channels[index].get(), pushBuffer});
+            for (auto &ring : rings)
+                ring->Push(Submission{});
+            for (auto &thread : threads)
+                thread.join();
+            return static_cast<double>(methods * Submissions * ChannelCount) / static_cast<double>(util::GetTimeNs() - start) * 1000; // Methods per microsecond are millions of methods per second
+        }};
+
+        std::vector<std::unique_ptr<Channel>> serialChannels, parallelChannels;
+        double serialThroughput{replay(false, serialChannels)}, parallelThroughput{replay(true, parallelChannels)};
+        for (size_t index{}; index < ChannelCount; index++)
+            EXPECT(Matches(*parallelChannels[index], *serialChannels[index]));
+
+        fmt::print("Replay of {} channels: one GPFIFO thread {:.1f}M, a thread per channel {:.1f}M methods/s ({:.1f}x)\n", ChannelCount, serialThroughput, parallelThroughput, parallelThroughput / serialThroughput);
+    }
+}
+
+int main() {
+    using namespace skyline::test;
+    return Run({
+        {"IncMethod", IncMethod},
+        {"NonIncMethod", NonIncMethod},
+        {"OneInc", OneInc},
+        {"MacroRuns", MacroRuns},
+        {"ShadowRamReplay", ShadowRamReplay},
+        {"RandomPushBuffers", RandomPushBuffers},
+        {"PushBufferReplay", PushBufferReplay},
+        {"MultiChannelThroughput", MultiChannelThroughput},
+    });
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+/**
+ * @brief Fails the current test if the supplied condition is false
+ */
+#define EXPECT(condition) skyline::test::Expect(condition, #condition, __FILE__, __LINE__)
+
+/**
+ * @brief Fails the current test if the supplied statement doesn't throw a skyline::exception
+ */
+#define EXPECT_THROW(statement) skyline::test::ExpectThrow([&]() { statement; }, #statement, __FILE__, __LINE__)
+
+namespace skyline::test {
+    constexpr int SkipExitCode{77}; //!< The exit status of a test executable which can't run on the host, CTest reports it as skipped
+
+    inline void Expect(bool condition, const char *expression, const char *file, int line) {
+        if (!condition)
+            throw exception("{}:{}: Expected {}", file, line, expression);
+    }
+
+    template<typename Function>
+    void ExpectThrow(Function &&function, const char *statement, const char *file, int line) {
+        try {
+            function();
+        } catch (const exception &) {
+            return;
+        }
+        throw exception("{}:{}: Expected an exception from {}", file, line, statement);
+    }
+
+    /**
+     * @return The sample at the supplied percentile (0-100) of the samples, they're sorted in-place
+     */
+    inline u64 Percentile(std::vector<u64> &samples, double percentile) {
+        if (samples.empty())
+            return 0;
+        std::sort(samples.begin(), samples.end());
+        auto index{static_cast<size_t>((percentile / 100.0) * static_cast<double>(samples.size() - 1) + 0.5)};
+        return samples[index];
+    }
+
+    /**
+     * @brief Runs all the supplied tests, a test fails if it throws an exception
+     * @return The exit status of the test executable, it's non-zero if any test failed
+     */
+    inline int Run(std::initializer_list<std::pair<const char *, void (*)()>> tests) {
+        int status{};
+        for (auto [name, test] : tests) {
+            try {
+                test();
+                fmt::print("[PASS] {}\n", name);
+            } catch (const std::exception &e) {
+                fmt::print(stderr, "[FAIL] {}: {}\n", name, e.what());
+                status = 1;
+            }
+        }
+        return status;
+    }
+}